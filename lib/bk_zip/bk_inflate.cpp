@@ -0,0 +1,434 @@
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include "bk_inflate.h"
+
+namespace BK64 {
+
+#define MAX_BITS 15
+#define LITLEN_SYMBOLS 288
+#define DIST_SYMBOLS 30
+#define CODELEN_SYMBOLS 19
+// Codes up to this long are decoded with a single table lookup
+#define TABLE_BITS 10
+// Complete codes never need more than 1332 entries, so this only limits broken ones
+#define TABLE_SIZE ((1 << TABLE_BITS) + 2048)
+
+// Table entries hold the value in the top 16 bits, the extra bits to read or the subtable size in the next 8, then
+// the kind of entry and the code length. Unused codes are 0
+#define ENTRY_VALUE 0x10
+#define ENTRY_LENGTH 0x20
+#define ENTRY_END 0x40
+#define ENTRY_SUBTABLE 0x80
+
+namespace {
+
+const uint16_t sLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t sLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t sDistBase[DIST_SYMBOLS] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+const uint8_t sDistExtra[DIST_SYMBOLS] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+const uint8_t sCodeLengthOrder[CODELEN_SYMBOLS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+enum class Code {
+    CodeLength,
+    LitLen,
+    Distance,
+};
+
+struct Huffman {
+    uint32_t table[TABLE_SIZE];
+};
+
+struct BitReader {
+    const uint8_t* in;
+    const uint8_t* end;
+    uint64_t bits = 0;
+    uint32_t count = 0;
+    // Zero bytes fed in once the input ran out
+    uint32_t overrun = 0;
+
+    // Tops the buffer up to at least 56 bits, enough for a whole length and distance pair
+    void Refill() {
+        if (end - in >= 8) {
+            uint64_t word;
+            memcpy(&word, in, sizeof(word));
+            if constexpr (std::endian::native == std::endian::big) {
+                word = __builtin_bswap64(word);
+            }
+            // The top byte is only partially counted, the next refill ORs the same bits back in
+            bits |= word << count;
+            in += (63 - count) >> 3;
+            count |= 56;
+        } else {
+            while (count <= 56) {
+                uint64_t byte = 0;
+                if (in < end) {
+                    byte = *in++;
+                } else {
+                    overrun++;
+                }
+                bits |= byte << count;
+                count += 8;
+            }
+        }
+    }
+
+    uint32_t Bits(const uint32_t n) {
+        const auto value = static_cast<uint32_t>(bits & ((1ull << n) - 1));
+        bits >>= n;
+        count -= n;
+        return value;
+    }
+
+    // True once bits past the end of the input were consumed
+    bool Overran() const {
+        return overrun * 8 > count;
+    }
+};
+
+// Resolves what a symbol means up front, so the inflate loop gets everything from a single lookup
+uint32_t SymbolEntry(const Code code, const uint32_t symbol) {
+    switch (code) {
+        case Code::LitLen:
+            if (symbol < 256) {
+                return symbol << 16 | ENTRY_VALUE;
+            }
+            if (symbol == 256) {
+                return ENTRY_END;
+            }
+            if (symbol - 257 < 29) {
+                return sLengthBase[symbol - 257] << 16 | sLengthExtra[symbol - 257] << 8 | ENTRY_LENGTH;
+            }
+            return 0;
+        case Code::Distance:
+            return symbol < DIST_SYMBOLS ? sDistBase[symbol] << 16 | sDistExtra[symbol] << 8 | ENTRY_VALUE : 0;
+        default:
+            return symbol << 16 | ENTRY_VALUE;
+    }
+}
+
+uint32_t Reverse(uint32_t code, const uint32_t length) {
+    uint32_t reversed = 0;
+    for (uint32_t bit = 0; bit < length; bit++, code >>= 1) {
+        reversed = (reversed << 1) | (code & 1);
+    }
+    return reversed;
+}
+
+bool Build(Huffman& h, const uint8_t* lengths, const uint32_t n, const Code kind) {
+    uint16_t count[MAX_BITS + 1] = {};
+    uint32_t next[MAX_BITS + 1];
+    uint32_t codes[LITLEN_SYMBOLS];
+    uint8_t longest[1 << TABLE_BITS] = {};
+
+    for (uint32_t i = 0; i < n; i++) {
+        count[lengths[i]]++;
+    }
+
+    // Over-subscribed codes can't be decoded. Like zlib, incomplete ones are only taken when the longest code is one
+    // bit, a lone distance code or no distance codes at all, and unused codes still fail once they show up
+    int32_t left = 1;
+    uint32_t code = 0;
+    uint32_t max = 0;
+    count[0] = 0;
+    for (uint32_t len = 1; len <= MAX_BITS; len++) {
+        left = (left << 1) - count[len];
+        if (left < 0) {
+            return false;
+        }
+        code = (code + count[len - 1]) << 1;
+        next[len] = code;
+        max = count[len] ? len : max;
+    }
+    if (left > 0 && (kind == Code::CodeLength || max > 1)) {
+        return false;
+    }
+
+    // Codes are stored most significant bit first, tables are indexed by the bits as they are read
+    memset(h.table, 0, sizeof(uint32_t) << TABLE_BITS);
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t len = lengths[i];
+        if (len == 0) {
+            continue;
+        }
+
+        codes[i] = next[len]++;
+        if (len <= TABLE_BITS) {
+            const uint32_t entry = SymbolEntry(kind, i) | len;
+            for (uint32_t slot = Reverse(codes[i], len); slot < (1u << TABLE_BITS); slot += 1u << len) {
+                h.table[slot] = entry;
+            }
+        } else {
+            auto& max = longest[Reverse(codes[i] >> (len - TABLE_BITS), TABLE_BITS)];
+            max = std::max<uint8_t>(max, len);
+        }
+    }
+
+    // Longer codes sharing their first TABLE_BITS bits get a subtable indexed by the rest
+    uint32_t used = 1 << TABLE_BITS;
+    for (uint32_t prefix = 0; prefix < (1u << TABLE_BITS); prefix++) {
+        if (longest[prefix] == 0) {
+            continue;
+        }
+
+        const uint32_t bits = longest[prefix] - TABLE_BITS;
+        if (used + (1u << bits) > TABLE_SIZE) {
+            return false;
+        }
+        h.table[prefix] = used << 16 | bits << 8 | ENTRY_SUBTABLE;
+        memset(h.table + used, 0, sizeof(uint32_t) << bits);
+        used += 1 << bits;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t len = lengths[i];
+        if (len <= TABLE_BITS) {
+            continue;
+        }
+
+        const uint32_t pointer = h.table[Reverse(codes[i] >> (len - TABLE_BITS), TABLE_BITS)];
+        const uint32_t bits = len - TABLE_BITS;
+        const uint32_t entry = SymbolEntry(kind, i) | bits;
+        uint32_t* subtable = h.table + (pointer >> 16);
+        for (uint32_t slot = Reverse(codes[i], bits); slot < (1u << ((pointer >> 8) & 0xFF)); slot += 1u << bits) {
+            subtable[slot] = entry;
+        }
+    }
+
+    return true;
+}
+
+// Expects a refilled reader, consumes the code and returns its entry
+inline uint32_t Lookup(BitReader& reader, const Huffman& h) {
+    uint32_t entry = h.table[reader.bits & ((1 << TABLE_BITS) - 1)];
+    if (entry & ENTRY_SUBTABLE) {
+        reader.Bits(TABLE_BITS);
+        entry = h.table[(entry >> 16) + (reader.bits & ((1u << ((entry >> 8) & 0xFF)) - 1))];
+    }
+
+    reader.Bits(entry & 0xF);
+    return entry;
+}
+
+struct FixedCodes {
+    Huffman litlen;
+    Huffman dist;
+
+    FixedCodes() {
+        uint8_t lengths[LITLEN_SYMBOLS];
+        std::fill(lengths, lengths + 144, 8);
+        std::fill(lengths + 144, lengths + 256, 9);
+        std::fill(lengths + 256, lengths + 280, 7);
+        std::fill(lengths + 280, lengths + LITLEN_SYMBOLS, 8);
+        Build(litlen, lengths, LITLEN_SYMBOLS, Code::LitLen);
+
+        // Distance codes 30 and 31 exist in fixed blocks but are invalid
+        std::fill(lengths, lengths + 32, 5);
+        Build(dist, lengths, 32, Code::Distance);
+    }
+};
+
+bool InflateCodes(BitReader& reader, const Huffman& litlen, const Huffman& dist, uint8_t* start, uint8_t*& out, uint8_t* end) {
+    while (true) {
+        reader.Refill();
+        uint32_t entry = Lookup(reader, litlen);
+
+        // Zeros padding a truncated input are never written out
+        if (entry & ENTRY_VALUE) {
+            if (out == end || reader.Overran()) {
+                return false;
+            }
+            *out++ = entry >> 16;
+            continue;
+        }
+
+        if (!(entry & ENTRY_LENGTH)) {
+            return (entry & ENTRY_END) && !reader.Overran();
+        }
+
+        const uint32_t length = (entry >> 16) + reader.Bits((entry >> 8) & 0xFF);
+
+        entry = Lookup(reader, dist);
+        if (!(entry & ENTRY_VALUE)) {
+            return false;
+        }
+        const uint32_t distance = (entry >> 16) + reader.Bits((entry >> 8) & 0xFF);
+
+        if (reader.Overran() || distance > static_cast<size_t>(out - start) || length > static_cast<size_t>(end - out)) {
+            return false;
+        }
+
+        const uint8_t* src = out - distance;
+        if (distance >= 8 && static_cast<size_t>(end - out) >= length + 8) {
+            // Enough room left to copy whole words, the bytes written past the match are overwritten by what follows
+            for (uint32_t copied = 0; copied < length; copied += 8) {
+                memcpy(out + copied, src + copied, 8);
+            }
+        } else if (distance == 1) {
+            memset(out, *src, length);
+        } else {
+            // Overlapping matches repeat the last distance bytes, which a forward byte copy does by itself
+            for (uint32_t i = 0; i < length; i++) {
+                out[i] = src[i];
+            }
+        }
+        out += length;
+    }
+}
+
+bool InflateStored(BitReader& reader, uint8_t*& out, uint8_t* end) {
+    // Stored blocks start on a byte boundary, hand the whole bytes still in the buffer back to the input
+    reader.Bits(reader.count & 7);
+    const uint32_t held = reader.count >> 3;
+    const uint32_t padding = std::min(held, reader.overrun);
+    reader.overrun -= padding;
+    reader.in -= held - padding;
+    reader.bits = 0;
+    reader.count = 0;
+
+    // A header cut short counts as running out of input, which is still fine if the output is already full
+    if (reader.end - reader.in < 4) {
+        reader.overrun++;
+    }
+    if (reader.overrun != 0) {
+        return false;
+    }
+
+    const uint32_t length = reader.in[0] | (reader.in[1] << 8);
+    const uint32_t complement = reader.in[2] | (reader.in[3] << 8);
+    reader.in += 4;
+
+    if (length != (~complement & 0xFFFF) || length > static_cast<size_t>(reader.end - reader.in) ||
+        length > static_cast<size_t>(end - out)) {
+        return false;
+    }
+
+    memcpy(out, reader.in, length);
+    reader.in += length;
+    out += length;
+    return true;
+}
+
+bool InflateDynamic(BitReader& reader, uint8_t* start, uint8_t*& out, uint8_t* end) {
+    uint8_t lengths[LITLEN_SYMBOLS + DIST_SYMBOLS] = {};
+    Huffman litlen;
+    Huffman dist;
+
+    reader.Refill();
+    const uint32_t nlen = reader.Bits(5) + 257;
+    const uint32_t ndist = reader.Bits(5) + 1;
+    const uint32_t ncode = reader.Bits(4) + 4;
+    if (nlen > 286 || ndist > DIST_SYMBOLS) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < ncode; i++) {
+        reader.Refill();
+        lengths[sCodeLengthOrder[i]] = reader.Bits(3);
+    }
+
+    // The code length code is only needed while reading the other two, litlen holds it until then
+    if (!Build(litlen, lengths, CODELEN_SYMBOLS, Code::CodeLength)) {
+        return false;
+    }
+
+    memset(lengths, 0, CODELEN_SYMBOLS);
+    for (uint32_t index = 0; index < nlen + ndist;) {
+        reader.Refill();
+        const uint32_t entry = Lookup(reader, litlen);
+        if (!(entry & ENTRY_VALUE)) {
+            return false;
+        }
+
+        const uint32_t symbol = entry >> 16;
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+
+        uint8_t length = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            length = lengths[index - 1];
+            repeat = 3 + reader.Bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + reader.Bits(3);
+        } else {
+            repeat = 11 + reader.Bits(7);
+        }
+
+        if (index + repeat > nlen + ndist) {
+            return false;
+        }
+        memset(lengths + index, length, repeat);
+        index += repeat;
+    }
+
+    // Every block needs an end of block code
+    if (lengths[256] == 0) {
+        return false;
+    }
+
+    if (!Build(litlen, lengths, nlen, Code::LitLen) || !Build(dist, lengths + nlen, ndist, Code::Distance)) {
+        return false;
+    }
+
+    return InflateCodes(reader, litlen, dist, start, out, end);
+}
+
+} // namespace
+
+int64_t bk_inflate(const uint8_t* in_buffer, uint32_t in_size, uint8_t* out_buffer, uint32_t out_size) {
+    static const FixedCodes sFixed;
+
+    BitReader reader = { in_buffer, in_buffer + in_size };
+    uint8_t* out = out_buffer;
+    uint8_t* end = out_buffer + out_size;
+    bool last = false;
+    bool valid = true;
+
+    while (valid && !last) {
+        reader.Refill();
+        last = reader.Bits(1);
+
+        switch (reader.Bits(2)) {
+            case 0:
+                valid = InflateStored(reader, out, end);
+                break;
+            case 1:
+                valid = InflateCodes(reader, sFixed.litlen, sFixed.dist, out_buffer, out, end);
+                break;
+            case 2:
+                valid = InflateDynamic(reader, out_buffer, out, end);
+                break;
+            default:
+                valid = false;
+                break;
+        }
+
+        valid = valid && !reader.Overran();
+    }
+
+    // Like zlib, a stream cut short is fine as long as it filled the whole output first
+    if (reader.Overran() && out == end) {
+        return out_size;
+    }
+
+    return valid ? out - out_buffer : -1;
+}
+
+} // namespace BK64
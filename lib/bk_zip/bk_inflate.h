@@ -0,0 +1,23 @@
+#ifndef BK_INFLATE_H
+#define BK_INFLATE_H
+
+#include <cstdint>
+
+namespace BK64 {
+
+/**
+ * Decompresses a raw deflate stream (no zlib or gzip header) whose decompressed size is known up front
+ *
+ * The whole output is decoded in place, so no window is kept and nothing is written past out_size bytes
+ *
+ * @param in_buffer Raw deflate data
+ * @param in_size Size of the input, trailing bytes after the final block are ignored
+ * @param out_buffer Buffer the stream is decompressed into
+ * @param out_size Size of the output buffer
+ * @return Number of bytes decompressed, or -1 if the stream is invalid, truncated or larger than out_size
+ */
+int64_t bk_inflate(const uint8_t* in_buffer, uint32_t in_size, uint8_t* out_buffer, uint32_t out_size);
+
+} // namespace BK64
+
+#endif // BK_INFLATE_H
@@ -1,20 +1,20 @@
 #include <vector>
 #include <stdexcept>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
-#include <cstring>
 #include <utility>
-#include "zlib.h"
 #include "bk_unzip.h"
+#include "bk_inflate.h"
 
 namespace BK64 {
 
 /**
- * Implementation of bk_unzip as declared in bk_unzip.h
+ * Implementation of bk_unzip_size as declared in bk_unzip.h
  */
-uint8_t* bk_unzip(const uint8_t* in_buffer, uint32_t* size) {
+uint32_t bk_unzip_size(const uint8_t* in_buffer, uint32_t size) {
     // Check buffer size
-    if (*size < 6) {
+    if (size < 6) {
         throw std::runtime_error("Input buffer too small");
     }
 
@@ -24,59 +24,48 @@ uint8_t* bk_unzip(const uint8_t* in_buffer, uint32_t* size) {
     }
 
     // Extract expected uncompressed length (big-endian)
-    uint32_t expected_len = 
-        (static_cast<uint32_t>(in_buffer[2]) << 24) |
-        (static_cast<uint32_t>(in_buffer[3]) << 16) |
-        (static_cast<uint32_t>(in_buffer[4]) << 8) |
-        static_cast<uint32_t>(in_buffer[5]);
-
-    uint8_t* out_buffer = (uint8_t*)malloc(expected_len);
-    memset(out_buffer, 0, expected_len);
-
-    // Set up zlib stream
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
-    stream.avail_in = static_cast<uInt>(*size - 6);
-    stream.next_in = const_cast<Bytef*>(in_buffer + 6);
-    stream.avail_out = static_cast<uInt>(expected_len);
-    stream.next_out = out_buffer;
-
-    // Initialize for raw inflate (no zlib/gzip header) - same as wbits=-15 in Python
-    int result = inflateInit2(&stream, -15);
-    if (result != Z_OK) {
-        throw std::runtime_error("Failed to initialize zlib: " + 
-                                 std::string(stream.msg ? stream.msg : "unknown error"));
-    }
-
-    // Perform decompression
-    result = inflate(&stream, Z_FINISH);
-
-    // Check for successful decompression (Z_STREAM_END or Z_BUF_ERROR with no bytes left to input is ok)
-    bool success = (result == Z_STREAM_END) || 
-                   (result == Z_BUF_ERROR && stream.avail_in == 0);
+    return (static_cast<uint32_t>(in_buffer[2]) << 24) |
+           (static_cast<uint32_t>(in_buffer[3]) << 16) |
+           (static_cast<uint32_t>(in_buffer[4]) << 8) |
+           static_cast<uint32_t>(in_buffer[5]);
+}
 
-    // Clean up zlib stream
-    inflateEnd(&stream);
+/**
+ * Implementation of bk_unzip_into as declared in bk_unzip.h
+ */
+void bk_unzip_into(const uint8_t* in_buffer, uint32_t size, uint8_t* out_buffer) {
+    const uint32_t expected_len = bk_unzip_size(in_buffer, size);
 
-    if (!success) {
-        throw std::runtime_error("Decompression failed: " + 
-                                 std::string(stream.msg ? stream.msg : "unknown error"));
+    // Raw deflate (no zlib/gzip header) - same as wbits=-15 in Python. The whole output is written, so it needs no clearing
+    const int64_t total_out = bk_inflate(in_buffer + 6, size - 6, out_buffer, expected_len);
+    if (total_out < 0) {
+        throw std::runtime_error("Decompression failed: invalid deflate data");
     }
 
-    // Resize buffer to the actual decompressed size
-    // out_buffer.resize(stream.total_out);
-    *size = stream.total_out;
-
     // Verify decompressed size matches expected size
-    if (stream.total_out != expected_len) {
+    if (total_out != expected_len) {
         throw std::runtime_error("Decompressed size (" + 
-                                 std::to_string(stream.total_out) + 
+                                 std::to_string(total_out) + 
                                  ") does not match expected size (" + 
                                  std::to_string(expected_len) + ")");
     }
+}
+
+/**
+ * Implementation of bk_unzip as declared in bk_unzip.h
+ */
+uint8_t* bk_unzip(const uint8_t* in_buffer, uint32_t* size) {
+    const uint32_t expected_len = bk_unzip_size(in_buffer, *size);
+    uint8_t* out_buffer = (uint8_t*)malloc(expected_len);
+
+    try {
+        bk_unzip_into(in_buffer, *size, out_buffer);
+    } catch (...) {
+        free(out_buffer);
+        throw;
+    }
 
+    *size = expected_len;
     return out_buffer;
 }
 
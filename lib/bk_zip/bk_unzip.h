@@ -7,6 +7,26 @@
 
 namespace BK64 {
 
+/**
+ * Reads the decompressed size from a buffer with a Banjo-Kazooie header format
+ *
+ * @param in_buffer Input compressed data with BK header (starting with 0x11, 0x72)
+ * @param size Size of the compressed buffer
+ * @return Size of the decompressed data
+ * @throws std::runtime_error if the header is invalid
+ */
+uint32_t bk_unzip_size(const uint8_t* in_buffer, uint32_t size);
+
+/**
+ * Decompresses a buffer with a Banjo-Kazooie header format into memory owned by the caller
+ *
+ * @param in_buffer Input compressed data with BK header (starting with 0x11, 0x72)
+ * @param size Size of the compressed buffer
+ * @param out_buffer Output buffer, at least bk_unzip_size bytes long
+ * @throws std::runtime_error if decompression fails or header is invalid
+ */
+void bk_unzip_into(const uint8_t* in_buffer, uint32_t size, uint8_t* out_buffer);
+
 /**
  * Decompresses a buffer with a Banjo-Kazooie header format
  * 
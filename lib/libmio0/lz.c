@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz.h"
+#include "utils.h"
+
+// defines
+
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+#define WINDOW_MASK (LZ_WINDOW_SIZE - 1)
+
+// candidates looked at per position by LZ_EFFORT_FAST
+#define FAST_CHAIN_LENGTH 32
+
+// bits a token takes in the control stream and data
+#define LITERAL_COST 9
+#define MATCH_COST 17
+#define LONG_MATCH_COST 25
+
+// types
+typedef struct
+{
+   const unsigned char *in;
+   // every position before this one is in the chains
+   unsigned int inserted;
+   int head[HASH_SIZE];
+   // previous position with the same hash, only the last window worth of positions is kept
+   int prev[LZ_WINDOW_SIZE];
+} hash_chain;
+
+// functions
+static inline unsigned int hash3(const unsigned char *p)
+{
+   return (((unsigned int)p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void chain_insert(hash_chain *hc, unsigned int pos)
+{
+   for ( ; hc->inserted < pos; hc->inserted++) {
+      unsigned int h = hash3(&hc->in[hc->inserted]);
+      hc->prev[hc->inserted & WINDOW_MASK] = hc->head[h];
+      hc->head[h] = hc->inserted;
+   }
+}
+
+// used to find longest matching stream in buffer
+// pos: offset in buffer to look back from
+// max_search: max number of bytes to find
+// depth: max number of candidates to look at
+// nearest: on ties keep the nearest match and stop at the first one of max_search bytes, the farthest one wins otherwise
+// found_distance: returned distance found (0 if none found)
+// returns max length of matching stream (0 if none found)
+static unsigned int find_longest(hash_chain *hc, unsigned int pos, unsigned int max_search, unsigned int depth,
+                                 int nearest, unsigned int *found_distance)
+{
+   const unsigned char *in = hc->in;
+   unsigned int best_length = 0;
+   unsigned int best_distance = 0;
+   int cand;
+
+   *found_distance = 0;
+   if (max_search < LZ_MIN_LENGTH) {
+      return 0;
+   }
+
+   chain_insert(hc, pos);
+   for (cand = hc->head[hash3(&in[pos])];
+        cand >= 0 && pos - (unsigned int)cand <= LZ_WINDOW_SIZE && depth > 0;
+        cand = hc->prev[cand & WINDOW_MASK], depth--) {
+      unsigned int length = 0;
+      // overlapping matches compare against the input itself, which is what the decoder reproduces
+      while (length < max_search && in[cand + length] == in[pos + length]) {
+         length++;
+      }
+      if (length > best_length || (!nearest && length == best_length && length >= LZ_MIN_LENGTH)) {
+         best_length = length;
+         best_distance = pos - cand;
+         if (nearest && length == max_search) {
+            break;
+         }
+      }
+   }
+
+   *found_distance = best_distance;
+   return best_length;
+}
+
+static int parse_greedy(hash_chain *hc, unsigned int begin, unsigned int end, unsigned int max_length,
+                        unsigned int depth, int nearest, lz_token *tokens)
+{
+   unsigned int pos = begin;
+   int count = 0;
+
+   while (pos < end) {
+      unsigned int distance;
+      unsigned int length = find_longest(hc, pos, MIN(end - pos, max_length), depth, nearest, &distance);
+      if (length >= LZ_MIN_LENGTH) {
+         unsigned int lookahead_distance;
+         // lookahead to next byte to see if longer match
+         unsigned int lookahead = find_longest(hc, pos + 1, MIN(end - pos - 1, max_length), depth, nearest, &lookahead_distance);
+         // better match found, use uncompressed + lookahead compressed
+         if (length + 1 < lookahead) {
+            tokens[count].length = 1;
+            tokens[count].distance = 0;
+            count++;
+            pos++;
+            length = lookahead;
+            distance = lookahead_distance;
+         }
+         tokens[count].length = length;
+         tokens[count].distance = distance;
+         pos += length;
+      } else {
+         tokens[count].length = 1;
+         tokens[count].distance = 0;
+         pos++;
+      }
+      count++;
+   }
+
+   return count;
+}
+
+// any shorter length works at the distance of the longest match and all distances cost the same, so the cheapest
+// split only needs the longest match at every position
+static int parse_optimal(hash_chain *hc, unsigned int begin, unsigned int end, unsigned int max_length,
+                         unsigned int short_length, lz_token *tokens)
+{
+   unsigned int size = end - begin;
+   unsigned int *cost = malloc((size + 1) * sizeof(*cost));
+   lz_token *choice = malloc(size * sizeof(*choice));
+   unsigned int i;
+   int count = 0;
+
+   if (cost == NULL || choice == NULL) {
+      free(cost);
+      free(choice);
+      return -1;
+   }
+
+   for (i = 0; i < size; i++) {
+      unsigned int distance;
+      choice[i].length = find_longest(hc, begin + i, MIN(size - i, max_length), LZ_WINDOW_SIZE, 1, &distance);
+      choice[i].distance = distance;
+   }
+
+   cost[size] = 0;
+   for (i = size; i-- > 0; ) {
+      unsigned int longest = choice[i].length;
+      unsigned int best = 1;
+      cost[i] = cost[i + 1] + LITERAL_COST;
+      for (unsigned int length = LZ_MIN_LENGTH; length <= longest; length++) {
+         unsigned int c = cost[i + length] + (length > short_length ? LONG_MATCH_COST : MATCH_COST);
+         if (c < cost[i]) {
+            cost[i] = c;
+            best = length;
+         }
+      }
+      choice[i].length = best;
+      if (best == 1) {
+         choice[i].distance = 0;
+      }
+   }
+
+   for (i = 0; i < size; i += choice[i].length) {
+      tokens[count++] = choice[i];
+   }
+
+   free(cost);
+   free(choice);
+   return count;
+}
+
+int lz_parse(const unsigned char *in, unsigned int begin, unsigned int end, unsigned int max_length,
+             unsigned int short_length, lz_effort effort, lz_token *tokens)
+{
+   hash_chain *hc;
+   int count;
+
+   if (begin >= end) {
+      return 0;
+   }
+
+   hc = malloc(sizeof(*hc));
+   if (hc == NULL) {
+      return -1;
+   }
+   hc->in = in;
+   hc->inserted = begin > LZ_WINDOW_SIZE ? begin - LZ_WINDOW_SIZE : 0;
+   memset(hc->head, 0xFF, sizeof(hc->head));
+
+   switch (effort) {
+      case LZ_EFFORT_ORIGINAL:
+         count = parse_greedy(hc, begin, end, max_length, LZ_WINDOW_SIZE, 0, tokens);
+         break;
+      case LZ_EFFORT_FAST:
+         count = parse_greedy(hc, begin, end, max_length, FAST_CHAIN_LENGTH, 1, tokens);
+         break;
+      case LZ_EFFORT_BEST:
+         count = parse_optimal(hc, begin, end, max_length, short_length, tokens);
+         break;
+      default:
+         count = -1;
+         break;
+   }
+
+   free(hc);
+   return count;
+}
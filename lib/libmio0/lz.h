@@ -0,0 +1,38 @@
+#pragma once
+
+// defines
+
+// MIO0, Yay0 and Yay1 all reach back at most 4096 bytes and only store matches of 3 bytes or more
+#define LZ_WINDOW_SIZE 4096
+#define LZ_MIN_LENGTH 3
+
+// typedefs
+
+typedef enum
+{
+   // byte for byte what the original encoder produces: farthest longest match with a one byte lookahead
+   LZ_EFFORT_ORIGINAL,
+   // nearest longest match out of a few candidates, with the same lookahead
+   LZ_EFFORT_FAST,
+   // smallest output the format allows, picks the cheapest split over the longest match at every position
+   LZ_EFFORT_BEST,
+} lz_effort;
+
+typedef struct
+{
+   // 1 for literals
+   unsigned short length;
+   // 0 for literals
+   unsigned short distance;
+} lz_token;
+
+// function prototypes
+
+// split in[begin, end) into literals and back-references, matches may reach back into data before begin
+// in: buffer containing raw data
+// max_length: longest match the format can store
+// short_length: matches longer than this take an extra byte in the format, only used by LZ_EFFORT_BEST
+// tokens: buffer for at least end - begin tokens
+// returns number of tokens written or negative value on failure
+int lz_parse(const unsigned char *in, unsigned int begin, unsigned int end, unsigned int max_length,
+             unsigned int short_length, lz_effort effort, lz_token *tokens);
@@ -15,116 +15,6 @@
 
 #define GET_BIT(buf, bit) ((buf)[(bit) / 8] & (1 << (7 - ((bit) % 8))))
 
-// types
-typedef struct
-{
-   int *indexes;
-   int allocated;
-   int count;
-   int start;
-} lookback;
-
-// functions
-#define LOOKBACK_COUNT 256
-#define LOOKBACK_INIT_SIZE 128
-static lookback *lookback_init(void)
-{
-   lookback *lb = malloc(LOOKBACK_COUNT * sizeof(*lb));
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      lb[i].allocated = LOOKBACK_INIT_SIZE;
-      lb[i].indexes = malloc(lb[i].allocated * sizeof(*lb[i].indexes));
-      lb[i].count = 0;
-      lb[i].start = 0;
-   }
-   return lb;
-}
-
-static void lookback_free(lookback *lb)
-{
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      free(lb[i].indexes);
-   }
-   free(lb);
-}
-
-static inline void lookback_push(lookback *lkbk, unsigned char val, int index)
-{
-   lookback *lb = &lkbk[val];
-   if (lb->count == lb->allocated) {
-      lb->allocated *= 4;
-      lb->indexes = realloc(lb->indexes, lb->allocated * sizeof(*lb->indexes));
-   }
-   lb->indexes[lb->count++] = index;
-}
-
-static void PUT_BIT(unsigned char *buf, int bit, int val)
-{
-   unsigned char mask = 1 << (7 - (bit % 8));
-   unsigned int offset = bit / 8;
-   buf[offset] = (buf[offset] & ~(mask)) | (val ? mask : 0);
-}
-
-// used to find longest matching stream in buffer
-// buf: buffer
-// start_offset: offset in buf to look back from
-// max_search: max number of bytes to find
-// found_offset: returned offset found (0 if none found)
-// returns max length of matching stream (0 if none found)
-static int find_longest(const unsigned char *buf, int start_offset, int max_search, int *found_offset, lookback *lkbk)
-{
-   int best_length = 0;
-   int best_offset = 0;
-   int cur_length;
-   int search_len;
-   int farthest, off, i;
-   int lb_idx;
-   const unsigned char first = buf[start_offset];
-   lookback *lb = &lkbk[first];
-
-   // buf
-   //  |    off        start                  max
-   //  V     |+i->       |+i->                 |
-   //  |--------------raw-data-----------------|
-   //        |+i->       |      |+i->
-   //                       +cur_length
-
-   // check at most the past 4096 values
-   farthest = MAX(start_offset - 4096, 0);
-   // find starting index
-   for (lb_idx = lb->start; lb_idx < lb->count && lb->indexes[lb_idx] < farthest; lb_idx++) {}
-   lb->start = lb_idx;
-   for ( ; lb_idx < lb->count && lb->indexes[lb_idx] < start_offset; lb_idx++) {
-      off = lb->indexes[lb_idx];
-      // check at most requested max or up until start
-      search_len = MIN(max_search, start_offset - off);
-      for (i = 0; i < search_len; i++) {
-         if (buf[start_offset + i] != buf[off + i]) {
-            break;
-         }
-      }
-      cur_length = i;
-      // if matched up until start, continue matching in already matched parts
-      if (cur_length == search_len) {
-         // check at most requested max less current length
-         search_len = max_search - cur_length;
-         for (i = 0; i < search_len; i++) {
-            if (buf[start_offset + cur_length + i] != buf[off + i]) {
-               break;
-            }
-         }
-         cur_length += i;
-      }
-      if (cur_length > best_length) {
-         best_offset = start_offset - off;
-         best_length = cur_length;
-      }
-   }
-
-   // return best reverse offset and length (may be 0)
-   *found_offset = best_offset;
-   return best_length;
-}
-
 // decode MIO0 header
 // returns 1 if valid header, 0 otherwise
 int mio0_decode_header(const unsigned char *buf, mio0_header_t *head)
@@ -146,153 +36,169 @@ void mio0_encode_header(unsigned char *buf, const mio0_header_t *head)
    write_u32_be(&buf[12], head->uncomp_offset);
 }
 
-int mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end)
+// next 32 flag bits, the ones past the end of the flag region read as 0
+static unsigned int read_flags(const unsigned char *flags, unsigned int length, unsigned int pos)
+{
+   unsigned int word = 0;
+   int i;
+   if (pos + 4 <= length) {
+      return read_u32_be(&flags[pos]);
+   }
+   for (i = 0; i < 4; i++) {
+      word = (word << 8) | (pos + i < length ? flags[pos + i] : 0);
+   }
+   return word;
+}
+
+int mio0_decode(const unsigned char *in, unsigned int in_size, unsigned char *out, unsigned int *end)
 {
    mio0_header_t head;
+   const unsigned char *flags;
+   const unsigned char *comp;
+   const unsigned char *uncomp;
+   const unsigned char *in_end = in + in_size;
+   unsigned int flags_length;
+   unsigned int flags_pos = 0;
    unsigned int bytes_written = 0;
-   int bit_idx = 0;
-   int comp_idx = 0;
-   int uncomp_idx = 0;
+   unsigned int mask = 0;
+   int bits = 0;
    int valid;
 
    // extract header
-   valid = mio0_decode_header(in, &head);
+   valid = in_size >= MIO0_HEADER_LENGTH && mio0_decode_header(in, &head);
    // verify MIO0 header
    if (!valid) {
       return -2;
    }
 
-   // decode data
+   if (head.comp_offset > in_size || head.uncomp_offset > in_size) {
+      return -1;
+   }
+
+   // flags can't extend into the uncompressed data, everything before it is part of the block
+   flags = &in[MIO0_HEADER_LENGTH];
+   flags_length = head.uncomp_offset > MIO0_HEADER_LENGTH ? head.uncomp_offset - MIO0_HEADER_LENGTH : 0;
+   comp = &in[head.comp_offset];
+   uncomp = &in[head.uncomp_offset];
+
+   // decode data, one 32-bit flag word at a time
    while (bytes_written < head.dest_size) {
-      if (GET_BIT(&in[MIO0_HEADER_LENGTH], bit_idx)) {
-         // 1 - pull uncompressed data
-         out[bytes_written] = in[head.uncomp_offset + uncomp_idx];
-         bytes_written++;
-         uncomp_idx++;
-      } else {
-         // 0 - read compressed data
-         int idx;
-         int length;
-         int i;
-         const unsigned char *vals = &in[head.comp_offset + comp_idx];
-         comp_idx += 2;
-         length = ((vals[0] & 0xF0) >> 4) + 3;
-         idx = ((vals[0] & 0x0F) << 8) + vals[1] + 1;
-         for (i = 0; i < length; i++) {
-            out[bytes_written] = out[bytes_written - idx];
-            bytes_written++;
+      unsigned int run;
+      unsigned int length;
+      unsigned int idx;
+
+      if (bits == 0) {
+         mask = read_flags(flags, flags_length, flags_pos);
+         flags_pos += 4;
+         bits = 32;
+      }
+
+      // 1 - copy the whole run of uncompressed bytes at once
+      run = count_leading_ones32(mask);
+      if (run > 0) {
+         run = MIN(run, (unsigned int)bits);
+         mask = run < 32 ? mask << run : 0;
+         bits -= run;
+         run = MIN(run, head.dest_size - bytes_written);
+         if ((unsigned int)(in_end - uncomp) < run) {
+            return -1;
          }
+         memcpy(&out[bytes_written], uncomp, run);
+         uncomp += run;
+         bytes_written += run;
+         continue;
+      }
+
+      // 0 - read compressed data
+      if (in_end - comp < 2) {
+         return -1;
       }
-      bit_idx++;
+      length = ((comp[0] & 0xF0) >> 4) + 3;
+      idx = ((comp[0] & 0x0F) << 8) + comp[1] + 1;
+      comp += 2;
+      mask <<= 1;
+      bits--;
+
+      if (idx > bytes_written) {
+         return -1;
+      }
+      length = MIN(length, head.dest_size - bytes_written);
+      lz_copy(&out[bytes_written], idx, length);
+      bytes_written += length;
    }
 
    if (end) {
-      *end = head.uncomp_offset + uncomp_idx;
+      *end = (unsigned int)(uncomp - in);
    }
 
    return bytes_written;
 }
 
-int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out)
+int mio0_encode_tokens(const unsigned char *in, unsigned int length, const lz_token *tokens, unsigned int count, unsigned char *out)
 {
-   unsigned char *bit_buf;
-   unsigned char *comp_buf;
-   unsigned char *uncomp_buf;
-   unsigned int bit_length;
-   unsigned int comp_offset;
-   unsigned int uncomp_offset;
+   unsigned int bit_length = (count + 7) / 8;
+   unsigned int comp_offset = ALIGN(MIO0_HEADER_LENGTH + bit_length, 4);
+   unsigned int uncomp_offset = comp_offset;
+   unsigned char *comp;
+   unsigned char *uncomp;
    unsigned int bytes_proc = 0;
-   int bytes_written;
-   int bit_idx = 0;
-   int comp_idx = 0;
-   int uncomp_idx = 0;
-   lookback *lookbacks;
-
-   // initialize lookback buffer
-   lookbacks = lookback_init();
-
-   // allocate some temporary buffers worst case size
-   bit_buf = malloc((length + 7) / 8); // 1-bit/byte
-   comp_buf = malloc(length); // 16-bits/2bytes
-   uncomp_buf = malloc(length); // all uncompressed
-   memset(bit_buf, 0, (length + 7) / 8);
-
-   // encode data
-   // special case for first byte
-   lookback_push(lookbacks, in[0], 0);
-   uncomp_buf[uncomp_idx] = in[0];
-   uncomp_idx += 1;
-   bytes_proc += 1;
-   PUT_BIT(bit_buf, bit_idx++, 1);
-   while (bytes_proc < length) {
-      int offset;
-      int max_length = MIN(length - bytes_proc, 18);
-      int longest_match = find_longest(in, bytes_proc, max_length, &offset, lookbacks);
-      // push current byte before checking next longer match
-      lookback_push(lookbacks, in[bytes_proc], bytes_proc);
-      if (longest_match > 2) {
-         int lookahead_offset;
-         // lookahead to next byte to see if longer match
-         int lookahead_length = MIN(length - bytes_proc - 1, 18);
-         int lookahead_match = find_longest(in, bytes_proc + 1, lookahead_length, &lookahead_offset, lookbacks);
-         // better match found, use uncompressed + lookahead compressed
-         if ((longest_match + 1) < lookahead_match) {
-            // uncompressed byte
-            uncomp_buf[uncomp_idx] = in[bytes_proc];
-            uncomp_idx++;
-            PUT_BIT(bit_buf, bit_idx, 1);
-            bytes_proc++;
-            longest_match = lookahead_match;
-            offset = lookahead_offset;
-            bit_idx++;
-            lookback_push(lookbacks, in[bytes_proc], bytes_proc);
-         }
-         // first byte already pushed above
-         for (int i = 1; i < longest_match; i++) {
-            lookback_push(lookbacks, in[bytes_proc + i], bytes_proc + i);
-         }
+   unsigned int i;
+
+   for (i = 0; i < count; i++) {
+      if (tokens[i].distance) {
+         uncomp_offset += 2;
+      }
+   }
+
+   // control bits and the padding after them start cleared
+   memset(&out[MIO0_HEADER_LENGTH], 0, comp_offset - MIO0_HEADER_LENGTH);
+   comp = &out[comp_offset];
+   uncomp = &out[uncomp_offset];
+
+   for (i = 0; i < count; i++) {
+      if (tokens[i].distance) {
          // compressed block
-         comp_buf[comp_idx] = (((longest_match - 3) & 0x0F) << 4) |
-                              (((offset - 1) >> 8) & 0x0F);
-         comp_buf[comp_idx + 1] = (offset - 1) & 0xFF;
-         comp_idx += 2;
-         PUT_BIT(bit_buf, bit_idx, 0);
-         bytes_proc += longest_match;
+         comp[0] = (((tokens[i].length - 3) & 0x0F) << 4) | (((tokens[i].distance - 1) >> 8) & 0x0F);
+         comp[1] = (tokens[i].distance - 1) & 0xFF;
+         comp += 2;
       } else {
          // uncompressed byte
-         uncomp_buf[uncomp_idx] = in[bytes_proc];
-         uncomp_idx++;
-         PUT_BIT(bit_buf, bit_idx, 1);
-         bytes_proc++;
+         out[MIO0_HEADER_LENGTH + i / 8] |= 1 << (7 - (i % 8));
+         *uncomp++ = in[bytes_proc];
       }
-      bit_idx++;
+      bytes_proc += tokens[i].length;
    }
 
-   // compute final sizes and offsets
-   // +7 so int division accounts for all bits
-   bit_length = ((bit_idx + 7) / 8);
-   // compressed data after control bits and aligned to 4-byte boundary
-   comp_offset = ALIGN(MIO0_HEADER_LENGTH + bit_length, 4);
-   uncomp_offset = comp_offset + comp_idx;
-   bytes_written = uncomp_offset + uncomp_idx;
-
    // output header
    memcpy(out, "MIO0", 4);
    write_u32_be(&out[4], length);
    write_u32_be(&out[8], comp_offset);
    write_u32_be(&out[12], uncomp_offset);
-   // output data
-   memcpy(&out[MIO0_HEADER_LENGTH], bit_buf, bit_length);
-   memcpy(&out[comp_offset], comp_buf, comp_idx);
-   memcpy(&out[uncomp_offset], uncomp_buf, uncomp_idx);
 
-   // free allocated buffers
-   free(bit_buf);
-   free(comp_buf);
-   free(uncomp_buf);
-   lookback_free(lookbacks);
+   return (int)(uncomp - out);
+}
+
+int mio0_encode_effort(const unsigned char *in, unsigned int length, unsigned char *out, lz_effort effort)
+{
+   lz_token *tokens = malloc(MAX(length, 1) * sizeof(*tokens));
+   int count;
 
-   return bytes_written;
+   if (tokens == NULL) {
+      return -1;
+   }
+
+   count = lz_parse(in, 0, length, MIO0_MAX_LENGTH, MIO0_MAX_LENGTH, effort, tokens);
+   if (count >= 0) {
+      count = mio0_encode_tokens(in, length, tokens, count, out);
+   }
+
+   free(tokens);
+   return count;
+}
+
+int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out)
+{
+   return mio0_encode_effort(in, length, out, LZ_EFFORT_ORIGINAL);
 }
 
 static FILE *mio0_open_out_file(const char *out_file) {
@@ -345,7 +251,7 @@ int mio0_decode_file(const char *in_file, unsigned long offset, mio0_data* data)
    out_buf = malloc(head.dest_size);
 
    // decompress MIO0 encoded data
-   bytes_decoded = mio0_decode(in_buf, out_buf, NULL);
+   bytes_decoded = mio0_decode(in_buf, file_size - offset, out_buf, NULL);
    if (bytes_decoded < 0) {
       ret_val = 3;
       exit(-1);
@@ -400,7 +306,7 @@ int mio0_encode_file(const char *in_file, const char *out_file)
    }
 
    // allocate worst case length
-   out_buf = malloc(MIO0_HEADER_LENGTH + ((file_size+7)/8) + file_size);
+   out_buf = malloc(ALIGN(MIO0_HEADER_LENGTH + ((file_size+7)/8), 4) + file_size);
 
    // compress data in MIO0 format
    bytes_encoded = mio0_encode(in_buf, file_size, out_buf);
@@ -1,9 +1,12 @@
 #pragma once
 #include <stddef.h>
+#include "lz.h"
 
 // defines
 
 #define MIO0_HEADER_LENGTH 16
+// longest back-reference, every one takes two bytes
+#define MIO0_MAX_LENGTH 18
 
 // typedefs
 
@@ -30,10 +33,11 @@ void mio0_encode_header(unsigned char *buf, const mio0_header_t *head);
 
 // decode MIO0 data in memory
 // in: buffer containing MIO0 data
+// in_size: bytes readable from in, data past it fails the decode
 // out: buffer for output data
 // end: output offset of the last byte decoded from in (set to NULL if unwanted)
 // returns bytes extracted to 'out' or negative value on failure
-int mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end);
+int mio0_decode(const unsigned char *in, unsigned int in_size, unsigned char *out, unsigned int *end);
 
 // encode MIO0 data in memory
 // in: buffer containing raw data
@@ -41,6 +45,14 @@ int mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end);
 // returns size of compressed data in 'out' including MIO0 header
 int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out);
 
+// encode MIO0 data in memory with the given match finder effort
+// returns size of compressed data in 'out' including MIO0 header or negative value on failure
+int mio0_encode_effort(const unsigned char *in, unsigned int length, unsigned char *out, lz_effort effort);
+
+// encode MIO0 data from tokens covering all of in (see lz_parse)
+// returns size of compressed data in 'out' including MIO0 header
+int mio0_encode_tokens(const unsigned char *in, unsigned int length, const lz_token *tokens, unsigned int count, unsigned char *out);
+
 // decode an entire MIO0 block at an offset from file to output file
 // in_file: input filename
 // offset: offset to start decoding from in_file
@@ -2,12 +2,14 @@
 #define UTILS_H_
 
 #include <stdio.h>
+#include <string.h>
 
 // defines
 
 // printing size_t varies by compiler
 #if defined(_MSC_VER) || defined(__MINGW32__)
   #include <windows.h>
+  #include <intrin.h>
   #define SIZE_T_FORMAT "%Iu"
   #define realpath(N,R) _fullpath((R),(N),MAX_PATH)
 #else
@@ -27,8 +29,8 @@
 #define ALIGN(VAL_, ALIGNMENT_) (((VAL_) + ((ALIGNMENT_) - 1)) & ~((ALIGNMENT_) - 1))
 
 // read/write u32/16 big/little endian
-#define read_u32_be(buf) (unsigned int)(((buf)[0] << 24) + ((buf)[1] << 16) + ((buf)[2] << 8) + ((buf)[3]))
-#define read_u32_le(buf) (unsigned int)(((buf)[1] << 24) + ((buf)[0] << 16) + ((buf)[3] << 8) + ((buf)[2]))
+#define read_u32_be(buf) (unsigned int)(((unsigned int)(buf)[0] << 24) + ((buf)[1] << 16) + ((buf)[2] << 8) + ((buf)[3]))
+#define read_u32_le(buf) (unsigned int)(((unsigned int)(buf)[1] << 24) + ((buf)[0] << 16) + ((buf)[3] << 8) + ((buf)[2]))
 #define write_u32_be(buf, val) do { \
    (buf)[0] = ((val) >> 24) & 0xFF; \
    (buf)[1] = ((val) >> 16) & 0xFF; \
@@ -41,6 +43,42 @@
    (buf)[1] = ((val)) & 0xFF; \
 } while(0)
 
+// number of set bits before the first clear one, starting from the most significant bit
+static inline int count_leading_ones32(unsigned int val)
+{
+   val = ~val;
+   if (val == 0) {
+      return 32;
+   }
+#if defined(_MSC_VER)
+   unsigned long index;
+   _BitScanReverse(&index, val);
+   return 31 - (int)index;
+#else
+   return __builtin_clz(val);
+#endif
+}
+
+// copy an LZ back-reference 'distance' bytes behind dst, shorter distances than
+// length repeat the pattern one non-overlapping chunk at a time
+static inline void lz_copy(unsigned char *dst, unsigned int distance, unsigned int length)
+{
+   const unsigned char *src = dst - distance;
+   if (distance >= length) {
+      memcpy(dst, src, length);
+   } else if (distance == 1) {
+      memset(dst, src[0], length);
+   } else {
+      while (length > 0) {
+         unsigned int chunk = MIN(distance, length);
+         memcpy(dst, src, chunk);
+         dst += chunk;
+         src += chunk;
+         length -= chunk;
+      }
+   }
+}
+
 // print nibbles and bytes
 #define fprint_nibble(FP, NIB_) fputc((NIB_) < 10 ? ('0' + (NIB_)) : ('A' + (NIB_) - 0xA), FP)
 #define fprint_byte(FP, BYTE_) do { \
@@ -1,8 +1,17 @@
 #pragma once
 
 #include <stdint.h>
+#include "libmio0/lz.h"
 
 #define YAY0_HEADER_LENGTH 16
+#define YAY0_MAX_LENGTH 0x111
+// longer back-references store their length in an extra chunk byte
+#define YAY0_SHORT_LENGTH 17
 
 extern int32_t yay0_encode(const uint8_t *in_buf, uint32_t length, uint8_t* out_buf);
-extern uint8_t* yay0_decode(const uint8_t* in, uint32_t* out_size);
\ No newline at end of file
+// Output needs room for the header, a 32 bit mask word per 32 input bytes and the input itself
+extern int32_t yay0_encode_effort(const uint8_t *in_buf, uint32_t length, uint8_t* out_buf, lz_effort effort);
+// Tokens have to cover all of in_buf, see lz_parse
+extern int32_t yay0_encode_tokens(const uint8_t* in_buf, uint32_t length, const lz_token* tokens, uint32_t count, uint8_t* out_buf);
+// Never reads past in_size bytes of in, returns NULL when the data is truncated or refers to bytes before its start
+extern uint8_t* yay0_decode(const uint8_t* in, uint32_t in_size, uint32_t* out_size);
\ No newline at end of file
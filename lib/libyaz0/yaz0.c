@@ -0,0 +1,139 @@
+#include "yaz0.h"
+#include "libmio0/utils.h"
+#include <string.h>
+#include <stdlib.h>
+
+int32_t yaz0_encode_tokens(const uint8_t* in_buf, uint32_t length, const lz_token* tokens, uint32_t count, uint8_t* out_buf) {
+    uint8_t* out = out_buf + YAZ0_HEADER_LENGTH;
+    uint8_t* group = NULL;
+    uint32_t bytes_proc = 0;
+
+    for(uint32_t i = 0; i < count; i++){
+        const uint32_t size = tokens[i].length;
+        const uint32_t distance = tokens[i].distance;
+
+        // every 8 tokens are preceded by their flag byte
+        if(i % 8 == 0){
+            group = out++;
+            *group = 0;
+        }
+
+        if(distance == 0){
+            *group |= 0x80 >> (i % 8);
+            *out++ = in_buf[bytes_proc];
+        } else if(size > YAZ0_SHORT_LENGTH){
+            *out++ = (distance - 1) >> 8;
+            *out++ = (distance - 1) & 0xFF;
+            *out++ = size - 18;
+        } else {
+            *out++ = ((size - 2) << 4) | ((distance - 1) >> 8);
+            *out++ = (distance - 1) & 0xFF;
+        }
+        bytes_proc += size;
+    }
+
+    memcpy(out_buf, "Yaz0", 4);
+    write_u32_be(&out_buf[4], length);
+    memset(&out_buf[8], 0, 8);
+
+    return out - out_buf;
+}
+
+int32_t yaz0_encode_effort(const uint8_t* in_buf, uint32_t length, uint8_t* out_buf, lz_effort effort) {
+    lz_token* tokens = malloc(MAX(length, 1) * sizeof(*tokens));
+    if(tokens == NULL){
+        return -1;
+    }
+
+    int32_t count = lz_parse(in_buf, 0, length, YAZ0_MAX_LENGTH, YAZ0_SHORT_LENGTH, effort, tokens);
+    if(count >= 0){
+        count = yaz0_encode_tokens(in_buf, length, tokens, count, out_buf);
+    }
+
+    free(tokens);
+    return count;
+}
+
+int32_t yaz0_encode(const uint8_t* in_buf, uint32_t length, uint8_t* out_buf) {
+    return yaz0_encode_effort(in_buf, length, out_buf, LZ_EFFORT_ORIGINAL);
+}
+
+uint8_t* yaz0_decode(const uint8_t* in, uint32_t in_size, uint32_t* out_size){
+    if(in_size < YAZ0_HEADER_LENGTH || strncmp((const char*) in, "Yaz0", 4) != 0){
+        return NULL;
+    }
+
+    const uint32_t decompressed_size = read_u32_be(in + 4);
+    const uint8_t* src = in + YAZ0_HEADER_LENGTH;
+    const uint8_t* src_end = in + in_size;
+
+    uint32_t current_mask = 0;
+    int mask_bit_counter = 0;
+    uint32_t idx = 0;
+
+    uint8_t* out = malloc(MAX(decompressed_size, 1));
+    if(out == NULL){
+        return NULL;
+    }
+
+    while(idx < decompressed_size){
+        if(mask_bit_counter == 0){
+            if(src == src_end){
+                goto fail;
+            }
+            current_mask = (uint32_t) *src++ << 24;
+            mask_bit_counter = 8;
+        }
+
+        // Literal runs are copied in one go
+        uint32_t run = count_leading_ones32(current_mask);
+        if(run > 0){
+            run = MIN(run, (uint32_t) mask_bit_counter);
+            run = MIN(run, decompressed_size - idx);
+            if((uint32_t) (src_end - src) < run){
+                goto fail;
+            }
+            current_mask <<= run;
+            mask_bit_counter -= run;
+            memcpy(out + idx, src, run);
+            src += run;
+            idx += run;
+            continue;
+        }
+
+        if(src_end - src < 2){
+            goto fail;
+        }
+        uint32_t distance = (((src[0] & 0xF) << 8) | src[1]) + 1;
+        uint32_t count = src[0] >> 4;
+        src += 2;
+
+        if(count == 0){
+            if(src == src_end){
+                goto fail;
+            }
+            count = *src++ + 18;
+        } else {
+            count += 2;
+        }
+
+        current_mask <<= 1;
+        mask_bit_counter--;
+
+        // Back-references before the start of the data only show up in corrupted blocks
+        if(distance > idx){
+            goto fail;
+        }
+
+        count = MIN(count, decompressed_size - idx);
+        lz_copy(out + idx, distance, count);
+        idx += count;
+    }
+
+    *out_size = decompressed_size;
+    return out;
+
+fail:
+    free(out);
+    return NULL;
+}
@@ -4967,6 +4967,9 @@ void *mz_zip_extract_archive_file_to_heap(const char *pZip_filename, const char
   For more information, please refer to <http://unlicense.org/>
 */
 
+// The zip_file wrapper needs the implementation above, skip it when only the declarations are wanted
+#ifndef MINIZ_HEADER_FILE_ONLY
+
 namespace miniz_cpp {
 namespace detail {
 
@@ -5727,3 +5730,5 @@ private:
 };
 
 } // namespace miniz_cpp
+
+#endif // MINIZ_HEADER_FILE_ONLY
@@ -35,10 +35,103 @@ typedef struct {
     int depth;
 } img_format;
 
+//---------------------------------------------------------
+// SIMD helpers, every kernel below has a scalar tail that also serves as the fallback
+//---------------------------------------------------------
+
+#if !defined(N64GRAPHICS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define N64GRAPHICS_SSE2 1
+
+// Byte swaps every 16-bit lane, N64 textures are big endian
+static inline __m128i sse2_bswap16(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+// SCALE_5_8 on 16-bit lanes: x * 255 / 31 == 8x + 7x / 31, the division is exact through mulhi for x < 32
+static inline __m128i sse2_scale_5_8(__m128i v) {
+    const __m128i seven = _mm_mullo_epi16(v, _mm_set1_epi16(7));
+    return _mm_add_epi16(_mm_slli_epi16(v, 3), _mm_mulhi_epu16(seven, _mm_set1_epi16(2115)));
+}
+
+// SCALE_8_5 on 16-bit lanes, y / 255 == (y + 1 + (y >> 8)) >> 8 for y < 65535
+static inline __m128i sse2_scale_8_5(__m128i v) {
+    const __m128i y = _mm_mullo_epi16(_mm_add_epi16(v, _mm_set1_epi16(4)), _mm_set1_epi16(31));
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(y, _mm_set1_epi16(1)), _mm_srli_epi16(y, 8)), 8);
+}
+
+// SCALE_4_8 on 8-bit lanes holding values below 16
+static inline __m128i sse2_scale_4_8(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 4), v);
+}
+
+// SCALE_8_4 and SCALE_8_3 on 16-bit lanes holding values below 256
+static inline __m128i sse2_scale_8_4(__m128i v) {
+    return _mm_mulhi_epu16(v, _mm_set1_epi16(3856));
+}
+
+static inline __m128i sse2_scale_8_3(__m128i v) {
+    return _mm_mulhi_epu16(v, _mm_set1_epi16(1821));
+}
+
+// Splits 16 bytes into their high and low nibbles
+static inline void sse2_split_nibbles(__m128i v, __m128i* hi, __m128i* lo) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    *hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    *lo = _mm_and_si128(v, mask);
+}
+
+// Joins 16-bit lanes holding two nibbles (even pixel in the low byte) into one byte each, (even << 4 | odd) & 0xFF
+static inline __m128i sse2_join_nibbles(__m128i v) {
+    const __m128i joined = _mm_or_si128(_mm_slli_epi16(v, 4), _mm_srli_epi16(v, 8));
+    return _mm_and_si128(joined, _mm_set1_epi16(0xFF));
+}
+#endif
+
+static int invalid_depth(int depth) {
+    ERROR("Error invalid depth %d\n", depth);
+    return -1;
+}
+
 //---------------------------------------------------------
 // N64 RGBA/IA/I/CI -> internal RGBA/IA
 //---------------------------------------------------------
 
+int raw2rgba_into(rgba* img, const uint8_t* raw, int width, int height, int depth) {
+    const int count = width * height;
+    int i = 0;
+
+    switch (depth) {
+        case 16:
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 8 <= count; i += 8) {
+                const __m128i v = sse2_bswap16(_mm_loadu_si128((const __m128i*) (raw + i * 2)));
+                const __m128i mask = _mm_set1_epi16(0x1F);
+                const __m128i r = sse2_scale_5_8(_mm_and_si128(_mm_srli_epi16(v, 11), mask));
+                const __m128i g = sse2_scale_5_8(_mm_and_si128(_mm_srli_epi16(v, 6), mask));
+                const __m128i b = sse2_scale_5_8(_mm_and_si128(_mm_srli_epi16(v, 1), mask));
+                const __m128i a = _mm_and_si128(_mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(v, _mm_set1_epi16(1))), _mm_set1_epi16(0xFF));
+                const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+                const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+                _mm_storeu_si128((__m128i*) (img + i), _mm_unpacklo_epi16(rg, ba));
+                _mm_storeu_si128((__m128i*) (img + i + 4), _mm_unpackhi_epi16(rg, ba));
+            }
+#endif
+            for (; i < count; i++) {
+                img[i].red = SCALE_5_8((raw[i * 2] & 0xF8) >> 3);
+                img[i].green = SCALE_5_8(((raw[i * 2] & 0x07) << 2) | ((raw[i * 2 + 1] & 0xC0) >> 6));
+                img[i].blue = SCALE_5_8((raw[i * 2 + 1] & 0x3E) >> 1);
+                img[i].alpha = (raw[i * 2 + 1] & 0x01) ? 0xFF : 0x00;
+            }
+            return 0;
+        case 32:
+            memcpy(img, raw, count * sizeof(rgba));
+            return 0;
+        default:
+            return invalid_depth(depth);
+    }
+}
+
 rgba* raw2rgba(const uint8_t* raw, int width, int height, int depth) {
     rgba* img;
     int img_size;
@@ -50,51 +143,55 @@ rgba* raw2rgba(const uint8_t* raw, int width, int height, int depth) {
         return NULL;
     }
 
-    if (depth == 16) {
-        for (int i = 0; i < width * height; i++) {
-            img[i].red = SCALE_5_8((raw[i * 2] & 0xF8) >> 3);
-            img[i].green = SCALE_5_8(((raw[i * 2] & 0x07) << 2) | ((raw[i * 2 + 1] & 0xC0) >> 6));
-            img[i].blue = SCALE_5_8((raw[i * 2 + 1] & 0x3E) >> 1);
-            img[i].alpha = (raw[i * 2 + 1] & 0x01) ? 0xFF : 0x00;
-        }
-    } else if (depth == 32) {
-        for (int i = 0; i < width * height; i++) {
-            img[i].red = raw[i * 4];
-            img[i].green = raw[i * 4 + 1];
-            img[i].blue = raw[i * 4 + 2];
-            img[i].alpha = raw[i * 4 + 3];
-        }
-    }
-
+    raw2rgba_into(img, raw, width, height, depth);
     return img;
 }
 
-ia* raw2ia(const uint8_t* raw, int width, int height, int depth) {
-    ia* img;
-    int img_size;
+// Expands 16 intensity and 16 alpha bytes into 16 IA pixels
+#ifdef N64GRAPHICS_SSE2
+static inline void sse2_store_ia(ia* img, __m128i intensity, __m128i alpha) {
+    _mm_storeu_si128((__m128i*) img, _mm_unpacklo_epi8(intensity, alpha));
+    _mm_storeu_si128((__m128i*) (img + 8), _mm_unpackhi_epi8(intensity, alpha));
+}
+#endif
 
-    img_size = width * height * sizeof(*img);
-    img = malloc(img_size);
-    if (!img) {
-        ERROR("Error allocating %u bytes\n", img_size);
-        return NULL;
-    }
+int raw2ia_into(ia* img, const uint8_t* raw, int width, int height, int depth) {
+    const int count = width * height;
+    int i = 0;
 
     switch (depth) {
         case 16:
-            for (int i = 0; i < width * height; i++) {
-                img[i].intensity = raw[i * 2];
-                img[i].alpha = raw[i * 2 + 1];
-            }
-            break;
+            memcpy(img, raw, count * sizeof(ia));
+            return 0;
         case 8:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                __m128i hi, lo;
+                sse2_split_nibbles(_mm_loadu_si128((const __m128i*) (raw + i)), &hi, &lo);
+                sse2_store_ia(img + i, sse2_scale_4_8(hi), sse2_scale_4_8(lo));
+            }
+#endif
+            for (; i < count; i++) {
                 img[i].intensity = SCALE_4_8((raw[i] & 0xF0) >> 4);
                 img[i].alpha = SCALE_4_8(raw[i] & 0x0F);
             }
-            break;
+            return 0;
         case 4:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 32 <= count; i += 32) {
+                __m128i hi, lo;
+                sse2_split_nibbles(_mm_loadu_si128((const __m128i*) (raw + i / 2)), &hi, &lo);
+                for (int k = 0; k < 2; k++) {
+                    const __m128i bits = k ? _mm_unpackhi_epi8(hi, lo) : _mm_unpacklo_epi8(hi, lo);
+                    const __m128i val = _mm_and_si128(_mm_srli_epi16(bits, 1), _mm_set1_epi8(0x07));
+                    // SCALE_3_8, val * 0x24 never leaves its byte
+                    const __m128i intensity = _mm_add_epi8(_mm_slli_epi16(val, 5), _mm_slli_epi16(val, 2));
+                    const __m128i alpha = _mm_cmpeq_epi8(_mm_and_si128(bits, _mm_set1_epi8(1)), _mm_set1_epi8(1));
+                    sse2_store_ia(img + i + k * 16, intensity, alpha);
+                }
+            }
+#endif
+            for (; i < count; i++) {
                 uint8_t bits;
                 bits = raw[i / 2];
                 if (i % 2) {
@@ -105,9 +202,9 @@ ia* raw2ia(const uint8_t* raw, int width, int height, int depth) {
                 img[i].intensity = SCALE_3_8((bits >> 1) & 0x07);
                 img[i].alpha = (bits & 0x01) ? 0xFF : 0x00;
             }
-            break;
+            return 0;
         case 1:
-            for (int i = 0; i < width * height; i++) {
+            for (; i < count; i++) {
                 uint8_t bits;
                 uint8_t mask;
                 bits = raw[i / 8];
@@ -116,17 +213,14 @@ ia* raw2ia(const uint8_t* raw, int width, int height, int depth) {
                 img[i].intensity = bits;
                 img[i].alpha = bits;
             }
-            break;
+            return 0;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-            break;
+            return invalid_depth(depth);
     }
-
-    return img;
 }
 
-ci *raw2ci_torch(const uint8_t* raw, int width, int height, int depth) {
-    ci *img = NULL;
+ia* raw2ia(const uint8_t* raw, int width, int height, int depth) {
+    ia* img;
     int img_size;
 
     img_size = width * height * sizeof(*img);
@@ -136,28 +230,39 @@ ci *raw2ci_torch(const uint8_t* raw, int width, int height, int depth) {
         return NULL;
     }
 
+    raw2ia_into(img, raw, width, height, depth);
+    return img;
+}
+
+int raw2ci_torch_into(ci* img, const uint8_t* raw, int width, int height, int depth) {
+    const int count = width * height;
+    int i = 0;
+
     switch (depth) {
         case 8:
-            for (int i = 0; i < width * height; i++) {
-                img[i].index = raw[i];
-            }
-        break;
+            memcpy(img, raw, count * sizeof(ci));
+            return 0;
         case 4:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 32 <= count; i += 32) {
+                __m128i hi, lo;
+                sse2_split_nibbles(_mm_loadu_si128((const __m128i*) (raw + i / 2)), &hi, &lo);
+                _mm_storeu_si128((__m128i*) (img + i), _mm_unpacklo_epi8(hi, lo));
+                _mm_storeu_si128((__m128i*) (img + i + 16), _mm_unpackhi_epi8(hi, lo));
+            }
+#endif
+            for (; i < count; i++) {
                 int pos = i / 2;
                 img[i].index = i % 2 ? raw[pos] & 0xF : raw[pos] >> 4;
             }
-        break;
+            return 0;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-        break;
+            return invalid_depth(depth);
     }
-
-    return img;
 }
 
-ia* raw2i(const uint8_t* raw, int width, int height, int depth) {
-    ia* img = NULL;
+ci *raw2ci_torch(const uint8_t* raw, int width, int height, int depth) {
+    ci *img = NULL;
     int img_size;
 
     img_size = width * height * sizeof(*img);
@@ -167,15 +272,38 @@ ia* raw2i(const uint8_t* raw, int width, int height, int depth) {
         return NULL;
     }
 
+    raw2ci_torch_into(img, raw, width, height, depth);
+    return img;
+}
+
+int raw2i_into(ia* img, const uint8_t* raw, int width, int height, int depth) {
+    const int count = width * height;
+    int i = 0;
+
     switch (depth) {
         case 8:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                sse2_store_ia(img + i, _mm_loadu_si128((const __m128i*) (raw + i)), _mm_set1_epi8((char) 0xFF));
+            }
+#endif
+            for (; i < count; i++) {
                 img[i].intensity = raw[i];
                 img[i].alpha = 0xFF;
             }
-            break;
+            return 0;
         case 4:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 32 <= count; i += 32) {
+                __m128i hi, lo;
+                sse2_split_nibbles(_mm_loadu_si128((const __m128i*) (raw + i / 2)), &hi, &lo);
+                hi = sse2_scale_4_8(hi);
+                lo = sse2_scale_4_8(lo);
+                sse2_store_ia(img + i, _mm_unpacklo_epi8(hi, lo), _mm_set1_epi8((char) 0xFF));
+                sse2_store_ia(img + i + 16, _mm_unpackhi_epi8(hi, lo), _mm_set1_epi8((char) 0xFF));
+            }
+#endif
+            for (; i < count; i++) {
                 uint8_t bits;
                 bits = raw[i / 2];
                 if (i % 2) {
@@ -186,15 +314,46 @@ ia* raw2i(const uint8_t* raw, int width, int height, int depth) {
                 img[i].intensity = SCALE_4_8(bits);
                 img[i].alpha = 0xFF;
             }
-            break;
+            return 0;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-            break;
+            return invalid_depth(depth);
+    }
+}
+
+ia* raw2i(const uint8_t* raw, int width, int height, int depth) {
+    ia* img = NULL;
+    int img_size;
+
+    img_size = width * height * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %u bytes\n", img_size);
+        return NULL;
     }
 
+    raw2i_into(img, raw, width, height, depth);
     return img;
 }
 
+void ci2raw_into(uint8_t* raw, const uint8_t* rawci, const uint8_t* palette, int width, int height, int ci_depth) {
+    const int count = width * height;
+
+    if (ci_depth == 4) {
+        for (int i = 0; i + 1 < count; i += 2) {
+            memcpy(raw + i * 2, palette + 2 * (rawci[i / 2] >> 4), 2);
+            memcpy(raw + i * 2 + 2, palette + 2 * (rawci[i / 2] & 0xF), 2);
+        }
+        if (count % 2) {
+            memcpy(raw + (count - 1) * 2, palette + 2 * (rawci[count / 2] >> 4), 2);
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        memcpy(raw + i * 2, palette + 2 * rawci[i], 2);
+    }
+}
+
 // convert CI raw data and palette to raw data (either RGBA16 or IA16)
 uint8_t* ci2raw(const uint8_t* rawci, const uint8_t* palette, int width, int height, int ci_depth) {
     uint8_t* raw;
@@ -208,18 +367,7 @@ uint8_t* ci2raw(const uint8_t* rawci, const uint8_t* palette, int width, int hei
         return NULL;
     }
 
-    for (int i = 0; i < width * height; i++) {
-        int pal_idx = rawci[i];
-        if (ci_depth == 4) {
-            int byte_idx = i / 2;
-            int nibble = 1 - (i % 2);
-            int shift = 4 * nibble;
-            pal_idx = (rawci[byte_idx] >> shift) & 0xF;
-        }
-        raw[2 * i] = palette[2 * pal_idx];
-        raw[2 * i + 1] = palette[2 * pal_idx + 1];
-    }
-
+    ci2raw_into(raw, rawci, palette, width, height, ci_depth);
     return raw;
 }
 
@@ -229,11 +377,30 @@ uint8_t* ci2raw(const uint8_t* rawci, const uint8_t* palette, int width, int hei
 //---------------------------------------------------------
 
 int rgba2raw(uint8_t* raw, const rgba* img, int width, int height, int depth) {
+    const int count = width * height;
     int size = width * height * depth / 8;
+    int i = 0;
     INFO("Converting RGBA%d %dx%d to raw\n", depth, width, height);
 
     if (depth == 16) {
-        for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+        for (; i + 8 <= count; i += 8) {
+            const __m128i p0 = _mm_loadu_si128((const __m128i*) (img + i));
+            const __m128i p1 = _mm_loadu_si128((const __m128i*) (img + i + 4));
+            const __m128i byte = _mm_set1_epi32(0xFF);
+            const __m128i r = _mm_packs_epi32(_mm_and_si128(p0, byte), _mm_and_si128(p1, byte));
+            const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), byte), _mm_and_si128(_mm_srli_epi32(p1, 8), byte));
+            const __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), byte), _mm_and_si128(_mm_srli_epi32(p1, 16), byte));
+            const __m128i a = _mm_packs_epi32(_mm_srli_epi32(p0, 24), _mm_srli_epi32(p1, 24));
+            const __m128i a1 = _mm_andnot_si128(_mm_cmpeq_epi16(a, _mm_setzero_si128()), _mm_set1_epi16(1));
+            __m128i v = _mm_slli_epi16(sse2_scale_8_5(r), 11);
+            v = _mm_or_si128(v, _mm_slli_epi16(sse2_scale_8_5(g), 6));
+            v = _mm_or_si128(v, _mm_slli_epi16(sse2_scale_8_5(b), 1));
+            v = _mm_or_si128(v, a1);
+            _mm_storeu_si128((__m128i*) (raw + i * 2), sse2_bswap16(v));
+        }
+#endif
+        for (; i < count; i++) {
             uint8_t r, g, b, a;
             r = SCALE_8_5(img[i].red);
             g = SCALE_8_5(img[i].green);
@@ -243,40 +410,57 @@ int rgba2raw(uint8_t* raw, const rgba* img, int width, int height, int depth) {
             raw[i * 2 + 1] = ((g & 0x3) << 6) | (b << 1) | a;
         }
     } else if (depth == 32) {
-        for (int i = 0; i < width * height; i++) {
-            raw[i * 4] = img[i].red;
-            raw[i * 4 + 1] = img[i].green;
-            raw[i * 4 + 2] = img[i].blue;
-            raw[i * 4 + 3] = img[i].alpha;
-        }
+        memcpy(raw, img, count * sizeof(rgba));
     } else {
-        ERROR("Error invalid depth %d\n", depth);
-        size = -1;
+        size = invalid_depth(depth);
     }
 
     return size;
 }
 
 int ia2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
+    const int count = width * height;
     int size = width * height * depth / 8;
+    int i = 0;
     INFO("Converting IA%d %dx%d to raw\n", depth, width, height);
 
     switch (depth) {
         case 16:
-            for (int i = 0; i < width * height; i++) {
-                raw[i * 2] = img[i].intensity;
-                raw[i * 2 + 1] = img[i].alpha;
-            }
+            memcpy(raw, img, count * sizeof(ia));
             break;
         case 8:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                const __m128i p0 = _mm_loadu_si128((const __m128i*) (img + i));
+                const __m128i p1 = _mm_loadu_si128((const __m128i*) (img + i + 8));
+                const __m128i byte = _mm_set1_epi16(0xFF);
+                const __m128i v0 = _mm_or_si128(_mm_slli_epi16(sse2_scale_8_4(_mm_and_si128(p0, byte)), 4), sse2_scale_8_4(_mm_srli_epi16(p0, 8)));
+                const __m128i v1 = _mm_or_si128(_mm_slli_epi16(sse2_scale_8_4(_mm_and_si128(p1, byte)), 4), sse2_scale_8_4(_mm_srli_epi16(p1, 8)));
+                _mm_storeu_si128((__m128i*) (raw + i), _mm_packus_epi16(v0, v1));
+            }
+#endif
+            for (; i < count; i++) {
                 uint8_t val = SCALE_8_4(img[i].intensity);
                 uint8_t alpha = SCALE_8_4(img[i].alpha);
                 raw[i] = (val << 4) | alpha;
             }
             break;
         case 4:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                const __m128i byte = _mm_set1_epi16(0xFF);
+                __m128i nibbles[2];
+                for (int k = 0; k < 2; k++) {
+                    const __m128i p = _mm_loadu_si128((const __m128i*) (img + i + k * 8));
+                    const __m128i val = sse2_scale_8_3(_mm_and_si128(p, byte));
+                    const __m128i alpha = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_srli_epi16(p, 8), _mm_setzero_si128()), _mm_set1_epi16(1));
+                    nibbles[k] = _mm_or_si128(_mm_slli_epi16(val, 1), alpha);
+                }
+                const __m128i joined = sse2_join_nibbles(_mm_packus_epi16(nibbles[0], nibbles[1]));
+                _mm_storel_epi64((__m128i*) (raw + i / 2), _mm_packus_epi16(joined, joined));
+            }
+#endif
+            for (; i < count; i++) {
                 uint8_t val = SCALE_8_3(img[i].intensity);
                 uint8_t alpha = img[i].alpha ? 0x01 : 0x00;
                 uint8_t old = raw[i / 2];
@@ -288,7 +472,7 @@ int ia2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
             }
             break;
         case 1:
-            for (int i = 0; i < width * height; i++) {
+            for (; i < count; i++) {
                 uint8_t val = img[i].intensity;
                 uint8_t old = raw[i / 8];
                 uint8_t bit = 1 << (7 - (i % 8));
@@ -300,8 +484,7 @@ int ia2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
             }
             break;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-            size = -1;
+            size = invalid_depth(depth);
             break;
     }
 
@@ -382,17 +565,36 @@ int imgpal2rawci(uint8_t *rawci, const rgba *img, const rgba *pal, const uint8_t
 }
 
 int i2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
+    const int count = width * height;
     int size = width * height * depth / 8;
+    int i = 0;
     INFO("Converting I%d %dx%d to raw\n", depth, width, height);
 
     switch (depth) {
         case 8:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                const __m128i byte = _mm_set1_epi16(0xFF);
+                const __m128i p0 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (img + i)), byte);
+                const __m128i p1 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (img + i + 8)), byte);
+                _mm_storeu_si128((__m128i*) (raw + i), _mm_packus_epi16(p0, p1));
+            }
+#endif
+            for (; i < count; i++) {
                 raw[i] = img[i].intensity;
             }
             break;
         case 4:
-            for (int i = 0; i < width * height; i++) {
+#ifdef N64GRAPHICS_SSE2
+            for (; i + 16 <= count; i += 16) {
+                const __m128i byte = _mm_set1_epi16(0xFF);
+                const __m128i v0 = sse2_scale_8_4(_mm_and_si128(_mm_loadu_si128((const __m128i*) (img + i)), byte));
+                const __m128i v1 = sse2_scale_8_4(_mm_and_si128(_mm_loadu_si128((const __m128i*) (img + i + 8)), byte));
+                const __m128i joined = sse2_join_nibbles(_mm_packus_epi16(v0, v1));
+                _mm_storel_epi64((__m128i*) (raw + i / 2), _mm_packus_epi16(joined, joined));
+            }
+#endif
+            for (; i < count; i++) {
                 uint8_t val = SCALE_8_4(img[i].intensity);
                 uint8_t old = raw[i / 2];
                 if (i % 2) {
@@ -403,8 +605,7 @@ int i2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
             }
             break;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-            size = -1;
+            size = invalid_depth(depth);
             break;
     }
 
@@ -412,30 +613,44 @@ int i2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
 }
 
 int ci2raw_torch(uint8_t *raw, const ci *img, int width, int height, int depth) {
+    const int count = width * height;
     int size = width * height * depth / 8;
+    int i = 0;
     INFO("Converting I%d %dx%d to raw\n", depth, width, height);
 
     switch (depth) {
         case 8:
-            for (int i = 0; i < width * height; i++) {
-                raw[i] = img[i].index;
-            }
+            memcpy(raw, img, count * sizeof(ci));
         break;
         case 4:
+            // Rows of odd width pack their last pixel with the first one of the next row
+            if (width % 2 == 0) {
+#ifdef N64GRAPHICS_SSE2
+                for (; i + 32 <= count; i += 32) {
+                    const __m128i v0 = sse2_join_nibbles(_mm_loadu_si128((const __m128i*) (img + i)));
+                    const __m128i v1 = sse2_join_nibbles(_mm_loadu_si128((const __m128i*) (img + i + 16)));
+                    _mm_storeu_si128((__m128i*) (raw + i / 2), _mm_packus_epi16(v0, v1));
+                }
+#endif
+                for (; i < count; i += 2) {
+                    raw[i / 2] = img[i].index << 4 | img[i + 1].index;
+                }
+                break;
+            }
+
             for(int y = 0; y < height; y++) {
                 for(int x = 0; x < width; x += 2) {
                     const size_t pos = (y * width + x) / 2;
 
                     const uint8_t cR1 = img[y * width + x].index;
-                    const uint8_t cR2 = img[y * width + x + 1].index;
+                    const uint8_t cR2 = y * width + x + 1 < count ? img[y * width + x + 1].index : 0;
 
                     raw[pos] = cR1 << 4 | cR2;
                 }
             }
         break;
         default:
-            ERROR("Error invalid depth %d\n", depth);
-        size = -1;
+            size = invalid_depth(depth);
         break;
     }
 
@@ -518,33 +733,13 @@ int ci2png(unsigned char **png_output, int *size_output, const ci *img, int widt
 // PNG -> internal RGBA/IA
 //---------------------------------------------------------
 
-rgba* png2rgba(unsigned char* png_input, int size_input, int* width, int* height) {
-    rgba* img = NULL;
-    int w = 0;
-    int h = 0;
-    int channels = 0;
-    int img_size;
-
-    stbi_uc* data = stbi_load_from_memory(png_input, size_input, &w, &h, &channels, STBI_default);
-    if (!data || w <= 0 || h <= 0) {
-        ERROR("Error loading file\n");
-        return NULL;
-    }
-    INFO("Read %dx%d channels: %d\n", w, h, channels);
-
-    img_size = w * h * sizeof(rgba);
-    img = malloc(img_size);
-    if (!img) {
-        ERROR("Error allocating %u bytes\n", img_size);
-        return NULL;
-    }
-
+int pixels2rgba_into(rgba* img, const uint8_t* data, int width, int height, int channels) {
     switch (channels) {
         case 3: // red, green, blue
         case 4: // red, green, blue, alpha
-            for (int j = 0; j < h; j++) {
-                for (int i = 0; i < w; i++) {
-                    int idx = j * w + i;
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    int idx = j * width + i;
                     img[idx].red = data[channels * idx];
                     img[idx].green = data[channels * idx + 1];
                     img[idx].blue = data[channels * idx + 2];
@@ -557,9 +752,9 @@ rgba* png2rgba(unsigned char* png_input, int size_input, int* width, int* height
             }
             break;
         case 2: // grey, alpha
-            for (int j = 0; j < h; j++) {
-                for (int i = 0; i < w; i++) {
-                    int idx = j * w + i;
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    int idx = j * width + i;
                     img[idx].red = data[2 * idx];
                     img[idx].green = data[2 * idx];
                     img[idx].blue = data[2 * idx];
@@ -569,8 +764,35 @@ rgba* png2rgba(unsigned char* png_input, int size_input, int* width, int* height
             break;
         default:
             ERROR("Don't know how to read channels: %d\n", channels);
-            free(img);
-            img = NULL;
+            return -1;
+    }
+    return 0;
+}
+
+rgba* png2rgba(unsigned char* png_input, int size_input, int* width, int* height) {
+    rgba* img = NULL;
+    int w = 0;
+    int h = 0;
+    int channels = 0;
+    int img_size;
+
+    stbi_uc* data = stbi_load_from_memory(png_input, size_input, &w, &h, &channels, STBI_default);
+    if (!data || w <= 0 || h <= 0) {
+        ERROR("Error loading file\n");
+        return NULL;
+    }
+    INFO("Read %dx%d channels: %d\n", w, h, channels);
+
+    img_size = w * h * sizeof(rgba);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %u bytes\n", img_size);
+        return NULL;
+    }
+
+    if (pixels2rgba_into(img, data, w, h, channels)) {
+        free(img);
+        img = NULL;
     }
 
     // cleanup
@@ -638,33 +860,14 @@ rgb* png2rgb(unsigned char* png_input, int size_input, int* width, int* height)
     return img;
 }
 
-ia* png2ia(unsigned char* png_input, int size_input, int* width, int* height) {
-    ia* img = NULL;
-    int w = 0, h = 0;
-    int channels = 0;
-    int img_size;
-
-    stbi_uc* data = stbi_load_from_memory(png_input, size_input, &w, &h, &channels, STBI_default);
-    if (!data || w <= 0 || h <= 0) {
-        ERROR("Error loading file\n");
-        return NULL;
-    }
-    INFO("Read %dx%d channels: %d\n", w, h, channels);
-
-    img_size = w * h * sizeof(*img);
-    img = malloc(img_size);
-    if (!img) {
-        ERROR("Error allocating %d bytes\n", img_size);
-        return NULL;
-    }
-
+int pixels2ia_into(ia* img, const uint8_t* data, int width, int height, int channels) {
     switch (channels) {
         case 3: // red, green, blue
         case 4: // red, green, blue, alpha
             ERROR("Warning: averaging RGB PNG to create IA\n");
-            for (int j = 0; j < h; j++) {
-                for (int i = 0; i < w; i++) {
-                    int idx = j * w + i;
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    int idx = j * width + i;
                     int sum = data[channels * idx] + data[channels * idx + 1] + data[channels * idx + 2];
                     img[idx].intensity = (sum + 1) / 3; // add 1 to round up where appropriate
                     if (channels == 4) {
@@ -676,9 +879,9 @@ ia* png2ia(unsigned char* png_input, int size_input, int* width, int* height) {
             }
             break;
         case 2: // grey, alpha
-            for (int j = 0; j < h; j++) {
-                for (int i = 0; i < w; i++) {
-                    int idx = j * w + i;
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    int idx = j * width + i;
                     img[idx].intensity = data[2 * idx];
                     img[idx].alpha = data[2 * idx + 1];
                 }
@@ -686,8 +889,34 @@ ia* png2ia(unsigned char* png_input, int size_input, int* width, int* height) {
             break;
         default:
             ERROR("Don't know how to read channels: %d\n", channels);
-            free(img);
-            img = NULL;
+            return -1;
+    }
+    return 0;
+}
+
+ia* png2ia(unsigned char* png_input, int size_input, int* width, int* height) {
+    ia* img = NULL;
+    int w = 0, h = 0;
+    int channels = 0;
+    int img_size;
+
+    stbi_uc* data = stbi_load_from_memory(png_input, size_input, &w, &h, &channels, STBI_default);
+    if (!data || w <= 0 || h <= 0) {
+        ERROR("Error loading file\n");
+        return NULL;
+    }
+    INFO("Read %dx%d channels: %d\n", w, h, channels);
+
+    img_size = w * h * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %d bytes\n", img_size);
+        return NULL;
+    }
+
+    if (pixels2ia_into(img, data, w, h, channels)) {
+        free(img);
+        img = NULL;
     }
 
     // cleanup
@@ -822,28 +1051,31 @@ const char* n64graphics_get_write_version(void) {
  * Converts binary ci8 + palette to a single .png
  */
 int convert_raw_to_ci8(unsigned char **png_output, int *size_output, uint8_t *texture, uint8_t *palette, int format, int width, int height, int depth, int pal_depth) {
+    const int count = width * height;
     uint8_t *raw_fmt;
     rgba *imgr;
-    ia   *imgi;
     int res;
 
-    raw_fmt = ci2raw(texture, palette, width, height, depth);
+    // The palette lookup and the RGBA conversion share one allocation
+    raw_fmt = malloc(count * (sizeof(uint16_t) + sizeof(rgba)));
+    if (!raw_fmt) {
+        ERROR("Error allocating %u bytes\n", count * (int) (sizeof(uint16_t) + sizeof(rgba)));
+        return EXIT_FAILURE;
+    }
+
+    ci2raw_into(raw_fmt, texture, palette, width, height, depth);
     switch (format) {
         case IMG_FORMAT_RGBA:
             INFO("Converting raw to RGBA%d\n", pal_depth);
-            imgr = raw2rgba(raw_fmt, width, height, pal_depth);
+            imgr = (rgba*) (raw_fmt + count * sizeof(uint16_t));
+            raw2rgba_into(imgr, raw_fmt, width, height, pal_depth);
             res = rgba2png(png_output, size_output, imgr, width, height);
-            free(imgr);
-            break;
-        case IMG_FORMAT_IA:
-            INFO("Converting raw to IA%d\n", pal_depth);
-            imgi = raw2ia(raw_fmt, width, height, pal_depth);
-            //res = ia2png(name, imgi, width, height);
-            free(imgi);
             break;
         default:
             //ERROR("Unsupported palette format: %s\n", format2str(&config.pal_format));
-            return EXIT_FAILURE;
+            res = EXIT_FAILURE;
+            break;
     }
     free(raw_fmt);
+    return res;
 }
\ No newline at end of file
@@ -57,6 +57,12 @@ ia *raw2i(const uint8_t *raw, int width, int height, int depth);
 // N64 raw CI4/CI8 -> intermediate CI
 ci *raw2ci_torch(const uint8_t* raw, int width, int height, int depth);
 
+// Same conversions writing into a caller provided buffer of width * height pixels, return 0 or -1 on an invalid depth
+int raw2rgba_into(rgba* img, const uint8_t* raw, int width, int height, int depth);
+int raw2ia_into(ia* img, const uint8_t* raw, int width, int height, int depth);
+int raw2i_into(ia* img, const uint8_t* raw, int width, int height, int depth);
+int raw2ci_torch_into(ci* img, const uint8_t* raw, int width, int height, int depth);
+
 int convert_raw_to_ci8(unsigned char **png_output, int *size_output, uint8_t *texture, uint8_t *palette, int format, int width, int height, int depth, int pal_depth);
 
 int imgpal2rawci(uint8_t *rawci, const rgba *img, const rgba *pal, const uint8_t *wheel_mask, int raw_size, int ci_depth, int img_size, int pal_size);
@@ -84,6 +90,7 @@ int ci2raw_torch(uint8_t* raw, const ci* img, int width, int height, int depth);
 
 // N64 CI raw data and palette to raw data (either RGBA16 or IA16)
 uint8_t *ci2raw(const uint8_t *rawci, const uint8_t *palette, int width, int height, int ci_depth);
+void ci2raw_into(uint8_t *raw, const uint8_t *rawci, const uint8_t *palette, int width, int height, int ci_depth);
 
 // convert from raw (RGBA16 or IA16) format to CI + palette
 int raw2ci(uint8_t *rawci, palette_t *pal, const uint8_t *raw, int raw_len, int ci_depth);
@@ -116,6 +123,10 @@ ia *png2ia(unsigned char* png_input, int size_input, int *width, int *height);
 // PNG file -> intermediate CI
 ci* png2ci(unsigned char* png_input, int size_input, int* width, int* height);
 
+// Already decoded 2 to 4 channel PNG pixels -> intermediate RGBA/IA, return 0 or -1 on an unsupported channel count
+int pixels2rgba_into(rgba* img, const uint8_t* data, int width, int height, int channels);
+int pixels2ia_into(ia* img, const uint8_t* data, int width, int height, int channels);
+
 // Adds colours to palette data
 static int pal_add_color(palette_t* pal, uint16_t val);
 
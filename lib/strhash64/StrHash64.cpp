@@ -83,6 +83,7 @@
 */
 
 #include <stdint.h>
+#include <string.h>
 
 #define u8 uint8_t
 #define u16 uint16_t
@@ -224,14 +225,51 @@ static const u64 CRC64_Table[256] = {
         CONST64(0xd80c07cd676f8394), CONST64(0x9afce626ce85b507)
 };
 
-uint64_t update_crc64(const void* buf, unint len, u64 crc)
+/*
+ * Slicing-by-8 tables, CRC64_Slices[k][b] is the CRC of byte b followed by k zero bytes.
+ * This lets the loops below fold 8 input bytes per step instead of one.
+ */
+struct CRC64SliceTables {
+    u64 t[8][256];
+};
+
+static constexpr CRC64SliceTables MakeSliceTables() {
+    CRC64SliceTables tables = {};
+    for (int b = 0; b < 256; b++) {
+        tables.t[0][b] = CRC64_Table[b];
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int b = 0; b < 256; b++) {
+            const u64 prev = tables.t[k - 1][b];
+            tables.t[k][b] = CRC64_Table[(u8)(prev >> 56)] ^ (prev << 8);
+        }
+    }
+    return tables;
+}
+
+static constexpr CRC64SliceTables CRC64_Slices = MakeSliceTables();
+
+static u64 crc64_slice8(const u8* b, size_t len, u64 crc)
 {
-    const u8* b = (const u8*)buf;
-    unint		i;
-    for (i = 0; i < len; i++) {
+    while (len >= 8) {
+        const u64 x = crc ^ (((u64)b[0] << 56) | ((u64)b[1] << 48) | ((u64)b[2] << 40) | ((u64)b[3] << 32) |
+                             ((u64)b[4] << 24) | ((u64)b[5] << 16) | ((u64)b[6] << 8) | (u64)b[7]);
+        crc = CRC64_Slices.t[7][(u8)(x >> 56)] ^ CRC64_Slices.t[6][(u8)(x >> 48)] ^
+              CRC64_Slices.t[5][(u8)(x >> 40)] ^ CRC64_Slices.t[4][(u8)(x >> 32)] ^
+              CRC64_Slices.t[3][(u8)(x >> 24)] ^ CRC64_Slices.t[2][(u8)(x >> 16)] ^
+              CRC64_Slices.t[1][(u8)(x >> 8)] ^ CRC64_Slices.t[0][(u8)x];
+        b += 8;
+        len -= 8;
+    }
+    while (len--) {
         crc = CRC64_Table[(u8)(crc >> 56) ^ *b++] ^ (crc << 8);
     }
-    return ~crc;
+    return crc;
+}
+
+uint64_t update_crc64(const void* buf, unint len, u64 crc)
+{
+    return ~crc64_slice8((const u8*)buf, len, crc);
 }
 
 u64 crc64(const void* buf, unint len)
@@ -241,10 +279,10 @@ u64 crc64(const void* buf, unint len)
 
 u64 CRC64(const char* t)
 {
-    u64		crc = INITIAL_CRC64;
-    const u8* s = (const u8*)t;
-    while (*s) {
-        crc = CRC64_Table[(u8)(crc >> 56) ^ *s++] ^ (crc << 8);
-    }
-    return crc;
-}
\ No newline at end of file
+    return crc64_slice8((const u8*)t, strlen(t), INITIAL_CRC64);
+}
+
+u64 CRC64N(const char* t, size_t len)
+{
+    return crc64_slice8((const u8*)t, len, INITIAL_CRC64);
+}
@@ -85,9 +85,12 @@
 */
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define INITIAL_CRC64 0xffffffffffffffffULL
 
 extern uint64_t update_crc64(const void* buf, uint32_t len, uint64_t crc);
 extern uint64_t crc64(const void* buf, uint32_t len);
-extern uint64_t CRC64(const char* t);
\ No newline at end of file
+extern uint64_t CRC64(const char* t);
+// Same as CRC64 for strings whose length is already known
+extern uint64_t CRC64N(const char* t, size_t len);
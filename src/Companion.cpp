@@ -2,6 +2,9 @@
 
 #include "utils/Decompressor.h"
 #include "utils/TorchUtils.h"
+#include "utils/ModdingCache.h"
+#include "utils/DecompressionCache.h"
+#include "utils/FileWriter.h"
 #include "archive/SWrapper.h"
 #include "archive/ZWrapper.h"
 #include "spdlog/spdlog.h"
@@ -10,6 +13,7 @@
 #include <regex>
 #include <fstream>
 #include <iostream>
+#include <iomanip>
 #include <filesystem>
 
 #include "factories/GenericArrayFactory.h"
@@ -288,6 +292,10 @@ std::optional<ParseResultData> Companion::ParseNode(YAML::Node& node, std::strin
     spdlog::set_pattern(line);
     node["vpath"] = name;
 
+    if(node["offset"]) {
+        this->gParsedAssets[this->gCurrentFile].insert(node["offset"].as<uint32_t>());
+    }
+
     auto factory = this->GetFactory(type);
     if(!factory.has_value()){
         throw std::runtime_error("No factory by the name '"+type+"' found for '"+name+"'");
@@ -303,15 +311,15 @@ std::optional<ParseResultData> Companion::ParseNode(YAML::Node& node, std::strin
 
     bool executeDef = true;
     std::optional<std::shared_ptr<IParsedData>> result;
-    if(this->gConfig.modding && impl->SupportModdedAssets() && this->gModdedAssetPaths.contains(name)) {
-        auto path = fs::path(this->gConfig.moddingPath) / this->gModdedAssetPaths[name];
+    const auto moddedPath = impl->SupportModdedAssets() ? this->GetModdedAssetPath(name) : std::nullopt;
+    if(moddedPath.has_value()) {
+        const auto& path = moddedPath.value();
         if(!exists(path)) {
             SPDLOG_ERROR("Modded asset {} not found", this->gModdedAssetPaths[name]);
         } else {
-            std::ifstream input(path, std::ios::binary);
-            std::vector<uint8_t> data = std::vector<uint8_t>( std::istreambuf_iterator( input ), {});
-            input.close();
+            std::vector<uint8_t> data = ModdingCache::Read(path);
 
+            this->gFileInputs[this->gCurrentFile].insert(path.generic_string());
             result = impl->parse_modding(data, node);
             executeDef = !result.has_value();
         }
@@ -323,6 +331,7 @@ std::optional<ParseResultData> Companion::ParseNode(YAML::Node& node, std::strin
 
     if(executeDef && this->gConfig.parseMode == ParseMode::Directory) {
         auto path = GetSafeNode<std::string>(node, "path");
+        this->gFileInputs[this->gCurrentFile].insert(fs::path(path).generic_string());
         std::ifstream input( path, std::ios::binary );
         auto data = std::vector<uint8_t>( std::istreambuf_iterator( input ), {} );
         result = impl->parse(data, node);
@@ -341,19 +350,191 @@ std::optional<ParseResultData> Companion::ParseNode(YAML::Node& node, std::strin
     };
 }
 
-void Companion::ParseModdingConfig() {
-    auto path = fs::path(this->gConfig.moddingPath) / "modding.yml";
-    if(!fs::exists(path)) {
-        throw std::runtime_error("No modding config found, please run in export mode first");
+static std::string QuoteModdingEntry(const std::string& str) {
+    std::string quoted = "\"";
+    for(const char c : str) {
+        if(c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static bool UnquoteModdingEntry(const std::string& line, size_t& pos, std::string& out) {
+    if(pos >= line.size() || line[pos] != '"') {
+        return false;
     }
+
+    out.clear();
+    for(pos++; pos < line.size(); pos++) {
+        const char c = line[pos];
+        if(c == '"') {
+            pos++;
+            return true;
+        }
+        if(c == '\\') {
+            if(++pos >= line.size() || (line[pos] != '"' && line[pos] != '\\')) {
+                return false;
+            }
+        }
+        out += line[pos];
+    }
+
+    return false;
+}
+
+/**
+ * modding.yml is written by WriteModdingConfig as one quoted "asset": "path" pair per line, which lets the import side
+ * read it without going through the YAML parser. Hand edited manifests that don't follow that layout are still
+ * loaded as regular YAML.
+ */
+static bool ReadModdingEntries(const fs::path& path, std::unordered_map<std::string, std::string>& entries) {
+    std::ifstream file(path, std::ios::binary);
+    std::string line;
+
+    if(!std::getline(file, line) || line != "assets:") {
+        return false;
+    }
+
+    std::string name;
+    std::string asset;
+    while(std::getline(file, line)) {
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if(line.empty()) {
+            continue;
+        }
+
+        size_t pos = 2;
+        if(!line.starts_with("  ") || !UnquoteModdingEntry(line, pos, name) || line.compare(pos, 2, ": ") != 0) {
+            return false;
+        }
+
+        pos += 2;
+        if(!UnquoteModdingEntry(line, pos, asset) || pos != line.size()) {
+            return false;
+        }
+
+        entries[name] = asset;
+    }
+
+    return true;
+}
+
+static void LoadModdingEntries(const fs::path& path, std::unordered_map<std::string, std::string>& entries) {
+    std::unordered_map<std::string, std::string> fast;
+    if(ReadModdingEntries(path, fast)) {
+        entries.merge(fast);
+        return;
+    }
+
     auto modding = YAML::LoadFile(path.string());
     for(auto assets = modding["assets"].begin(); assets != modding["assets"].end(); ++assets) {
         auto name = assets->first.as<std::string>();
         auto asset = assets->second.as<std::string>();
-        this->gModdedAssetPaths[name] = asset;
+        entries[name] = asset;
+    }
+}
+
+void Companion::ParseModdingConfig() {
+    auto path = fs::path(this->gConfig.moddingPath) / "modding.yml";
+    if(!fs::exists(path)) {
+        throw std::runtime_error("No modding config found, please run in export mode first");
+    }
+    this->gGlobalInputs.insert(path.generic_string());
+
+    LoadModdingEntries(path, this->gModdedAssetPaths);
+
+    // Partial runs only touch a few assets, decoding the whole mod up front would cost more than it saves
+    std::vector<fs::path> images;
+    if (!this->gConfig.filters.IsActive()) {
+        for (const auto& [name, asset] : this->gModdedAssetPaths) {
+            if (asset.ends_with(".png")) {
+                images.push_back(fs::path(this->gConfig.moddingPath) / asset);
+            }
+        }
     }
+    ModdingCache::Prefetch(images, this->GetCacheDirectory() / "modding");
 }
 
+void Companion::WriteModdingConfig() {
+    const auto path = fs::path(this->gConfig.outputPath) / "modding.yml";
+
+    // Sorted so that re-exports produce the same file
+    std::map<std::string, std::string> sorted(this->gModdedAssetPaths.begin(), this->gModdedAssetPaths.end());
+    std::string buffer = "assets:\n";
+    for(const auto& [name, asset] : sorted) {
+        buffer += "  " + QuoteModdingEntry(name) + ": " + QuoteModdingEntry(asset) + "\n";
+    }
+
+    FileWriter::Write(path, buffer);
+
+    auto& inputs = this->gDependencies[path.generic_string()];
+    for(const auto& [file, fileInputs] : this->gFileInputs) {
+        inputs.insert(fileInputs.begin(), fileInputs.end());
+    }
+}
+
+
+bool Companion::IsAssetSelected(const std::string& path, YAML::Node& node) const {
+    const auto& filters = this->gConfig.filters;
+
+    if(!filters.paths.empty()) {
+        const auto matches = std::any_of(filters.paths.begin(), filters.paths.end(), [&](const auto& glob) {
+            return Torch::globMatch(glob, path);
+        });
+        if(!matches) {
+            return false;
+        }
+    }
+
+    if(!filters.symbols.empty()) {
+        const auto symbol = GetSafeNode<std::string>(node, "symbol", fs::path(path).filename().string());
+        const auto matches = std::any_of(filters.symbols.begin(), filters.symbols.end(), [&](const auto& glob) {
+            return Torch::globMatch(glob, symbol);
+        });
+        if(!matches) {
+            return false;
+        }
+    }
+
+    if(!filters.types.empty()) {
+        if(!node["type"]) {
+            return false;
+        }
+        auto type = GetTypeNode(node);
+        const auto matches = std::any_of(filters.types.begin(), filters.types.end(), [&](std::string filter) {
+            std::transform(filter.begin(), filter.end(), filter.begin(), ::toupper);
+            return filter == type;
+        });
+        if(!matches) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Companion::HasSelectedAssets(YAML::Node& root) {
+    for(auto asset = root.begin(); asset != root.end(); ++asset) {
+        auto entryName = asset->first.as<std::string>();
+        if(entryName.find(":config") != std::string::npos) {
+            continue;
+        }
+
+        auto node = asset->second;
+        auto output = (this->gCurrentDirectory / entryName).string();
+        std::replace(output.begin(), output.end(), '\\', '/');
+        if(this->IsAssetSelected(output, node)) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
 void Companion::ParseCurrentFileConfig(YAML::Node node) {
     if (node["external_files"]) {
@@ -380,14 +561,18 @@ void Companion::ParseCurrentFileConfig(YAML::Node node) {
                     auto currentFile = this->gCurrentFile;
                     auto currentDirectory = this->gCurrentDirectory;
                     auto currentExternalFiles = this->gCurrentExternalFiles;
+                    auto filterAssets = this->gFilterAssets;
 
                     this->gCurrentFile = externalFileName;
                     this->gCurrentDirectory = std::filesystem::relative(externalFileName, this->gAssetPath).replace_extension("");
 
                     YAML::Node root = YAML::LoadFile(externalFileName);
 
+                    // Dependencies are always processed in full, filters only apply to the selected files
+                    this->gFilterAssets = false;
                     if (!this->gProcessedFiles.contains(this->gCurrentFile)) {
                         ProcessFile(root);
+                        this->RegisterFileDependencies(this->gCurrentFile);
                         this->gProcessedFiles.insert(this->gCurrentFile);
                     }
 
@@ -396,10 +581,17 @@ void Companion::ParseCurrentFileConfig(YAML::Node node) {
                     this->gCurrentFile = currentFile;
                     this->gCurrentDirectory = currentDirectory;
                     this->gCurrentExternalFiles = currentExternalFiles;
+                    this->gFilterAssets = filterAssets;
                     this->gFileHeader.clear();
                 } else {
                     SPDLOG_INFO("Skipping external file {} as it has already been processed", externalFileName);
                 }
+
+                // Symbols resolved from an external file end up in our output, so its inputs are ours too
+                const auto externalInputs = this->gFileInputs[externalFileName];
+                auto& inputs = this->gFileInputs[this->gCurrentFile];
+                inputs.insert(externalFileName);
+                inputs.insert(externalInputs.begin(), externalInputs.end());
             }
         }
     }
@@ -486,6 +678,7 @@ void Companion::ParseCurrentFileConfig(YAML::Node node) {
     this->gEnablePadGen = GetSafeNode<bool>(node, "autopads", true);
     this->gNodeForceProcessing = GetSafeNode<bool>(node, "force", false);
     this->gIndividualIncludes = GetSafeNode<bool>(node, "individual_data_incs", false);
+    this->gUnityGroup = GetNode<std::string>(node, "unity");
     this->gCurrentVirtualPath = GetSafeNode<std::string>(node, "path", "");
 }
 
@@ -563,6 +756,7 @@ void Companion::LoadYAMLRecursively(const std::string &dirPath, std::vector<YAML
         } else if (entry.path().extension() == ".yaml" || entry.path().extension() == ".yml") {
             // Load YAML file and add it to the result vector
             result.push_back(YAML::LoadFile(entry.path().generic_string()));
+            this->gGlobalInputs.insert(entry.path().generic_string());
         }
     }
 }
@@ -591,6 +785,269 @@ void Companion::ProcessTables(YAML::Node& rom) {
     }
 }
 
+void Companion::RegisterFileDependencies(const std::string& file) {
+    auto outputs = FileWriter::ConsumeOutputs();
+    const auto entry = RelativePathToSrcDir(file);
+    const auto type = ExportTypeToString(this->gConfig.exporterType);
+
+    if(this->gConfig.exporterType == ExportType::Binary) {
+        // Every asset ends up in the same archive
+        outputs = { fs::path(this->gConfig.outputPath).generic_string() };
+    } else if(!outputs.empty()) {
+        this->gHashNode[entry]["outputs"][type] = outputs;
+    } else if(this->gHashNode[entry] && this->gHashNode[entry]["outputs"] && this->gHashNode[entry]["outputs"][type]) {
+        // The file was skipped because it has not changed, reuse the outputs from the run that generated them
+        outputs = this->gHashNode[entry]["outputs"][type].as<std::vector<std::string>>();
+    }
+
+    auto& inputs = this->gFileInputs[file];
+    inputs.insert(fs::path(file).generic_string());
+
+    for(const auto& output : outputs) {
+        this->gDependencies[output].insert(inputs.begin(), inputs.end());
+    }
+}
+
+static std::string EscapeDepfilePath(const std::string& path) {
+    std::string escaped;
+    for(const char c : path) {
+        switch (c) {
+            case ' ':
+            case '#':
+            case '\\':
+                escaped += '\\';
+                escaped += c;
+                break;
+            case '$':
+                escaped += "$$";
+                break;
+            default:
+                escaped += c;
+                break;
+        }
+    }
+    return escaped;
+}
+
+static std::string EscapeJsonString(const std::string& str) {
+    std::string escaped;
+    for(const char c : str) {
+        switch (c) {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            default:
+                // Every other control character has to be written as an escape for the JSON to parse
+                if(static_cast<unsigned char>(c) < 0x20) {
+                    escaped += fmt::format("\\u{:04X}", static_cast<unsigned char>(c));
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+void Companion::IndexTextures() {
+    if(!this->gConfig.textureIndex.IsActive()) {
+        return;
+    }
+
+    for(auto& result : this->gParseResults[this->gCurrentFile]) {
+        if(!result.data.has_value() || (result.type != "TEXTURE" && result.type != "COMPRESSED_TEXTURE")) {
+            continue;
+        }
+
+        TextureFormat format;
+        uint32_t width;
+        uint32_t height;
+        const std::vector<uint8_t>* buffer;
+
+        if(result.type == "TEXTURE") {
+            const auto texture = std::static_pointer_cast<TextureData>(result.data.value());
+            format = texture->mFormat;
+            width = texture->mWidth;
+            height = texture->mHeight;
+            buffer = &texture->mBuffer;
+        } else {
+            const auto texture = std::static_pointer_cast<CompressedTextureData>(result.data.value());
+            format = texture->mFormat;
+            width = texture->mWidth;
+            height = texture->mHeight;
+            buffer = &texture->mBuffer;
+        }
+
+        std::optional<ParseResultData> palette;
+        if(format.type == TextureType::Palette4bpp || format.type == TextureType::Palette8bpp) {
+            if(result.node["tlut_symbol"]) {
+                palette = this->GetParseDataBySymbol(GetSafeNode<std::string>(result.node, "tlut_symbol"));
+            } else if(result.node["tlut"]) {
+                palette = this->GetParseDataByAddr(GetSafeNode<uint32_t>(result.node, "tlut"));
+            }
+        }
+
+        const std::vector<uint8_t>* tlut = nullptr;
+        if(palette.has_value() && palette->type == "TEXTURE") {
+            tlut = &std::static_pointer_cast<TextureData>(palette->data.value())->mBuffer;
+        }
+
+        const auto offset = result.node["offset"] ? result.GetOffset() : 0;
+        this->gTextureIndex.push_back(TextureIndex::CreateEntry(result.name, this->GetPathHash(result.name), offset, format, width, height, *buffer, tlut));
+    }
+}
+
+void Companion::WriteTextureIndex() {
+    const auto& config = this->gConfig.textureIndex;
+    if(!config.IsActive()) {
+        return;
+    }
+
+    // Every processed file can add textures, so the index depends on all of them
+    const auto queue = [this](const fs::path& path, std::string data) {
+        auto& inputs = this->gDependencies[path.generic_string()];
+        for(const auto& file : this->gProcessedFiles) {
+            const auto& fileInputs = this->gFileInputs[file];
+            inputs.insert(file);
+            inputs.insert(fileInputs.begin(), fileInputs.end());
+        }
+        FileWriter::Queue(path, std::move(data));
+    };
+
+    const auto hex = [](const uint64_t value, const int width) {
+        std::ostringstream out;
+        out << std::hex << std::uppercase << std::setw(width) << std::setfill('0') << value;
+        return out.str();
+    };
+
+    if(config.json) {
+        std::ostringstream json;
+        json << "[";
+        for(size_t i = 0; i < this->gTextureIndex.size(); i++) {
+            const auto& entry = this->gTextureIndex[i];
+            json << (i ? ",\n" : "\n") << fourSpaceTab << "{ ";
+            json << "\"path\": \"" << EscapeJsonString(entry.path) << "\", ";
+            json << "\"path_hash\": \"" << hex(entry.pathHash, 16) << "\", ";
+            json << "\"offset\": " << entry.offset << ", ";
+            json << "\"type\": " << static_cast<uint32_t>(entry.format.type) << ", ";
+            json << "\"depth\": " << entry.format.depth << ", ";
+            json << "\"width\": " << entry.width << ", ";
+            json << "\"height\": " << entry.height << ", ";
+            json << "\"crc\": \"" << hex(entry.crc, 8) << "\", ";
+            json << "\"palette_crc\": \"" << hex(entry.paletteCrc, 8) << "\", ";
+            json << "\"hash\": \"" << hex(entry.hash, 16) << "\" }";
+        }
+        json << "\n]\n";
+
+        queue(this->gDestinationDirectory / "texture_index.json", json.str());
+    }
+
+    if(config.binary || config.archive) {
+        const auto binary = TextureIndex::ToBinary(this->gTextureIndex);
+
+        if(config.binary) {
+            queue(this->gDestinationDirectory / "texture_index.bin", std::string(binary.begin(), binary.end()));
+        }
+
+        if(config.archive) {
+            if(this->gCurrentWrapper != nullptr) {
+                this->gCurrentWrapper->AddFile("texture_index", binary);
+            } else {
+                SPDLOG_WARN("texture_index ARCHIVE only applies to OTR/O2R exports");
+            }
+        }
+    }
+
+    SPDLOG_INFO("Indexed {} textures", this->gTextureIndex.size());
+}
+
+void Companion::WriteDependencies() {
+    if(this->gConfig.depfilePath.empty() && this->gConfig.depManifestPath.empty()) {
+        return;
+    }
+
+    for(auto& [output, inputs] : this->gDependencies) {
+        inputs.insert(this->gGlobalInputs.begin(), this->gGlobalInputs.end());
+    }
+
+    if(!this->gConfig.depfilePath.empty()) {
+        std::ofstream depfile(this->gConfig.depfilePath, std::ios::binary);
+
+        for(const auto& [output, inputs] : this->gDependencies) {
+            depfile << EscapeDepfilePath(output) << ":";
+            for(const auto& input : inputs) {
+                depfile << " \\\n  " << EscapeDepfilePath(input);
+            }
+            depfile << "\n";
+        }
+
+        depfile.close();
+        SPDLOG_INFO("Wrote depfile to {}", this->gConfig.depfilePath);
+    }
+
+    if(!this->gConfig.depManifestPath.empty()) {
+        std::ofstream manifest(this->gConfig.depManifestPath, std::ios::binary);
+
+        manifest << "{\n" << fourSpaceTab << "\"outputs\": {";
+        for(auto output = this->gDependencies.begin(); output != this->gDependencies.end(); ++output) {
+            manifest << (output == this->gDependencies.begin() ? "\n" : ",\n");
+            manifest << fourSpaceTab << fourSpaceTab << "\"" << EscapeJsonString(output->first) << "\": [";
+            for(auto input = output->second.begin(); input != output->second.end(); ++input) {
+                manifest << (input == output->second.begin() ? "\n" : ",\n");
+                manifest << fourSpaceTab << fourSpaceTab << fourSpaceTab << "\"" << EscapeJsonString(*input) << "\"";
+            }
+            manifest << "\n" << fourSpaceTab << fourSpaceTab << "]";
+        }
+        manifest << "\n" << fourSpaceTab << "}\n}\n";
+
+        manifest.close();
+        SPDLOG_INFO("Wrote dependency manifest to {}", this->gConfig.depManifestPath);
+    }
+}
+
+void Companion::WriteUnityOutputs() {
+    for(const auto& [output, chunks] : this->gUnityChunks) {
+        std::string buffer;
+        for(const auto& [source, chunk] : chunks) {
+            buffer += "// " + source + "\n" + chunk + "\n";
+        }
+
+        SPDLOG_INFO("Writing {} files to {}", chunks.size(), output);
+        FileWriter::Queue(output, buffer);
+    }
+
+    if(this->gSymbolIndex.empty()) {
+        return;
+    }
+
+    std::ostringstream index;
+    index << "{\n" << fourSpaceTab << "\"files\": {";
+    for(auto file = this->gSymbolIndex.begin(); file != this->gSymbolIndex.end(); ++file) {
+        index << (file == this->gSymbolIndex.begin() ? "\n" : ",\n");
+        index << fourSpaceTab << fourSpaceTab << "\"" << EscapeJsonString(file->first) << "\": [";
+        for(auto symbol = file->second.begin(); symbol != file->second.end(); ++symbol) {
+            index << (symbol == file->second.begin() ? "\n" : ",\n");
+            index << fourSpaceTab << fourSpaceTab << fourSpaceTab;
+            index << "{ \"symbol\": \"" << EscapeJsonString(symbol->symbol) << "\", ";
+            index << "\"source\": \"" << EscapeJsonString(symbol->source) << "\", ";
+            index << "\"offset\": \"" << Torch::to_hex(symbol->offset) << "\" }";
+        }
+        index << "\n" << fourSpaceTab << fourSpaceTab << "]";
+    }
+    index << "\n" << fourSpaceTab << "}\n}\n";
+
+    FileWriter::Queue(fs::path(this->gConfig.outputPath) / "symbols.json", index.str());
+}
+
 void Companion::ProcessFile(YAML::Node root) {
     // Set compressed file offsets and compression type
     if (auto segments = root[":config"]["segments"]) {
@@ -635,7 +1092,7 @@ void Companion::ProcessFile(YAML::Node root) {
             node["path"] = gCurrentVirtualPath;
         }
 
-        this->gAddrMap[this->gCurrentFile][node["offset"].as<uint32_t>()] = std::make_tuple(output, node);
+        this->gAddrMap[this->gCurrentFile][node["offset"].as<uint32_t>()] = this->CreateAddrEntry(output, node);
     }
 
     // Stupid hack because the iteration broke the assets
@@ -650,13 +1107,21 @@ void Companion::ProcessFile(YAML::Node root) {
     this->gCurrentFileOffset = 0;
     this->gTables.clear();
     this->gCurrentExternalFiles.clear();
+    this->gUnityGroup = std::nullopt;
     GFXDOverride::ClearVtx();
 
     if(root[":config"]) {
         this->ParseCurrentFileConfig(root[":config"]);
     }
 
-    if(!this->NodeHasChanges(this->gCurrentFile) && !this->gNodeForceProcessing) {
+    // Unity outputs inline everything, and are rebuilt from all of their files so they can't skip unchanged ones
+    if(this->IsUnityBuild()) {
+        this->gIndividualIncludes = false;
+    }
+
+    // The texture index is written from scratch every run, so it needs the textures of every file too
+    if(!this->NodeHasChanges(this->gCurrentFile) && !this->gNodeForceProcessing && !this->gConfig.filters.IsActive() && !this->IsUnityBuild() &&
+       !this->gConfig.textureIndex.IsActive()) {
         return;
     }
 
@@ -664,6 +1129,8 @@ void Companion::ProcessFile(YAML::Node root) {
     SPDLOG_INFO("------------------------------------------------");
     spdlog::set_pattern(line);
 
+    this->gParsedAssets[this->gCurrentFile].clear();
+
     for(auto asset = root.begin(); asset != root.end(); ++asset){
 
         auto entryName = asset->first.as<std::string>();
@@ -686,17 +1153,34 @@ void Companion::ProcessFile(YAML::Node root) {
 
         std::string output = (this->gCurrentDirectory / entryName).string();
         std::replace(output.begin(), output.end(), '\\', '/');
-        this->gConfig.segment.temporal.clear();
-        auto result = this->ParseNode(assetNode, output);
-        if(result.has_value()) {
-            this->gParseResults[this->gCurrentFile].push_back(result.value());
+
+        if(this->gFilterAssets) {
+            if(!this->IsAssetSelected(output, assetNode)) {
+                continue;
+            }
+
+            // Already pulled in as a dependency of a previously selected asset
+            if(assetNode["offset"] && this->gParsedAssets[this->gCurrentFile].contains(assetNode["offset"].as<uint32_t>())) {
+                continue;
+            }
         }
 
+        this->gConfig.segment.temporal.clear();
+        this->ParseWithDependencies(assetNode, output);
+
         spdlog::set_pattern(regular);
         SPDLOG_INFO("------------------------------------------------");
         spdlog::set_pattern(line);
     }
 
+    // Textures discovered from display lists can join a TLUT's palette group after the TLUT was parsed
+    ModdingCache::ResolvePalettes(this->gParseResults[this->gCurrentFile]);
+
+    // Exporters may convert the data in place, so the index has to see it first
+    this->IndexTextures();
+
+    std::vector<SymbolEntry> symbols;
+
     for(auto& result : this->gParseResults[this->gCurrentFile]){
         std::ostringstream stream;
         ExportResult endptr = std::nullopt;
@@ -710,6 +1194,9 @@ void Companion::ProcessFile(YAML::Node root) {
             continue;
         }
 
+        const auto alignment = GetSafeNode<uint32_t>(result.node, "alignment", impl->GetAlignment());
+        this->gCurrentAlignment = alignment;
+
         switch (this->gConfig.exporterType) {
             case ExportType::Binary: {
                 stream.str("");
@@ -734,37 +1221,37 @@ void Companion::ProcessFile(YAML::Node root) {
                 exporter->get()->Export(stream, data, result.name, result.node, &result.name);
 
                 auto data = stream.str();
-                if(data.empty()) {
+                auto image = std::move(this->gModdingImage);
+                this->gModdingImage.reset();
+
+                if(data.empty() && !image.has_value()) {
                     break;
                 }
 
                 std::string dpath = Instance->GetOutputPath() + "/" + result.name;
-                if(!exists(fs::path(dpath).parent_path())){
-                    create_directories(fs::path(dpath).parent_path());
-                }
 
                 this->gModdedAssetPaths[ogname] = result.name;
 
-                std::ofstream file(dpath, std::ios::binary);
-                file.write(data.c_str(), data.size());
-                file.close();
+                if(image.has_value()) {
+                    PNGEncoder::Queue(dpath, std::move(image.value()), this->gConfig.pngCompression);
+                } else {
+                    FileWriter::Queue(dpath, std::move(data));
+                }
 
                 for(auto& entry : this->gCompanionFiles){
                     auto cpath = (Instance->GetOutputPath() / this->gCurrentDirectory / entry.first).string();
                     std::replace(cpath.begin(), cpath.end(), '\\', '/');
-                    if(!exists(fs::path(cpath).parent_path())){
-                        create_directories(fs::path(cpath).parent_path());
-                    }
-
-                    std::ofstream cfile(cpath, std::ios::binary);
-                    cfile.write(entry.second.data(), entry.second.size());
-                    cfile.close();
+                    FileWriter::Queue(cpath, entry.second);
                 }
 
                 break;
             }
             default: {
+                const auto symbol = GetSafeNode<std::string>(result.node, "symbol", fs::path(result.name).filename().string());
                 endptr = exporter->get()->Export(stream, data, result.name, result.node, &result.name);
+                if(this->IsUnityBuild() && result.node["offset"]) {
+                    symbols.push_back({ symbol, RelativePathToSrcDir(this->gCurrentFile), result.node["offset"].as<uint32_t>() });
+                }
                 break;
             }
         }
@@ -772,7 +1259,6 @@ void Companion::ProcessFile(YAML::Node root) {
         this->gCompanionFiles.clear();
 
         if(result.node["offset"]) {
-            auto alignment = GetSafeNode<uint32_t>(result.node, "alignment", impl->GetAlignment());
             if(!endptr.has_value()) {
                 wEntry = {
                     result.name,
@@ -819,18 +1305,7 @@ void Companion::ProcessFile(YAML::Node root) {
 
     auto fsout = fs::path(this->gConfig.outputPath);
 
-    if(this->gConfig.exporterType == ExportType::Modding || this->gConfig.exporterType == ExportType::XML) {
-        fsout /= "modding.yml";
-        YAML::Node modding;
-
-        for (const auto& [key, value] : this->gModdedAssetPaths) {
-            modding["assets"][key] = value;
-        }
-
-        std::ofstream file(fsout.string(), std::ios::binary);
-        file << modding;
-        file.close();
-    } else if(this->gConfig.exporterType != ExportType::Binary){
+    if(this->gConfig.exporterType != ExportType::Binary && this->gConfig.exporterType != ExportType::Modding && this->gConfig.exporterType != ExportType::XML){
         std::string filename = this->gCurrentDirectory.filename().string();
 
         switch (this->gConfig.exporterType) {
@@ -839,7 +1314,11 @@ void Companion::ProcessFile(YAML::Node root) {
                 break;
             }
             case ExportType::Code: {
-                fsout /= this->gCurrentDirectory / (filename + ".c");
+                if(this->gUnityGroup.has_value()) {
+                    fsout /= this->gUnityGroup.value() + ".c";
+                } else {
+                    fsout /= this->gCurrentDirectory / (filename + ".c");
+                }
                 break;
             }
             default: break;
@@ -907,7 +1386,12 @@ void Companion::ProcessFile(YAML::Node root) {
                 } else if(gap < 0x10 && gap >= alignment && end % alignment == 0 && this->gEnablePadGen) {
                     SPDLOG_WARN("Gap detected between 0x{:X} and 0x{:X} with size 0x{:X} on file {}", startptr, end, gap, this->gCurrentFile);
                     SPDLOG_WARN("Creating pad of 0x{:X} bytes", gap);
-                    const auto padfile = this->gCurrentDirectory.filename().string();
+                    auto padfile = this->gCurrentDirectory.filename().string();
+                    // Files sharing a unity output can have the same name, so their pads are named after the whole path
+                    if(this->gUnityGroup.has_value()) {
+                        padfile = this->gCurrentDirectory.relative_path().generic_string();
+                        std::replace_if(padfile.begin(), padfile.end(), [](const char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+                    }
                     if(this->IsDebug()){
                         stream << "// 0x" << std::hex << std::uppercase << startptr << "\n";
                     }
@@ -931,11 +1415,7 @@ void Companion::ProcessFile(YAML::Node root) {
                 fs::path outinc = fs::path(this->gConfig.outputPath) / this->gCurrentDirectory.parent_path() /
                     fs::relative(fs::path(result.name + ".inc.c"), this->gCurrentDirectory.parent_path());
 
-                if(!exists(outinc.parent_path())){
-                    create_directories(outinc.parent_path());
-                }
-
-                std::ofstream file(outinc, std::ios::binary);
+                std::ostringstream file;
 
                 if(!this->gFileHeader.empty()) {
                     file << this->gFileHeader << std::endl;
@@ -943,7 +1423,7 @@ void Companion::ProcessFile(YAML::Node root) {
                 file << stream.str();
                 stream.str("");
                 stream.seekp(0);
-                file.close();
+                FileWriter::Queue(outinc, file.str());
             }
         }
 
@@ -959,11 +1439,8 @@ void Companion::ProcessFile(YAML::Node root) {
 
             std::string output = fsout.string();
             std::replace(output.begin(), output.end(), '\\', '/');
-            if(!exists(fs::path(output).parent_path())){
-                create_directories(fs::path(output).parent_path());
-            }
 
-            std::ofstream file(output, std::ios::binary);
+            std::ostringstream file;
             SPDLOG_INFO("Writing {} to {}", this->gCurrentFile, output);
 
             if(this->gConfig.exporterType == ExportType::Header) {
@@ -990,15 +1467,39 @@ void Companion::ProcessFile(YAML::Node root) {
                 file << buffer;
             }
 
-            file.close();
+            if(this->IsUnityBuild()) {
+                auto& index = this->gSymbolIndex[output];
+                index.insert(index.end(), symbols.begin(), symbols.end());
+            }
+
+            if(this->IsUnityBuild() && this->gUnityGroup.has_value()) {
+                this->gUnityChunks[output][RelativePathToSrcDir(this->gCurrentFile)] = file.str();
+
+                const auto& fileInputs = this->gFileInputs[this->gCurrentFile];
+                auto& inputs = this->gDependencies[output];
+                inputs.insert(this->gCurrentFile);
+                inputs.insert(fileInputs.begin(), fileInputs.end());
+            } else {
+                FileWriter::Queue(output, file.str());
+            }
         }
     }
 
-    if(this->gConfig.exporterType != ExportType::Binary) {
+    // A partial export must not mark the file as up to date
+    if(this->gConfig.exporterType != ExportType::Binary && !this->gFilterAssets) {
         this->gHashNode[RelativePathToSrcDir(this->gCurrentFile)]["extracted"][ExportTypeToString(this->gConfig.exporterType)] = true;
     }
 }
 
+// Joins the background pools if Process unwinds, threads left joinable in their statics would terminate the program at exit
+struct WorkerPoolsGuard {
+    ~WorkerPoolsGuard() {
+        PNGEncoder::StopWorkers();
+        FileWriter::StopWorkers();
+        ModdingCache::Clear();
+    }
+};
+
 void Companion::Process() {
 
     auto configPath = this->gSourceDirectory / "config.yml";
@@ -1008,13 +1509,18 @@ void Companion::Process() {
         return;
     }
 
+    WorkerPoolsGuard workers;
+
     auto start = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
     YAML::Node config = YAML::LoadFile(configPath.string());
+    FileWriter::ResetStats();
+    this->gGlobalInputs.insert(configPath.generic_string());
 
     bool isDirectoryMode = config["mode"] && config["mode"].as<std::string>() == "directory";
 
     if(!isDirectoryMode) {
         if(this->gRomPath.has_value()){
+            this->gGlobalInputs.insert(this->gRomPath.value().generic_string());
             std::ifstream input( this->gRomPath.value(), std::ios::binary );
             this->gRomData = std::vector<uint8_t>( std::istreambuf_iterator( input ), {} );
             input.close();
@@ -1047,7 +1553,14 @@ void Companion::Process() {
                 auto restart = GetSafeNode<bool>(item, "restart");
 
                 if (type == "DECOMPRESS") {
-                    this->gRomData = CompTool::Decompress(this->gRomData);
+                    const auto key = DecompressionCache::Key(this->gCartridge->GetHash(), "comptool", 0, this->gRomData.size());
+                    if(const auto cached = DecompressionCache::Load(key)) {
+                        this->gRomData = std::vector(cached->data, cached->data + cached->size);
+                        DecompressionCache::Release(cached->data);
+                    } else {
+                        this->gRomData = CompTool::Decompress(this->gRomData);
+                        DecompressionCache::Store(key, this->gRomData.data(), this->gRomData.size());
+                    }
                     this->gCartridge = std::make_shared<N64::Cartridge>(this->gRomData);
                     this->gCartridge->Initialize();
 
@@ -1157,6 +1670,100 @@ void Companion::Process() {
         }
     }
 
+    if(auto disassembler = cfg["gfx_disassembler"]) {
+        auto key = disassembler.as<std::string>();
+
+        if(key == "NATIVE") {
+            this->gConfig.gbi.disassembler = GfxDisassembler::Native;
+        } else if(key == "GFXD") {
+            this->gConfig.gbi.disassembler = GfxDisassembler::GFXD;
+        } else if(key == "VERIFY") {
+            this->gConfig.gbi.disassembler = GfxDisassembler::Verify;
+        } else {
+            SPDLOG_ERROR("Invalid gfx_disassembler {}, please use NATIVE, GFXD or VERIFY", key);
+            return;
+        }
+    }
+
+    if(auto optimizer = cfg["gfx_optimizer"]) {
+        auto key = optimizer.as<std::string>();
+
+        if(key == "OFF") {
+            this->gConfig.gbi.optimizer = GfxOptimizer::Off;
+        } else if(key == "ON") {
+            this->gConfig.gbi.optimizer = GfxOptimizer::On;
+        } else if(key == "VERIFY") {
+            this->gConfig.gbi.optimizer = GfxOptimizer::Verify;
+        } else {
+            SPDLOG_ERROR("Invalid gfx_optimizer {}, please use OFF, ON or VERIFY", key);
+            return;
+        }
+    }
+
+    if(auto textureExport = cfg["texture_export"]) {
+        auto key = textureExport.as<std::string>();
+
+        if(key == "NATIVE") {
+            this->gConfig.textureExport = TextureExport::Native;
+        } else if(key == "RGBA32") {
+            this->gConfig.textureExport = TextureExport::RGBA32;
+        } else {
+            SPDLOG_ERROR("Invalid texture_export {}, please use NATIVE or RGBA32", key);
+            return;
+        }
+    }
+
+    if(auto pngCompression = cfg["png_compression"]) {
+        auto key = pngCompression.as<std::string>();
+
+        if(key == "STORE") {
+            this->gConfig.pngCompression = PNGCompression::Store;
+        } else if(key == "RLE") {
+            this->gConfig.pngCompression = PNGCompression::RLE;
+        } else if(key == "FAST") {
+            this->gConfig.pngCompression = PNGCompression::Fast;
+        } else if(key == "DEFAULT") {
+            this->gConfig.pngCompression = PNGCompression::Default;
+        } else if(key == "BEST") {
+            this->gConfig.pngCompression = PNGCompression::Best;
+        } else {
+            SPDLOG_ERROR("Invalid png_compression {}, please use STORE, RLE, FAST, DEFAULT or BEST", key);
+            return;
+        }
+    }
+
+    if(auto compressionEffort = cfg["compression_effort"]) {
+        auto key = compressionEffort.as<std::string>();
+
+        if(key == "ORIGINAL") {
+            this->gConfig.compressionEffort = CompressionEffort::Original;
+        } else if(key == "FAST") {
+            this->gConfig.compressionEffort = CompressionEffort::Fast;
+        } else if(key == "BEST") {
+            this->gConfig.compressionEffort = CompressionEffort::Best;
+        } else {
+            SPDLOG_ERROR("Invalid compression_effort {}, please use ORIGINAL, FAST or BEST", key);
+            return;
+        }
+    }
+
+    if(auto textureIndex = cfg["texture_index"]) {
+        const auto keys = textureIndex.IsSequence() ? textureIndex.as<std::vector<std::string>>() : std::vector { textureIndex.as<std::string>() };
+
+        for(const auto& key : keys) {
+            if(key == "JSON") {
+                this->gConfig.textureIndex.json = true;
+            } else if(key == "BINARY") {
+                this->gConfig.textureIndex.binary = true;
+            } else if(key == "ARCHIVE") {
+                this->gConfig.textureIndex.archive = true;
+            } else {
+                SPDLOG_ERROR("Invalid texture_index {}, please use JSON, BINARY or ARCHIVE", key);
+                return;
+            }
+        }
+    }
+
     if(auto sort = cfg["sort"]) {
         if(sort.IsSequence()) {
             this->gWriteOrder = sort.as<std::vector<std::string>>();
@@ -1189,6 +1796,7 @@ void Companion::Process() {
         auto enums = GetSafeNode<std::vector<std::string>>(cfg, "enums");
         for (auto& file : enums) {
             file = (this->gSourceDirectory / file).string();
+            this->gGlobalInputs.insert(fs::path(file).generic_string());
             this->ParseEnums(file);
         }
     }
@@ -1216,6 +1824,11 @@ void Companion::Process() {
     }
 
     this->gConfig.textureDefines = cfg["textures"] && (cfg["textures"].as<std::string>() == "ADDITIONAL_DEFINES");
+    this->gConfig.unity = GetSafeNode<bool>(cfg, "unity", false);
+
+    if(cfg["raw_data"]) {
+        this->gConfig.rawData = BinaryEmbed::ParseMode(cfg["raw_data"].as<std::string>());
+    }
 
     this->ParseHash();
 
@@ -1255,10 +1868,28 @@ void Companion::Process() {
     }
 
     if (wrapper) {
-        wrapper->CreateArchive();
+        // Filtered runs update the entries of an existing archive instead of replacing it
+        if (this->gConfig.filters.IsActive()) {
+            wrapper->OpenArchive();
+        } else {
+            wrapper->CreateArchive();
+        }
     }
     this->gCurrentWrapper = wrapper;
 
+    FileWriter::StartWorkers();
+    if (this->gConfig.exporterType == ExportType::Modding) {
+        PNGEncoder::StartWorkers();
+    }
+
+    if (this->gConfig.exporterType == ExportType::Modding || this->gConfig.exporterType == ExportType::XML) {
+        // Keep the entries of the assets that are not part of this run, filtered out or skipped as unchanged
+        const auto manifest = fs::path(this->gConfig.outputPath) / "modding.yml";
+        if (fs::exists(manifest)) {
+            LoadModdingEntries(manifest, this->gModdedAssetPaths);
+        }
+    }
+
     auto vWriter = LUS::BinaryWriter();
     vWriter.SetEndianness(Torch::Endianness::Big);
     vWriter.Write(static_cast<uint8_t>(Torch::Endianness::Big));
@@ -1288,12 +1919,34 @@ void Companion::Process() {
         this->gCurrentDirectory = relative(entry.path(), this->gAssetPath).replace_extension("");
         this->gCurrentFile = yamlPath;
 
+        if (this->gConfig.filters.IsActive()) {
+            // Grouped unity outputs are rebuilt from every file that belongs to them
+            const auto grouped = this->gConfig.exporterType == ExportType::Code && root[":config"] && root[":config"]["unity"];
+            if (!grouped && !this->HasSelectedAssets(root)) {
+                continue;
+            }
+
+            // Code and headers are written per file, so only archives and modding exports can be partial
+            const auto type = this->gConfig.exporterType;
+            this->gFilterAssets = type == ExportType::Binary || type == ExportType::Modding || type == ExportType::XML;
+        }
+
         if (!this->gProcessedFiles.contains(this->gCurrentFile)) {
             ProcessFile(root);
+            this->RegisterFileDependencies(this->gCurrentFile);
             this->gProcessedFiles.insert(this->gCurrentFile);
         }
+
+        this->gFilterAssets = false;
     }
 
+    if(this->gConfig.exporterType == ExportType::Modding || this->gConfig.exporterType == ExportType::XML) {
+        this->WriteModdingConfig();
+    }
+
+    this->WriteUnityOutputs();
+    this->WriteTextureIndex();
+
     if(wrapper != nullptr) {
         SPDLOG_CRITICAL("Writing version file");
         wrapper->AddFile("version", vWriter.ToVector());
@@ -1301,6 +1954,14 @@ void Companion::Process() {
         wrapper->Close();
     }
 
+    // Encoders feed the file writers, so they have to be drained first
+    PNGEncoder::Flush();
+    PNGEncoder::StopWorkers();
+    FileWriter::Flush();
+    FileWriter::StopWorkers();
+
+    this->WriteDependencies();
+
     // Write entries hash
     std::ofstream file(this->gDestinationDirectory / "torch.hash.yml", std::ios::binary);
     file << this->gHashNode;
@@ -1309,12 +1970,21 @@ void Companion::Process() {
     auto end = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
     auto level = spdlog::get_level();
     spdlog::set_level(spdlog::level::info);
+    const auto stats = FileWriter::GetStats();
     SPDLOG_CRITICAL("Done! Took {}ms", end.count() - start.count());
+    if(stats.written || stats.skipped) {
+        SPDLOG_CRITICAL("Files written: {}, unchanged: {}", stats.written, stats.skipped);
+    }
     SPDLOG_CRITICAL("------------------------------------------------");
     spdlog::set_level(level);
     spdlog::set_pattern(regular);
 
     Decompressor::ClearCache();
+    ModdingCache::Clear();
+    // A limit of 0 disables the cache, the entries of earlier runs are left alone
+    if (this->gConfig.cacheLimit != 0) {
+        Torch::evictCache(this->GetCacheDirectory(), this->gConfig.cacheLimit);
+    }
     this->gCartridge = nullptr;
     Instance = nullptr;
 }
@@ -1374,6 +2044,40 @@ void Companion::Pack(const std::string& folder, const std::string& output, const
     wrapper->Close();
 }
 
+void Companion::PrintCacheInfo(const std::string& destination) {
+    const auto directory = GetCacheDirectory(destination);
+    if(!fs::exists(directory)) {
+        std::cout << "No cache found in " << directory.string() << std::endl;
+        return;
+    }
+
+    uintmax_t total = 0;
+    for(const auto& cache : fs::directory_iterator(directory)) {
+        if(!cache.is_directory()) {
+            continue;
+        }
+
+        size_t entries = 0;
+        uintmax_t size = 0;
+        for(const auto& entry : fs::recursive_directory_iterator(cache.path())) {
+            if(entry.is_regular_file()) {
+                entries++;
+                size += entry.file_size();
+            }
+        }
+
+        total += size;
+        std::cout << fmt::format("{:<16}{:>8} entries{:>12.2f} MB", cache.path().filename().string(), entries, size / (1024.0 * 1024.0)) << std::endl;
+    }
+    std::cout << fmt::format("{:<32}{:>12.2f} MB", "Total", total / (1024.0 * 1024.0)) << std::endl;
+}
+
+void Companion::ClearCacheDirectory(const std::string& destination) {
+    const auto directory = GetCacheDirectory(destination);
+    const auto removed = fs::remove_all(directory);
+    std::cout << "Removed " << removed << " files and folders from " << directory.string() << std::endl;
+}
+
 std::optional<std::tuple<std::string, YAML::Node>> Companion::RegisterAsset(const std::string& name, YAML::Node& node) {
     if(!node["offset"]) {
         return std::nullopt;
@@ -1382,17 +2086,107 @@ std::optional<std::tuple<std::string, YAML::Node>> Companion::RegisterAsset(cons
     auto output = (this->gCurrentDirectory / name).string();
     std::replace(output.begin(), output.end(), '\\', '/');
 
-    auto entry = std::make_tuple(output, node);
-    this->gAddrMap[this->gCurrentFile][node["offset"].as<uint32_t>()] = entry;
-    auto dResult = this->ParseNode(node, output);
-    if(dResult.has_value()) {
-        this->gParseResults[this->gCurrentFile].push_back(dResult.value());
+    this->gAddrMap[this->gCurrentFile][node["offset"].as<uint32_t>()] = this->CreateAddrEntry(output, node);
+    this->QueueDiscoveredAsset(output, node);
+
+    return std::make_tuple(output, node);
+}
+
+void Companion::LinkDiscoveredAsset(const AssetKey& key) {
+    if(this->gDiscoveryParent.has_value()) {
+        this->gDiscoveryEdges[this->gDiscoveryParent.value()].push_back(key);
     }
-    spdlog::set_pattern(regular);
-    SPDLOG_INFO("------------------------------------------------");
-    spdlog::set_pattern(line);
+}
+
+void Companion::QueueDiscoveredAsset(const std::string& name, YAML::Node& node) {
+    const auto offset = node["offset"].as<uint32_t>();
+    const AssetKey key = { offset, GetTypeNode(node) };
+
+    this->LinkDiscoveredAsset(key);
 
-    return entry;
+    if(!this->gDiscoveryVisited.insert(key).second) {
+        return;
+    }
+
+    auto romOffset = offset;
+    if(IS_SEGMENTED(offset)) {
+        romOffset = this->GetFileOffsetFromSegmentedAddr(SEGMENT_NUMBER(offset)).value_or(0) + SEGMENT_OFFSET(offset);
+    }
+
+    this->gDiscoveryQueue.push_back({ name, node, key, romOffset });
+}
+
+/**
+ * Parses an asset and everything it pulls in through AddAsset. Dependencies are parsed in breadth-first passes sorted
+ * by ROM offset instead of recursing from inside the factories, the results are then stored dependencies first so
+ * the output order matches what the recursive discovery produced.
+ */
+void Companion::ParseWithDependencies(YAML::Node& node, std::string& name) {
+    const AssetKey root = node["offset"] ? AssetKey{ node["offset"].as<uint32_t>(), GetTypeNode(node) } : AssetKey{ 0, "" };
+    std::set<AssetKey> processed;
+    std::map<AssetKey, ParseResultData> parsed;
+
+    this->gDiscoveryQueue.clear();
+    this->gDiscoveryVisited = { root };
+    this->gDiscoveryEdges.clear();
+    this->gDiscoveryParent = root;
+
+    const auto rootResult = this->ParseNode(node, name);
+
+    while(!this->gDiscoveryQueue.empty()) {
+        auto pass = std::move(this->gDiscoveryQueue);
+        this->gDiscoveryQueue.clear();
+
+        std::stable_sort(pass.begin(), pass.end(), [](const DiscoveredAsset& a, const DiscoveredAsset& b) {
+            return a.romOffset < b.romOffset;
+        });
+
+        for(auto& asset : pass) {
+            this->gDiscoveryParent = asset.key;
+            processed.insert(asset.key);
+
+            auto result = this->ParseNode(asset.node, asset.name);
+            if(result.has_value()) {
+                parsed.emplace(asset.key, result.value());
+            }
+
+            spdlog::set_pattern(regular);
+            SPDLOG_INFO("------------------------------------------------");
+            spdlog::set_pattern(line);
+        }
+    }
+
+    this->gDiscoveryParent = std::nullopt;
+
+    auto& results = this->gParseResults[this->gCurrentFile];
+    std::set<AssetKey> entered = { root };
+    std::vector<std::pair<AssetKey, size_t>> stack = { { root, 0 } };
+
+    while(!stack.empty()) {
+        const auto key = stack.back().first;
+        const auto edges = this->gDiscoveryEdges.find(key);
+
+        if(edges != this->gDiscoveryEdges.end() && stack.back().second < edges->second.size()) {
+            const auto child = edges->second[stack.back().second++];
+            if(processed.contains(child) && entered.insert(child).second) {
+                stack.emplace_back(child, 0);
+            }
+            continue;
+        }
+
+        stack.pop_back();
+
+        const auto result = parsed.find(key);
+        if(key != root && result != parsed.end()) {
+            results.push_back(result->second);
+        }
+    }
+
+    if(rootResult.has_value()) {
+        results.push_back(rootResult.value());
+    }
+
+    this->gDiscoveryEdges.clear();
 }
 
 void Companion::RegisterFactory(const std::string& type, const std::shared_ptr<BaseFactory>& factory) {
@@ -1460,9 +2254,16 @@ uint32_t Companion::PatchVirtualAddr(uint32_t addr) {
     return addr;
 }
 
-std::optional<std::tuple<std::string, YAML::Node>> Companion::GetNodeByAddr(uint32_t addr){
+AddrEntry Companion::CreateAddrEntry(const std::string& path, YAML::Node& node) {
+    auto type = GetSafeNode<std::string>(node, "type", "");
+    std::transform(type.begin(), type.end(), type.begin(), toupper);
+
+    return { path, node, this->GetPathHash(path), type, GetNode<std::string>(node, "symbol") };
+}
+
+const AddrEntry* Companion::FindAddrEntry(uint32_t addr){
     if(!this->gAddrMap.contains(this->gCurrentFile)){
-        return std::nullopt;
+        return nullptr;
     }
 
     // HACK: Adjust address to rom address if virtual address
@@ -1478,12 +2279,44 @@ std::optional<std::tuple<std::string, YAML::Node>> Companion::GetNodeByAddr(uint
             if (!this->gAddrMap[file].contains(addr)) {
                 continue;
             }
-            return this->gAddrMap[file][addr];
+            return &this->gAddrMap[file][addr];
         }
+        return nullptr;
+    }
+
+    return &this->gAddrMap[this->gCurrentFile][addr];
+}
+
+std::optional<std::tuple<std::string, YAML::Node>> Companion::GetNodeByAddr(uint32_t addr){
+    const auto entry = this->FindAddrEntry(addr);
+
+    if(entry == nullptr) {
+        return std::nullopt;
+    }
+
+    return std::make_tuple(entry->path, entry->node);
+}
+
+std::optional<uint64_t> Companion::GetHashByAddr(uint32_t addr){
+    const auto entry = this->FindAddrEntry(addr);
+
+    if(entry == nullptr) {
         return std::nullopt;
     }
 
-    return this->gAddrMap[this->gCurrentFile][addr];
+    return entry->hash;
+}
+
+uint64_t Companion::GetPathHash(const std::string& path) {
+    const auto it = this->gPathHashes.find(path);
+
+    if(it != this->gPathHashes.end()) {
+        return it->second;
+    }
+
+    const auto hash = CRC64N(path.c_str(), path.size());
+    this->gPathHashes[path] = hash;
+    return hash;
 }
 
 std::optional<std::tuple<std::string, YAML::Node>> Companion::GetSafeNodeByAddr(const uint32_t addr, std::string type) {
@@ -1504,6 +2337,25 @@ std::optional<std::tuple<std::string, YAML::Node>> Companion::GetSafeNodeByAddr(
 
 }
 
+std::optional<std::string> Companion::GetSymbolByAddr(const uint32_t addr, const std::string& type) {
+    const auto entry = this->FindAddrEntry(addr);
+
+    if(entry == nullptr) {
+        return std::nullopt;
+    }
+
+    if(entry->type != type) {
+        throw std::runtime_error("Requested node type does not match with the target node type at " + Torch::to_hex(addr, false) + " Found: " + entry->type + " Expected: " + type);
+    }
+
+    if(!entry->symbol.has_value()) {
+        auto node = entry->node;
+        return GetSafeNode<std::string>(node, "symbol");
+    }
+
+    return entry->symbol;
+}
+
 std::string Companion::GetSymbolFromAddr(uint32_t address, bool validZero) {
     auto dec = Companion::Instance->GetNodeByAddr(address);
     std::ostringstream outSymbol;
@@ -1564,22 +2416,23 @@ std::optional<ParseResultData> Companion::GetParseDataBySymbol(const std::string
 
 }
 
-std::optional<std::vector<std::tuple<std::string, YAML::Node>>> Companion::GetNodesByType(const std::string& type){
+std::optional<std::vector<std::tuple<std::string, YAML::Node>>> Companion::GetNodesByType(const std::string& type, const bool includeAutogen){
     std::vector<std::tuple<std::string, YAML::Node>> nodes;
 
     if(!this->gAddrMap.contains(this->gCurrentFile)){
         return nodes;
     }
 
-    for(auto& [addr, tpl] : this->gAddrMap[this->gCurrentFile]){
-        auto [name, node] = tpl;
+    for(auto& [addr, entry] : this->gAddrMap[this->gCurrentFile]){
+        const auto& name = entry.path;
+        auto& node = entry.node;
         const auto n_type = GetTypeNode(node);
-        if(node["autogen"]){
+        if(node["autogen"] && !includeAutogen){
             SPDLOG_DEBUG("Skipping autogenerated asset {}", name);
             continue;
         }
         if(n_type == type){
-            nodes.push_back(tpl);
+            nodes.emplace_back(name, node);
         }
     }
 
@@ -1592,6 +2445,23 @@ void Companion::RegisterCompanionFile(const std::string path, std::vector<char>
     SPDLOG_TRACE("Registered companion file {}", path);
 }
 
+std::optional<fs::path> Companion::GetModdedAssetPath(const std::string& name) const {
+    if(!this->gConfig.modding) {
+        return std::nullopt;
+    }
+
+    const auto it = this->gModdedAssetPaths.find(name);
+    if(it == this->gModdedAssetPaths.end()) {
+        return std::nullopt;
+    }
+
+    return fs::path(this->gConfig.moddingPath) / it->second;
+}
+
+void Companion::QueueModdingImage(PNGImage image) {
+    this->gModdingImage = std::move(image);
+}
+
 std::string Companion::NormalizeAsset(const std::string& name) const {
     auto path = fs::path(this->gCurrentFile).stem().string() + "_" + name;
     return path;
@@ -1638,11 +2508,17 @@ std::optional<YAML::Node> Companion::AddAsset(YAML::Node asset) {
         if(GetTypeNode(found) != type) {
             SPDLOG_ERROR("Asset clash detected {} vs {} at 0x{:X}", type, GetTypeNode(found), offset);
         } else {
+            // Filtered runs skip unselected assets, queue this one since a selected asset needs it
+            const auto foundOffset = GetSafeNode<uint32_t>(found, "offset");
+            if(this->gFilterAssets && this->gAddrMap[this->gCurrentFile].contains(foundOffset) && !this->gParsedAssets[this->gCurrentFile].contains(foundOffset)) {
+                this->QueueDiscoveredAsset(std::get<0>(decl.value()), found);
+            } else {
+                this->LinkDiscoveredAsset({ foundOffset, type });
+            }
             return found;
         }
     }
 
-    auto rom = this->GetRomData();
     auto factory = this->GetFactory(type);
 
     if(!factory.has_value()) {
@@ -7,10 +7,16 @@
 #include <fstream>
 #include <unordered_map>
 #include <unordered_set>
+#include <set>
+#include <map>
 #include <variant>
 #include "factories/BaseFactory.h"
 #include "n64/Cartridge.h"
 #include "utils/Decompressor.h"
+#include "utils/BinaryEmbed.h"
+#include "utils/PNGEncoder.h"
+#include "utils/Compressor.h"
+#include "utils/TextureIndex.h"
 #include "factories/TextureFactory.h"
 
 class BinaryWrapper;
@@ -35,6 +41,23 @@ enum class GBIMinorVersion {
     SM64
 };
 
+enum class GfxDisassembler {
+    Native,
+    GFXD,
+    Verify
+};
+
+enum class GfxOptimizer {
+    Off,
+    On,
+    Verify
+};
+
+enum class TextureExport {
+    Native,
+    RGBA32
+};
+
 enum class TableMode {
     Reference,
     Append
@@ -74,10 +97,59 @@ struct WriteEntry {
     std::optional<uint32_t> endptr;
 };
 
+struct AddrEntry {
+    std::string path;
+    YAML::Node node;
+    // CRC64 of the path, computed once when the asset is registered
+    uint64_t hash;
+    // Uppercased type and symbol, read once so lookups by address don't go through the YAML node
+    std::string type;
+    std::optional<std::string> symbol;
+};
+
+struct SymbolEntry {
+    std::string symbol;
+    std::string source;
+    uint32_t offset;
+};
+
+// An asset is discovered once per offset and type, aliased segment addresses keep their own symbols
+using AssetKey = std::pair<uint32_t, std::string>;
+
+struct DiscoveredAsset {
+    std::string name;
+    YAML::Node node;
+    AssetKey key;
+    uint32_t romOffset;
+};
+
 struct GBIConfig {
     GBIVersion version = GBIVersion::f3d;
     GBIMinorVersion subversion = GBIMinorVersion::None;
     bool useFloats = false;
+    GfxDisassembler disassembler = GfxDisassembler::Native;
+    GfxOptimizer optimizer = GfxOptimizer::Off;
+};
+
+// Outputs of the texture hash index, any combination of them can be enabled
+struct TextureIndexConfig {
+    bool json = false;
+    bool binary = false;
+    bool archive = false;
+
+    bool IsActive() const {
+        return json || binary || archive;
+    }
+};
+
+struct FilterConfig {
+    std::vector<std::string> paths;
+    std::vector<std::string> symbols;
+    std::vector<std::string> types;
+
+    bool IsActive() const {
+        return !paths.empty() || !symbols.empty() || !types.empty();
+    }
 };
 
 struct TorchConfig {
@@ -91,6 +163,17 @@ struct TorchConfig {
     bool debug;
     bool modding;
     bool textureDefines;
+    RawDataMode rawData = RawDataMode::Hex;
+    bool unity = false;
+    TextureExport textureExport = TextureExport::Native;
+    PNGCompression pngCompression = PNGCompression::Default;
+    CompressionEffort compressionEffort = CompressionEffort::Original;
+    // Bytes of decompressed ROM data kept in the cache across runs, 0 disables it
+    uintmax_t cacheLimit = 1024ull * 1024 * 1024;
+    TextureIndexConfig textureIndex;
+    std::string depfilePath;
+    std::string depManifestPath;
+    FilterConfig filters;
 };
 
 struct ParseResultData {
@@ -152,12 +235,28 @@ public:
     std::vector<uint8_t>& GetRomData() { return this->gRomData; }
     std::string GetOutputPath() { return this->gConfig.outputPath; }
     std::string GetDestRelativeOutputPath() { return RelativePathToDestDir(GetOutputPath()); }
+    // Holds data that is expensive to regenerate and can be reused by later runs
+    fs::path GetCacheDirectory() const { return GetCacheDirectory(this->gDestinationDirectory); }
+    static fs::path GetCacheDirectory(const fs::path& destination) { return destination / ".torch_cache"; }
 
     GBIVersion GetGBIVersion() const { return this->gConfig.gbi.version; }
     GBIMinorVersion GetGBIMinorVersion() const { return  this->gConfig.gbi.subversion; }
+    GfxDisassembler GetGfxDisassembler() const { return this->gConfig.gbi.disassembler; }
+    GfxOptimizer GetGfxOptimizer() const { return this->gConfig.gbi.optimizer; }
+    TextureExport GetTextureExport() const { return this->gConfig.textureExport; }
+    PNGCompression GetPNGCompression() const { return this->gConfig.pngCompression; }
+    CompressionEffort GetCompressionEffort() const { return this->gConfig.compressionEffort; }
+    const std::string& GetCurrentFile() const { return this->gCurrentFile; }
+    // Alignment of the asset being exported, from its node or its factory
+    uint32_t GetCurrentAlignment() const { return this->gCurrentAlignment; }
+    // File replacing the asset when importing a mod
+    std::optional<fs::path> GetModdedAssetPath(const std::string& name) const;
     std::unordered_map<std::string, std::vector<YAML::Node>> GetCourseMetadata() { return this->gCourseMetadata; }
     std::optional<std::string> GetEnumFromValue(const std::string& key, int id);
     bool IsUsingIndividualIncludes() const { return this->gIndividualIncludes; }
+    bool IsUnityBuild() const { return this->gConfig.exporterType == ExportType::Code && (this->gConfig.unity || this->gUnityGroup.has_value()); }
+    // Whether data that normally goes to its own .inc.c file should be written inline
+    bool IsInliningData() const { return this->gIndividualIncludes || this->IsUnityBuild(); }
 
     std::optional<ParseResultData> GetParseDataByAddr(uint32_t addr);
     std::optional<ParseResultData> GetParseDataBySymbol(const std::string& symbol);
@@ -166,9 +265,14 @@ public:
     std::optional<std::shared_ptr<BaseFactory>> GetFactory(const std::string& type);
     uint32_t PatchVirtualAddr(uint32_t addr);
     std::optional<std::tuple<std::string, YAML::Node>> GetNodeByAddr(uint32_t addr);
+    // Path hash of the asset at addr, without building its path again
+    std::optional<uint64_t> GetHashByAddr(uint32_t addr);
     std::optional<std::tuple<std::string, YAML::Node>> GetSafeNodeByAddr(const uint32_t addr, std::string type);
-    std::optional<std::vector<std::tuple<std::string, YAML::Node>>> GetNodesByType(const std::string& type);
+    std::optional<std::string> GetSymbolByAddr(uint32_t addr, const std::string& type);
+    std::optional<std::vector<std::tuple<std::string, YAML::Node>>> GetNodesByType(const std::string& type, bool includeAutogen = false);
     std::string GetSymbolFromAddr(uint32_t addr, bool validZero = false);
+    // CRC64 of an asset path as used for OTR references, computed once when the asset is registered
+    uint64_t GetPathHash(const std::string& path);
 
     std::optional<std::uint32_t> GetFileOffset(void) const { return this->gCurrentFileOffset; };
     std::optional<std::uint32_t> GetCurrSegmentNumber(void) const { return this->gCurrentSegmentNumber; };
@@ -178,11 +282,16 @@ public:
 
     static std::string CalculateHash(const std::vector<uint8_t>& data);
     static void Pack(const std::string& folder, const std::string& output, const ArchiveType otrMode);
+    // Lists the entries and size of every cache in the destination directory
+    static void PrintCacheInfo(const std::string& destination);
+    static void ClearCacheDirectory(const std::string& destination);
     std::string NormalizeAsset(const std::string& name) const;
     std::string RelativePath(const std::string& path) const;
     std::string RelativePathToSrcDir(const std::string& path) const;
     std::string RelativePathToDestDir(const std::string& path) const;
     void RegisterCompanionFile(const std::string path, std::vector<char> data);
+    // Used by modding exporters instead of writing to the stream, the image is encoded on the PNG threads
+    void QueueModdingImage(PNGImage image);
 
     TorchConfig& GetConfig() { return this->gConfig; }
     BinaryWrapper* GetCurrentWrapper() { return this->gCurrentWrapper; }
@@ -209,6 +318,7 @@ private:
 
     // Temporal Variables
     std::string gCurrentFile;
+    uint32_t gCurrentAlignment = 4;
     std::string gCurrentVirtualPath;
     std::string gFileHeader;
     bool gEnablePadGen = false;
@@ -219,26 +329,58 @@ private:
     CompressionType gCurrentCompressionType = CompressionType::None;
     std::vector<Table> gTables;
     std::vector<std::string> gCurrentExternalFiles;
+    std::optional<std::string> gUnityGroup;
     std::unordered_set<std::string> gProcessedFiles;
+    // Set while a top-level file is only partially processed because of --only/--symbol/--type
+    bool gFilterAssets = false;
+    std::unordered_map<std::string, std::unordered_set<uint32_t>> gParsedAssets;
 
     std::unordered_map<std::string, std::vector<char>> gCompanionFiles;
     std::unordered_map<std::string, std::vector<ParseResultData>> gParseResults;
 
     std::unordered_map<std::string, std::string> gModdedAssetPaths;
+    std::optional<PNGImage> gModdingImage;
+    std::set<std::string> gGlobalInputs;
+    std::unordered_map<std::string, std::set<std::string>> gFileInputs;
+    std::map<std::string, std::set<std::string>> gDependencies;
+    // Unity output path -> source yaml -> generated code, sorted so the output is deterministic
+    std::map<std::string, std::map<std::string, std::string>> gUnityChunks;
+    std::map<std::string, std::vector<SymbolEntry>> gSymbolIndex;
     std::variant<std::vector<std::string>, std::string> gWriteOrder;
     std::unordered_map<std::string, std::shared_ptr<BaseFactory>> gFactories;
     std::unordered_map<std::string, std::map<std::string, std::vector<WriteEntry>>> gWriteMap;
     std::unordered_map<std::string, std::tuple<uint32_t, uint32_t>> gVirtualAddrMap;
-    std::unordered_map<std::string, std::unordered_map<uint32_t, std::tuple<std::string, YAML::Node>>> gAddrMap;
+    std::unordered_map<std::string, std::unordered_map<uint32_t, AddrEntry>> gAddrMap;
+    std::unordered_map<std::string, uint64_t> gPathHashes;
+    std::vector<TextureIndexEntry> gTextureIndex;
+
+    // Assets registered by AddAsset while parsing, drained in breadth-first passes by ParseWithDependencies
+    std::vector<DiscoveredAsset> gDiscoveryQueue;
+    std::set<AssetKey> gDiscoveryVisited;
+    std::map<AssetKey, std::vector<AssetKey>> gDiscoveryEdges;
+    std::optional<AssetKey> gDiscoveryParent;
 
     void ProcessFile(YAML::Node root);
     void ParseEnums(std::string& file);
     void ParseHash();
     void ParseModdingConfig();
+    void WriteModdingConfig();
     void ParseCurrentFileConfig(YAML::Node node);
     void RegisterFactory(const std::string& type, const std::shared_ptr<BaseFactory>& factory);
     void ExtractNode(YAML::Node& node, std::string& name, BinaryWrapper* binary);
     void ProcessTables(YAML::Node& rom);
+    void RegisterFileDependencies(const std::string& file);
+    const AddrEntry* FindAddrEntry(uint32_t addr);
+    AddrEntry CreateAddrEntry(const std::string& path, YAML::Node& node);
+    void WriteDependencies();
+    void IndexTextures();
+    void WriteTextureIndex();
+    void WriteUnityOutputs();
+    bool IsAssetSelected(const std::string& path, YAML::Node& node) const;
+    bool HasSelectedAssets(YAML::Node& root);
     void LoadYAMLRecursively(const std::string &dirPath, std::vector<YAML::Node> &result, bool skipRoot);
     std::optional<ParseResultData> ParseNode(YAML::Node& node, std::string& name);
+    void ParseWithDependencies(YAML::Node& node, std::string& name);
+    void QueueDiscoveredAsset(const std::string& name, YAML::Node& node);
+    void LinkDiscoveredAsset(const AssetKey& key);
 };
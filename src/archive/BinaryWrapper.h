@@ -11,6 +11,8 @@ public:
     virtual ~BinaryWrapper() = default;
 
     virtual int32_t CreateArchive(void) = 0;
+    // Opens an existing archive so that added files replace their previous versions, creates it if missing
+    virtual int32_t OpenArchive(void) = 0;
     virtual bool AddFile(const std::string& path, std::vector<char> data) = 0;
     virtual int32_t Close(void) = 0;
 protected:
@@ -5,6 +5,7 @@
 
 #include "spdlog/spdlog.h"
 #include <Companion.h>
+#include "utils/FileWriter.h"
 
 namespace fs = std::filesystem;
 
@@ -29,19 +30,30 @@ int32_t SWrapper::CreateArchive() {
 #endif
 }
 
+int32_t SWrapper::OpenArchive() {
+#ifndef USE_STORMLIB
+    throw std::runtime_error("StormLib is not enabled. Cannot open archive");
+#else
+    if(!fs::exists(mPath)) {
+        return CreateArchive();
+    }
+
+    if(!SFileOpenArchive(mPath.c_str(), 0, 0, &this->hMpq)){
+        SPDLOG_ERROR("Failed to open archive {} with error code {}", mPath, GetLastError());
+        return -1;
+    }
+
+    return 0;
+#endif
+}
+
 bool SWrapper::AddFile(const std::string& path, std::vector<char> data) {
 #ifndef USE_STORMLIB
     throw std::runtime_error("StormLib is not enabled. Cannot create file");
 #else
     if(Companion::Instance != nullptr && Companion::Instance->IsDebug()){
         SPDLOG_INFO("Creating debug file: debug/{}", path);
-        std::string dpath = "debug/" + path;
-        if(!fs::exists(fs::path(dpath).parent_path())){
-            fs::create_directories(fs::path(dpath).parent_path());
-        }
-        std::ofstream stream(dpath, std::ios::binary);
-        stream.write((char*)data.data(), data.size());
-        stream.close();
+        FileWriter::Queue("debug/" + path, data);
     }
 
     HANDLE hFile;
@@ -68,7 +80,7 @@ bool SWrapper::AddFile(const std::string& path, std::vector<char> data) {
         throw std::runtime_error("File at path " + path + " is too large with size " + std::to_string(size));
     }
 
-    if(!SFileCreateFile(this->hMpq, path.c_str(), theTime, size, 0, MPQ_FILE_COMPRESS, &hFile)){
+    if(!SFileCreateFile(this->hMpq, path.c_str(), theTime, size, 0, MPQ_FILE_COMPRESS | MPQ_FILE_REPLACEEXISTING, &hFile)){
         return false;
     }
 
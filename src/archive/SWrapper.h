@@ -12,6 +12,7 @@ public:
     explicit SWrapper(const std::string& path);
 
     int32_t CreateArchive(void) override;
+    int32_t OpenArchive(void) override;
     bool AddFile(const std::string& path, std::vector<char> data) override;
     int32_t Close(void) override;
 #ifdef USE_STORMLIB
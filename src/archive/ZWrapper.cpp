@@ -5,6 +5,7 @@
 
 #include "spdlog/spdlog.h"
 #include <Companion.h>
+#include "utils/FileWriter.h"
 #include <miniz/zip_file.hpp>
 
 namespace fs = std::filesystem;
@@ -19,26 +20,39 @@ int32_t ZWrapper::CreateArchive() {
     return 0;
 }
 
-bool ZWrapper::AddFile(const std::string& path, std::vector<char> data) {
-    char* fileData = data.data();
-    size_t fileSize = data.size();
+int32_t ZWrapper::OpenArchive() {
+    if(!fs::exists(mPath)) {
+        return CreateArchive();
+    }
+
+    this->mBase = new miniz_cpp::zip_file(mPath);
+    SPDLOG_INFO("Updating ZIP (O2R) archive: {}", mPath.c_str());
+    return 0;
+}
 
+bool ZWrapper::AddFile(const std::string& path, std::vector<char> data) {
     if(Companion::Instance != nullptr && Companion::Instance->IsDebug()){
         SPDLOG_INFO("Creating debug file: debug/{}", path);
-        std::string dpath = "debug/" + path;
-        if(!fs::exists(fs::path(dpath).parent_path())){
-            fs::create_directories(fs::path(dpath).parent_path());
-        }
-        std::ofstream stream(dpath, std::ios::binary);
-        stream.write(fileData, fileSize);
-        stream.close();
+        FileWriter::Queue("debug/" + path, data);
     }
 
+    this->mEntries.insert(path);
     this->mZip->writebytes(path, data);
     return true;
 }
 
 int32_t ZWrapper::Close(void) {
+    if(this->mBase != nullptr) {
+        // Carry over everything that was not replaced during this run
+        for(auto& name : this->mBase->namelist()) {
+            if(!this->mEntries.contains(name)) {
+                this->mZip->writestr(name, this->mBase->read(name));
+            }
+        }
+        delete this->mBase;
+        this->mBase = nullptr;
+    }
+
     this->mZip->save(this->mPath);
     return 0;
 }
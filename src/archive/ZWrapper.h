@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <unordered_set>
 #include "BinaryWrapper.h"
 
 namespace miniz_cpp {
@@ -13,8 +14,12 @@ public:
     explicit ZWrapper(const std::string& path);
 
     int32_t CreateArchive(void) override;
+    int32_t OpenArchive(void) override;
     bool AddFile(const std::string& path, std::vector<char> data) override;
     int32_t Close(void) override;
 
     miniz_cpp::zip_file* mZip;
+    // Previous contents of the archive when updating it in place
+    miniz_cpp::zip_file* mBase = nullptr;
+    std::unordered_set<std::string> mEntries;
 };
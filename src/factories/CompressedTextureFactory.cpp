@@ -1,16 +1,17 @@
 #include "CompressedTextureFactory.h"
 #include "utils/Decompressor.h"
+#include "utils/Compressor.h"
 #include "spdlog/spdlog.h"
 #include "Companion.h"
+#include "utils/FileWriter.h"
+#include "utils/ModdingCache.h"
+#include "utils/BinaryEmbed.h"
 #include <iomanip>
 #include <regex>
 
 extern "C" {
 #include "n64graphics/n64graphics.h"
 #include "BaseFactory.h"
-#include <libmio0/mio0.h>
-#include <libyay0/yay0.h>
-#include <libyay0/yay1.h>
 }
 
 static bool isTable = false;
@@ -37,6 +38,13 @@ static const std::unordered_map <std::string, CompressionType> sCompressionTypes
     { "YAZ0", CompressionType::YAZ0 },
 };
 
+const std::vector<uint8_t>& CompressedTextureData::GetCompressed() {
+    if(!this->mCompressed.has_value()) {
+        this->mCompressed = Compressor::EncodeCached(this->mBuffer, this->mCompressionType, Companion::Instance->GetCompressionEffort());
+    }
+    return this->mCompressed.value();
+}
+
 ExportResult CompressedTextureHeaderExporter::Export(std::ostream &write, std::shared_ptr<IParsedData> raw, std::string& entryName, YAML::Node &node, std::string* replacement) {
     const auto symbol = GetSafeNode(node, "symbol", entryName);
     const auto offset = GetSafeNode<uint32_t>(node, "offset");
@@ -78,33 +86,7 @@ ExportResult CompressedTextureHeaderExporter::Export(std::ostream &write, std::s
         } else {
             write << "extern " << "u8 " << symbol << "[];\n";
             if (Companion::Instance->AddTextureDefines()) {
-                // Allocate worse case size
-                uint8_t* compressedData;
-                size_t compressedSize;
-                size_t worstSize;
-
-                switch (texture->mCompressionType) {
-                    case CompressionType::MIO0:
-                        worstSize = MIO0_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-                        compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-                        compressedSize = mio0_encode(data.data(), data.size(), compressedData);
-                        break;
-                    case CompressionType::YAY0:
-                        worstSize = YAY0_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-                        compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-                        compressedSize = yay0_encode(data.data(), data.size(), compressedData);
-                        break;
-                    case CompressionType::YAY1:
-                        worstSize = YAY1_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-                        compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-                        compressedSize = yay1_encode(data.data(), data.size(), compressedData);
-                        break;
-                    default:
-                        // UNIMPLEMENTED
-                        throw std::runtime_error("Unsupported Compressed Texture Type");
-                        break;
-                }
-                write << "#define _" << symbol << "_COMPRESSED_SIZE 0x" << std::hex << compressedSize << std::dec << "\n";
+                write << "#define _" << symbol << "_COMPRESSED_SIZE 0x" << std::hex << texture->GetCompressed().size() << std::dec << "\n";
                 write << "#define _" << symbol << "_WIDTH 0x" << std::hex << texture->mWidth << std::dec << "\n";
                 write << "#define _" << symbol << "_HEIGHT 0x" << std::hex << texture->mHeight << std::dec << "\n";
             }
@@ -125,9 +107,6 @@ ExportResult CompressedTextureCodeExporter::Export(std::ostream &write, std::sha
     (*replacement) += "." + format;
 
     std::string dpath = Companion::Instance->GetOutputPath() + "/" + (*replacement);
-    if(!exists(fs::path(dpath).parent_path())){
-        create_directories(fs::path(dpath).parent_path());
-    }
 
     std::ostringstream imgstream;
 
@@ -149,39 +128,32 @@ ExportResult CompressedTextureCodeExporter::Export(std::ostream &write, std::sha
     }
     imgstream << std::endl;
 
-    std::ofstream file(dpath + ".inc.c", std::ios::binary);
-    file << imgstream.str();
-    file.close();
+    const bool inlineData = Companion::Instance->IsUnityBuild();
 
-    // Allocate worse case size
-    uint8_t* compressedData;
-    size_t compressedSize;
-    size_t worstSize;
+    if (!inlineData) {
+        FileWriter::Queue(dpath + ".inc.c", imgstream.str());
+    }
 
-    switch (texture->mCompressionType) {
-        case CompressionType::MIO0:
-            worstSize = MIO0_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-            compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-            compressedSize = mio0_encode(data.data(), data.size(), compressedData);
-            break;
-        case CompressionType::YAY0:
-            worstSize = YAY0_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-            compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-            compressedSize = yay0_encode(data.data(), data.size(), compressedData);
-            break;
-        case CompressionType::YAY1:
-            worstSize = YAY1_HEADER_LENGTH + ((data.size()+7)/8) + data.size();
-            compressedData = static_cast<uint8_t*>(std::calloc(worstSize, sizeof(uint8_t)));
-            compressedSize = yay1_encode(data.data(), data.size(), compressedData);
-            break;
-        default:
-            // UNIMPLEMENTED
-            throw std::runtime_error("Unsupported Compressed Texture Type");
-            break;
+    const auto& compressed = texture->GetCompressed();
+    const auto compressedData = compressed.data();
+    const auto compressedSize = compressed.size();
+    const auto searchTable = Companion::Instance->SearchTable(offset);
+
+    if (!searchTable.has_value() && BinaryEmbed::WriteDefinition(write, "u8", symbol, *replacement, compressedData, compressedSize)) {
+        if (Companion::Instance->IsDebug()) {
+            write << "// size: 0x" << std::hex << std::uppercase << data.size();
+        }
+
+        write << "\n";
+        return offset + compressedSize;
     }
-    if (compressedData) {
-        std::ostringstream compressedStream;
 
+    std::ostringstream embedstream;
+    const bool embedded = searchTable.has_value() && BinaryEmbed::WriteElements(embedstream, *replacement, compressedData, compressedSize, 1, std::string(tab_t) + tab_t);
+
+    std::ostringstream compressedStream;
+
+    if (!embedded) {
         for (size_t i = 0; i < compressedSize; i++) {
             if (i % 16 == 0 && i != 0) {
                 compressedStream << std::endl;
@@ -193,14 +165,11 @@ ExportResult CompressedTextureCodeExporter::Export(std::ostream &write, std::sha
         }
         compressedStream << std::endl;
 
-        std::ofstream file(dpath + ".incbin.c", std::ios::binary);
-        file << compressedStream.str();
-        file.close();
-        free(compressedData);
+        if (!inlineData) {
+            FileWriter::Queue(dpath + ".incbin.c", compressedStream.str());
+        }
     }
 
-    const auto searchTable = Companion::Instance->SearchTable(offset);
-
     if(searchTable.has_value()){
         const auto [name, start, end, mode, index_size] = searchTable.value();
 
@@ -218,7 +187,13 @@ ExportResult CompressedTextureCodeExporter::Export(std::ostream &write, std::sha
 
         write << tab_t << "{\n";
 
-        write << tab_t << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".incbin.c\"\n";
+        if (embedded) {
+            write << embedstream.str();
+        } else if (inlineData) {
+            write << compressedStream.str();
+        } else {
+            write << tab_t << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".incbin.c\"\n";
+        }
 
         write << tab_t << "},\n";
 
@@ -231,7 +206,11 @@ ExportResult CompressedTextureCodeExporter::Export(std::ostream &write, std::sha
     } else {
         write << "u8 " << symbol  << "[] = {\n";
 
-        write << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".incbin.c\"\n";
+        if (inlineData) {
+            write << compressedStream.str();
+        } else {
+            write << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".incbin.c\"\n";
+        }
 
         write << "};\n";
 
@@ -271,8 +250,7 @@ ExportResult CompressedTextureBinaryExporter::Export(std::ostream &write, std::s
 ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::shared_ptr<IParsedData> data, std::string&entryName, YAML::Node&node, std::string* replacement) {
     auto texture = std::static_pointer_cast<CompressedTextureData>(data);
     auto format = texture->mFormat;
-    uint8_t* raw = new uint8_t[TextureUtils::CalculateTextureSize(format.type, texture->mWidth, texture->mHeight) * 2];
-    int size = 0;
+    PNGImage image;
 
     auto ext = GetSafeNode<std::string>(node, "format");
 
@@ -283,8 +261,8 @@ ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::s
         case TextureType::TLUT:
         case TextureType::RGBA16bpp:
         case TextureType::RGBA32bpp: {
-            rgba* imgr = raw2rgba(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(rgba2png(&raw, &size, imgr, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::RGBA, texture->mWidth, texture->mHeight);
+            if(raw2rgba_into(reinterpret_cast<rgba*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
@@ -293,8 +271,8 @@ ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::s
         case TextureType::GrayscaleAlpha8bpp:
         case TextureType::GrayscaleAlpha4bpp:
         case TextureType::GrayscaleAlpha1bpp: {
-            ia* imgia = raw2ia(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(ia2png(&raw, &size, imgia, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, texture->mWidth, texture->mHeight);
+            if(raw2ia_into(reinterpret_cast<ia*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
@@ -307,7 +285,7 @@ ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::s
 
                 if (palette.has_value()) {
                     auto palTexture = std::static_pointer_cast<TextureData>(palette.value().data.value());
-                    convert_raw_to_ci8(&raw, &size, texture->mBuffer.data(), (uint8_t *)palTexture->mBuffer.data(), 0, texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mFormat.depth);
+                    image = PNGEncoder::CreatePaletteImage(texture->mBuffer.data(), texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mBuffer, palTexture->mFormat.depth);
                 } else {
                     auto symbol = GetSafeNode<std::string>(node, "symbol");
                     throw std::runtime_error("Could not convert ci8 '"+symbol+"' the tlut symbol name is probably wrong for tlut_symbol node");
@@ -321,7 +299,7 @@ ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::s
 
                 if (palette.has_value()) {
                     auto palTexture = std::static_pointer_cast<TextureData>(palette.value().data.value());
-                    convert_raw_to_ci8(&raw, &size, texture->mBuffer.data(), (uint8_t *)palTexture->mBuffer.data(), 0, texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mFormat.depth);
+                    image = PNGEncoder::CreatePaletteImage(texture->mBuffer.data(), texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mBuffer, palTexture->mFormat.depth);
                 } else {
                     auto symbol = GetSafeNode<std::string>(node, "symbol");
                     throw std::runtime_error("Could not convert ci8 '"+symbol+"' the address is probably wrong for tlut address node");
@@ -331,18 +309,19 @@ ExportResult CompressedTextureModdingExporter::Export(std::ostream&write, std::s
         }
         case TextureType::Grayscale8bpp:
         case TextureType::Grayscale4bpp: {
-            ia* imgi = raw2i(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(ia2png(&raw, &size, imgi, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, texture->mWidth, texture->mHeight);
+            if(raw2i_into(reinterpret_cast<ia*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
         }
         default: {
             SPDLOG_ERROR("Unsupported texture format for modding: {}", ext);
+            return std::nullopt;
         }
     }
 
-    write.write(reinterpret_cast<char*>(raw), size);
+    Companion::Instance->QueueModdingImage(std::move(image));
     return std::nullopt;
 }
 
@@ -363,6 +342,25 @@ std::string getcomptype(CompressionType type) {
     return "None";
 }
 
+// CI textures that carry a tlut offset and a color count bring in their TLUT as its own asset
+static void AddTlutAsset(YAML::Node& node, const std::string& symbol) {
+    YAML::Node tlutNode;
+    const auto tlutOffset = GetSafeNode<uint32_t>(node, "tlut");
+    const auto tlutSymbol = GetSafeNode(node, "tlut_symbol", symbol + "_tlut");
+    std::ostringstream offsetSeg;
+    offsetSeg << std::uppercase << std::hex << tlutOffset;
+    tlutNode["symbol"] = std::regex_replace(tlutSymbol, std::regex(R"(OFFSET)"), offsetSeg.str());
+    tlutNode["type"] = "TEXTURE";
+    tlutNode["format"] = "TLUT";
+    tlutNode["offset"] = tlutOffset;
+    tlutNode["colors"] = GetSafeNode<uint32_t>(node, "colors");
+    node["tlut"] = tlutOffset;
+    if(node["tlut_ctype"]) {
+        tlutNode["ctype"] = GetSafeNode<std::string>(node, "tlut_ctype");
+    }
+    Companion::Instance->AddAsset(tlutNode);
+}
+
 std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse(std::vector<uint8_t>& buffer, YAML::Node& node) {
     auto offset = GetSafeNode<uint32_t>(node, "offset");
     auto format = GetSafeNode<std::string>(node, "format");
@@ -375,7 +373,7 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse(std:
     if (!sCompressionTypes.contains(compression)) {
         SPDLOG_ERROR("Compresed Texture entry at {:X} in yaml missing compression type\n\
                       Please add one of the following compression types\n\
-                      MIO0, YAY0, YAY1, YAZ0 (Unsupported)", offset);
+                      MIO0, YAY0, YAY1, YAZ0", offset);
         return std::nullopt;
     }
     compressionType = sCompressionTypes.at(compression);
@@ -414,21 +412,7 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse(std:
     }
 
     if((format == "CI4" || format == "CI8") && node["tlut"] && node["colors"]) {
-        YAML::Node tlutNode;
-        const auto tlutOffset = GetSafeNode<uint32_t>(node, "tlut");
-        const auto tlutSymbol = GetSafeNode(node, "tlut_symbol", symbol + "_tlut");
-        std::ostringstream offsetSeg;
-        offsetSeg << std::uppercase << std::hex << tlutOffset;
-        tlutNode["symbol"] = std::regex_replace(tlutSymbol, std::regex(R"(OFFSET)"), offsetSeg.str());
-        tlutNode["type"] = "TEXTURE";
-        tlutNode["format"] = "TLUT";
-        tlutNode["offset"] = tlutOffset;
-        tlutNode["colors"] = GetSafeNode<uint32_t>(node, "colors");
-        node["tlut"] = tlutOffset;
-        if(node["tlut_ctype"]) {
-            tlutNode["ctype"] = GetSafeNode<std::string>(node, "tlut_ctype");
-        }
-        Companion::Instance->AddAsset(tlutNode);
+        AddTlutAsset(node, symbol);
     }
     size = GetSafeNode<uint32_t>(node, "size", TextureUtils::CalculateTextureSize(sTextureFormats.at(format).type, width, height));
 
@@ -440,6 +424,11 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse(std:
         result = std::vector(uncompressedData->data, uncompressedData->data + uncompressedData->size);
     }
 
+    // Textures sharing their TLUT with a modded CI texture are remapped to the palette quantized for it
+    if(auto imported = ModdingCache::ImportPalette(node)) {
+        result = std::move(imported->data);
+    }
+
     SPDLOG_INFO("Texture: {}", format);
     if(fmt.type == TextureType::TLUT){
         SPDLOG_INFO("Colors: {}", width);
@@ -463,6 +452,7 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse(std:
 
 std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse_modding(std::vector<uint8_t>& buffer, YAML::Node& node) {
     auto format = GetSafeNode<std::string>(node, "format");
+    auto symbol = GetSafeNode<std::string>(node, "symbol", "texture");
     int width;
     int height;
     uint32_t size;
@@ -472,7 +462,7 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse_modd
     if (!sCompressionTypes.contains(compression)) {
         SPDLOG_ERROR("Compresed Texture entry at {:X} in yaml missing compression type\n\
                       Please add one of the following compression types\n\
-                      MIO0, YAY0, YAY1, YAZ0 (Unsupported)", offset);
+                      MIO0, YAY0, YAY1, YAZ0", offset);
         return std::nullopt;
     }
     compressionType = sCompressionTypes.at(compression);
@@ -484,6 +474,8 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse_modd
         return std::nullopt;
     }
 
+    std::transform(format.begin(), format.end(), format.begin(), ::toupper);
+
     if(!sTextureFormats.contains(format)) {
         return std::nullopt;
     }
@@ -497,69 +489,46 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse_modd
         height = GetSafeNode<uint32_t>(node, "height");
     }
 
-    uint8_t* raw;
+    if((format == "CI4" || format == "CI8") && node["tlut"] && node["colors"]) {
+        AddTlutAsset(node, symbol);
+    }
+
+    std::vector<uint8_t> result;
     switch (fmt.type) {
-        case TextureType::TLUT:
         case TextureType::RGBA16bpp:
-        case TextureType::RGBA32bpp: {
-            const auto imgr = png2rgba(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(rgba2raw(raw, imgr, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
-            }
-            break;
-        }
+        case TextureType::RGBA32bpp:
         case TextureType::GrayscaleAlpha16bpp:
         case TextureType::GrayscaleAlpha8bpp:
         case TextureType::GrayscaleAlpha4bpp:
-        case TextureType::GrayscaleAlpha1bpp: {
-            const auto imgia = png2ia(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(ia2raw(raw, imgia, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
-            }
+        case TextureType::GrayscaleAlpha1bpp:
+        case TextureType::Grayscale8bpp:
+        case TextureType::Grayscale4bpp: {
+            auto texture = ModdingCache::ImportTexture(buffer, fmt);
+            width = texture.width;
+            height = texture.height;
+            result = std::move(texture.data);
+            size = result.size();
             break;
         }
+        case TextureType::TLUT:
         case TextureType::Palette8bpp:
         case TextureType::Palette4bpp: {
-            // This implementation is not correct.
-            // The process should be:
-            // png2rgba --> imgpal2rawci
-
-            // todo: Add wheel palette input
-            // Implement so that it works.
-
-            // auto tlut = GetSafeNode<std::string>(node,"tlut_symbol");
-            // auto tlutTextureMap = Companion::Instance->GetTlutTextureMap();
-            // auto palettePtr = tlutTextureMap[tlut];
-
-            // if (palettePtr) {
-
-            //     auto imgi = png2rgba(buffer.data(), buffer.size(), &width, &height);
-            //     auto pal = png2rgba(palettePtr->mBuffer.data(), (palettePtr->mWidth * palettePtr->mWidth * palettePtr->mFormat.depth * 2), &width, &height);
-
-            //     size = width * height * fmt.depth / 8;
-            //     raw = new uint8_t[size];
-
-            //     if(imgpal2rawci(raw, imgi, pal, 0, 0, width, height, fmt.depth) <= 0){
-            //         throw std::runtime_error("Failed to convert PNG to texture");
-            //     }
-            // } else {
+            // CI textures are quantized together with everything sharing their TLUT, an edited TLUT image is only
+            // used as is when none of those textures is modded
+            auto texture = ModdingCache::ImportPalette(node);
+            if(!texture.has_value() && fmt.type == TextureType::TLUT) {
+                texture = ModdingCache::ImportTexture(buffer, fmt);
+            }
 
-            // }
-            SPDLOG_ERROR("Unsupported texture format for modding: {}", format);
-            return std::nullopt;
-        }
-        case TextureType::Grayscale8bpp:
-        case TextureType::Grayscale4bpp: {
-            const auto imgi = png2ia(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(i2raw(raw, imgi, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
+            if(!texture.has_value()) {
+                SPDLOG_ERROR("No tlut found for {}, add a tlut or tlut_symbol node to import it", symbol);
+                return std::nullopt;
             }
+
+            width = texture->width;
+            height = texture->height;
+            result = std::move(texture->data);
+            size = result.size();
             break;
         }
         default: {
@@ -568,8 +537,6 @@ std::optional<std::shared_ptr<IParsedData>> CompressedTextureFactory::parse_modd
         }
     }
 
-    auto result = std::vector(raw, raw + size);
-
     SPDLOG_INFO("Texture: {}", format);
     if(fmt.type == TextureType::TLUT){
         SPDLOG_INFO("Colors: {}", width);
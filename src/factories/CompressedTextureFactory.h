@@ -13,6 +13,11 @@ public:
     CompressionType mCompressionType;
 
     CompressedTextureData(TextureFormat format, uint32_t width, uint32_t height, std::vector<uint8_t>& buffer, CompressionType compressionType) : mFormat(format), mWidth(width), mHeight(height), mBuffer(std::move(buffer)), mCompressionType(compressionType) {}
+
+    // Compressed on first use and shared by every exporter of the asset
+    const std::vector<uint8_t>& GetCompressed();
+private:
+    std::optional<std::vector<uint8_t>> mCompressed;
 };
 
 class CompressedTextureHeaderExporter : public BaseExporter {
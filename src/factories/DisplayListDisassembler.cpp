@@ -0,0 +1,1665 @@
+#include "DisplayListDisassembler.h"
+
+#ifdef STANDALONE
+#include "DisplayListOverrides.h"
+#include "GBIOpcodes.h"
+#include "Companion.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <mutex>
+#include <gfxd.h>
+
+#define C0(pos, width) ((w0 >> (pos)) & ((1U << width) - 1))
+#define C1(pos, width) ((w1 >> (pos)) & ((1U << width) - 1))
+
+// gfxd keeps its configuration and callbacks in globals, so only one list can go through it at a time
+static std::mutex sGfxdMutex;
+
+struct GfxdOutput {
+    std::string text;
+    std::string indent;
+    bool stopped = false;
+    // Stops gfxd after the first macro, packets counts the commands it took
+    bool single = false;
+    size_t packets = 0;
+};
+
+void GFXDSetGBIVersion(){
+    switch (Companion::Instance->GetGBIVersion()) {
+        case GBIVersion::f3d:
+            gfxd_target(gfxd_f3d);
+            break;
+        case GBIVersion::f3dex:
+            gfxd_target(gfxd_f3dex);
+            break;
+        case GBIVersion::f3db:
+            gfxd_target(gfxd_f3db);
+            break;
+        case GBIVersion::f3dex2:
+            gfxd_target(gfxd_f3dex2);
+            break;
+        case GBIVersion::f3dexb:
+            gfxd_target(gfxd_f3dexb);
+            break;
+    }
+}
+
+// Holds gfxd for one display list, configured once and fed each command the native disassembler can't reproduce
+class GfxdSession {
+  public:
+    explicit GfxdSession(const std::string& indent) : mLock(sGfxdMutex) {
+        mOutput.indent = indent;
+
+        gfxd_udata_set(&mOutput);
+        gfxd_output_callback([](const char* buf, int count) {
+            static_cast<GfxdOutput*>(gfxd_udata_get())->text.append(buf, count);
+            return count;
+        });
+
+        gfxd_endian(gfxd_endian_host, sizeof(uint32_t));
+        gfxd_macro_fn([] {
+            auto output = static_cast<GfxdOutput*>(gfxd_udata_get());
+            auto gfx = static_cast<const N64Gfx*>(gfxd_macro_data());
+            const uint8_t opcode = (gfx->words.w0 >> 24) & 0xFF;
+            const auto& gbi = GetGBIOpcodes(Companion::Instance->GetGBIVersion());
+
+            gfxd_puts(output->indent.c_str());
+
+            // For mk64 only
+            if(opcode == gbi.quad && Companion::Instance->GetGBIMinorVersion() == GBIMinorVersion::Mk64) {
+                GFXDOverride::Quadrangle(gfx);
+            // Prevents mix and matching of quadrangle commands. Forces 2TRI only.
+            } else if(opcode == gbi.tri2) {
+                GFXDOverride::Triangle2(gfx);
+            } else {
+                gfxd_macro_dflt();
+            }
+
+            switch (gfxd_macro_id()) {
+                case gfxd_Invalid:
+                case gfxd_SPEndDisplayList:
+                case gfxd_SPBranchList:
+                    output->stopped = true;
+                    break;
+            }
+
+            gfxd_puts(",\n");
+            output->packets += gfxd_macro_packets();
+            return output->single ? 1 : 0;
+        });
+
+        gfxd_vtx_callback(GFXDOverride::Vtx);
+        gfxd_timg_callback(GFXDOverride::Texture);
+        gfxd_dl_callback(GFXDOverride::DisplayList);
+        gfxd_tlut_callback(GFXDOverride::Palette);
+        gfxd_lightsn_callback(GFXDOverride::Lights);
+        gfxd_light_callback(GFXDOverride::Light);
+        gfxd_vp_callback(GFXDOverride::Viewport);
+        gfxd_mtx_callback(GFXDOverride::Matrix);
+        GFXDSetGBIVersion();
+    }
+
+    ~GfxdSession() {
+        gfxd_udata_set(nullptr);
+    }
+
+    // Appends the macros of the range to out, or only its first one when single is set. Returns how many commands
+    // were rendered, stopped is set if gfxd ended on an invalid command, an end or a branch
+    size_t Run(const uint32_t* cmds, const size_t count, std::string& out, const bool single, bool& stopped) {
+        mOutput.text.clear();
+        mOutput.stopped = false;
+        mOutput.single = single;
+        mOutput.packets = 0;
+        gfxd_input_buffer(cmds, sizeof(uint32_t) * 2 * count);
+        gfxd_execute();
+        out += mOutput.text;
+        stopped = mOutput.stopped;
+        return mOutput.packets;
+    }
+
+  private:
+    std::lock_guard<std::mutex> mLock;
+    GfxdOutput mOutput;
+};
+
+static constexpr uint32_t TX_RENDERTILE = 0;
+static constexpr uint32_t TX_LOADTILE = 7;
+
+// G_IM_SIZ_* values
+static constexpr uint32_t IM_SIZ_4b = 0;
+static constexpr uint32_t IM_SIZ_8b = 1;
+static constexpr uint32_t IM_SIZ_16b = 2;
+static constexpr uint32_t IM_SIZ_32b = 3;
+
+// G_MW_* indices
+static constexpr uint32_t MW_NUMLIGHT = 0x02;
+static constexpr uint32_t MW_CLIP = 0x04;
+static constexpr uint32_t MW_SEGMENT = 0x06;
+static constexpr uint32_t MW_FOG = 0x08;
+static constexpr uint32_t MW_LIGHTCOL = 0x0A;
+static constexpr uint32_t MW_POINTS = 0x0C;
+static constexpr uint32_t MW_PERSPNORM = 0x0E;
+
+struct GBIName {
+    uint32_t value;
+    const char* name;
+};
+
+static constexpr uint32_t Bits(const uint32_t value, const uint32_t pos, const uint32_t width) {
+    return (value & ((1U << width) - 1)) << pos;
+}
+
+static constexpr N64Words Cmd(const uint8_t opcode, const uint32_t w0, const uint32_t w1) {
+    return { Bits(opcode, 24, 8) | w0, w1 };
+}
+
+static constexpr bool Same(const N64Words& a, const uint32_t w0, const uint32_t w1) {
+    return a.w0 == w0 && a.w1 == w1;
+}
+
+/*
+ * Encoders for the RDP macros of gbi.h. A macro is only printed when encoding
+ * its arguments back gives the exact words of the list, anything else is left to gfxd.
+ */
+
+static constexpr N64Words SetImage(const uint8_t opcode, const uint32_t fmt, const uint32_t siz, const uint32_t width, const uint32_t img) {
+    return Cmd(opcode, Bits(fmt, 21, 3) | Bits(siz, 19, 2) | Bits(width - 1, 0, 12), img);
+}
+
+static constexpr N64Words SetTextureImage(const uint32_t fmt, const uint32_t siz, const uint32_t width, const uint32_t img) {
+    return SetImage(gRDPOpcodes.settimg, fmt, siz, width, img);
+}
+
+// Wrap, mask and shift fields of a G_SETTILE, shared by the load and render tiles of the texture macros
+static constexpr uint32_t TileWrap(const uint32_t w1) {
+    return w1 & 0xFFFFF;
+}
+
+static constexpr N64Words SetTile(const uint32_t fmt, const uint32_t siz, const uint32_t line, const uint32_t tmem,
+                                  const uint32_t tile, const uint32_t palette, const uint32_t wrap) {
+    return Cmd(gRDPOpcodes.settile, Bits(fmt, 21, 3) | Bits(siz, 19, 2) | Bits(line, 9, 9) | Bits(tmem, 0, 9),
+               Bits(tile, 24, 3) | Bits(palette, 20, 4) | TileWrap(wrap));
+}
+
+static constexpr N64Words TileCmd(const uint8_t opcode, const uint32_t tile, const uint32_t uls, const uint32_t ult, const uint32_t lrs, const uint32_t lrt) {
+    return Cmd(opcode, Bits(uls, 12, 12) | Bits(ult, 0, 12), Bits(tile, 24, 3) | Bits(lrs, 12, 12) | Bits(lrt, 0, 12));
+}
+
+static constexpr N64Words LoadTLUTCmd(const uint32_t tile, const uint32_t count) {
+    return Cmd(gRDPOpcodes.loadtlut, 0, Bits(tile, 24, 3) | Bits(count, 14, 10));
+}
+
+static constexpr N64Words Sync(const uint8_t opcode) {
+    return Cmd(opcode, 0, 0);
+}
+
+// CALC_DXT and CALC_DXT_4b
+static constexpr uint32_t CalcDxt(const uint32_t width, const uint32_t siz) {
+    const uint32_t words = std::max(1U, siz == IM_SIZ_4b ? width / 16 : width * (1U << (siz - 1)) / 8);
+    return ((1U << 11) + words - 1) / words;
+}
+
+/*
+ * Argument formatting, matching the macro arguments gfxd used to print
+ */
+
+static std::string Hex(const uint32_t value, const int digits) {
+    return fmt::format("0x{:0{}X}", value, digits);
+}
+
+// Commands without a macro are written as their words, which the Gfx union takes as is
+static std::string Address(const std::optional<std::string>& symbol, const uint32_t ptr) {
+    return symbol.has_value() ? symbol.value() : Hex(ptr, 8);
+}
+
+static std::optional<std::string> FindName(const uint32_t value, std::initializer_list<GBIName> names) {
+    for(const auto& entry : names) {
+        if(entry.value == value) {
+            return entry.name;
+        }
+    }
+    return std::nullopt;
+}
+
+static std::string Name(const uint32_t value, std::initializer_list<GBIName> names) {
+    const auto name = FindName(value, names);
+    return name.has_value() ? name.value() : std::to_string(value);
+}
+
+// Names every flag set in value, whatever has no name is kept as a hex number
+template<size_t N>
+static std::string Flags(uint32_t value, const GBIName (&names)[N]) {
+    std::string out;
+    auto append = [&out](const std::string& term) {
+        out += out.empty() ? term : " | " + term;
+    };
+
+    for(const auto& entry : names) {
+        if(entry.value != 0 && (value & entry.value) == entry.value) {
+            append(entry.name);
+            value &= ~entry.value;
+        }
+    }
+
+    if(value != 0) {
+        append(Hex(value, 8));
+    }
+
+    return out.empty() ? "0" : out;
+}
+
+static std::string ImFmt(const uint32_t fmt) {
+    return Name(fmt, { {0, "G_IM_FMT_RGBA"}, {1, "G_IM_FMT_YUV"}, {2, "G_IM_FMT_CI"}, {3, "G_IM_FMT_IA"}, {4, "G_IM_FMT_I"} });
+}
+
+static std::string ImSiz(const uint32_t siz) {
+    return Name(siz, { {IM_SIZ_4b, "G_IM_SIZ_4b"}, {IM_SIZ_8b, "G_IM_SIZ_8b"}, {IM_SIZ_16b, "G_IM_SIZ_16b"}, {IM_SIZ_32b, "G_IM_SIZ_32b"} });
+}
+
+static std::string Tile(const uint32_t tile) {
+    return Name(tile, { {TX_RENDERTILE, "G_TX_RENDERTILE"}, {TX_LOADTILE, "G_TX_LOADTILE"} });
+}
+
+static std::string TexCm(const uint32_t cm) {
+    return std::string(cm & 1 ? "G_TX_MIRROR" : "G_TX_NOMIRROR") + " | " + (cm & 2 ? "G_TX_CLAMP" : "G_TX_WRAP");
+}
+
+static std::string TexMask(const uint32_t mask) {
+    return mask == 0 ? "G_TX_NOMASK" : std::to_string(mask);
+}
+
+static std::string TexShift(const uint32_t shift) {
+    return shift == 0 ? "G_TX_NOLOD" : std::to_string(shift);
+}
+
+// The cms, cmt, masks, maskt, shifts, shiftt arguments of the texture load macros
+static std::string TexWrap(const uint32_t w1) {
+    return fmt::format("{}, {}, {}, {}, {}, {}", TexCm(C1(8, 2)), TexCm(C1(18, 2)), TexMask(C1(4, 4)), TexMask(C1(14, 4)),
+                       TexShift(C1(0, 4)), TexShift(C1(10, 4)));
+}
+
+// Fixed point arguments print through the q macros, qu102(1.5) is 6
+static std::string Fixed(const char* macro, const double value) {
+    return value == 0 ? "0" : fmt::format("{}({})", macro, value);
+}
+
+static std::string Qu102(const uint32_t value) {
+    return Fixed("qu102", value / 4.0);
+}
+
+static std::string Qs105(const uint32_t value) {
+    return Fixed("qs105", static_cast<int16_t>(value) / 32.0);
+}
+
+static std::string Qs510(const uint32_t value) {
+    return Fixed("qs510", static_cast<int16_t>(value) / 1024.0);
+}
+
+/*
+ * Othermode names
+ */
+
+struct OtherModeField {
+    uint32_t shift;
+    uint32_t length;
+    const char* shiftName;
+    const char* macro;
+    GBIName names[4];
+};
+
+static constexpr OtherModeField sOtherModeH[] = {
+    { 4, 2, "G_MDSFT_ALPHADITHER", "gsDPSetAlphaDither", { {0x00, "G_AD_PATTERN"}, {0x10, "G_AD_NOTPATTERN"}, {0x20, "G_AD_NOISE"}, {0x30, "G_AD_DISABLE"} } },
+    { 6, 2, "G_MDSFT_RGBDITHER", "gsDPSetColorDither", { {0x00, "G_CD_MAGICSQ"}, {0x40, "G_CD_BAYER"}, {0x80, "G_CD_NOISE"}, {0xC0, "G_CD_DISABLE"} } },
+    { 8, 1, "G_MDSFT_COMBKEY", "gsDPSetCombineKey", { {0x000, "G_CK_NONE"}, {0x100, "G_CK_KEY"} } },
+    { 9, 3, "G_MDSFT_TEXTCONV", "gsDPSetTextureConvert", { {0x000, "G_TC_CONV"}, {0xA00, "G_TC_FILTCONV"}, {0xC00, "G_TC_FILT"} } },
+    { 12, 2, "G_MDSFT_TEXTFILT", "gsDPSetTextureFilter", { {0x0000, "G_TF_POINT"}, {0x3000, "G_TF_AVERAGE"}, {0x2000, "G_TF_BILERP"} } },
+    { 14, 2, "G_MDSFT_TEXTLUT", "gsDPSetTextureLUT", { {0x0000, "G_TT_NONE"}, {0x8000, "G_TT_RGBA16"}, {0xC000, "G_TT_IA16"} } },
+    { 16, 1, "G_MDSFT_TEXTLOD", "gsDPSetTextureLOD", { {0x00000, "G_TL_TILE"}, {0x10000, "G_TL_LOD"} } },
+    { 17, 2, "G_MDSFT_TEXTDETAIL", "gsDPSetTextureDetail", { {0x00000, "G_TD_CLAMP"}, {0x20000, "G_TD_SHARPEN"}, {0x40000, "G_TD_DETAIL"} } },
+    { 19, 1, "G_MDSFT_TEXTPERSP", "gsDPSetTexturePersp", { {0x00000, "G_TP_NONE"}, {0x80000, "G_TP_PERSP"} } },
+    { 20, 2, "G_MDSFT_CYCLETYPE", "gsDPSetCycleType", { {0x000000, "G_CYC_1CYCLE"}, {0x100000, "G_CYC_2CYCLE"}, {0x200000, "G_CYC_COPY"}, {0x300000, "G_CYC_FILL"} } },
+    { 22, 1, "G_MDSFT_COLORDITHER", nullptr, {} },
+    { 23, 1, "G_MDSFT_PIPELINE", "gsDPPipelineMode", { {0x000000, "G_PM_NPRIMITIVE"}, {0x800000, "G_PM_1PRIMITIVE"} } },
+};
+
+static constexpr OtherModeField sOtherModeL[] = {
+    { 0, 2, "G_MDSFT_ALPHACOMPARE", "gsDPSetAlphaCompare", { {0, "G_AC_NONE"}, {1, "G_AC_THRESHOLD"}, {3, "G_AC_DITHER"} } },
+    { 2, 1, "G_MDSFT_ZSRCSEL", "gsDPSetDepthSource", { {0, "G_ZS_PIXEL"}, {4, "G_ZS_PRIM"} } },
+    { 3, 29, "G_MDSFT_RENDERMODE", "gsDPSetRenderMode", {} },
+};
+
+static std::optional<std::string> FieldName(const OtherModeField& field, const uint32_t value) {
+    for(const auto& entry : field.names) {
+        if(entry.name != nullptr && entry.value == value) {
+            return entry.name;
+        }
+    }
+    return std::nullopt;
+}
+
+// Render mode flags and blender inputs, see RM_* in gbi.h
+enum RenderModeFlag : uint32_t {
+    AA_EN = 0x8,
+    Z_CMP = 0x10,
+    Z_UPD = 0x20,
+    IM_RD = 0x40,
+    CLR_ON_CVG = 0x80,
+    CVG_DST_CLAMP = 0,
+    CVG_DST_WRAP = 0x100,
+    CVG_DST_FULL = 0x200,
+    CVG_DST_SAVE = 0x300,
+    ZMODE_OPA = 0,
+    ZMODE_INTER = 0x400,
+    ZMODE_XLU = 0x800,
+    ZMODE_DEC = 0xC00,
+    CVG_X_ALPHA = 0x1000,
+    ALPHA_CVG_SEL = 0x2000,
+    FORCE_BL = 0x4000,
+    AC_DITHER = 0x3,
+};
+
+enum BlenderInput : uint32_t { CLR_IN = 0, CLR_MEM = 1, CLR_BL = 2, CLR_FOG = 3, A_IN = 0, A_FOG = 1, A_SHADE = 2, BL_0 = 3, BL_1MA = 0, A_MEM = 1, BL_1 = 2 };
+
+struct RenderMode {
+    const char* name;
+    uint32_t flags;
+    uint32_t blend[4];
+
+    constexpr uint32_t Cycle(const int clk) const {
+        const uint32_t shift = clk == 1 ? 2 : 0;
+        return flags | blend[0] << (28 + shift) | blend[1] << (24 + shift) | blend[2] << (20 + shift) | blend[3] << (16 + shift);
+    }
+};
+
+static constexpr RenderMode sRenderModes[] = {
+    { "AA_ZB_OPA_SURF", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_CLAMP | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "RA_ZB_OPA_SURF", AA_EN | Z_CMP | Z_UPD | CVG_DST_CLAMP | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_XLU_SURF", AA_EN | Z_CMP | IM_RD | CVG_DST_WRAP | CLR_ON_CVG | FORCE_BL | ZMODE_XLU, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_ZB_OPA_DECAL", AA_EN | Z_CMP | IM_RD | CVG_DST_WRAP | ALPHA_CVG_SEL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "RA_ZB_OPA_DECAL", AA_EN | Z_CMP | CVG_DST_WRAP | ALPHA_CVG_SEL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_XLU_DECAL", AA_EN | Z_CMP | IM_RD | CVG_DST_WRAP | CLR_ON_CVG | FORCE_BL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_ZB_OPA_INTER", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_CLAMP | ALPHA_CVG_SEL | ZMODE_INTER, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "RA_ZB_OPA_INTER", AA_EN | Z_CMP | Z_UPD | CVG_DST_CLAMP | ALPHA_CVG_SEL | ZMODE_INTER, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_XLU_INTER", AA_EN | Z_CMP | IM_RD | CVG_DST_WRAP | CLR_ON_CVG | FORCE_BL | ZMODE_INTER, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_ZB_XLU_LINE", AA_EN | Z_CMP | IM_RD | CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | FORCE_BL | ZMODE_XLU, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_ZB_DEC_LINE", AA_EN | Z_CMP | IM_RD | CVG_DST_SAVE | CVG_X_ALPHA | ALPHA_CVG_SEL | FORCE_BL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_ZB_TEX_EDGE", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_TEX_INTER", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | ZMODE_INTER, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_SUB_SURF", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_FULL | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_PCL_SURF", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_CLAMP | ZMODE_OPA | AC_DITHER, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_ZB_SUB_TERR", AA_EN | Z_CMP | Z_UPD | IM_RD | CVG_DST_FULL | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_OPA_SURF", AA_EN | IM_RD | CVG_DST_CLAMP | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "RA_OPA_SURF", AA_EN | CVG_DST_CLAMP | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_XLU_SURF", AA_EN | IM_RD | CVG_DST_WRAP | CLR_ON_CVG | FORCE_BL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_XLU_LINE", AA_EN | IM_RD | CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | FORCE_BL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_DEC_LINE", AA_EN | IM_RD | CVG_DST_FULL | CVG_X_ALPHA | ALPHA_CVG_SEL | FORCE_BL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "AA_TEX_EDGE", AA_EN | IM_RD | CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_SUB_SURF", AA_EN | IM_RD | CVG_DST_FULL | ZMODE_OPA | ALPHA_CVG_SEL, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "AA_PCL_SURF", AA_EN | IM_RD | CVG_DST_CLAMP | ZMODE_OPA | AC_DITHER, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "ZB_OPA_SURF", Z_CMP | Z_UPD | CVG_DST_FULL | ALPHA_CVG_SEL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "ZB_XLU_SURF", Z_CMP | IM_RD | CVG_DST_FULL | FORCE_BL | ZMODE_XLU, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "ZB_OPA_DECAL", Z_CMP | CVG_DST_FULL | ALPHA_CVG_SEL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, A_MEM } },
+    { "ZB_XLU_DECAL", Z_CMP | IM_RD | CVG_DST_FULL | FORCE_BL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "ZB_CLD_SURF", Z_CMP | IM_RD | CVG_DST_SAVE | FORCE_BL | ZMODE_XLU, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "ZB_OVL_SURF", Z_CMP | IM_RD | CVG_DST_SAVE | FORCE_BL | ZMODE_DEC, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "ZB_PCL_SURF", Z_CMP | Z_UPD | CVG_DST_FULL | ZMODE_OPA | AC_DITHER, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "OPA_SURF", CVG_DST_CLAMP | FORCE_BL | ZMODE_OPA, { CLR_IN, BL_0, CLR_IN, BL_1 } },
+    { "XLU_SURF", IM_RD | CVG_DST_FULL | FORCE_BL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "TEX_EDGE", CVG_DST_CLAMP | CVG_X_ALPHA | ALPHA_CVG_SEL | FORCE_BL | ZMODE_OPA | AA_EN, { CLR_IN, BL_0, CLR_IN, BL_1 } },
+    { "CLD_SURF", IM_RD | CVG_DST_SAVE | FORCE_BL | ZMODE_OPA, { CLR_IN, A_IN, CLR_MEM, BL_1MA } },
+    { "PCL_SURF", CVG_DST_FULL | FORCE_BL | ZMODE_OPA | AC_DITHER, { CLR_IN, BL_0, CLR_IN, BL_1 } },
+    { "ADD", IM_RD | CVG_DST_SAVE | FORCE_BL | ZMODE_OPA, { CLR_IN, A_FOG, CLR_MEM, BL_1 } },
+    { "VISCVG", IM_RD | FORCE_BL, { CLR_IN, BL_0, CLR_BL, A_MEM } },
+    { "OPA_CI", CVG_DST_CLAMP | ZMODE_OPA, { CLR_IN, BL_0, CLR_IN, BL_1 } },
+    { "NOOP", 0, { 0, 0, 0, 0 } },
+};
+
+// Only valid as the first cycle, their second cycle is left to the other argument
+static constexpr RenderMode sFirstCycleModes[] = {
+    { "FOG_SHADE_A", 0, { CLR_FOG, A_SHADE, CLR_IN, BL_1MA } },
+    { "FOG_PRIM_A", 0, { CLR_FOG, A_FOG, CLR_IN, BL_1MA } },
+    { "PASS", 0, { CLR_IN, BL_0, CLR_IN, BL_1 } },
+};
+
+static constexpr GBIName sRenderModeFlags[] = {
+    {AA_EN, "AA_EN"}, {Z_CMP, "Z_CMP"}, {Z_UPD, "Z_UPD"}, {IM_RD, "IM_RD"}, {CLR_ON_CVG, "CLR_ON_CVG"},
+    {CVG_DST_SAVE, "CVG_DST_SAVE"}, {CVG_DST_FULL, "CVG_DST_FULL"}, {CVG_DST_WRAP, "CVG_DST_WRAP"},
+    {ZMODE_DEC, "ZMODE_DEC"}, {ZMODE_XLU, "ZMODE_XLU"}, {ZMODE_INTER, "ZMODE_INTER"},
+    {CVG_X_ALPHA, "CVG_X_ALPHA"}, {ALPHA_CVG_SEL, "ALPHA_CVG_SEL"}, {FORCE_BL, "FORCE_BL"},
+};
+
+// The two arguments of gsDPSetRenderMode, preset names when a pair of them gives the value
+static std::pair<std::string, std::string> RenderModeArgs(const uint32_t value) {
+    for(const auto& first : sRenderModes) {
+        for(const auto& second : sRenderModes) {
+            if((first.Cycle(1) | second.Cycle(2)) == value) {
+                return { fmt::format("G_RM_{}", first.name), fmt::format("G_RM_{}2", second.name) };
+            }
+        }
+    }
+
+    for(const auto& first : sFirstCycleModes) {
+        for(const auto& second : sRenderModes) {
+            if((first.Cycle(1) | second.Cycle(2)) == value) {
+                return { fmt::format("G_RM_{}", first.name), fmt::format("G_RM_{}2", second.name) };
+            }
+        }
+    }
+
+    static constexpr const char* colors[] = { "G_BL_CLR_IN", "G_BL_CLR_MEM", "G_BL_CLR_BL", "G_BL_CLR_FOG" };
+    static constexpr const char* alphas[] = { "G_BL_A_IN", "G_BL_A_FOG", "G_BL_A_SHADE", "G_BL_0" };
+    static constexpr const char* factors[] = { "G_BL_1MA", "G_BL_A_MEM", "G_BL_1", "G_BL_0" };
+
+    auto blender = [&](const int clk) {
+        const uint32_t shift = clk == 1 ? 2 : 0;
+        return fmt::format("GBL_c{}({}, {}, {}, {})", clk, colors[(value >> (28 + shift)) & 3], alphas[(value >> (24 + shift)) & 3],
+                           colors[(value >> (20 + shift)) & 3], factors[(value >> (16 + shift)) & 3]);
+    };
+
+    const std::string flags = Flags(value & 0xFFFF, sRenderModeFlags);
+    return { (flags == "0" ? "" : flags + " | ") + blender(1), blender(2) };
+}
+
+/*
+ * Combiner inputs, "0" is G_CCMUX_0 which each slot truncates to its own width
+ */
+
+static constexpr const char* sCCMuxA[16] = { "COMBINED", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "1", "NOISE",
+                                             nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "0" };
+static constexpr const char* sCCMuxB[16] = { "COMBINED", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "CENTER", "K4",
+                                             nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "0" };
+static constexpr const char* sCCMuxC[32] = { "COMBINED", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "SCALE",
+                                             "COMBINED_ALPHA", "TEXEL0_ALPHA", "TEXEL1_ALPHA", "PRIMITIVE_ALPHA", "SHADE_ALPHA",
+                                             "ENV_ALPHA", "LOD_FRACTION", "PRIM_LOD_FRAC", "K5", nullptr, nullptr, nullptr, nullptr,
+                                             nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                             nullptr, nullptr, "0" };
+static constexpr const char* sCCMuxD[8] = { "COMBINED", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "1", "0" };
+static constexpr const char* sACMuxABD[8] = { "COMBINED", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "1", "0" };
+static constexpr const char* sACMuxC[8] = { "LOD_FRACTION", "TEXEL0", "TEXEL1", "PRIMITIVE", "SHADE", "ENVIRONMENT", "PRIM_LOD_FRAC", "0" };
+
+// The G_CC_* presets of gbi.h, one cycle each. Where gbi.h defines a preset as another one, only the first name is
+// kept, which is the one gfxd prints
+struct CombinerPreset {
+    const char* name;
+    const char* args[8];
+};
+
+static constexpr CombinerPreset sCombinerPresets[] = {
+    {"G_CC_PRIMITIVE", {"0", "0", "0", "PRIMITIVE", "0", "0", "0", "PRIMITIVE"}},
+    {"G_CC_SHADE", {"0", "0", "0", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_MODULATEI", {"TEXEL0", "0", "SHADE", "0", "0", "0", "0", "SHADE"}},
+    {"G_CC_MODULATEIA", {"TEXEL0", "0", "SHADE", "0", "TEXEL0", "0", "SHADE", "0"}},
+    {"G_CC_MODULATEIDECALA", {"TEXEL0", "0", "SHADE", "0", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_MODULATEI_PRIM", {"TEXEL0", "0", "PRIMITIVE", "0", "0", "0", "0", "PRIMITIVE"}},
+    {"G_CC_MODULATEIA_PRIM", {"TEXEL0", "0", "PRIMITIVE", "0", "TEXEL0", "0", "PRIMITIVE", "0"}},
+    {"G_CC_MODULATEIDECALA_PRIM", {"TEXEL0", "0", "PRIMITIVE", "0", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_DECALRGB", {"0", "0", "0", "TEXEL0", "0", "0", "0", "SHADE"}},
+    {"G_CC_DECALRGBA", {"0", "0", "0", "TEXEL0", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_BLENDI", {"ENVIRONMENT", "SHADE", "TEXEL0", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_BLENDIA", {"ENVIRONMENT", "SHADE", "TEXEL0", "SHADE", "TEXEL0", "0", "SHADE", "0"}},
+    {"G_CC_BLENDIDECALA", {"ENVIRONMENT", "SHADE", "TEXEL0", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_BLENDRGBA", {"TEXEL0", "SHADE", "TEXEL0_ALPHA", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_BLENDRGBDECALA", {"TEXEL0", "SHADE", "TEXEL0_ALPHA", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_ADDRGB", {"TEXEL0", "0", "TEXEL0", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_ADDRGBDECALA", {"TEXEL0", "0", "TEXEL0", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_REFLECTRGB", {"ENVIRONMENT", "0", "TEXEL0", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_REFLECTRGBDECALA", {"ENVIRONMENT", "0", "TEXEL0", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_HILITERGB", {"PRIMITIVE", "SHADE", "TEXEL0", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_HILITERGBA", {"PRIMITIVE", "SHADE", "TEXEL0", "SHADE", "PRIMITIVE", "SHADE", "TEXEL0", "SHADE"}},
+    {"G_CC_HILITERGBDECALA", {"PRIMITIVE", "SHADE", "TEXEL0", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_SHADEDECALA", {"0", "0", "0", "SHADE", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_BLENDPE", {"PRIMITIVE", "ENVIRONMENT", "TEXEL0", "ENVIRONMENT", "TEXEL0", "0", "SHADE", "0"}},
+    {"G_CC_BLENDPEDECALA", {"PRIMITIVE", "ENVIRONMENT", "TEXEL0", "ENVIRONMENT", "0", "0", "0", "TEXEL0"}},
+    {"_G_CC_BLENDPE", {"ENVIRONMENT", "PRIMITIVE", "TEXEL0", "PRIMITIVE", "TEXEL0", "0", "SHADE", "0"}},
+    {"_G_CC_BLENDPEDECALA", {"ENVIRONMENT", "PRIMITIVE", "TEXEL0", "PRIMITIVE", "0", "0", "0", "TEXEL0"}},
+    {"_G_CC_SPARSEST", {"PRIMITIVE", "TEXEL0", "LOD_FRACTION", "TEXEL0", "PRIMITIVE", "TEXEL0", "LOD_FRACTION", "TEXEL0"}},
+    {"G_CC_TEMPLERP", {"TEXEL1", "TEXEL0", "PRIM_LOD_FRAC", "TEXEL0", "TEXEL1", "TEXEL0", "PRIM_LOD_FRAC", "TEXEL0"}},
+    {"G_CC_TRILERP", {"TEXEL1", "TEXEL0", "LOD_FRACTION", "TEXEL0", "TEXEL1", "TEXEL0", "LOD_FRACTION", "TEXEL0"}},
+    {"G_CC_INTERFERENCE", {"TEXEL0", "0", "TEXEL1", "0", "TEXEL0", "0", "TEXEL1", "0"}},
+    {"G_CC_1CYUV2RGB", {"TEXEL0", "K4", "K5", "TEXEL0", "0", "0", "0", "SHADE"}},
+    {"G_CC_YUV2RGB", {"TEXEL1", "K4", "K5", "TEXEL1", "0", "0", "0", "0"}},
+    {"G_CC_PASS2", {"0", "0", "0", "COMBINED", "0", "0", "0", "COMBINED"}},
+    {"G_CC_MODULATEI2", {"COMBINED", "0", "SHADE", "0", "0", "0", "0", "SHADE"}},
+    {"G_CC_MODULATEIA2", {"COMBINED", "0", "SHADE", "0", "COMBINED", "0", "SHADE", "0"}},
+    {"G_CC_MODULATEI_PRIM2", {"COMBINED", "0", "PRIMITIVE", "0", "0", "0", "0", "PRIMITIVE"}},
+    {"G_CC_MODULATEIA_PRIM2", {"COMBINED", "0", "PRIMITIVE", "0", "COMBINED", "0", "PRIMITIVE", "0"}},
+    {"G_CC_DECALRGB2", {"0", "0", "0", "COMBINED", "0", "0", "0", "SHADE"}},
+    {"G_CC_BLENDI2", {"ENVIRONMENT", "SHADE", "COMBINED", "SHADE", "0", "0", "0", "SHADE"}},
+    {"G_CC_BLENDIA2", {"ENVIRONMENT", "SHADE", "COMBINED", "SHADE", "COMBINED", "0", "SHADE", "0"}},
+    {"G_CC_CHROMA_KEY2", {"TEXEL0", "CENTER", "SCALE", "0", "0", "0", "0", "0"}},
+    {"G_CC_HILITERGB2", {"ENVIRONMENT", "COMBINED", "TEXEL0", "COMBINED", "0", "0", "0", "SHADE"}},
+    {"G_CC_HILITERGBA2", {"ENVIRONMENT", "COMBINED", "TEXEL0", "COMBINED", "ENVIRONMENT", "COMBINED", "TEXEL0", "COMBINED"}},
+    {"G_CC_HILITERGBDECALA2", {"ENVIRONMENT", "COMBINED", "TEXEL0", "COMBINED", "0", "0", "0", "TEXEL0"}},
+    {"G_CC_HILITERGBPASSA2", {"ENVIRONMENT", "COMBINED", "TEXEL0", "COMBINED", "0", "0", "0", "COMBINED"}},
+};
+
+static const char* CombinerPresetName(const char* const* args) {
+    for(const auto& preset : sCombinerPresets) {
+        if(std::equal(args, args + 8, preset.args, [](const char* a, const char* b) { return std::strcmp(a, b) == 0; })) {
+            return preset.name;
+        }
+    }
+    return nullptr;
+}
+
+// gsDPSetCombineMode when both cycles are presets, like gfxd, otherwise gsDPSetCombineLERP
+static std::optional<std::string> CombineMode(const uint32_t w0, const uint32_t w1) {
+    const uint32_t mux[16] = {
+        C0(20, 4), C1(28, 4), C0(15, 5), C1(15, 3), C0(12, 3), C1(12, 3), C0(9, 3), C1(9, 3),
+        C0(5, 4), C1(24, 4), C0(0, 5), C1(6, 3), C1(21, 3), C1(3, 3), C1(18, 3), C1(0, 3),
+    };
+    const char* names[16];
+
+    for(int cycle = 0; cycle < 16; cycle += 8) {
+        names[cycle + 0] = sCCMuxA[mux[cycle + 0]];
+        names[cycle + 1] = sCCMuxB[mux[cycle + 1]];
+        names[cycle + 2] = sCCMuxC[mux[cycle + 2]];
+        names[cycle + 3] = sCCMuxD[mux[cycle + 3]];
+        names[cycle + 4] = sACMuxABD[mux[cycle + 4]];
+        names[cycle + 5] = sACMuxABD[mux[cycle + 5]];
+        names[cycle + 6] = sACMuxC[mux[cycle + 6]];
+        names[cycle + 7] = sACMuxABD[mux[cycle + 7]];
+    }
+
+    for(const auto name : names) {
+        if(name == nullptr) {
+            return std::nullopt;
+        }
+    }
+
+    const char* first = CombinerPresetName(names);
+    const char* second = CombinerPresetName(names + 8);
+    if(first != nullptr && second != nullptr) {
+        return fmt::format("gsDPSetCombineMode({}, {})", first, second);
+    }
+
+    std::string out = "gsDPSetCombineLERP(";
+    for(int i = 0; i < 16; i++) {
+        out += i == 0 ? "" : ", ";
+        out += names[i];
+    }
+    return out + ")";
+}
+
+// Geometry mode bits, G_CULL_BOTH is listed first so it is named before its halves
+static constexpr GBIName sGeometryModeF3D[] = {
+    {0x1, "G_ZBUFFER"}, {0x2, "G_TEXTURE_ENABLE"}, {0x4, "G_SHADE"}, {0x200, "G_SHADING_SMOOTH"}, {0x3000, "G_CULL_BOTH"},
+    {0x1000, "G_CULL_FRONT"}, {0x2000, "G_CULL_BACK"}, {0x10000, "G_FOG"}, {0x20000, "G_LIGHTING"}, {0x40000, "G_TEXTURE_GEN"},
+    {0x80000, "G_TEXTURE_GEN_LINEAR"}, {0x100000, "G_LOD"},
+};
+
+static constexpr GBIName sGeometryModeF3DEX[] = {
+    {0x1, "G_ZBUFFER"}, {0x2, "G_TEXTURE_ENABLE"}, {0x4, "G_SHADE"}, {0x200, "G_SHADING_SMOOTH"}, {0x3000, "G_CULL_BOTH"},
+    {0x1000, "G_CULL_FRONT"}, {0x2000, "G_CULL_BACK"}, {0x10000, "G_FOG"}, {0x20000, "G_LIGHTING"}, {0x40000, "G_TEXTURE_GEN"},
+    {0x80000, "G_TEXTURE_GEN_LINEAR"}, {0x100000, "G_LOD"}, {0x800000, "G_CLIPPING"},
+};
+
+static constexpr GBIName sGeometryModeF3DEX2[] = {
+    {0x1, "G_ZBUFFER"}, {0x4, "G_SHADE"}, {0x600, "G_CULL_BOTH"}, {0x200, "G_CULL_FRONT"}, {0x400, "G_CULL_BACK"},
+    {0x10000, "G_FOG"}, {0x20000, "G_LIGHTING"}, {0x40000, "G_TEXTURE_GEN"}, {0x80000, "G_TEXTURE_GEN_LINEAR"},
+    {0x100000, "G_LOD"}, {0x200000, "G_SHADING_SMOOTH"}, {0x800000, "G_CLIPPING"},
+};
+
+template<GBIVersion V>
+static std::string GeometryMode(const uint32_t flags) {
+    if constexpr (V == GBIVersion::f3dex2) {
+        return Flags(flags, sGeometryModeF3DEX2);
+    } else if constexpr (IsF3DEX(V)) {
+        return Flags(flags, sGeometryModeF3DEX);
+    } else {
+        return Flags(flags, sGeometryModeF3D);
+    }
+}
+
+template<GBIVersion V>
+class NativeDisassembler {
+  public:
+    static std::string Run(const std::vector<uint32_t>& cmds, const std::string& indent) {
+        const NativeDisassembler dis(cmds.data(), cmds.size() / 2);
+        std::string out;
+        out.reserve(cmds.size() * 24);
+        // Only opened once the list has a command that needs gfxd, then kept for the rest of it
+        std::optional<GfxdSession> session;
+
+        for(size_t i = 0; i < dis.mCount;) {
+            size_t used = 1;
+            bool ends = false;
+            const auto macro = dis.Decode(i, used, ends);
+
+            if(macro.has_value()) {
+                out += indent;
+                out += macro.value();
+                out += ",\n";
+            } else {
+                if(!session.has_value()) {
+                    session.emplace(indent);
+                }
+                used = std::max<size_t>(session->Run(cmds.data() + i * 2, dis.mCount - i, out, true, ends), 1);
+            }
+            i += used;
+
+            if(ends) {
+                break;
+            }
+        }
+
+        return out;
+    }
+
+  private:
+    static constexpr GBIOpcodes gbi = GetGBIOpcodes(V);
+    static constexpr RDPOpcodes rdp = gRDPOpcodes;
+
+    const uint32_t* mCmds;
+    const size_t mCount;
+
+    NativeDisassembler(const uint32_t* cmds, const size_t count) : mCmds(cmds), mCount(count) {}
+
+    uint32_t W0(const size_t i) const {
+        return mCmds[i * 2];
+    }
+
+    uint32_t W1(const size_t i) const {
+        return mCmds[i * 2 + 1];
+    }
+
+    bool Is(const size_t i, const N64Words& words) const {
+        return i < mCount && Same(words, W0(i), W1(i));
+    }
+
+    // Whether the commands from i on are exactly the expected ones
+    bool Matches(size_t i, std::initializer_list<N64Words> expected) const {
+        for(const auto& words : expected) {
+            if(!Is(i++, words)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Returns nullopt when no macro gives back the exact words, those commands are left to gfxd
+    std::optional<std::string> Decode(const size_t i, size_t& used, bool& ends) const {
+        const uint32_t w0 = W0(i);
+        const uint32_t w1 = W1(i);
+        const uint8_t opcode = w0 >> 24;
+        std::optional<std::string> macro;
+
+        // Macros made of several commands first, so their parts are not printed one by one
+        if(opcode == rdp.settimg) {
+            macro = LoadTLUT(i, used);
+            if(!macro.has_value()) {
+                macro = LoadTextureBlock(i, used);
+            }
+            if(!macro.has_value()) {
+                macro = LoadTextureTile(i, used);
+            }
+        } else if(opcode == rdp.texrect || opcode == rdp.texrectflip) {
+            macro = TextureRectangle(i, used);
+        } else if(opcode == gbi.moveword) {
+            macro = MoveWordMacro(i, used);
+        } else if(gbi.branchZ != 0xFF && opcode == gbi.rdphalf1) {
+            macro = BranchLessZ(i, used);
+        }
+
+        if(macro.has_value()) {
+            return macro.value();
+        }
+
+        used = 1;
+        return Command(w0, w1, ends);
+    }
+
+    /*
+     * Multi-command macros
+     */
+
+    // gsDPLoadTLUT_pal16, gsDPLoadTLUT_pal256 and gsDPLoadTLUT
+    std::optional<std::string> LoadTLUT(const size_t i, size_t& used) const {
+        if(i + 6 > mCount) {
+            return std::nullopt;
+        }
+
+        const uint32_t dram = W1(i);
+        const uint32_t tmem = W0(i + 2) & 0x1FF;
+        const uint32_t count = ((W1(i + 4) >> 14) & 0x3FF) + 1;
+
+        if(!Matches(i, {
+            SetTextureImage(0, IM_SIZ_16b, 1, dram),
+            Sync(rdp.tilesync),
+            SetTile(0, 0, 0, tmem, TX_LOADTILE, 0, 0),
+            Sync(rdp.loadsync),
+            LoadTLUTCmd(TX_LOADTILE, count - 1),
+            Sync(rdp.pipesync),
+        })) {
+            return std::nullopt;
+        }
+
+        used = 6;
+        const auto symbol = Address(GFXDOverride::GetPaletteSymbol(dram), dram);
+
+        if(count == 256 && tmem == 256) {
+            return fmt::format("gsDPLoadTLUT_pal256({})", symbol);
+        }
+        if(count == 16 && tmem >= 256 && (tmem - 256) % 16 == 0) {
+            return fmt::format("gsDPLoadTLUT_pal16({}, {})", (tmem - 256) / 16, symbol);
+        }
+        return fmt::format("gsDPLoadTLUT({}, {}, {})", count, tmem, symbol);
+    }
+
+    // gsDPLoadTextureBlock, gsDPLoadMultiBlock and their _4b and S variants
+    std::optional<std::string> LoadTextureBlock(const size_t i, size_t& used) const {
+        if(i + 7 > mCount || (W0(i + 3) >> 24) != rdp.loadblock) {
+            return std::nullopt;
+        }
+
+        // The render tile and its size carry the real format and dimensions, the load commands are derived from them
+        const uint32_t timg = W1(i);
+        const uint32_t tile0 = W0(i + 5);
+        const uint32_t tile1 = W1(i + 5);
+        const uint32_t fmt = (tile0 >> 21) & 0x7;
+        const uint32_t siz = (tile0 >> 19) & 0x3;
+        const uint32_t tmem = tile0 & 0x1FF;
+        const uint32_t rtile = (tile1 >> 24) & 0x7;
+        const uint32_t pal = (tile1 >> 20) & 0xF;
+        const uint32_t width = ((W1(i + 6) >> 12) & 0xFFF) / 4 + 1;
+        const uint32_t height = (W1(i + 6) & 0xFFF) / 4 + 1;
+
+        const uint32_t loadSiz = siz == IM_SIZ_32b ? IM_SIZ_32b : IM_SIZ_16b;
+        const uint32_t texels = width * height;
+        const uint32_t lrs = (siz == IM_SIZ_4b ? (texels + 3) >> 2 : siz == IM_SIZ_8b ? (texels + 1) >> 1 : texels) - 1;
+        const uint32_t line = siz == IM_SIZ_4b ? ((width >> 1) + 7) >> 3 : ((width * (siz == IM_SIZ_8b ? 1 : 2)) + 7) >> 3;
+        const uint32_t dxt = W1(i + 3) & 0xFFF;
+
+        if(dxt != 0 && dxt != CalcDxt(width, siz)) {
+            return std::nullopt;
+        }
+
+        if(!Matches(i, {
+            SetTextureImage(fmt, loadSiz, 1, timg),
+            SetTile(fmt, loadSiz, 0, tmem, TX_LOADTILE, 0, tile1),
+            Sync(rdp.loadsync),
+            TileCmd(rdp.loadblock, TX_LOADTILE, 0, 0, lrs, dxt),
+            Sync(rdp.pipesync),
+            SetTile(fmt, siz, line, tmem, rtile, pal, tile1),
+            TileCmd(rdp.settilesize, rtile, 0, 0, (width - 1) << 2, (height - 1) << 2),
+        })) {
+            return std::nullopt;
+        }
+
+        used = 7;
+        const bool multi = tmem != 0 || rtile != TX_RENDERTILE;
+        std::string out = multi ? "gsDPLoadMultiBlock" : "gsDPLoadTextureBlock";
+        out += siz == IM_SIZ_4b ? "_4b" : "";
+        out += dxt == 0 ? "S(" : "(";
+        out += Address(GFXDOverride::GetTextureSymbol(timg), timg);
+        if(multi) {
+            out += fmt::format(", {}, {}", Hex(tmem, 4), Tile(rtile));
+        }
+        out += ", " + ImFmt(fmt);
+        if(siz != IM_SIZ_4b) {
+            out += ", " + ImSiz(siz);
+        }
+        return out + fmt::format(", {}, {}, {}, {})", width, height, pal, TexWrap(tile1));
+    }
+
+    // gsDPLoadTextureTile, gsDPLoadMultiTile and their _4b variants
+    std::optional<std::string> LoadTextureTile(const size_t i, size_t& used) const {
+        if(i + 7 > mCount || (W0(i + 3) >> 24) != rdp.loadtile) {
+            return std::nullopt;
+        }
+
+        const uint32_t timg = W1(i);
+        const uint32_t tile0 = W0(i + 5);
+        const uint32_t tile1 = W1(i + 5);
+        const uint32_t fmt = (tile0 >> 21) & 0x7;
+        const uint32_t siz = (tile0 >> 19) & 0x3;
+        const uint32_t tmem = tile0 & 0x1FF;
+        const uint32_t rtile = (tile1 >> 24) & 0x7;
+        const uint32_t pal = (tile1 >> 20) & 0xF;
+        const uint32_t uls = ((W0(i + 6) >> 12) & 0xFFF) / 4;
+        const uint32_t ult = (W0(i + 6) & 0xFFF) / 4;
+        const uint32_t lrs = ((W1(i + 6) >> 12) & 0xFFF) / 4;
+        const uint32_t lrt = (W1(i + 6) & 0xFFF) / 4;
+        const uint32_t tiles = lrs - uls + 1;
+        const bool is4b = siz == IM_SIZ_4b;
+        // gsDPLoadTextureTile_4b loads the image as 8b at half the width
+        const uint32_t width = ((W0(i) & 0xFFF) + 1) * (is4b ? 2 : 1);
+        const uint32_t line = is4b ? ((tiles >> 1) + 7) >> 3 : ((tiles * (siz == IM_SIZ_8b ? 1 : 2)) + 7) >> 3;
+        const uint32_t loadSiz = is4b ? IM_SIZ_8b : siz;
+        const uint32_t sShift = is4b ? 1 : 2;
+
+        if(lrs < uls || !Matches(i, {
+            SetTextureImage(fmt, loadSiz, is4b ? width >> 1 : width, timg),
+            SetTile(fmt, loadSiz, line, tmem, TX_LOADTILE, 0, tile1),
+            Sync(rdp.loadsync),
+            TileCmd(rdp.loadtile, TX_LOADTILE, uls << sShift, ult << 2, lrs << sShift, lrt << 2),
+            Sync(rdp.pipesync),
+            SetTile(fmt, siz, line, tmem, rtile, pal, tile1),
+            TileCmd(rdp.settilesize, rtile, uls << 2, ult << 2, lrs << 2, lrt << 2),
+        })) {
+            return std::nullopt;
+        }
+
+        used = 7;
+        const bool multi = tmem != 0 || rtile != TX_RENDERTILE;
+        std::string out = multi ? "gsDPLoadMultiTile" : "gsDPLoadTextureTile";
+        out += is4b ? "_4b(" : "(";
+        out += Address(GFXDOverride::GetTextureSymbol(timg), timg);
+        if(multi) {
+            out += fmt::format(", {}, {}", Hex(tmem, 4), Tile(rtile));
+        }
+        out += ", " + ImFmt(fmt);
+        if(!is4b) {
+            out += ", " + ImSiz(siz);
+        }
+        // The height argument is not encoded by the macro, the tile is the tallest it can be
+        return out + fmt::format(", {}, {}, {}, {}, {}, {}, {}, {})", width, lrt + 1, uls, ult, lrs, lrt, pal, TexWrap(tile1));
+    }
+
+    // gsSPTextureRectangle and gsSPTextureRectangleFlip
+    std::optional<std::string> TextureRectangle(const size_t i, size_t& used) const {
+        const uint32_t w0 = W0(i);
+        const uint32_t w1 = W1(i);
+
+        if(i + 3 > mCount || C1(27, 5) != 0 || W0(i + 1) != Bits(gbi.rdphalf1, 24, 8) || W0(i + 2) != Bits(gbi.rdphalf2, 24, 8)) {
+            return std::nullopt;
+        }
+
+        used = 3;
+        const uint32_t st = W1(i + 1);
+        const uint32_t delta = W1(i + 2);
+        return fmt::format("{}({}, {}, {}, {}, {}, {}, {}, {}, {})",
+                           (w0 >> 24) == rdp.texrect ? "gsSPTextureRectangle" : "gsSPTextureRectangleFlip",
+                           Qu102(C1(12, 12)), Qu102(C1(0, 12)), Qu102(C0(12, 12)), Qu102(C0(0, 12)), Tile(C1(24, 3)),
+                           Qs105(st >> 16), Qs105(st & 0xFFFF), Qs510(delta >> 16), Qs510(delta & 0xFFFF));
+    }
+
+    // gsSPBranchLessZraw
+    std::optional<std::string> BranchLessZ(const size_t i, size_t& used) const {
+        if(i + 2 > mCount || W0(i) != Bits(gbi.rdphalf1, 24, 8)) {
+            return std::nullopt;
+        }
+
+        const uint32_t dl = W1(i);
+        const uint32_t vtx = (W0(i + 1) & 0xFFF) / 2;
+
+        if(!Is(i + 1, Cmd(gbi.branchZ, Bits(vtx * 5, 12, 12) | Bits(vtx * 2, 0, 12), W1(i + 1)))) {
+            return std::nullopt;
+        }
+
+        used = 2;
+        return fmt::format("gsSPBranchLessZraw({}, {}, {})", Address(GFXDOverride::GetDisplayListSymbol(dl), dl), vtx, Hex(W1(i + 1), 8));
+    }
+
+    static constexpr N64Words MoveWd(const uint32_t index, const uint32_t offset, const uint32_t data) {
+        if constexpr (V == GBIVersion::f3dex2) {
+            return Cmd(gbi.moveword, Bits(index, 16, 8) | Bits(offset, 0, 16), data);
+        } else {
+            return Cmd(gbi.moveword, Bits(offset, 8, 16) | Bits(index, 0, 8), data);
+        }
+    }
+
+    static constexpr uint32_t NumLights(const uint32_t n) {
+        if constexpr (V == GBIVersion::f3dex2) {
+            return n * 24;
+        } else {
+            return (n + 1) * 32 + 0x80000000;
+        }
+    }
+
+    // G_MWO_aLIGHT_n, G_MWO_bLIGHT_n is 4 bytes after it
+    static constexpr uint32_t LightColorOffset(const uint32_t n) {
+        return (n - 1) * (V == GBIVersion::f3dex2 ? 0x18 : 0x20);
+    }
+
+    static constexpr N64Words Light(const uint32_t ptr, const uint32_t n) {
+        if constexpr (V == GBIVersion::f3dex2) {
+            return Cmd(gbi.movemem, Bits((16 - 1) / 8, 19, 5) | Bits((n * 24 + 24) / 8, 8, 8) | gbi.mvLight, ptr);
+        } else {
+            return Cmd(gbi.movemem, Bits((n - 1) * 2 + gbi.mvL0, 16, 8) | 16, ptr);
+        }
+    }
+
+    // gsSPSetLights1-7, gsSPLightColor and gsSPClipRatio
+    std::optional<std::string> MoveWordMacro(const size_t i, size_t& used) const {
+        const uint32_t w0 = W0(i);
+        const uint32_t w1 = W1(i);
+        const uint32_t index = V == GBIVersion::f3dex2 ? C0(16, 8) : C0(0, 8);
+
+        if(index == MW_NUMLIGHT) {
+            for(uint32_t n = 1; n <= 7; n++) {
+                if(!Same(MoveWd(MW_NUMLIGHT, 0, NumLights(n)), w0, w1) || i + n + 2 > mCount) {
+                    continue;
+                }
+
+                // gsSPSetLightsN(name) loads name.l[0] to name.l[n - 1] and then the ambient name.a
+                const uint32_t base = W1(i + n + 1);
+                bool lights = Is(i + n + 1, Light(base, n + 1));
+                for(uint32_t l = 0; lights && l < n; l++) {
+                    lights = Is(i + l + 1, Light(base + 8 + l * 16, l + 1));
+                }
+
+                if(!lights) {
+                    return std::nullopt;
+                }
+
+                const auto symbol = GFXDOverride::GetLightsSymbol(base);
+                if(!symbol.has_value()) {
+                    return std::nullopt;
+                }
+
+                used = n + 2;
+                return fmt::format("gsSPSetLights{}({})", n, symbol.value());
+            }
+        }
+
+        if(index == MW_LIGHTCOL) {
+            for(uint32_t n = 1; n <= 8; n++) {
+                if(Matches(i, { MoveWd(MW_LIGHTCOL, LightColorOffset(n), w1), MoveWd(MW_LIGHTCOL, LightColorOffset(n) + 4, w1) })) {
+                    used = 2;
+                    return fmt::format("gsSPLightColor(LIGHT_{}, {})", n, Hex(w1, 8));
+                }
+            }
+        }
+
+        if(index == MW_CLIP && w1 >= 1 && w1 <= 6) {
+            const uint32_t pos = 0x10000 - w1;
+            if(Matches(i, { MoveWd(MW_CLIP, 0x04, w1), MoveWd(MW_CLIP, 0x0C, w1), MoveWd(MW_CLIP, 0x14, pos), MoveWd(MW_CLIP, 0x1C, pos) })) {
+                used = 4;
+                return fmt::format("gsSPClipRatio(FRUSTRATIO_{})", w1);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+     * Single commands
+     */
+
+    std::optional<std::string> Command(const uint32_t w0, const uint32_t w1, bool& ends) const {
+        const uint8_t opcode = w0 >> 24;
+
+        // For mk64 only
+        if(opcode == gbi.quad && Companion::Instance->GetGBIMinorVersion() == GBIMinorVersion::Mk64) {
+            return GFXDOverride::FormatQuadrangle(w1);
+        }
+
+        switch (opcode) {
+            case rdp.texrect:
+            case rdp.texrectflip:
+                // Only valid followed by its two half commands
+                return std::nullopt;
+            case rdp.loadsync:
+                return SyncCmd(opcode, w0, w1, "gsDPLoadSync()");
+            case rdp.pipesync:
+                return SyncCmd(opcode, w0, w1, "gsDPPipeSync()");
+            case rdp.tilesync:
+                return SyncCmd(opcode, w0, w1, "gsDPTileSync()");
+            case rdp.fullsync:
+                return SyncCmd(opcode, w0, w1, "gsDPFullSync()");
+            case rdp.setkeygb:
+                return fmt::format("gsDPSetKeyGB({}, {}, {}, {}, {}, {})", C1(24, 8), C1(16, 8), C0(12, 12), C1(8, 8), C1(0, 8), C0(0, 12));
+            case rdp.setkeyr: {
+                if(C0(0, 24) != 0 || C1(28, 4) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetKeyR({}, {}, {})", C1(8, 8), C1(0, 8), C1(16, 12));
+            }
+            case rdp.setconvert: {
+                if(C0(22, 2) != 0) {
+                    return std::nullopt;
+                }
+                // Each coefficient is a signed 9 bit value, k2 is split between both words
+                auto k = [](const uint32_t value) { return static_cast<int32_t>(value << 23) >> 23; };
+                return fmt::format("gsDPSetConvert({}, {}, {}, {}, {}, {})", k(C0(13, 9)), k(C0(4, 9)), k(C0(0, 4) << 5 | C1(27, 5)),
+                                   k(C1(18, 9)), k(C1(9, 9)), k(C1(0, 9)));
+            }
+            case rdp.setscissor: {
+                if(C0(12, 12) % 4 == 0 && C0(0, 12) % 4 == 0 && C1(12, 12) % 4 == 0 && C1(0, 12) % 4 == 0 && C1(26, 6) == 0) {
+                    return fmt::format("gsDPSetScissor({}, {}, {}, {}, {})", ScissorMode(C1(24, 2)), C0(12, 12) / 4, C0(0, 12) / 4,
+                                       C1(12, 12) / 4, C1(0, 12) / 4);
+                }
+                if(C1(26, 6) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetScissorFrac({}, {}, {}, {}, {})", ScissorMode(C1(24, 2)), Qu102(C0(12, 12)), Qu102(C0(0, 12)),
+                                   Qu102(C1(12, 12)), Qu102(C1(0, 12)));
+            }
+            case rdp.setprimdepth: {
+                if(C0(0, 24) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetPrimDepth({}, {})", C1(16, 16), C1(0, 16));
+            }
+            case rdp.setothermode:
+                return fmt::format("gsDPSetOtherMode({}, {})", OtherModeH(C0(0, 24)), OtherModeL(w1));
+            case rdp.loadtlut: {
+                if(!Same(LoadTLUTCmd(C1(24, 3), C1(14, 10)), w0, w1)) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPLoadTLUTCmd({}, {})", Tile(C1(24, 3)), C1(14, 10));
+            }
+            case rdp.settilesize:
+            case rdp.loadtile: {
+                if(C1(27, 5) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("{}({}, {}, {}, {}, {})", opcode == rdp.loadtile ? "gsDPLoadTile" : "gsDPSetTileSize", Tile(C1(24, 3)),
+                                   Qu102(C0(12, 12)), Qu102(C0(0, 12)), Qu102(C1(12, 12)), Qu102(C1(0, 12)));
+            }
+            case rdp.loadblock: {
+                if(C1(27, 5) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPLoadBlock({}, {}, {}, {}, {})", Tile(C1(24, 3)), C0(12, 12), C0(0, 12), C1(12, 12), C1(0, 12));
+            }
+            case rdp.settile: {
+                if(C0(18, 1) != 0 || C1(27, 5) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetTile({}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {})", ImFmt(C0(21, 3)), ImSiz(C0(19, 2)),
+                                   C0(9, 9), Hex(C0(0, 9), 4), Tile(C1(24, 3)), C1(20, 4), TexCm(C1(18, 2)), TexMask(C1(14, 4)),
+                                   TexShift(C1(10, 4)), TexCm(C1(8, 2)), TexMask(C1(4, 4)), TexShift(C1(0, 4)));
+            }
+            case rdp.fillrect: {
+                if((w0 & 0x3003) != 0 || (w1 & 0xFF003003) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPFillRectangle({}, {}, {}, {})", C1(14, 10), C1(2, 10), C0(14, 10), C0(2, 10));
+            }
+            case rdp.setfillcolor: {
+                if(C0(0, 24) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetFillColor({})", Hex(w1, 8));
+            }
+            case rdp.setfogcolor:
+                return Color(w0, w1, "gsDPSetFogColor");
+            case rdp.setblendcolor:
+                return Color(w0, w1, "gsDPSetBlendColor");
+            case rdp.setenvcolor:
+                return Color(w0, w1, "gsDPSetEnvColor");
+            case rdp.setprimcolor: {
+                if(C0(16, 8) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetPrimColor({}, {}, {}, {}, {}, {})", C0(8, 8), C0(0, 8), Hex(C1(24, 8), 2), Hex(C1(16, 8), 2),
+                                   Hex(C1(8, 8), 2), Hex(C1(0, 8), 2));
+            }
+            case rdp.setcombine:
+                return CombineMode(w0, w1);
+            case rdp.settimg:
+            case rdp.setcimg: {
+                if(C0(12, 7) != 0) {
+                    return std::nullopt;
+                }
+                const auto img = opcode == rdp.settimg ? Address(GFXDOverride::GetTextureSymbol(w1), w1) : Hex(w1, 8);
+                return fmt::format("{}({}, {}, {}, {})", opcode == rdp.settimg ? "gsDPSetTextureImage" : "gsDPSetColorImage",
+                                   ImFmt(C0(21, 3)), ImSiz(C0(19, 2)), C0(0, 12) + 1, img);
+            }
+            case rdp.setzimg: {
+                if(C0(0, 24) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsDPSetDepthImage({})", Hex(w1, 8));
+            }
+            default:
+                break;
+        }
+
+        // Microcode commands, tested after the RDP ones since missing opcodes are 0xFF
+        if(opcode == gbi.vtx) {
+            return Vertex(w0, w1);
+        }
+
+        if(opcode == gbi.dl) {
+            const auto branch = C0(16, 8);
+            if(C0(0, 16) != 0 || branch > 1) {
+                return std::nullopt;
+            }
+            ends = branch == 1;
+            return fmt::format("{}({})", branch ? "gsSPBranchList" : "gsSPDisplayList", Address(GFXDOverride::GetDisplayListSymbol(w1), w1));
+        }
+
+        if(opcode == gbi.enddl) {
+            if(C0(0, 24) != 0 || w1 != 0) {
+                return std::nullopt;
+            }
+            ends = true;
+            return "gsSPEndDisplayList()";
+        }
+
+        if(opcode == gbi.tri1) {
+            return Triangle1(w0, w1);
+        }
+
+        if(opcode == gbi.tri2) {
+            // F3D has no two triangle command
+            if constexpr (IsF3D(V)) {
+                return std::nullopt;
+            }
+            if((w0 & 0x010101) != 0 || (w1 & 0xFF010101) != 0) {
+                return std::nullopt;
+            }
+            return GFXDOverride::FormatTriangle2(w0, w1);
+        }
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(opcode == gbi.quad) {
+                // gsSP1Quadrangle(v0, v1, v2, v3, 0) is the triangles v0 v1 v2 and v0 v2 v3
+                if((w0 & 0x010101) != 0 || (w1 & 0xFF010101) != 0 || C0(16, 8) != C1(16, 8) || C0(0, 8) != C1(8, 8)) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsSP1Quadrangle({}, {}, {}, {}, 0)", C0(16, 8) / 2, C0(8, 8) / 2, C0(0, 8) / 2, C1(0, 8) / 2);
+            }
+        }
+
+        if(opcode == gbi.line3d) {
+            return Line3D(w0, w1);
+        }
+
+        if(opcode == gbi.culldl) {
+            return CullDisplayList(w0, w1);
+        }
+
+        if(opcode == gbi.mtx) {
+            return Matrix(w0, w1);
+        }
+
+        if(opcode == gbi.popmtx) {
+            if constexpr (V == GBIVersion::f3dex2) {
+                if(w0 != Bits(gbi.popmtx, 24, 8) + Bits((64 - 1) / 8, 19, 5) + 2 || w1 == 0 || w1 % 64 != 0) {
+                    return std::nullopt;
+                }
+                return w1 == 64 ? "gsSPPopMatrix(G_MTX_MODELVIEW)" : fmt::format("gsSPPopMatrixN(G_MTX_MODELVIEW, {})", w1 / 64);
+            } else {
+                if(C0(0, 24) != 0 || w1 > 1) {
+                    return std::nullopt;
+                }
+                return w1 == 0 ? "gsSPPopMatrix(G_MTX_MODELVIEW)" : "gsSPPopMatrix(G_MTX_PROJECTION)";
+            }
+        }
+
+        if(opcode == gbi.movemem) {
+            return MoveMem(w0, w1);
+        }
+
+        if(opcode == gbi.moveword) {
+            return MoveWord(w0, w1);
+        }
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(opcode == gbi.modifyvtx) {
+                const auto where = PointName(C0(16, 8));
+                if(!where.has_value() || C0(0, 1) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("gsSPModifyVertex({}, {}, {})", C0(1, 15), where.value(), Hex(w1, 8));
+            }
+        }
+
+        if(opcode == gbi.texture) {
+            return Texture(w0, w1);
+        }
+
+        if(opcode == gbi.othermodeH || opcode == gbi.othermodeL) {
+            return SetOtherMode(w0, w1, opcode == gbi.othermodeH);
+        }
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(opcode == gbi.geometrymode) {
+                const uint32_t clear = ~w0 & 0xFFFFFF;
+                if(clear == 0) {
+                    return fmt::format("gsSPSetGeometryMode({})", GeometryMode<V>(w1));
+                }
+                if(clear == 0xFFFFFF) {
+                    return fmt::format("gsSPLoadGeometryMode({})", GeometryMode<V>(w1));
+                }
+                if(w1 == 0) {
+                    return fmt::format("gsSPClearGeometryMode({})", GeometryMode<V>(clear));
+                }
+                return fmt::format("gsSPGeometryMode({}, {})", GeometryMode<V>(clear), GeometryMode<V>(w1));
+            }
+        } else {
+            if(opcode == gbi.setgeometrymode || opcode == gbi.cleargeometrymode) {
+                if(C0(0, 24) != 0) {
+                    return std::nullopt;
+                }
+                return fmt::format("{}({})", opcode == gbi.setgeometrymode ? "gsSPSetGeometryMode" : "gsSPClearGeometryMode", GeometryMode<V>(w1));
+            }
+        }
+
+        if(opcode == gbi.spnoop) {
+            if(C0(0, 24) != 0 || w1 != 0) {
+                return std::nullopt;
+            }
+            return "gsSPNoOp()";
+        }
+
+        if(opcode == gbi.rdpnoop) {
+            if(C0(0, 24) != 0) {
+                return std::nullopt;
+            }
+            return w1 == 0 ? "gsDPNoOp()" : fmt::format("gsDPNoOpTag({})", Hex(w1, 8));
+        }
+
+        return std::nullopt;
+    }
+
+    static std::optional<std::string> SyncCmd(const uint8_t opcode, const uint32_t w0, const uint32_t w1, const char* macro) {
+        if(!Same(Sync(opcode), w0, w1)) {
+            return std::nullopt;
+        }
+        return macro;
+    }
+
+    static std::optional<std::string> Color(const uint32_t w0, const uint32_t w1, const char* macro) {
+        if(C0(0, 24) != 0) {
+            return std::nullopt;
+        }
+        return fmt::format("{}({}, {}, {}, {})", macro, Hex(C1(24, 8), 2), Hex(C1(16, 8), 2), Hex(C1(8, 8), 2), Hex(C1(0, 8), 2));
+    }
+
+    static std::string ScissorMode(const uint32_t mode) {
+        return Name(mode, { {0, "G_SC_NON_INTERLACE"}, {2, "G_SC_EVEN_INTERLACE"}, {3, "G_SC_ODD_INTERLACE"} });
+    }
+
+    static std::optional<std::string> PointName(const uint32_t where) {
+        return FindName(where, { {0x10, "G_MWO_POINT_RGBA"}, {0x14, "G_MWO_POINT_ST"}, {0x18, "G_MWO_POINT_XYSCREEN"}, {0x1C, "G_MWO_POINT_ZSCREEN"} });
+    }
+
+    static std::optional<std::string> Vertex(const uint32_t w0, const uint32_t w1) {
+        uint32_t num;
+        uint32_t v0;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            num = C0(12, 8);
+            v0 = C0(1, 7) - num;
+            if((w0 & 0xF01) != 0 || C0(1, 7) < num) {
+                return std::nullopt;
+            }
+        } else if constexpr (IsF3DEX(V)) {
+            num = C0(10, 6);
+            v0 = C0(17, 7);
+            if(C0(16, 1) != 0 || C0(0, 10) != ((num * sizeof(N64Vtx_t) - 1) & 0x3FF)) {
+                return std::nullopt;
+            }
+        } else {
+            num = C0(20, 4) + 1;
+            v0 = C0(16, 4);
+            if(C0(0, 16) != num * sizeof(N64Vtx_t)) {
+                return std::nullopt;
+            }
+        }
+
+        if(num == 0) {
+            return std::nullopt;
+        }
+
+        return fmt::format("gsSPVertex({}, {}, {})", Address(GFXDOverride::GetVtxSymbol(w1), w1), num, v0);
+    }
+
+    static std::optional<std::string> Triangle1(const uint32_t w0, const uint32_t w1) {
+        if constexpr (IsF3D(V)) {
+            if(C0(0, 24) != 0 || C1(16, 8) % 10 != 0 || C1(8, 8) % 10 != 0 || C1(0, 8) % 10 != 0) {
+                return std::nullopt;
+            }
+            return fmt::format("gsSP1Triangle({}, {}, {}, {})", C1(16, 8) / 10, C1(8, 8) / 10, C1(0, 8) / 10, C1(24, 8));
+        } else {
+            const uint32_t v = V == GBIVersion::f3dex2 ? C0(0, 24) : w1;
+            if((V == GBIVersion::f3dex2 ? w1 : C0(0, 24)) != 0 || (v & 0xFF010101) != 0) {
+                return std::nullopt;
+            }
+            return fmt::format("gsSP1Triangle({}, {}, {}, 0)", (v >> 16 & 0xFF) / 2, (v >> 8 & 0xFF) / 2, (v & 0xFF) / 2);
+        }
+    }
+
+    static std::optional<std::string> Line3D(const uint32_t w0, const uint32_t w1) {
+        uint32_t v0;
+        uint32_t v1;
+        uint32_t flag = 0;
+        uint32_t wd;
+
+        if constexpr (IsF3D(V)) {
+            if(C0(0, 24) != 0 || C1(16, 8) % 10 != 0 || C1(8, 8) % 10 != 0) {
+                return std::nullopt;
+            }
+            v0 = C1(16, 8) / 10;
+            v1 = C1(8, 8) / 10;
+            wd = C1(0, 8);
+            flag = C1(24, 8);
+        } else {
+            const uint32_t v = V == GBIVersion::f3dex2 ? C0(0, 24) : w1;
+            if((V == GBIVersion::f3dex2 ? w1 : C0(0, 24)) != 0 || (v & 0xFF010100) != 0) {
+                return std::nullopt;
+            }
+            v0 = (v >> 16 & 0xFF) / 2;
+            v1 = (v >> 8 & 0xFF) / 2;
+            wd = v & 0xFF;
+        }
+
+        if(wd == 0) {
+            return fmt::format("gsSPLine3D({}, {}, {})", v0, v1, flag);
+        }
+        return fmt::format("gsSPLineW3D({}, {}, {}, {})", v0, v1, wd, flag);
+    }
+
+    static std::optional<std::string> CullDisplayList(const uint32_t w0, const uint32_t w1) {
+        if(C0(16, 8) != 0 || C1(16, 16) != 0) {
+            return std::nullopt;
+        }
+
+        if constexpr (IsF3D(V)) {
+            if(C0(0, 16) % 40 != 0 || w1 % 40 != 0 || w1 == 0) {
+                return std::nullopt;
+            }
+            return fmt::format("gsSPCullDisplayList({}, {})", C0(0, 16) / 40, w1 / 40 - 1);
+        } else {
+            if(C0(0, 16) % 2 != 0 || w1 % 2 != 0) {
+                return std::nullopt;
+            }
+            return fmt::format("gsSPCullDisplayList({}, {})", C0(0, 16) / 2, w1 / 2);
+        }
+    }
+
+    static std::optional<std::string> Matrix(const uint32_t w0, const uint32_t w1) {
+        uint32_t params;
+        bool projection;
+        bool push;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(C0(8, 16) != Bits((64 - 1) / 8, 11, 5)) {
+                return std::nullopt;
+            }
+            params = C0(0, 8) ^ 1;
+            push = params & 1;
+            projection = params & 4;
+        } else {
+            if(C0(0, 16) != 64) {
+                return std::nullopt;
+            }
+            params = C0(16, 8);
+            projection = params & 1;
+            push = params & 4;
+        }
+
+        if((params & ~7U) != 0) {
+            return std::nullopt;
+        }
+
+        return fmt::format("gsSPMatrix({}, {} | {} | {})", Address(GFXDOverride::GetMatrixSymbol(w1), w1),
+                           projection ? "G_MTX_PROJECTION" : "G_MTX_MODELVIEW", params & 2 ? "G_MTX_LOAD" : "G_MTX_MUL",
+                           push ? "G_MTX_PUSH" : "G_MTX_NOPUSH");
+    }
+
+    static std::optional<std::string> MoveMem(const uint32_t w0, const uint32_t w1) {
+        uint32_t index;
+        uint32_t offset = 0;
+        uint32_t length;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(C0(16, 3) != 0) {
+                return std::nullopt;
+            }
+            index = C0(0, 8);
+            offset = C0(8, 8) * 8;
+            length = (C0(19, 5) + 1) * 8;
+        } else {
+            index = C0(16, 8);
+            length = C0(0, 16);
+        }
+
+        // Every macro here loads a viewport or a light, both 16 bytes
+        if(length != 16) {
+            return std::nullopt;
+        }
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(index == 8 && offset == 0) {
+                return fmt::format("gsSPViewport({})", Address(GFXDOverride::GetViewportSymbol(w1), w1));
+            }
+            if(index == gbi.mvLight && offset == 0) {
+                return fmt::format("gsSPLookAtX({})", Hex(w1, 8));
+            }
+            if(index == gbi.mvLight && offset == 24) {
+                return fmt::format("gsSPLookAtY({})", Hex(w1, 8));
+            }
+            if(index == gbi.mvLight && offset >= 48 && offset % 24 == 0) {
+                return fmt::format("gsSPLight({}, {})", Address(GFXDOverride::GetLightSymbol(w1), w1), offset / 24 - 1);
+            }
+        } else {
+            if(index == 0x80) {
+                return fmt::format("gsSPViewport({})", Address(GFXDOverride::GetViewportSymbol(w1), w1));
+            }
+            if(index == 0x84) {
+                return fmt::format("gsSPLookAtX({})", Hex(w1, 8));
+            }
+            if(index == 0x82) {
+                return fmt::format("gsSPLookAtY({})", Hex(w1, 8));
+            }
+            if(index >= gbi.mvL0 && index <= gbi.mvL0 + 14 && index % 2 == 0) {
+                return fmt::format("gsSPLight({}, {})", Address(GFXDOverride::GetLightSymbol(w1), w1), (index - gbi.mvL0) / 2 + 1);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    static std::optional<std::string> MoveWord(const uint32_t w0, const uint32_t w1) {
+        const uint32_t index = V == GBIVersion::f3dex2 ? C0(16, 8) : C0(0, 8);
+        const uint32_t offset = V == GBIVersion::f3dex2 ? C0(0, 16) : C0(8, 16);
+
+        switch (index) {
+            case MW_NUMLIGHT: {
+                for(uint32_t n = 1; n <= 7; n++) {
+                    if(offset == 0 && w1 == NumLights(n)) {
+                        return fmt::format("gsSPNumLights(NUMLIGHTS_{})", n);
+                    }
+                }
+                break;
+            }
+            case MW_SEGMENT: {
+                if(offset % 4 == 0) {
+                    return fmt::format("gsSPSegment({}, {})", Hex(offset / 4, 2), Hex(w1, 8));
+                }
+                break;
+            }
+            case MW_FOG: {
+                if(offset == 0) {
+                    return Fog(w1);
+                }
+                break;
+            }
+            case MW_PERSPNORM: {
+                if(offset == 0) {
+                    return fmt::format("gsSPPerspNormalize({})", Hex(w1, 4));
+                }
+                break;
+            }
+            case MW_POINTS: {
+                // F3DEX2 uses the index to force a matrix and has its own command to modify a vertex
+                if constexpr (V != GBIVersion::f3dex2) {
+                    const auto where = PointName(offset % 40);
+                    if(where.has_value()) {
+                        return fmt::format("gsSPModifyVertex({}, {}, {})", offset / 40, where.value(), Hex(w1, 8));
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        const auto name = FindName(index, {
+            {0x00, "G_MW_MATRIX"}, {MW_NUMLIGHT, "G_MW_NUMLIGHT"}, {MW_CLIP, "G_MW_CLIP"}, {MW_SEGMENT, "G_MW_SEGMENT"},
+            {MW_FOG, "G_MW_FOG"}, {MW_LIGHTCOL, "G_MW_LIGHTCOL"}, {MW_POINTS, V == GBIVersion::f3dex2 ? "G_MW_FORCEMTX" : "G_MW_POINTS"},
+            {MW_PERSPNORM, "G_MW_PERSPNORM"},
+        });
+        return fmt::format("gsMoveWd({}, {}, {})", name.has_value() ? name.value() : Hex(index, 2), Hex(offset, 4), Hex(w1, 8));
+    }
+
+    // gsSPFogPosition when some near and far planes in 0-1000 give the factors, gsSPFogFactor otherwise
+    static std::string Fog(const uint32_t w1) {
+        const auto multiplier = static_cast<int16_t>(w1 >> 16);
+        const auto offset = static_cast<int16_t>(w1 & 0xFFFF);
+
+        for(int32_t range = 1; range <= 1000; range++) {
+            if(static_cast<int16_t>(128000 / range) != multiplier) {
+                continue;
+            }
+            for(int32_t min = 0; min + range <= 1000; min++) {
+                if(static_cast<int16_t>((500 - min) * 256 / range) == offset) {
+                    return fmt::format("gsSPFogPosition({}, {})", min, min + range);
+                }
+            }
+        }
+
+        return fmt::format("gsSPFogFactor({}, {})", multiplier, offset);
+    }
+
+    static std::optional<std::string> Texture(const uint32_t w0, const uint32_t w1) {
+        uint32_t on;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            if(C0(14, 10) != 0 || C0(0, 1) != 0) {
+                return std::nullopt;
+            }
+            on = C0(1, 7);
+        } else {
+            if(C0(14, 10) != 0) {
+                return std::nullopt;
+            }
+            on = C0(0, 8);
+        }
+
+        return fmt::format("gsSPTexture({}, {}, {}, {}, {})", Hex(C1(16, 16), 4), Hex(C1(0, 16), 4), C0(11, 3), Tile(C0(8, 3)),
+                           Name(on, { {0, "G_OFF"}, {1, "G_ON"} }));
+    }
+
+    static std::optional<std::string> SetOtherMode(const uint32_t w0, const uint32_t w1, const bool high) {
+        uint32_t shift;
+        uint32_t length;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            length = C0(0, 8) + 1;
+            if(C0(8, 8) + length > 32) {
+                return std::nullopt;
+            }
+            shift = 32 - C0(8, 8) - length;
+        } else {
+            shift = C0(8, 8);
+            length = C0(0, 8);
+        }
+
+        if(C0(16, 8) != 0 || length == 0 || shift + length > 32) {
+            return std::nullopt;
+        }
+
+        const uint32_t mask = (length == 32 ? 0xFFFFFFFF : (1U << length) - 1) << shift;
+        const char* shiftName = nullptr;
+        const OtherModeField* fields = high ? sOtherModeH : sOtherModeL;
+        const size_t count = high ? std::size(sOtherModeH) : std::size(sOtherModeL);
+
+        for(size_t f = 0; f < count; f++) {
+            const auto& field = fields[f];
+            if(field.shift != shift) {
+                continue;
+            }
+            shiftName = field.shiftName;
+            if(field.length != length || field.macro == nullptr) {
+                break;
+            }
+            // gsDPSetRenderMode does not mask its modes, the alpha compare bits of the PCL presets stay in the data
+            if(!high && shift == 3) {
+                const auto [first, second] = RenderModeArgs(w1);
+                return fmt::format("gsDPSetRenderMode({}, {})", first, second);
+            }
+            if((w1 & ~mask) != 0) {
+                break;
+            }
+            const auto name = FieldName(field, w1);
+            if(name.has_value()) {
+                return fmt::format("{}({})", field.macro, name.value());
+            }
+            break;
+        }
+
+        return fmt::format("gsSPSetOtherMode({}, {}, {}, {})", high ? "G_SETOTHERMODE_H" : "G_SETOTHERMODE_L",
+                           shiftName != nullptr ? shiftName : std::to_string(shift), length, Hex(w1, 8));
+    }
+
+    static std::string OtherModeH(const uint32_t value) {
+        std::string out;
+        uint32_t rest = value;
+
+        for(const auto& field : sOtherModeH) {
+            const uint32_t bits = value & (((1U << field.length) - 1) << field.shift);
+            const auto name = field.macro != nullptr ? FieldName(field, bits) : std::nullopt;
+            if(name.has_value()) {
+                out += out.empty() ? name.value() : " | " + name.value();
+                rest &= ~(((1U << field.length) - 1) << field.shift);
+            }
+        }
+
+        if(rest != 0) {
+            out += out.empty() ? Hex(rest, 8) : " | " + Hex(rest, 8);
+        }
+
+        return out;
+    }
+
+    static std::string OtherModeL(const uint32_t value) {
+        const auto [first, second] = RenderModeArgs(value & ~7U);
+        return fmt::format("{} | {} | {} | {}", FieldName(sOtherModeL[0], value & 3).value_or(Hex(value & 3, 1)),
+                           FieldName(sOtherModeL[1], value & 4).value_or("0"), first, second);
+    }
+};
+
+std::string DListDisassembler::DisassembleGFXD(const uint32_t* cmds, size_t count, const std::string& indent, bool* stopped) {
+    GfxdSession session(indent);
+    std::string out;
+    bool ended = false;
+    session.Run(cmds, count / 2, out, false, ended);
+
+    if(stopped != nullptr) {
+        *stopped = ended;
+    }
+
+    return out;
+}
+
+std::string DListDisassembler::DisassembleNative(const std::vector<uint32_t>& cmds, const std::string& indent) {
+    return DispatchGBI<NativeDisassembler>(Companion::Instance->GetGBIVersion(), cmds, indent);
+}
+
+std::string DListDisassembler::Disassemble(const std::vector<uint32_t>& cmds, const std::string& indent) {
+    switch (Companion::Instance->GetGfxDisassembler()) {
+        case GfxDisassembler::GFXD:
+            return DisassembleGFXD(cmds.data(), cmds.size(), indent);
+        case GfxDisassembler::Verify: {
+            const auto reference = DisassembleGFXD(cmds.data(), cmds.size(), indent);
+            const auto native = DisassembleNative(cmds, indent);
+
+            if(native != reference) {
+                size_t line = 1;
+                size_t pos = 0;
+                while(pos < native.size() && pos < reference.size() && native[pos] == reference[pos]) {
+                    if(native[pos] == '\n') {
+                        line++;
+                    }
+                    pos++;
+                }
+                SPDLOG_ERROR("Native display list output differs from gfxd at line {}", line);
+            }
+            return reference;
+        }
+        case GfxDisassembler::Native:
+        default:
+            return DisassembleNative(cmds, indent);
+    }
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#ifdef STANDALONE
+void GFXDSetGBIVersion();
+
+class DListDisassembler {
+  public:
+    // Renders a display list as `indent macro,\n` lines using the configured gfx_disassembler, stopping after an end
+    // or a branch. Safe to call from several threads, lists are only serialized once they reach a command that needs gfxd.
+    static std::string Disassemble(const std::vector<uint32_t>& cmds, const std::string& indent);
+
+    // Renders the whole range with gfxd, the reference output for VERIFY.
+    // stopped is set when gfxd ended early on an invalid command, an end or a branch.
+    static std::string DisassembleGFXD(const uint32_t* cmds, size_t count, const std::string& indent, bool* stopped = nullptr);
+
+    // Renders every command natively that a gbi.h macro reproduces exactly, grouping texture loads, lights and texture
+    // rectangles like gfxd does. Any other command goes through one gfxd session, a macro at a time.
+    static std::string DisassembleNative(const std::vector<uint32_t>& cmds, const std::string& indent);
+};
+#endif
@@ -0,0 +1,840 @@
+#include "DisplayListOptimizer.h"
+
+#include "DisplayListFactory.h"
+#include "DisplayListOverrides.h"
+#include "GBIOpcodes.h"
+#include "Companion.h"
+#include "n64/gbi-otr.h"
+#include "spdlog/spdlog.h"
+#include <array>
+#include <map>
+#include <optional>
+
+#define C0(pos, width) ((w0 >> (pos)) & ((1U << width) - 1))
+
+// Sub display lists with at most this many commands before their end are copied into the caller
+#define INLINE_LIMIT 4
+// Calls are followed this deep when verifying
+#define VERIFY_DEPTH 16
+// G_MOVEWORD index that sets a segment base, the same in every microcode
+#define MW_SEGMENT 0x06
+
+// RDP commands are passed through as is by every microcode
+enum RDPOpcode : uint8_t {
+    RDP_NOOP = 0x00,
+    RDP_TEXRECT = 0xE4,
+    RDP_TEXRECTFLIP = 0xE5,
+    RDP_LOADSYNC = 0xE6,
+    RDP_PIPESYNC = 0xE7,
+    RDP_TILESYNC = 0xE8,
+    RDP_FULLSYNC = 0xE9,
+    RDP_SETOTHERMODE = 0xEF,
+    RDP_LOADTLUT = 0xF0,
+    RDP_SETTILESIZE = 0xF2,
+    RDP_LOADBLOCK = 0xF3,
+    RDP_LOADTILE = 0xF4,
+    RDP_SETTILE = 0xF5,
+    RDP_FILLRECT = 0xF6,
+};
+
+// Commands that fully replace one RDP register, so issuing the same words twice in a row does nothing
+static bool IsRegisterCommand(const uint8_t opcode) {
+    switch (opcode) {
+        case 0xEC: // G_SETCONVERT
+        case 0xED: // G_SETSCISSOR
+        case 0xEE: // G_SETPRIMDEPTH
+        case 0xF7: // G_SETFILLCOLOR
+        case 0xF8: // G_SETFOGCOLOR
+        case 0xF9: // G_SETBLENDCOLOR
+        case 0xFA: // G_SETPRIMCOLOR
+        case 0xFB: // G_SETENVCOLOR
+        case 0xFC: // G_SETCOMBINE
+        case 0xFD: // G_SETTIMG
+        case 0xFE: // G_SETZIMG
+        case 0xFF: // G_SETCIMG
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint64_t Pack(const uint32_t w0, const uint32_t w1) {
+    return (static_cast<uint64_t>(w0) << 32) | w1;
+}
+
+// A mode word where only some of the bits are known
+struct KnownBits {
+    uint32_t value = 0;
+    uint32_t known = 0;
+
+    bool Matches(const uint32_t mask, const uint32_t bits) const {
+        return (known & mask) == mask && (value & mask) == (bits & mask);
+    }
+
+    void Set(const uint32_t mask, const uint32_t bits) {
+        value = (value & ~mask) | (bits & mask);
+        known |= mask;
+    }
+
+    bool operator==(const KnownBits& other) const {
+        return known == other.known && (value & known) == (other.value & other.known);
+    }
+};
+
+struct VtxSlot {
+    uint32_t addr = 0;
+    KnownBits geometry;
+    std::optional<uint64_t> texture;
+    uint32_t epoch = 0;
+
+    bool operator==(const VtxSlot&) const = default;
+};
+
+struct TextureLoad {
+    uint64_t timg;
+    uint64_t tile;
+    uint64_t load;
+
+    bool operator==(const TextureLoad&) const = default;
+};
+
+struct DListState {
+    KnownBits othermodeH;
+    KnownBits othermodeL;
+    KnownBits geometry;
+    std::map<uint8_t, uint64_t> registers;
+    std::array<std::optional<uint64_t>, 8> tiles;
+    // Set by G_SETTILESIZE or by the load that last used the tile
+    std::array<std::optional<uint64_t>, 8> tileSizes;
+    std::optional<TextureLoad> lastLoad;
+    // Only needed to compare lists, keyed by TMEM address
+    std::map<uint32_t, TextureLoad> tmem;
+    std::array<std::optional<VtxSlot>, 128> vtx;
+    // Bumped by anything that changes how vertices get transformed and lit
+    uint32_t epoch = 0;
+
+    // Commands naming the same segmented address can now load different data
+    void ForgetImages() {
+        registers.erase(0xFD);
+        registers.erase(0xFE);
+        registers.erase(0xFF);
+        lastLoad.reset();
+        tmem.clear();
+    }
+
+    void Invalidate() {
+        const auto vertices = vtx;
+        const auto next = epoch + 1;
+        *this = {};
+        vtx = vertices;
+        epoch = next;
+    }
+
+    bool operator==(const DListState&) const = default;
+};
+
+enum class CommandEffect {
+    // The command changes nothing and can be dropped
+    Redundant,
+    Applied,
+    // The state is unknown after the command
+    Unknown,
+    Draw,
+};
+
+template<GBIVersion V>
+struct DListStateMachine {
+    static constexpr GBIOpcodes gbi = GetGBIOpcodes(V);
+
+    static void DecodeVtx(const uint32_t w0, uint32_t& num, uint32_t& v0) {
+        if constexpr (V == GBIVersion::f3dex2) {
+            num = C0(12, 8);
+            v0 = C0(1, 7) - C0(12, 8);
+        } else if constexpr (IsF3DEX(V)) {
+            num = C0(10, 6);
+            v0 = C0(17, 7);
+        } else {
+            num = C0(0, 16) / sizeof(N64Vtx_t);
+            v0 = C0(16, 4);
+        }
+    }
+
+    static uint32_t EncodeVtx(const uint32_t num, const uint32_t v0) {
+        if constexpr (V == GBIVersion::f3dex2) {
+            return (gbi.vtx << 24) | (num << 12) | ((v0 + num) << 1);
+        } else if constexpr (IsF3DEX(V)) {
+            return (gbi.vtx << 24) | ((v0 * 2) << 16) | (num << 10) | (num * sizeof(N64Vtx_t) - 1);
+        } else {
+            return (gbi.vtx << 24) | ((num - 1) << 20) | (v0 << 16) | (num * sizeof(N64Vtx_t));
+        }
+    }
+
+    static bool IsTriangle(const uint8_t opcode) {
+        if (opcode == gbi.tri1) {
+            return true;
+        }
+        if constexpr (!IsF3D(V)) {
+            return opcode == gbi.tri2 || opcode == gbi.quad;
+        }
+        return false;
+    }
+
+    static uint32_t OthermodeMask(const uint32_t w0) {
+        uint32_t shift;
+        uint32_t len;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            len = C0(0, 8) + 1;
+            shift = 32 - C0(8, 8) - len;
+        } else {
+            shift = C0(8, 8);
+            len = C0(0, 8);
+        }
+
+        if (shift >= 32 || len == 0 || shift + len > 32) {
+            return 0;
+        }
+
+        return static_cast<uint32_t>(((1ULL << len) - 1) << shift);
+    }
+
+    // Returns the segment a G_MOVEWORD sets, if it sets one
+    static std::optional<uint32_t> DecodeSegmentWrite(const uint32_t w0) {
+        uint32_t index;
+        uint32_t offset;
+
+        if constexpr (V == GBIVersion::f3dex2) {
+            index = C0(16, 8);
+            offset = C0(0, 16);
+        } else {
+            index = C0(0, 8);
+            offset = C0(8, 16);
+        }
+
+        if (index != MW_SEGMENT) {
+            return std::nullopt;
+        }
+        return (offset / 4) & 0xF;
+    }
+
+    static CommandEffect SetOthermode(KnownBits& mode, const uint32_t w0, const uint32_t w1) {
+        const auto mask = OthermodeMask(w0);
+
+        if (mask == 0) {
+            return CommandEffect::Unknown;
+        }
+
+        // Data outside of the mask is ORed in by some microcodes and ignored by others
+        const auto stray = w1 & ~mask;
+        if (stray == 0 && mode.Matches(mask, w1)) {
+            return CommandEffect::Redundant;
+        }
+
+        mode.Set(mask, w1);
+        mode.known &= ~stray;
+        return CommandEffect::Applied;
+    }
+
+    static CommandEffect SetGeometry(DListState& state, const uint8_t opcode, const uint32_t w0, const uint32_t w1) {
+        uint32_t affected;
+
+        if (opcode == gbi.setgeometrymode) {
+            affected = w1;
+        } else if (opcode == gbi.cleargeometrymode) {
+            affected = w1;
+            if (state.geometry.Matches(affected, 0)) {
+                return CommandEffect::Redundant;
+            }
+            state.geometry.Set(affected, 0);
+            return CommandEffect::Applied;
+        } else {
+            // The upper byte of the and mask isn't encoded, so those bits are only known when they get set
+            affected = (~w0 & 0x00FFFFFF) | w1;
+            if (state.geometry.Matches(affected, w1) && (state.geometry.known & 0xFF000000 & ~w1) == 0) {
+                return CommandEffect::Redundant;
+            }
+            state.geometry.Set(affected, w1);
+            state.geometry.known &= ~(0xFF000000 & ~w1);
+            return CommandEffect::Applied;
+        }
+
+        if (state.geometry.Matches(affected, w1)) {
+            return CommandEffect::Redundant;
+        }
+        state.geometry.Set(affected, w1);
+        return CommandEffect::Applied;
+    }
+
+    static CommandEffect Load(DListState& state, const uint32_t w0, const uint32_t w1) {
+        const auto tile = (w1 >> 24) & 7;
+        const auto timg = state.registers.find(0xFD);
+        const auto cmd = Pack(w0, w1);
+
+        if (timg == state.registers.end() || !state.tiles[tile].has_value()) {
+            state.lastLoad.reset();
+            state.tmem.clear();
+            state.tileSizes[tile] = cmd;
+            return CommandEffect::Applied;
+        }
+
+        const TextureLoad load = { timg->second, state.tiles[tile].value(), cmd };
+
+        // Loading the same texture into the same place again, without anything else loaded in between
+        if (state.lastLoad == load && state.tileSizes[tile] == cmd) {
+            return CommandEffect::Redundant;
+        }
+
+        const auto tmem = static_cast<uint32_t>(state.tiles[tile].value() >> 32) & 0x1FF;
+        state.lastLoad = load;
+        state.tmem[tmem] = load;
+        state.tileSizes[tile] = cmd;
+        return CommandEffect::Applied;
+    }
+
+    // Applies the command to the state and tells if it had any effect. Calls are handled by the caller.
+    static CommandEffect Apply(DListState& state, const uint32_t w0, const uint32_t w1) {
+        const uint8_t opcode = w0 >> 24;
+
+        // The unused geometry opcodes are 0xFF, which is G_SETCIMG
+        if constexpr (V == GBIVersion::f3dex2) {
+            if (opcode == gbi.geometrymode) {
+                return SetGeometry(state, opcode, w0, w1);
+            }
+        } else {
+            if (opcode == gbi.setgeometrymode || opcode == gbi.cleargeometrymode) {
+                return SetGeometry(state, opcode, w0, w1);
+            }
+        }
+
+        if (IsTriangle(opcode)) {
+            return CommandEffect::Draw;
+        }
+
+        if (IsRegisterCommand(opcode)) {
+            const auto value = Pack(w0, w1);
+            const auto current = state.registers.find(opcode);
+            if (current != state.registers.end() && current->second == value) {
+                return CommandEffect::Redundant;
+            }
+            state.registers[opcode] = value;
+            return CommandEffect::Applied;
+        }
+
+        switch (opcode) {
+            case gbi.vtx: {
+                uint32_t num;
+                uint32_t v0;
+                DecodeVtx(w0, num, v0);
+
+                if (num == 0 || v0 + num > state.vtx.size()) {
+                    return CommandEffect::Unknown;
+                }
+
+                const auto texture = state.registers.find(gbi.texture);
+                for (uint32_t i = 0; i < num; i++) {
+                    state.vtx[v0 + i] = VtxSlot {
+                        .addr = static_cast<uint32_t>(w1 + i * sizeof(N64Vtx_t)),
+                        .geometry = state.geometry,
+                        .texture = texture != state.registers.end() ? std::optional(texture->second) : std::nullopt,
+                        .epoch = state.epoch,
+                    };
+                }
+                return CommandEffect::Applied;
+            }
+            case gbi.texture: {
+                const auto value = Pack(w0, w1);
+                const auto current = state.registers.find(opcode);
+                if (current != state.registers.end() && current->second == value) {
+                    return CommandEffect::Redundant;
+                }
+                state.registers[opcode] = value;
+                return CommandEffect::Applied;
+            }
+            case gbi.othermodeH:
+                return SetOthermode(state.othermodeH, w0, w1);
+            case gbi.othermodeL:
+                return SetOthermode(state.othermodeL, w0, w1);
+            case gbi.moveword:
+                if (DecodeSegmentWrite(w0).has_value()) {
+                    state.ForgetImages();
+                }
+                state.epoch++;
+                return CommandEffect::Applied;
+            case gbi.mtx:
+            case gbi.popmtx:
+            case gbi.movemem:
+                state.epoch++;
+                return CommandEffect::Applied;
+            case RDP_SETOTHERMODE: {
+                if (state.othermodeH.Matches(0x00FFFFFF, w0) && state.othermodeL.Matches(0xFFFFFFFF, w1)) {
+                    return CommandEffect::Redundant;
+                }
+                state.othermodeH.Set(0x00FFFFFF, w0);
+                state.othermodeH.known &= 0x00FFFFFF;
+                state.othermodeL.Set(0xFFFFFFFF, w1);
+                return CommandEffect::Applied;
+            }
+            case RDP_SETTILE: {
+                const auto tile = (w1 >> 24) & 7;
+                const auto value = Pack(w0, w1);
+                if (state.tiles[tile] == value) {
+                    return CommandEffect::Redundant;
+                }
+                state.tiles[tile] = value;
+                return CommandEffect::Applied;
+            }
+            case RDP_SETTILESIZE: {
+                const auto tile = (w1 >> 24) & 7;
+                const auto value = Pack(w0, w1);
+                if (state.tileSizes[tile] == value) {
+                    return CommandEffect::Redundant;
+                }
+                state.tileSizes[tile] = value;
+                return CommandEffect::Applied;
+            }
+            case RDP_LOADBLOCK:
+            case RDP_LOADTILE:
+            case RDP_LOADTLUT:
+                return Load(state, w0, w1);
+            case RDP_LOADSYNC:
+            case RDP_PIPESYNC:
+            case RDP_TILESYNC:
+            case RDP_FULLSYNC:
+                return CommandEffect::Applied;
+            case RDP_FILLRECT:
+                return CommandEffect::Draw;
+            default:
+                // G_NOOP is 0 everywhere, F3DEX2 has its own G_SPNOOP
+                if (opcode == RDP_NOOP || (V == GBIVersion::f3dex2 && opcode == 0xE0)) {
+                    return CommandEffect::Applied;
+                }
+                state.Invalidate();
+                return CommandEffect::Unknown;
+        }
+    }
+
+    static bool IsBranch(const uint32_t w0) {
+        return (w0 >> 16) & G_DL_NO_PUSH;
+    }
+
+    // Returns the commands of a sub display list small enough to be copied into its caller, without the end
+    static std::optional<std::vector<uint32_t>> GetInlineCandidate(const uint32_t w0, const uint32_t w1) {
+        if (IsBranch(w0) || (w0 & 0xFFFF) != 0) {
+            return std::nullopt;
+        }
+
+        // Segment 7 display lists are exported as indices into a runtime buffer
+        if (Companion::Instance->GetGBIMinorVersion() == GBIMinorVersion::Mk64 && SEGMENT_NUMBER(w1) == 0x07) {
+            return std::nullopt;
+        }
+
+        const auto result = Companion::Instance->GetParseDataByAddr(w1);
+        if (!result.has_value() || result->type != "GFX" || !result->data.has_value()) {
+            return std::nullopt;
+        }
+
+        const auto& gfxs = std::static_pointer_cast<DListData>(result->data.value())->mGfxs;
+        if (gfxs.size() < 2 || gfxs.size() > (INLINE_LIMIT + 1) * 2 || (gfxs[gfxs.size() - 2] >> 24) != gbi.enddl) {
+            return std::nullopt;
+        }
+
+        for (size_t i = 0; i < gfxs.size() - 2; i += 2) {
+            const uint8_t opcode = gfxs[i] >> 24;
+            if (opcode == gbi.dl || opcode == gbi.enddl) {
+                return std::nullopt;
+            }
+        }
+
+        return std::vector<uint32_t>(gfxs.begin(), gfxs.end() - 2);
+    }
+
+    // Returns the [start, end) range of the vertex array a G_VTX pointer lands in, the same way the binary exporter resolves it
+    static std::optional<std::pair<uint32_t, uint32_t>> GetVtxArray(const uint32_t ptr) {
+        std::optional<YAML::Node> node;
+
+        if (auto overlap = GFXDOverride::GetVtxOverlap(ptr); overlap.has_value()) {
+            node = std::get<1>(overlap.value());
+        } else if (auto dec = Companion::Instance->GetNodeByAddr(ptr); dec.has_value()) {
+            node = std::get<1>(dec.value());
+        }
+
+        if (!node.has_value() || !(*node)["count"]) {
+            return std::nullopt;
+        }
+
+        const auto offset = GetSafeNode<uint32_t>(node.value(), "offset");
+        const auto count = GetSafeNode<uint32_t>(node.value(), "count");
+        return std::make_pair(offset, static_cast<uint32_t>(offset + count * sizeof(N64Vtx_t)));
+    }
+
+    // Merges a vertex load into the one right before it when the second continues the first in both memory and the vertex buffer
+    static bool MergeVtx(std::vector<uint32_t>& out, const uint32_t w0, const uint32_t w1) {
+        if (out.size() < 2 || (out[out.size() - 2] >> 24) != gbi.vtx) {
+            return false;
+        }
+
+        const auto pw0 = out[out.size() - 2];
+        const auto pw1 = out[out.size() - 1];
+        uint32_t pnum, pv0, num, v0;
+        DecodeVtx(pw0, pnum, pv0);
+        DecodeVtx(w0, num, v0);
+
+        if (pnum == 0 || num == 0 || pw0 != EncodeVtx(pnum, pv0) || w0 != EncodeVtx(num, v0)) {
+            return false;
+        }
+
+        if (v0 != pv0 + pnum || w1 != pw1 + pnum * sizeof(N64Vtx_t) || pv0 + pnum + num > gbi.vtxBuffer) {
+            return false;
+        }
+
+        const auto array = GetVtxArray(pw1);
+        if (!array.has_value() || pw1 < array->first || w1 + num * sizeof(N64Vtx_t) > array->second) {
+            return false;
+        }
+
+        out[out.size() - 2] = EncodeVtx(pnum + num, pv0);
+        return true;
+    }
+
+    static void Optimize(const std::vector<uint32_t>& cmds, std::vector<uint32_t>& out, DListState& state, bool& ended) {
+        for (size_t i = 0; i + 1 < cmds.size() && !ended; i += 2) {
+            const auto w0 = cmds[i];
+            const auto w1 = cmds[i + 1];
+            const uint8_t opcode = w0 >> 24;
+
+            if (opcode == gbi.dl) {
+                if (auto callee = GetInlineCandidate(w0, w1); callee.has_value()) {
+                    SPDLOG_INFO("Inlining display list 0x{:X}", w1);
+                    Optimize(callee.value(), out, state, ended);
+                    continue;
+                }
+
+                out.push_back(w0);
+                out.push_back(w1);
+                state.Invalidate();
+                ended = IsBranch(w0);
+                continue;
+            }
+
+            if (opcode == gbi.enddl) {
+                out.push_back(w0);
+                out.push_back(w1);
+                ended = true;
+                continue;
+            }
+
+            if (opcode == gbi.vtx && MergeVtx(out, w0, w1)) {
+                Apply(state, w0, w1);
+                continue;
+            }
+
+            if (Apply(state, w0, w1) == CommandEffect::Redundant) {
+                // A skipped load doesn't need the sync in front of it
+                const bool load = opcode == RDP_LOADBLOCK || opcode == RDP_LOADTILE || opcode == RDP_LOADTLUT;
+                if (load && out.size() >= 2 && (out[out.size() - 2] >> 24) == RDP_LOADSYNC) {
+                    out.resize(out.size() - 2);
+                }
+                continue;
+            }
+
+            out.push_back(w0);
+            out.push_back(w1);
+        }
+    }
+
+    static std::vector<uint32_t> Run(const std::vector<uint32_t>& cmds) {
+        std::vector<uint32_t> out;
+        out.reserve(cmds.size());
+        DListState state;
+        bool ended = false;
+        Optimize(cmds, out, state, ended);
+        return out;
+    }
+};
+
+// Replays a display list the way the RSP and RDP see it, without any of the reasoning the optimizer does about which
+// commands matter, so Verify checks the optimizer rather than its own model. Segments are tracked so an address is
+// only equal to itself when its segment wasn't set in between, matrices and other transform changes are hashed
+// in the order they happen.
+template<GBIVersion V>
+struct DListRenderModel {
+    using Machine = DListStateMachine<V>;
+    static constexpr GBIOpcodes gbi = GetGBIOpcodes(V);
+
+    struct Address {
+        uint32_t addr;
+        // Times the segment was set before the address was used
+        uint32_t generation;
+
+        bool operator==(const Address&) const = default;
+    };
+
+    struct TmemEntry {
+        std::optional<Address> image;
+        std::optional<uint64_t> timg;
+        std::optional<uint64_t> tile;
+        uint64_t load;
+
+        bool operator==(const TmemEntry&) const = default;
+    };
+
+    struct Vertex {
+        Address addr;
+        uint64_t transform;
+        KnownBits geometry;
+        std::optional<uint64_t> texture;
+
+        bool operator==(const Vertex&) const = default;
+    };
+
+    struct State {
+        std::array<uint32_t, 16> segments = {};
+        uint64_t transform = 0;
+        KnownBits othermodeH;
+        KnownBits othermodeL;
+        KnownBits geometry;
+        // Every other state command by opcode, with the image registers also resolved through the segments
+        std::map<uint8_t, uint64_t> registers;
+        std::map<uint8_t, Address> images;
+        std::array<std::optional<uint64_t>, 8> tiles;
+        std::array<std::optional<uint64_t>, 8> tileSizes;
+        // Keyed by TMEM address, 0xFFFF when the load went to an unknown tile
+        std::map<uint32_t, TmemEntry> tmem;
+        std::array<std::optional<Vertex>, 128> vtx;
+
+        bool operator==(const State&) const = default;
+    };
+
+    struct Event {
+        uint32_t w0;
+        uint32_t w1;
+        State state;
+
+        bool operator==(const Event&) const = default;
+    };
+
+    static Address Resolve(const State& state, const uint32_t addr) {
+        return { addr, state.segments[SEGMENT_NUMBER(addr) & 0xF] };
+    }
+
+    static void Mix(uint64_t& hash, const uint64_t value) {
+        hash = (hash ^ value) * 0x100000001B3ULL;
+    }
+
+    static void SetGeometry(KnownBits& geometry, const uint8_t opcode, const uint32_t w0, const uint32_t w1) {
+        if (opcode == gbi.setgeometrymode) {
+            geometry.Set(w1, 0xFFFFFFFF);
+        } else if (opcode == gbi.cleargeometrymode) {
+            geometry.Set(w1, 0);
+        } else {
+            geometry.Set(~w0 & 0x00FFFFFF, 0);
+            geometry.Set(w1, w1);
+            geometry.known &= ~(0xFF000000 & ~w1);
+        }
+    }
+
+    static void SetOthermode(KnownBits& mode, const uint32_t w0, const uint32_t w1) {
+        const auto mask = Machine::OthermodeMask(w0);
+        mode.Set(mask, w1);
+        mode.known &= ~(w1 & ~mask);
+    }
+
+    // Returns false for commands the model doesn't know, they are compared as they are
+    static bool Step(State& state, const uint32_t w0, const uint32_t w1) {
+        const uint8_t opcode = w0 >> 24;
+
+        if (V == GBIVersion::f3dex2 ? opcode == gbi.geometrymode : (opcode == gbi.setgeometrymode || opcode == gbi.cleargeometrymode)) {
+            SetGeometry(state.geometry, opcode, w0, w1);
+            return true;
+        }
+
+        if (opcode == gbi.moveword) {
+            if (const auto segment = Machine::DecodeSegmentWrite(w0); segment.has_value()) {
+                state.segments[segment.value()]++;
+            } else {
+                Mix(state.transform, Pack(w0, w1));
+            }
+            return true;
+        }
+
+        if (opcode == gbi.mtx || opcode == gbi.popmtx || opcode == gbi.movemem) {
+            const auto addr = Resolve(state, w1);
+            Mix(state.transform, Pack(w0, w1));
+            Mix(state.transform, opcode == gbi.popmtx ? 0 : addr.generation);
+            return true;
+        }
+
+        if (opcode == gbi.vtx) {
+            uint32_t num;
+            uint32_t v0;
+            Machine::DecodeVtx(w0, num, v0);
+            if (v0 + num > state.vtx.size()) {
+                return false;
+            }
+
+            const auto texture = state.registers.find(gbi.texture);
+            for (uint32_t i = 0; i < num; i++) {
+                state.vtx[v0 + i] = Vertex {
+                    .addr = Resolve(state, w1 + i * sizeof(N64Vtx_t)),
+                    .transform = state.transform,
+                    .geometry = state.geometry,
+                    .texture = texture != state.registers.end() ? std::optional(texture->second) : std::nullopt,
+                };
+            }
+            return true;
+        }
+
+        if (opcode == gbi.texture || IsRegisterCommand(opcode)) {
+            state.registers[opcode] = Pack(w0, w1);
+            if (opcode == 0xFD || opcode == 0xFE || opcode == 0xFF) {
+                state.images[opcode] = Resolve(state, w1);
+            }
+            return true;
+        }
+
+        if (opcode == gbi.othermodeH) {
+            SetOthermode(state.othermodeH, w0, w1);
+            return true;
+        }
+
+        if (opcode == gbi.othermodeL) {
+            SetOthermode(state.othermodeL, w0, w1);
+            return true;
+        }
+
+        switch (opcode) {
+            case RDP_SETOTHERMODE:
+                state.othermodeH.Set(0x00FFFFFF, w0);
+                state.othermodeH.known &= 0x00FFFFFF;
+                state.othermodeL.Set(0xFFFFFFFF, w1);
+                return true;
+            case RDP_SETTILE:
+                state.tiles[(w1 >> 24) & 7] = Pack(w0, w1);
+                return true;
+            case RDP_SETTILESIZE:
+                state.tileSizes[(w1 >> 24) & 7] = Pack(w0, w1);
+                return true;
+            case RDP_LOADBLOCK:
+            case RDP_LOADTILE:
+            case RDP_LOADTLUT: {
+                const auto tile = (w1 >> 24) & 7;
+                const auto image = state.images.find(0xFD);
+                const auto timg = state.registers.find(0xFD);
+                const auto tmem = state.tiles[tile].has_value() ? static_cast<uint32_t>(state.tiles[tile].value() >> 32) & 0x1FF : 0xFFFF;
+
+                state.tmem[tmem] = TmemEntry {
+                    .image = image != state.images.end() ? std::optional(image->second) : std::nullopt,
+                    .timg = timg != state.registers.end() ? std::optional(timg->second) : std::nullopt,
+                    .tile = state.tiles[tile],
+                    .load = Pack(w0, w1),
+                };
+                state.tileSizes[tile] = Pack(w0, w1);
+                return true;
+            }
+            case RDP_NOOP:
+            case RDP_LOADSYNC:
+            case RDP_PIPESYNC:
+            case RDP_TILESYNC:
+            case RDP_FULLSYNC:
+                return true;
+            default:
+                return V == GBIVersion::f3dex2 && opcode == 0xE0;
+        }
+    }
+
+    // Records the state at every draw, every call that can't be followed and every command the model doesn't know
+    static void Simulate(const std::vector<uint32_t>& cmds, State& state, std::vector<Event>& events, bool& ended, const int depth) {
+        for (size_t i = 0; i + 1 < cmds.size() && !ended; i += 2) {
+            const auto w0 = cmds[i];
+            const auto w1 = cmds[i + 1];
+            const uint8_t opcode = w0 >> 24;
+
+            if (opcode == gbi.dl) {
+                const auto result = Companion::Instance->GetParseDataByAddr(w1);
+                const bool resolved = depth < VERIFY_DEPTH && result.has_value() && result->type == "GFX" && result->data.has_value();
+
+                if (resolved && (w0 & 0xFFFF) == 0) {
+                    bool returned = false;
+                    Simulate(std::static_pointer_cast<DListData>(result->data.value())->mGfxs, state, events, returned, depth + 1);
+                } else {
+                    // Whatever the callee does is unknown, both lists have to make the same call from the same state
+                    events.push_back({ w0, w1, state });
+                    state = {};
+                }
+                ended = Machine::IsBranch(w0);
+                continue;
+            }
+
+            if (opcode == gbi.enddl) {
+                ended = true;
+                continue;
+            }
+
+            if (Machine::IsTriangle(opcode) || opcode == RDP_FILLRECT || opcode == RDP_TEXRECT || opcode == RDP_TEXRECTFLIP) {
+                events.push_back({ w0, w1, state });
+                continue;
+            }
+
+            if (!Step(state, w0, w1)) {
+                events.push_back({ w0, w1, state });
+            }
+        }
+    }
+
+    static bool Compare(const std::vector<uint32_t>& original, const std::vector<uint32_t>& optimized) {
+        std::vector<Event> expected;
+        std::vector<Event> actual;
+        State state;
+        bool ended = false;
+
+        Simulate(original, state, expected, ended, 0);
+        state = {};
+        ended = false;
+        Simulate(optimized, state, actual, ended, 0);
+
+        if (expected.size() != actual.size()) {
+            SPDLOG_ERROR("Optimized display list has {} draws and unknown commands, expected {}", actual.size(), expected.size());
+            return false;
+        }
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (!(expected[i] == actual[i])) {
+                SPDLOG_ERROR("Optimized display list reaches 0x{:08X} 0x{:08X} with a different state", expected[i].w0, expected[i].w1);
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+template<GBIVersion V>
+struct DListOptimizePass {
+    static std::vector<uint32_t> Run(const std::vector<uint32_t>& cmds) {
+        return DListStateMachine<V>::Run(cmds);
+    }
+};
+
+template<GBIVersion V>
+struct DListVerifyPass {
+    static bool Run(const std::vector<uint32_t>& original, const std::vector<uint32_t>& optimized) {
+        return DListRenderModel<V>::Compare(original, optimized);
+    }
+};
+
+std::vector<uint32_t> DListOptimizer::Optimize(const std::vector<uint32_t>& cmds) {
+    const auto version = Companion::Instance->GetGBIVersion();
+    auto optimized = DispatchGBI<DListOptimizePass>(version, cmds);
+
+    if (Companion::Instance->GetGfxOptimizer() == GfxOptimizer::Verify && !Verify(cmds, optimized)) {
+        SPDLOG_ERROR("Display list optimization changed the rendered state, keeping the original commands");
+        return cmds;
+    }
+
+    SPDLOG_INFO("Optimized display list from {} to {} commands", cmds.size() / 2, optimized.size() / 2);
+    return optimized;
+}
+
+bool DListOptimizer::Verify(const std::vector<uint32_t>& original, const std::vector<uint32_t>& optimized) {
+    return DispatchGBI<DListVerifyPass>(Companion::Instance->GetGBIVersion(), original, optimized);
+}
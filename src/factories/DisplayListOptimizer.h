@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+class DListOptimizer {
+  public:
+    // Drops state changes that don't change anything and texture loads of what is already in TMEM,
+    // inlines tiny sub display lists and merges back to back vertex loads of the same array.
+    // With gfx_optimizer VERIFY the result is checked with Verify and the original commands are kept if it fails.
+    static std::vector<uint32_t> Optimize(const std::vector<uint32_t>& cmds);
+
+    // True if both lists reach every draw with the same RSP/RDP state, vertex buffer and TMEM contents. The lists are
+    // replayed by a model separate from the optimizer's, which also follows segment and matrix changes
+    static bool Verify(const std::vector<uint32_t>& original, const std::vector<uint32_t>& optimized);
+};
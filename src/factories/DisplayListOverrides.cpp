@@ -14,11 +14,7 @@ namespace GFXDOverride {
 
 std::unordered_map<uint32_t, std::tuple<std::string, YAML::Node>> mVtxOverlaps;
 
-#ifdef STANDALONE
-void Triangle2(const N64Gfx* gfx) {
-    auto w0 = gfx->words.w0;
-    auto w1 = gfx->words.w1;
-
+std::string FormatTriangle2(const uint32_t w0, const uint32_t w1) {
     auto v1 = std::to_string( ((w0 >> 16) & 0xFF) / 2 );
     auto v2 = std::to_string( ((w0 >> 8) & 0xFF) / 2 );
     auto v3 = std::to_string( (w0 & 0xFF) / 2 );
@@ -28,30 +24,20 @@ void Triangle2(const N64Gfx* gfx) {
     auto v6 = std::to_string( (w1 & 0xFF) / 2 );
     auto flag = "0";
 
-    const auto str = v1 + ", " + v2 + ", " + v3 + ", " + flag + ", " + v4 + ", " + v5 + ", " + v6 + ", " + flag;
-
-    gfxd_puts("gsSP2Triangles(");
-    gfxd_puts(str.c_str());
-    gfxd_puts(")");
+    return "gsSP2Triangles(" + v1 + ", " + v2 + ", " + v3 + ", " + flag + ", " + v4 + ", " + v5 + ", " + v6 + ", " + flag + ")";
 }
 
-void Quadrangle(const N64Gfx* gfx) {
-    auto w1 = gfx->words.w1;
-
+std::string FormatQuadrangle(const uint32_t w1) {
     auto v1 = std::to_string( ((w1 >> 16) & 0xFF) / 2 );
     auto v2 = std::to_string( ((w1 >> 8) & 0xFF) / 2 );
     auto v3 = std::to_string( (w1 & 0xFF) / 2 );
     auto v4 = std::to_string( ((w1 >> 24) & 0xFF) / 2 );
     auto flag = "0";
 
-    const auto str = v1 + ", " + v2 + ", " + v3 + ", " + v4 + ", " + flag;
-
-    gfxd_puts("gsSP1Quadrangle(");
-    gfxd_puts(str.c_str());
-    gfxd_puts(")");
+    return "gsSP1Quadrangle(" + v1 + ", " + v2 + ", " + v3 + ", " + v4 + ", " + flag + ")";
 }
 
-int Vtx(uint32_t ptr, int32_t num) {
+std::optional<std::string> GetVtxSymbol(uint32_t ptr) {
     ptr = Companion::Instance->PatchVirtualAddr(ptr);
     auto vtx = GetVtxOverlap(ptr);
 
@@ -64,142 +50,170 @@ int Vtx(uint32_t ptr, int32_t num) {
         auto idx = (ptr - offset) / sizeof(N64Vtx_t);
 
         SPDLOG_INFO("Replaced Vtx Overlapped: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts("&");
-        gfxd_puts(symbol.c_str());
-        gfxd_puts("[");
-        gfxd_puts(std::to_string(idx).c_str());
-        gfxd_puts("]");
-        return 1;
+        return "&" + symbol + "[" + std::to_string(idx) + "]";
     }
 
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "VTX");
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "VTX");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = dec.value();
         SPDLOG_INFO("Found Vtx: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(symbol.c_str());
-        return 1;
+        return symbol;
     }
 
     SPDLOG_WARN("Could not find vtx at 0x{:X}", ptr);
-    return 0;
+    return std::nullopt;
 }
 
-int Texture(uint32_t ptr, int32_t fmt, int32_t siz, int32_t width, int32_t height, int32_t pal) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "TEXTURE");
+std::optional<std::string> GetDisplayListSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "GFX");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = dec.value();
+        SPDLOG_INFO("Found Display List: 0x{:X} Symbol: {}", ptr, symbol);
+        return symbol;
+    }
+
+    SPDLOG_WARN("Could not find display list to override at 0x{:X}", ptr);
+    return std::nullopt;
+}
+
+std::optional<std::string> GetTextureSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "TEXTURE");
+
+    if(dec.has_value()){
+        const auto symbol = dec.value();
         SPDLOG_INFO("Found Texture: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(symbol.c_str());
-        return 1;
+        return symbol;
     }
 
     SPDLOG_WARN("Could not find texture at 0x{:X}", ptr);
-    return 0;
+    return std::nullopt;
 }
 
-int Palette(uint32_t ptr, int32_t idx, int32_t count) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "TEXTURE");
+std::optional<std::string> GetPaletteSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "TEXTURE");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = dec.value();
         SPDLOG_INFO("Found TLUT: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(symbol.c_str());
-        return 1;
+        return symbol;
     }
 
     SPDLOG_WARN("Could not find tlut at 0x{:X}", ptr);
-    return 0;
+    return std::nullopt;
 }
 
-int Lights(uint32_t ptr, int32_t count) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "LIGHTS");
+std::optional<std::string> GetLightsSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "LIGHTS");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = dec.value();
         SPDLOG_INFO("Found Lightsn: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(symbol.c_str());
-        return 1;
+        return symbol;
     }
 
     SPDLOG_WARN("Could not find lights at 0x{:X}", ptr);
-    return 0;
+    return std::nullopt;
 }
 
-int Light(uint32_t ptr) {
-    auto res = Companion::Instance->GetSafeNodeByAddr(ptr, "LIGHTS");
+std::optional<std::string> GetLightSymbol(uint32_t ptr) {
+    auto res = Companion::Instance->GetSymbolByAddr(ptr, "LIGHTS");
 
     if(res.has_value()){
-        auto node = std::get<1>(res.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = res.value();
         SPDLOG_INFO("Found Light A Ptr: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(("&" + symbol + ".a").c_str());
-        return 1;
+        return "&" + symbol + ".a";
     }
 
-    res = Companion::Instance->GetSafeNodeByAddr(ptr - 0x8, "LIGHTS");
+    res = Companion::Instance->GetSymbolByAddr(ptr - 0x8, "LIGHTS");
 
     if(res.has_value()){
-        auto node = std::get<1>(res.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
+        const auto symbol = res.value();
         SPDLOG_INFO("Found Light L Ptr: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(("&" + symbol + ".l").c_str());
-        return 1;
+        return "&" + symbol + ".l";
     }
 
     SPDLOG_WARN("Could not find light at 0x{:X}", ptr);
-    return 0;
+    return std::nullopt;
 }
 
-int DisplayList(uint32_t ptr) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "GFX");
+std::optional<std::string> GetViewportSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "VP");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
-        SPDLOG_INFO("Found Display List: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(symbol.c_str());
-        return 1;
+        const auto symbol = dec.value();
+        SPDLOG_INFO("Found Viewport: 0x{:X} Symbol: {}", ptr, symbol);
+        return "&" + symbol;
     }
 
-    SPDLOG_WARN("Could not find display list to override at 0x{:X}", ptr);
-    return 0;
+    SPDLOG_TRACE("Could not find viewport to override at 0x{:X}", ptr);
+    return std::nullopt;
 }
 
-int Viewport(uint32_t ptr) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "VP");
+std::optional<std::string> GetMatrixSymbol(uint32_t ptr) {
+    auto dec = Companion::Instance->GetSymbolByAddr(ptr, "MTX");
 
     if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
-        SPDLOG_INFO("Found Viewport: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(("&" + symbol).c_str());
-        return 1;
+        const auto symbol = dec.value();
+        SPDLOG_INFO("Found Matrix: 0x{:X} Symbol: {}", ptr, symbol);
+        return "&" + symbol;
     }
 
-    SPDLOG_TRACE("Could not find viewport to override at 0x{:X}", ptr);
-    return 0;
+    SPDLOG_TRACE("Could not find matrix to override at 0x{:X}", ptr);
+    return std::nullopt;
 }
 
-int Matrix(uint32_t ptr) {
-    auto dec = Companion::Instance->GetSafeNodeByAddr(ptr, "MTX");
-
-    if(dec.has_value()){
-        auto node = std::get<1>(dec.value());
-        auto symbol = GetSafeNode<std::string>(node, "symbol");
-        SPDLOG_INFO("Found Matrix: 0x{:X} Symbol: {}", ptr, symbol);
-        gfxd_puts(("&" + symbol).c_str());
+#ifdef STANDALONE
+// gfxd callbacks, they print the symbol and return 1 if there is one, otherwise gfxd prints the address
+static int Put(const std::optional<std::string>& symbol) {
+    if(symbol.has_value()){
+        gfxd_puts(symbol->c_str());
         return 1;
     }
 
-    SPDLOG_TRACE("Could not find viewport to override at 0x{:X}", ptr);
     return 0;
 }
+
+void Triangle2(const N64Gfx* gfx) {
+    gfxd_puts(FormatTriangle2(gfx->words.w0, gfx->words.w1).c_str());
+}
+
+void Quadrangle(const N64Gfx* gfx) {
+    gfxd_puts(FormatQuadrangle(gfx->words.w1).c_str());
+}
+
+int Vtx(uint32_t ptr, int32_t num) {
+    return Put(GetVtxSymbol(ptr));
+}
+
+int Texture(uint32_t ptr, int32_t fmt, int32_t siz, int32_t width, int32_t height, int32_t pal) {
+    return Put(GetTextureSymbol(ptr));
+}
+
+int Palette(uint32_t ptr, int32_t idx, int32_t count) {
+    return Put(GetPaletteSymbol(ptr));
+}
+
+int Lights(uint32_t ptr, int32_t count) {
+    return Put(GetLightsSymbol(ptr));
+}
+
+int Light(uint32_t ptr) {
+    return Put(GetLightSymbol(ptr));
+}
+
+int DisplayList(uint32_t ptr) {
+    return Put(GetDisplayListSymbol(ptr));
+}
+
+int Viewport(uint32_t ptr) {
+    return Put(GetViewportSymbol(ptr));
+}
+
+int Matrix(uint32_t ptr) {
+    return Put(GetMatrixSymbol(ptr));
+}
 #endif
 
 std::optional<std::tuple<std::string, YAML::Node>> GetVtxOverlap(uint32_t ptr){
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <tuple>
 #include <string>
+#include <optional>
 
 typedef struct {
     uint32_t w0;
@@ -37,6 +38,18 @@ typedef union {
 } N64Vtx;
 
 namespace GFXDOverride {
+// Symbol lookups shared by the native disassembler and the gfxd callbacks, nullopt when the address is not an asset
+// of the expected type
+std::string FormatTriangle2(uint32_t w0, uint32_t w1);
+std::string FormatQuadrangle(uint32_t w1);
+std::optional<std::string> GetVtxSymbol(uint32_t ptr);
+std::optional<std::string> GetDisplayListSymbol(uint32_t ptr);
+std::optional<std::string> GetTextureSymbol(uint32_t ptr);
+std::optional<std::string> GetPaletteSymbol(uint32_t ptr);
+std::optional<std::string> GetLightsSymbol(uint32_t ptr);
+std::optional<std::string> GetLightSymbol(uint32_t ptr);
+std::optional<std::string> GetViewportSymbol(uint32_t ptr);
+std::optional<std::string> GetMatrixSymbol(uint32_t ptr);
 #ifdef STANDALONE
 void Quadrangle(const N64Gfx* gfx);
 void Triangle2(const N64Gfx* gfx);
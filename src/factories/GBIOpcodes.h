@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include "Companion.h"
+
+// Opcodes that differ between microcodes, resolved at compile time so display list loops can switch on them
+struct GBIOpcodes {
+    uint8_t vtx;
+    uint8_t dl;
+    uint8_t mtx;
+    uint8_t enddl;
+    uint8_t settimg;
+    uint8_t movemem;
+    uint8_t mvL0;
+    uint8_t mvL1;
+    uint8_t mvLight;
+    uint8_t tri2;
+    // 0xFF when the microcode has no quad command
+    uint8_t quad;
+    uint8_t tri1;
+    uint8_t texture;
+    uint8_t popmtx;
+    uint8_t moveword;
+    uint8_t othermodeH;
+    uint8_t othermodeL;
+    // F3D and F3DEX set and clear geometry mode bits with two commands, F3DEX2 with a single one, the others are 0xFF
+    uint8_t setgeometrymode;
+    uint8_t cleargeometrymode;
+    uint8_t geometrymode;
+    // Size of the vertex buffer G_VTX loads into
+    uint8_t vtxBuffer;
+    uint8_t spnoop;
+    uint8_t rdpnoop;
+    uint8_t culldl;
+    // 0xFF when the microcode has no depth branch
+    uint8_t branchZ;
+    uint8_t line3d;
+    // F3D and F3DEX modify vertices through G_MOVEWORD, the others are 0xFF
+    uint8_t modifyvtx;
+    uint8_t rdphalf1;
+    uint8_t rdphalf2;
+};
+
+// RDP commands, the same for every microcode
+struct RDPOpcodes {
+    uint8_t texrect;
+    uint8_t texrectflip;
+    uint8_t loadsync;
+    uint8_t pipesync;
+    uint8_t tilesync;
+    uint8_t fullsync;
+    uint8_t setkeygb;
+    uint8_t setkeyr;
+    uint8_t setconvert;
+    uint8_t setscissor;
+    uint8_t setprimdepth;
+    uint8_t setothermode;
+    uint8_t loadtlut;
+    uint8_t settilesize;
+    uint8_t loadblock;
+    uint8_t loadtile;
+    uint8_t settile;
+    uint8_t fillrect;
+    uint8_t setfillcolor;
+    uint8_t setfogcolor;
+    uint8_t setblendcolor;
+    uint8_t setprimcolor;
+    uint8_t setenvcolor;
+    uint8_t setcombine;
+    uint8_t settimg;
+    uint8_t setzimg;
+    uint8_t setcimg;
+};
+
+constexpr RDPOpcodes gRDPOpcodes = {
+    .texrect = 0xE4,
+    .texrectflip = 0xE5,
+    .loadsync = 0xE6,
+    .pipesync = 0xE7,
+    .tilesync = 0xE8,
+    .fullsync = 0xE9,
+    .setkeygb = 0xEA,
+    .setkeyr = 0xEB,
+    .setconvert = 0xEC,
+    .setscissor = 0xED,
+    .setprimdepth = 0xEE,
+    .setothermode = 0xEF,
+    .loadtlut = 0xF0,
+    .settilesize = 0xF2,
+    .loadblock = 0xF3,
+    .loadtile = 0xF4,
+    .settile = 0xF5,
+    .fillrect = 0xF6,
+    .setfillcolor = 0xF7,
+    .setfogcolor = 0xF8,
+    .setblendcolor = 0xF9,
+    .setprimcolor = 0xFA,
+    .setenvcolor = 0xFB,
+    .setcombine = 0xFC,
+    .settimg = 0xFD,
+    .setzimg = 0xFE,
+    .setcimg = 0xFF,
+};
+
+constexpr GBIOpcodes gF3DOpcodes = {
+    .vtx = 0x04,
+    .dl = 0x06,
+    .mtx = 0x01,
+    .enddl = 0xB8,
+    .settimg = 0xFD,
+    .movemem = 0x03,
+    .mvL0 = 0x86,
+    .mvL1 = 0x88,
+    .mvLight = 0x0A,
+    .tri2 = 0xB1,
+    .quad = 0xFF,
+    .tri1 = 0xBF,
+    .texture = 0xBB,
+    .popmtx = 0xBD,
+    .moveword = 0xBC,
+    .othermodeH = 0xBA,
+    .othermodeL = 0xB9,
+    .setgeometrymode = 0xB7,
+    .cleargeometrymode = 0xB6,
+    .geometrymode = 0xFF,
+    .vtxBuffer = 16,
+    .spnoop = 0x00,
+    .rdpnoop = 0xC0,
+    .culldl = 0xBE,
+    .branchZ = 0xFF,
+    .line3d = 0xB5,
+    .modifyvtx = 0xFF,
+    .rdphalf1 = 0xB4,
+    .rdphalf2 = 0xB3,
+};
+
+constexpr GBIOpcodes gF3DExOpcodes = {
+    .vtx = 0x04,
+    .dl = 0x06,
+    .mtx = 0x01,
+    .enddl = 0xB8,
+    .settimg = 0xFD,
+    .movemem = 0x03,
+    .mvL0 = 0x86,
+    .mvL1 = 0x88,
+    .mvLight = 0x0A,
+    .tri2 = 0xB1,
+    .quad = 0xB5,
+    .tri1 = 0xBF,
+    .texture = 0xBB,
+    .popmtx = 0xBD,
+    .moveword = 0xBC,
+    .othermodeH = 0xBA,
+    .othermodeL = 0xB9,
+    .setgeometrymode = 0xB7,
+    .cleargeometrymode = 0xB6,
+    .geometrymode = 0xFF,
+    .vtxBuffer = 32,
+    .spnoop = 0x00,
+    .rdpnoop = 0xC0,
+    .culldl = 0xBE,
+    .branchZ = 0xB0,
+    .line3d = 0xB5,
+    .modifyvtx = 0xFF,
+    .rdphalf1 = 0xB4,
+    .rdphalf2 = 0xB3,
+};
+
+constexpr GBIOpcodes gF3DEx2Opcodes = {
+    .vtx = 0x01,
+    .dl = 0xDE,
+    .mtx = 0xDA,
+    .enddl = 0xDF,
+    .settimg = 0xFD,
+    .movemem = 0xDC,
+    .mvL0 = 0x86,
+    .mvL1 = 0x88,
+    .mvLight = 0x0A,
+    .tri2 = 0x06,
+    .quad = 0x07,
+    .tri1 = 0x05,
+    .texture = 0xD7,
+    .popmtx = 0xD8,
+    .moveword = 0xDB,
+    .othermodeH = 0xE3,
+    .othermodeL = 0xE2,
+    .setgeometrymode = 0xFF,
+    .cleargeometrymode = 0xFF,
+    .geometrymode = 0xD9,
+    .vtxBuffer = 32,
+    .spnoop = 0xE0,
+    .rdpnoop = 0x00,
+    .culldl = 0x03,
+    .branchZ = 0x04,
+    .line3d = 0x08,
+    .modifyvtx = 0x02,
+    .rdphalf1 = 0xE1,
+    .rdphalf2 = 0xF1,
+};
+
+// The beta microcodes share the command encoding of the release they preceded
+constexpr const GBIOpcodes& GetGBIOpcodes(const GBIVersion version) {
+    switch (version) {
+        case GBIVersion::f3d:
+        case GBIVersion::f3db:
+            return gF3DOpcodes;
+        case GBIVersion::f3dex:
+        case GBIVersion::f3dexb:
+            return gF3DExOpcodes;
+        case GBIVersion::f3dex2:
+        default:
+            return gF3DEx2Opcodes;
+    }
+}
+
+// Version checks for if constexpr chains, each beta is grouped with its release
+constexpr bool IsF3D(const GBIVersion version) {
+    return version == GBIVersion::f3d || version == GBIVersion::f3db;
+}
+
+constexpr bool IsF3DEX(const GBIVersion version) {
+    return version == GBIVersion::f3dex || version == GBIVersion::f3dexb;
+}
+
+struct GBIMoveMem {
+    uint8_t index;
+    uint8_t offset;
+};
+
+// Light slot and byte offset a G_MOVEMEM loads, as stored in the exported OTR command
+template<GBIVersion V>
+constexpr GBIMoveMem DecodeMoveMem(const uint32_t w0) {
+    if constexpr (IsF3D(V)) {
+        return { static_cast<uint8_t>((w0 >> 16) & 0xFF), 0 };
+    } else if constexpr (IsF3DEX(V)) {
+        return { static_cast<uint8_t>((w0 >> 16) & 0xFF), static_cast<uint8_t>(((w0 >> 8) & 0xFF) * 8) };
+    } else {
+        return { static_cast<uint8_t>(w0 & 0xFF), static_cast<uint8_t>(((w0 >> 8) & 0xFF) * 8) };
+    }
+}
+
+// Whether a G_MOVEMEM is the gsSPLight whose pointer the lights asset is generated from
+template<GBIVersion V>
+constexpr bool IsLightMoveMem(const uint32_t w0) {
+    constexpr GBIOpcodes gbi = GetGBIOpcodes(V);
+
+    /*
+     * Only generate lights on the second gsSPLight.
+     * gsSPSetLights1(name) outputs three macros:
+     *
+     * gsSPNumLights(NUMLIGHTS_1)
+     * gsSPLight(&name.l[0], G_MV_L0)
+     * gsSPLight(&name.a, G_MV_L1) <-- This ptr is used to generate the lights
+    */
+    if constexpr (IsF3D(V) || IsF3DEX(V)) {
+        if (((w0 >> 16) & 0xFF) == gbi.mvL1) {
+            return true;
+        }
+    }
+
+    // same thing as above; see macro gSPLight at gbi.h
+    return (w0 & 0xFF) == gbi.mvLight && ((w0 >> 8) & 0xFF) * 8 == (2 * 24 + 24);
+}
+
+// The betas decode G_MOVEMEM like their release, gsSPLight(&name.a, G_MV_L1) and the F3DEX2 gsSPLight(&name.l[0], 2)
+static_assert(IsLightMoveMem<GBIVersion::f3db>(0x03880010) && IsLightMoveMem<GBIVersion::f3dexb>(0x03880010));
+static_assert(!IsLightMoveMem<GBIVersion::f3db>(0x03860010) && IsLightMoveMem<GBIVersion::f3dex2>(0xDC08090A));
+static_assert(DecodeMoveMem<GBIVersion::f3db>(0x03880010).index == 0x88 && DecodeMoveMem<GBIVersion::f3db>(0x03880010).offset == 0);
+static_assert(DecodeMoveMem<GBIVersion::f3dexb>(0x03860210).index == 0x86 && DecodeMoveMem<GBIVersion::f3dexb>(0x03860210).offset == 16);
+static_assert(DecodeMoveMem<GBIVersion::f3dex2>(0xDC08090A).index == 0x0A && DecodeMoveMem<GBIVersion::f3dex2>(0xDC08090A).offset == 72);
+
+// Calls Fn<version>::Run for the configured microcode, so the per-command dispatch is picked once per display list
+template<template<GBIVersion> class Fn, typename... Args>
+auto DispatchGBI(const GBIVersion version, Args&&... args) {
+    switch (version) {
+        case GBIVersion::f3db:
+            return Fn<GBIVersion::f3db>::Run(std::forward<Args>(args)...);
+        case GBIVersion::f3d:
+            return Fn<GBIVersion::f3d>::Run(std::forward<Args>(args)...);
+        case GBIVersion::f3dex:
+            return Fn<GBIVersion::f3dex>::Run(std::forward<Args>(args)...);
+        case GBIVersion::f3dexb:
+            return Fn<GBIVersion::f3dexb>::Run(std::forward<Args>(args)...);
+        case GBIVersion::f3dex2:
+        default:
+            return Fn<GBIVersion::f3dex2>::Run(std::forward<Args>(args)...);
+    }
+}
@@ -2,6 +2,9 @@
 #include "utils/Decompressor.h"
 #include "spdlog/spdlog.h"
 #include "Companion.h"
+#include "utils/FileWriter.h"
+#include "utils/ModdingCache.h"
+#include "utils/BinaryEmbed.h"
 #include <iomanip>
 #include <regex>
 
@@ -88,16 +91,29 @@ ExportResult TextureCodeExporter::Export(std::ostream &write, std::shared_ptr<IP
     (*replacement) += "." + format;
 
     std::string dpath = Companion::Instance->GetOutputPath() + "/" + (*replacement);
-    if(!exists(fs::path(dpath).parent_path())){
-        create_directories(fs::path(dpath).parent_path());
-    }
 
     std::ostringstream imgstream;
 
     size_t byteSize = std::max(1, (int) (texture->mFormat.depth / 8));
     size_t isize = texture->mBuffer.size() / byteSize;
 
-    for (int i = 0; i < data.size(); i+=byteSize) {
+    const auto ctype = GetSafeNode<std::string>(node, "ctype", "u8");
+    const auto searchTable = Companion::Instance->SearchTable(offset);
+
+    if(!searchTable.has_value() && BinaryEmbed::WriteDefinition(write, ctype, symbol, *replacement, data, byteSize)) {
+        if (Companion::Instance->IsDebug()) {
+            write << "// size: 0x" << std::hex << std::uppercase << data.size();
+        }
+
+        write << "\n";
+        return offset + isize * byteSize;
+    }
+
+    // Table entries can only be embedded when each element is a single byte
+    std::ostringstream embedstream;
+    const bool embedded = searchTable.has_value() && BinaryEmbed::WriteElements(embedstream, *replacement, data.data(), data.size(), byteSize, std::string(tab_t) + tab_t);
+
+    for (int i = 0; i < data.size() && !embedded; i+=byteSize) {
         if (i % 16 == 0 && i != 0) {
             imgstream << std::endl;
         }
@@ -112,14 +128,10 @@ ExportResult TextureCodeExporter::Export(std::ostream &write, std::shared_ptr<IP
     }
     imgstream << std::endl;
 
-    if (!Companion::Instance->IsUsingIndividualIncludes()){
-        std::ofstream file(dpath + ".inc.c", std::ios::binary);
-        file << imgstream.str();
-        file.close();
+    if (!Companion::Instance->IsInliningData() && !embedded){
+        FileWriter::Queue(dpath + ".inc.c", imgstream.str());
     }
 
-    const auto searchTable = Companion::Instance->SearchTable(offset);
-
     if(searchTable.has_value()){
         const auto [name, start, end, mode, index_size] = searchTable.value();
 
@@ -132,11 +144,13 @@ ExportResult TextureCodeExporter::Export(std::ostream &write, std::shared_ptr<IP
         }
 
         if(start == offset){
-            write << GetSafeNode<std::string>(node, "ctype", "u8") << " " << name << "[][" << isize << "] = {\n";
+            write << ctype << " " << name << "[][" << isize << "] = {\n";
         }
 
         write << tab_t << "{\n";
-        if (!Companion::Instance->IsUsingIndividualIncludes()){
+        if (embedded) {
+            write << embedstream.str();
+        } else if (!Companion::Instance->IsInliningData()){
             write << tab_t << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".inc.c\"\n";
         } else {
             write << imgstream.str();
@@ -150,9 +164,9 @@ ExportResult TextureCodeExporter::Export(std::ostream &write, std::shared_ptr<IP
             }
         }
     } else {
-        write << GetSafeNode<std::string>(node, "ctype", "u8") << " " << symbol  << "[] = {\n";
+        write << ctype << " " << symbol  << "[] = {\n";
 
-        if (!Companion::Instance->IsUsingIndividualIncludes()){
+        if (!Companion::Instance->IsInliningData()){
             write << tab_t << "#include \"" << Companion::Instance->GetDestRelativeOutputPath() + "/" << *replacement << ".inc.c\"\n";
         } else {
             write << imgstream.str();
@@ -169,11 +183,75 @@ ExportResult TextureCodeExporter::Export(std::ostream &write, std::shared_ptr<IP
     return offset + isize * byteSize;
 }
 
+// Tells the port the image is already RGBA8 and must not be converted from the format set by the display list
+#define TEX_FLAG_LOAD_AS_RAW (1 << 0)
+
+static std::optional<std::vector<uint8_t>> DecodeTexture(const std::shared_ptr<TextureData>& texture, YAML::Node& node) {
+    const auto type = texture->mFormat.type;
+    const bool decode = GetSafeNode<bool>(node, "decode", Companion::Instance->GetTextureExport() == TextureExport::RGBA32);
+
+    // Tluts are loaded separately by the display lists, and RGBA32 is already what the port wants
+    if(!decode || type == TextureType::TLUT || type == TextureType::RGBA32bpp) {
+        return std::nullopt;
+    }
+
+    std::optional<ParseResultData> palette;
+    auto tlutType = TextureType::RGBA16bpp;
+    if(type == TextureType::Palette4bpp || type == TextureType::Palette8bpp) {
+        if(node["tlut_symbol"]) {
+            palette = Companion::Instance->GetParseDataBySymbol(GetSafeNode<std::string>(node, "tlut_symbol"));
+        } else if(node["tlut"]) {
+            palette = Companion::Instance->GetParseDataByAddr(GetSafeNode<uint32_t>(node, "tlut"));
+        }
+
+        if(!palette.has_value() || !palette->data.has_value()) {
+            SPDLOG_WARN("No tlut found for {}, exporting it as {}bpp CI", GetSafeNode<std::string>(node, "symbol", "texture"), texture->mFormat.depth);
+            return std::nullopt;
+        }
+
+        // The display list picks how the tlut is read (G_TT_RGBA16 or G_TT_IA16), so the asset has to tell which one it is
+        const auto tlutFormat = GetSafeNode<std::string>(node, "tlut_format", GetSafeNode<std::string>(palette->node, "tlut_format", ""));
+        if(tlutFormat == "IA16") {
+            tlutType = TextureType::GrayscaleAlpha16bpp;
+        } else if(tlutFormat != "RGBA16") {
+            SPDLOG_WARN("Unknown tlut_format for {}, exporting it as {}bpp CI", GetSafeNode<std::string>(node, "symbol", "texture"), texture->mFormat.depth);
+            return std::nullopt;
+        }
+    }
+
+    const auto tlut = palette.has_value() ? &std::static_pointer_cast<TextureData>(palette->data.value())->mBuffer : nullptr;
+    auto result = TextureUtils::DecodeToRGBA32(type, texture->mWidth, texture->mHeight, texture->mBuffer, tlut, tlutType);
+
+    if(result.empty()) {
+        SPDLOG_WARN("Failed to decode {} to RGBA32, exporting it in its native format", GetSafeNode<std::string>(node, "symbol", "texture"));
+        return std::nullopt;
+    }
+
+    return result;
+}
+
 ExportResult TextureBinaryExporter::Export(std::ostream &write, std::shared_ptr<IParsedData> raw, std::string& entryName, YAML::Node &node, std::string* replacement) {
     auto writer = LUS::BinaryWriter();
     auto texture = std::static_pointer_cast<TextureData>(raw);
     auto data = texture->mBuffer;
 
+    if(auto decoded = DecodeTexture(texture, node)) {
+        WriteHeader(writer, Torch::ResourceType::Texture, 1);
+
+        writer.Write((uint32_t) TextureType::RGBA32bpp);
+        writer.Write(texture->mWidth);
+        writer.Write(texture->mHeight);
+        writer.Write((uint32_t) TEX_FLAG_LOAD_AS_RAW);
+        // Ratio between the decoded and the native line size, the port scales the tile sizes the game sets up by it
+        writer.Write(32.0f / texture->mFormat.depth);
+        writer.Write(1.0f);
+
+        writer.Write((uint32_t) decoded->size());
+        writer.Write((char*) decoded->data(), decoded->size());
+        writer.Finish(write);
+        return std::nullopt;
+    }
+
     WriteHeader(writer, Torch::ResourceType::Texture, 0);
 
     if(texture->mFormat.type == TextureType::TLUT) {
@@ -193,8 +271,7 @@ ExportResult TextureBinaryExporter::Export(std::ostream &write, std::shared_ptr<
 ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<IParsedData> data, std::string&entryName, YAML::Node&node, std::string* replacement) {
     auto texture = std::static_pointer_cast<TextureData>(data);
     auto format = texture->mFormat;
-    uint8_t* raw = new uint8_t[TextureUtils::CalculateTextureSize(format.type, texture->mWidth, texture->mHeight) * 2];
-    int size = 0;
+    PNGImage image;
 
     auto ext = GetSafeNode<std::string>(node, "format");
 
@@ -205,8 +282,8 @@ ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<
         case TextureType::TLUT:
         case TextureType::RGBA16bpp:
         case TextureType::RGBA32bpp: {
-            rgba* imgr = raw2rgba(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(rgba2png(&raw, &size, imgr, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::RGBA, texture->mWidth, texture->mHeight);
+            if(raw2rgba_into(reinterpret_cast<rgba*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
@@ -215,8 +292,8 @@ ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<
         case TextureType::GrayscaleAlpha8bpp:
         case TextureType::GrayscaleAlpha4bpp:
         case TextureType::GrayscaleAlpha1bpp: {
-            ia* imgia = raw2ia(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(ia2png(&raw, &size, imgia, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, texture->mWidth, texture->mHeight);
+            if(raw2ia_into(reinterpret_cast<ia*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
@@ -229,7 +306,7 @@ ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<
 
                 if (palette.has_value()) {
                     auto palTexture = std::static_pointer_cast<TextureData>(palette.value().data.value());
-                    convert_raw_to_ci8(&raw, &size, texture->mBuffer.data(), (uint8_t *)palTexture->mBuffer.data(), 0, texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mFormat.depth);
+                    image = PNGEncoder::CreatePaletteImage(texture->mBuffer.data(), texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mBuffer, palTexture->mFormat.depth);
                 } else {
                     auto symbol = GetSafeNode<std::string>(node, "symbol");
                     throw std::runtime_error("Could not convert ci8 '"+symbol+"' the tlut symbol name is probably wrong for tlut_symbol node");
@@ -243,7 +320,7 @@ ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<
 
                 if (palette.has_value()) {
                     auto palTexture = std::static_pointer_cast<TextureData>(palette.value().data.value());
-                    convert_raw_to_ci8(&raw, &size, texture->mBuffer.data(), (uint8_t *)palTexture->mBuffer.data(), 0, texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mFormat.depth);
+                    image = PNGEncoder::CreatePaletteImage(texture->mBuffer.data(), texture->mWidth, texture->mHeight, texture->mFormat.depth, palTexture->mBuffer, palTexture->mFormat.depth);
                 } else {
                     auto symbol = GetSafeNode<std::string>(node, "symbol");
                     throw std::runtime_error("Could not convert ci8 '"+symbol+"' the address is probably wrong for tlut address node");
@@ -253,22 +330,42 @@ ExportResult TextureModdingExporter::Export(std::ostream&write, std::shared_ptr<
         }
         case TextureType::Grayscale8bpp:
         case TextureType::Grayscale4bpp: {
-            ia* imgi = raw2i(texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth);
-            if(ia2png(&raw, &size, imgi, texture->mWidth, texture->mHeight)) {
+            image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, texture->mWidth, texture->mHeight);
+            if(raw2i_into(reinterpret_cast<ia*>(image.pixels.data()), texture->mBuffer.data(), texture->mWidth, texture->mHeight, format.depth)) {
                 throw std::runtime_error("Failed to convert texture to PNG");
             }
             break;
         }
         default: {
             SPDLOG_ERROR("Unsupported texture format for modding: {}", ext);
+            return std::nullopt;
         }
     }
 
-    write.write(reinterpret_cast<char*>(raw), size);
+    Companion::Instance->QueueModdingImage(std::move(image));
     return std::nullopt;
 }
 
 
+// CI textures that carry a tlut offset and a color count bring in their TLUT as its own asset
+static void AddTlutAsset(YAML::Node& node, const std::string& symbol) {
+    YAML::Node tlutNode;
+    const auto tlutOffset = GetSafeNode<uint32_t>(node, "tlut");
+    const auto tlutSymbol = GetSafeNode(node, "tlut_symbol", symbol + "_tlut");
+    std::ostringstream offsetSeg;
+    offsetSeg << std::uppercase << std::hex << tlutOffset;
+    tlutNode["symbol"] = std::regex_replace(tlutSymbol, std::regex(R"(OFFSET)"), offsetSeg.str());
+    tlutNode["type"] = "TEXTURE";
+    tlutNode["format"] = "TLUT";
+    tlutNode["offset"] = tlutOffset;
+    tlutNode["colors"] = GetSafeNode<uint32_t>(node, "colors");
+    node["tlut"] = tlutOffset;
+    if(node["tlut_ctype"]) {
+        tlutNode["ctype"] = GetSafeNode<std::string>(node, "tlut_ctype");
+    }
+    Companion::Instance->AddAsset(tlutNode);
+}
+
 std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse(std::vector<uint8_t>& buffer, YAML::Node& node) {
     auto offset = GetSafeNode<uint32_t>(node, "offset");
     auto format = GetSafeNode<std::string>(node, "format");
@@ -301,21 +398,7 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse(std::vector<ui
     }
 
     if((format == "CI4" || format == "CI8") && node["tlut"] && node["colors"]) {
-        YAML::Node tlutNode;
-        const auto tlutOffset = GetSafeNode<uint32_t>(node, "tlut");
-        const auto tlutSymbol = GetSafeNode(node, "tlut_symbol", symbol + "_tlut");
-        std::ostringstream offsetSeg;
-        offsetSeg << std::uppercase << std::hex << tlutOffset;
-        tlutNode["symbol"] = std::regex_replace(tlutSymbol, std::regex(R"(OFFSET)"), offsetSeg.str());
-        tlutNode["type"] = "TEXTURE";
-        tlutNode["format"] = "TLUT";
-        tlutNode["offset"] = tlutOffset;
-        tlutNode["colors"] = GetSafeNode<uint32_t>(node, "colors");
-        node["tlut"] = tlutOffset;
-        if(node["tlut_ctype"]) {
-            tlutNode["ctype"] = GetSafeNode<std::string>(node, "tlut_ctype");
-        }
-        Companion::Instance->AddAsset(tlutNode);
+        AddTlutAsset(node, symbol);
     }
     size = GetSafeNode<uint32_t>(node, "size", TextureUtils::CalculateTextureSize(sTextureFormats.at(format).type, width, height));
     auto [_, segment] = Decompressor::AutoDecode(node, buffer, size);
@@ -327,6 +410,11 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse(std::vector<ui
         result = std::vector(segment.data, segment.data + segment.size);
     }
 
+    // Textures sharing their TLUT with a modded CI texture are remapped to the palette quantized for it
+    if(auto imported = ModdingCache::ImportPalette(node)) {
+        result = std::move(imported->data);
+    }
+
     SPDLOG_INFO("Texture: {}", format);
     if(fmt.type == TextureType::TLUT){
         SPDLOG_INFO("Colors: {}", width);
@@ -350,6 +438,7 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse(std::vector<ui
 
 std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse_modding(std::vector<uint8_t>& buffer, YAML::Node& node) {
     auto format = GetSafeNode<std::string>(node, "format");
+    auto symbol = GetSafeNode<std::string>(node, "symbol", "texture");
     int width;
     int height;
     uint32_t size;
@@ -362,6 +451,8 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse_modding(std::v
         return std::nullopt;
     }
 
+    std::transform(format.begin(), format.end(), format.begin(), ::toupper);
+
     if(!sTextureFormats.contains(format)) {
         return std::nullopt;
     }
@@ -375,69 +466,46 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse_modding(std::v
         height = GetSafeNode<uint32_t>(node, "height");
     }
 
-    uint8_t* raw;
+    if((format == "CI4" || format == "CI8") && node["tlut"] && node["colors"]) {
+        AddTlutAsset(node, symbol);
+    }
+
+    std::vector<uint8_t> result;
     switch (fmt.type) {
-        case TextureType::TLUT:
         case TextureType::RGBA16bpp:
-        case TextureType::RGBA32bpp: {
-            const auto imgr = png2rgba(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(rgba2raw(raw, imgr, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
-            }
-            break;
-        }
+        case TextureType::RGBA32bpp:
         case TextureType::GrayscaleAlpha16bpp:
         case TextureType::GrayscaleAlpha8bpp:
         case TextureType::GrayscaleAlpha4bpp:
-        case TextureType::GrayscaleAlpha1bpp: {
-            const auto imgia = png2ia(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(ia2raw(raw, imgia, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
-            }
+        case TextureType::GrayscaleAlpha1bpp:
+        case TextureType::Grayscale8bpp:
+        case TextureType::Grayscale4bpp: {
+            auto texture = ModdingCache::ImportTexture(buffer, fmt);
+            width = texture.width;
+            height = texture.height;
+            result = std::move(texture.data);
+            size = result.size();
             break;
         }
+        case TextureType::TLUT:
         case TextureType::Palette8bpp:
         case TextureType::Palette4bpp: {
-            // This implementation is not correct.
-            // The process should be:
-            // png2rgba --> imgpal2rawci
-
-            // todo: Add wheel palette input
-            // Implement so that it works.
-
-            // auto tlut = GetSafeNode<std::string>(node,"tlut_symbol");
-            // auto tlutTextureMap = Companion::Instance->GetTlutTextureMap();
-            // auto palettePtr = tlutTextureMap[tlut];
-
-            // if (palettePtr) {
-
-            //     auto imgi = png2rgba(buffer.data(), buffer.size(), &width, &height);
-            //     auto pal = png2rgba(palettePtr->mBuffer.data(), (palettePtr->mWidth * palettePtr->mWidth * palettePtr->mFormat.depth * 2), &width, &height);
-
-            //     size = width * height * fmt.depth / 8;
-            //     raw = new uint8_t[size];
-
-            //     if(imgpal2rawci(raw, imgi, pal, 0, 0, width, height, fmt.depth) <= 0){
-            //         throw std::runtime_error("Failed to convert PNG to texture");
-            //     }
-            // } else {
+            // CI textures are quantized together with everything sharing their TLUT, an edited TLUT image is only
+            // used as is when none of those textures is modded
+            auto texture = ModdingCache::ImportPalette(node);
+            if(!texture.has_value() && fmt.type == TextureType::TLUT) {
+                texture = ModdingCache::ImportTexture(buffer, fmt);
+            }
 
-            // }
-            SPDLOG_ERROR("Unsupported texture format for modding: {}", format);
-            return std::nullopt;
-        }
-        case TextureType::Grayscale8bpp:
-        case TextureType::Grayscale4bpp: {
-            const auto imgi = png2ia(buffer.data(), buffer.size(), &width, &height);
-            size = width * height * fmt.depth / 8;
-            raw = new uint8_t[size];
-            if(i2raw(raw, imgi, width, height, fmt.depth) <= 0){
-                throw std::runtime_error("Failed to convert PNG to texture");
+            if(!texture.has_value()) {
+                SPDLOG_ERROR("No tlut found for {}, add a tlut or tlut_symbol node to import it", symbol);
+                return std::nullopt;
             }
+
+            width = texture->width;
+            height = texture->height;
+            result = std::move(texture->data);
+            size = result.size();
             break;
         }
         default: {
@@ -446,8 +514,6 @@ std::optional<std::shared_ptr<IParsedData>> TextureFactory::parse_modding(std::v
         }
     }
 
-    auto result = std::vector(raw, raw + size);
-
     SPDLOG_INFO("Texture: {}", format);
     if(fmt.type == TextureType::TLUT){
         SPDLOG_INFO("Colors: {}", width);
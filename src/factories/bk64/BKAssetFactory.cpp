@@ -83,6 +83,16 @@ std::optional<std::shared_ptr<IParsedData>> BKAssetFactory::parse(std::vector<ui
         assetTableInfo.emplace_back(assetInfo);
     }
 
+    // Inflate every compressed asset up front in parallel, both the type checks below and the generated assets reuse them
+    std::vector<std::pair<uint32_t, uint32_t>> compressedAssets;
+    for (uint32_t i = 0; i + 1 < assetCount; i++) {
+        const auto& assetInfo = assetTableInfo.at(i);
+        if (assetInfo.tFlag != 4 && assetInfo.compressionFlag != 0) {
+            compressedAssets.emplace_back(dataStartRomOffset + assetInfo.offset, assetTableInfo.at(i + 1).offset - assetInfo.offset);
+        }
+    }
+    Decompressor::PrefetchBKZIP(buffer, compressedAssets);
+
     int count = 0;
 
     for (uint32_t i = 0; i < assetCount - 1; i++) {
@@ -2,6 +2,7 @@
 #include "spdlog/spdlog.h"
 #include "Companion.h"
 #include "utils/Decompressor.h"
+#include "utils/FileWriter.h"
 #include <iomanip>
 #include <yaml-cpp/yaml.h>
 #include <cstring>
@@ -158,10 +159,7 @@ ExportResult SpriteModdingExporter::Export(std::ostream&write, std::shared_ptr<I
 
     for (auto& chunk : sprites->mChunks) {
         auto format = chunk.mFormat;
-        std::ostringstream stream;
-    
-        uint8_t* raw = new uint8_t[TextureUtils::CalculateTextureSize(format.type, chunk.mWidth, chunk.mHeight) * 2];
-        int size = 0;
+        PNGImage image;
 
         auto ext = sTextureFormatsReverse.at(format.type);
 
@@ -173,8 +171,8 @@ ExportResult SpriteModdingExporter::Export(std::ostream&write, std::shared_ptr<I
                 palette = &chunk;
             case TextureType::RGBA16bpp:
             case TextureType::RGBA32bpp: {
-                rgba* imgr = raw2rgba(chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth);
-                if(rgba2png(&raw, &size, imgr, chunk.mWidth, chunk.mHeight)) {
+                image = PNGEncoder::CreateImage(PNGColor::RGBA, chunk.mWidth, chunk.mHeight);
+                if(raw2rgba_into(reinterpret_cast<rgba*>(image.pixels.data()), chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth)) {
                     throw std::runtime_error("Failed to convert texture to PNG");
                 }
                 break;
@@ -183,8 +181,8 @@ ExportResult SpriteModdingExporter::Export(std::ostream&write, std::shared_ptr<I
             case TextureType::GrayscaleAlpha8bpp:
             case TextureType::GrayscaleAlpha4bpp:
             case TextureType::GrayscaleAlpha1bpp: {
-                ia* imgia = raw2ia(chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth);
-                if(ia2png(&raw, &size, imgia, chunk.mWidth, chunk.mHeight)) {
+                image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, chunk.mWidth, chunk.mHeight);
+                if(raw2ia_into(reinterpret_cast<ia*>(image.pixels.data()), chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth)) {
                     throw std::runtime_error("Failed to convert texture to PNG");
                 }
                 break;
@@ -194,13 +192,13 @@ ExportResult SpriteModdingExporter::Export(std::ostream&write, std::shared_ptr<I
                 if (palette == nullptr) {
                     throw std::runtime_error("Failed to find TLUT");
                 }
-                convert_raw_to_ci8(&raw, &size, chunk.mBuffer.data(), (uint8_t *)palette->mBuffer.data(), 0, chunk.mWidth, chunk.mHeight, chunk.mFormat.depth, palette->mFormat.depth);
+                image = PNGEncoder::CreatePaletteImage(chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, chunk.mFormat.depth, palette->mBuffer, palette->mFormat.depth);
                 break;
             }
             case TextureType::Grayscale8bpp:
             case TextureType::Grayscale4bpp: {
-                ia* imgi = raw2i(chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth);
-                if(ia2png(&raw, &size, imgi, chunk.mWidth, chunk.mHeight)) {
+                image = PNGEncoder::CreateImage(PNGColor::GrayAlpha, chunk.mWidth, chunk.mHeight);
+                if(raw2i_into(reinterpret_cast<ia*>(image.pixels.data()), chunk.mBuffer.data(), chunk.mWidth, chunk.mHeight, format.depth)) {
                     throw std::runtime_error("Failed to convert texture to PNG");
                 }
                 break;
@@ -223,20 +221,12 @@ ExportResult SpriteModdingExporter::Export(std::ostream&write, std::shared_ptr<I
             frame++;
         }
 
-        stream.write(reinterpret_cast<char*>(raw), size);
-        auto data = stream.str();
-        if(data.empty()) {
+        if(image.pixels.empty()) {
             continue;
         }
 
         std::string dpath = Companion::Instance->GetOutputPath() + "/" + outFile;
-        if(!exists(fs::path(dpath).parent_path())){
-            create_directories(fs::path(dpath).parent_path());
-        }
-
-        std::ofstream file(dpath, std::ios::binary);
-        file.write(data.c_str(), data.size());
-        file.close();
+        PNGEncoder::Queue(dpath, std::move(image), Companion::Instance->GetPNGCompression());
     }
     return std::nullopt;
 }
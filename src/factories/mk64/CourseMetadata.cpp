@@ -1,6 +1,7 @@
 #include "CourseMetadata.h"
 
 #include "Companion.h"
+#include "utils/FileWriter.h"
 #include "spdlog/spdlog.h"
 #include <algorithm>
 #include <filesystem>
@@ -21,278 +22,231 @@ ExportResult MK64::CourseMetadataCodeExporter::Export(std::ostream &write, std::
             return a.id < b.id;
     });
 
-    std::ofstream file;
+    std::ostringstream file;
     auto outDir = GetSafeNode<std::string>(node, "out_directory") + "/";
 
-    // Check if the output directory exists, and create it if it doesn't.
-    if (!std::filesystem::exists(outDir)) {
-        std::filesystem::create_directory(outDir);
+    file.str("");
+   // file << "char *gCourseNames[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        if (m.name == "null") { continue; }
+        // Remove debug line once proven that sort worked right (start at id 0 and go up)
+        SPDLOG_INFO("Processing Course Id: "+std::to_string(m.id));
+        file << '"' << m.name << "\", ";
     }
-    
-    file.open(outDir+"gCourseNames.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-       // file << "char *gCourseNames[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            if (m.name == "null") { continue; }
-            // Remove debug line once proven that sort worked right (start at id 0 and go up)
-            SPDLOG_INFO("Processing Course Id: "+std::to_string(m.id));
-            file << '"' << m.name << "\", ";
-        }
-        file << "\n";
-       // file << "\n};\n\n";
-        file.close();
-    } else if (file.fail()) {
-        throw std::runtime_error("Course metadata output folder is likely bad or the file is in-use");
+    file << "\n";
+   // file << "\n};\n\n";
+    FileWriter::Queue(outDir + "gCourseNames.inc.c", file.str());
+
+    file.str("");
+   // file << "char *gDebugCourseNames[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        if (m.name == "null") { continue; }
+        file << '"' << m.debugName << "\", ";
     }
-
-    file.open(outDir+"gCourseDebugNames.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-       // file << "char *gDebugCourseNames[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            if (m.name == "null") { continue; }
-            file << '"' << m.debugName << "\", ";
-        }
-        file << "\n";
-        //file << "\n};\n\n";
-        file.close();
+    file << "\n";
+    //file << "\n};\n\n";
+    FileWriter::Queue(outDir + "gCourseDebugNames.inc.c", file.str());
+
+    file.str("");
+    //file << "char *gCupSelectionByCourseId[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        if (m.cup == "null") { continue; }
+        file << m.cup << ", ";
     }
-
-    file.open(outDir+"gCupSelectionByCourseId.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        //file << "char *gCupSelectionByCourseId[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            if (m.cup == "null") { continue; }
-            file << m.cup << ", ";
-        }
-        file << "\n";
-       // file << "\n};\n\n";
-        file.close();
+    file << "\n";
+   // file << "\n};\n\n";
+    FileWriter::Queue(outDir + "gCupSelectionByCourseId.inc.c", file.str());
+
+    file.str("");
+    //file << "const u8 gPerCupIndexByCourseId[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        if (m.cupIndex == -1) { continue; }
+        file << m.cupIndex << ", ";
     }
-
-    file.open(outDir+"gPerCupIndexByCourseId.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        //file << "const u8 gPerCupIndexByCourseId[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            if (m.cupIndex == -1) { continue; }
-            file << m.cupIndex << ", ";
-        }
-        file << "\n";
-        //file << "\n};\n\n";
-        file.close();
+    file << "\n";
+    //file << "\n};\n\n";
+    FileWriter::Queue(outDir + "gPerCupIndexByCourseId.inc.c", file.str());
+
+    file.str("");
+    for (const auto& m : metadata) {
+        if (m.courseLength == "null") { continue; }
+        file << '"' << m.courseLength << "\", ";
     }
+    file << "\n";
+    FileWriter::Queue(outDir + "sCourseLengths.inc.c", file.str());
 
-    file.open(outDir+"sCourseLengths.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            if (m.courseLength == "null") { continue; }
-            file << '"' << m.courseLength << "\", ";
-        }
-        file << "\n";
-        file.close();
+    file.str("");
+    for (const auto& m : metadata) {
+        file << m.CPUBehaviourLUT << ", ";
     }
-
-    file.open(outDir+"cpu_BehaviourLUT.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << m.CPUBehaviourLUT << ", ";
-        }
-        file << 0; // @WARNING TRAILING ZERO IN ARRAY
-        file << "\n";
-        file.close();
+    file << 0; // @WARNING TRAILING ZERO IN ARRAY
+    file << "\n";
+    FileWriter::Queue(outDir + "cpu_BehaviourLUT.inc.c", file.str());
+
+    file.str("");
+    // file << "f32 gWaypointWidth[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        file << m.kartAIMaximumSeparation << ", ";
     }
-
-    file.open(outDir+"cpu_CourseMaximumSeparation.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        // file << "f32 gWaypointWidth[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            file << m.kartAIMaximumSeparation << ", ";
-        }
-        file << "\n";
-        // file << "\n};\n\n";
-        file.close();
+    file << "\n";
+    // file << "\n};\n\n";
+    FileWriter::Queue(outDir + "cpu_CourseMaximumSeparation.inc.c", file.str());
+
+    file.str("");
+    // file << "f32 gWaypointWidth2[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        file << m.kartAIMinimumSeparation << ", ";
     }
-
-    file.open(outDir+"cpu_CourseMinimumSeparation.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        // file << "f32 gWaypointWidth2[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            file << m.kartAIMinimumSeparation << ", ";
-        }
-        file << "\n";
-        // file << "\n};\n\n";
-        file.close();
-    }
-
-    file.open(outDir+"D_800DCBB4.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        //file << "uintptr_t *D_800DCBB4[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            file << m.D_800DCBB4 << ", ";
-        }
-        file << "\n";
-        //file << "\n};\n\n";
-        file.close();
+    file << "\n";
+    // file << "\n};\n\n";
+    FileWriter::Queue(outDir + "cpu_CourseMinimumSeparation.inc.c", file.str());
+
+    file.str("");
+    //file << "uintptr_t *D_800DCBB4[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        file << m.D_800DCBB4 << ", ";
     }
+    file << "\n";
+    //file << "\n};\n\n";
+    FileWriter::Queue(outDir + "D_800DCBB4.inc.c", file.str());
 
-    file.open(outDir+"cpu_SteeringSensitivity.inc.c", std::ios_base::binary | std::ios_base::out);
+    file.str("");
 
     // @WARNING THIS FILE HAS A TRAILING ZERO
-    if (file.is_open()) {
-        //file << "u16 cpu_SteeringSensitivity[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            file << m.steeringSensitivity << ", ";
-        }
-        file << 0;
-        file << "\n";
-        //file << "\n};\n\n";
-        file.close();
+    //file << "u16 cpu_SteeringSensitivity[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        file << m.steeringSensitivity << ", ";
     }
-
-    file.open(outDir+"gBombKartSpawns.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        //file << "u16 cpu_SteeringSensitivity[] = {\n" << fourSpaceTab;
-        for (const auto& m : metadata) {
-            file << "{ // " << m.name << "\n";
-            for (const auto& bombKart : m.bombKartSpawns) {
-                file << "{ ";
-                file << bombKart.waypointIndex << ", ";
-                file << bombKart.startingState << ", ";
-                file << bombKart.unk_04 << ", ";
-                file << bombKart.x << ", ";
-                file << bombKart.z << ", ";
-                file << bombKart.unk10 << ", ";
-                file << bombKart.unk14;
-                file << " },\n";
-            }
-            file << "},\n";
-        }
-        file.close();
-    }
-
-    file.open(outDir+"gCoursePathSizes.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
+    file << 0;
+    file << "\n";
+    //file << "\n};\n\n";
+    FileWriter::Queue(outDir + "cpu_SteeringSensitivity.inc.c", file.str());
+
+    file.str("");
+    //file << "u16 cpu_SteeringSensitivity[] = {\n" << fourSpaceTab;
+    for (const auto& m : metadata) {
+        file << "{ // " << m.name << "\n";
+        for (const auto& bombKart : m.bombKartSpawns) {
             file << "{ ";
-            for (size_t i = 0; i < m.pathSizes.size(); i++) {
-                if (i == 5) {
-                    file << "{";
-                }
-                if (i == 7) {
-                    file << m.pathSizes[i];
-                    file << "}";
-                } else {
-                    file << m.pathSizes[i] << ", ";
-                }
+            file << bombKart.waypointIndex << ", ";
+            file << bombKart.startingState << ", ";
+            file << bombKart.unk_04 << ", ";
+            file << bombKart.x << ", ";
+            file << bombKart.z << ", ";
+            file << bombKart.unk10 << ", ";
+            file << bombKart.unk14;
+            file << " },\n";
+        }
+        file << "},\n";
+    }
+    FileWriter::Queue(outDir + "gBombKartSpawns.inc.c", file.str());
+
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (size_t i = 0; i < m.pathSizes.size(); i++) {
+            if (i == 5) {
+                file << "{";
+            }
+            if (i == 7) {
+                file << m.pathSizes[i];
+                file << "}";
+            } else {
+                file << m.pathSizes[i] << ", ";
             }
-            file << "},\n";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "gCoursePathSizes.inc.c", file.str());
 
-    file.open(outDir+"cpu_CurveTargetSpeed.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto size : m.cpu_CurveTargetSpeed) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto size : m.cpu_CurveTargetSpeed) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "cpu_CurveTargetSpeed.inc.c", file.str());
 
-    file.open(outDir+"cpu_NormalTargetSpeed.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.cpu_NormalTargetSpeed) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.cpu_NormalTargetSpeed) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "cpu_NormalTargetSpeed.inc.c", file.str());
 
-    file.open(outDir+"D_0D0096B8.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.D_0D0096B8) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.D_0D0096B8) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "D_0D0096B8.inc.c", file.str());
 
-    file.open(outDir+"cpu_OffTrackTargetSpeed.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.cpu_OffTrackTargetSpeed) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.cpu_OffTrackTargetSpeed) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "cpu_OffTrackTargetSpeed.inc.c", file.str());
 
-    file.open(outDir+"gCoursePathTable.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.pathTable) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.pathTable) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "gCoursePathTable.inc.c", file.str());
 
-    file.open(outDir+"gCoursePathTableUnknown.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.pathTableUnknown) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.pathTableUnknown) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "gCoursePathTableUnknown.inc.c", file.str());
 
-    file.open(outDir+"sSkyColors.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.skyColors) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.skyColors) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "sSkyColors.inc.c", file.str());
 
-    file.open(outDir+"sSkyColors2.inc.c", std::ios_base::binary | std::ios_base::out);
-    if (file.is_open()) {
-        for (const auto& m : metadata) {
-            file << "// " << m.name << "\n";
-            file << "{ ";
-            for (const auto& size : m.skyColors2) {
-                file << size << ", ";
-            }
-            file << "},\n";
+    file.str("");
+    for (const auto& m : metadata) {
+        file << "// " << m.name << "\n";
+        file << "{ ";
+        for (const auto& size : m.skyColors2) {
+            file << size << ", ";
         }
-        file.close();
+        file << "},\n";
     }
+    FileWriter::Queue(outDir + "sSkyColors2.inc.c", file.str());
     return std::nullopt;
 }
 
@@ -84,7 +84,7 @@ uint64_t AudioContext::GetPathByAddr(uint32_t addr) {
     auto dec = Companion::Instance->GetNodeByAddr(addr);
     if (dec.has_value()) {
         std::string path = std::get<0>(dec.value());
-        uint64_t hash = CRC64(path.c_str());
+        uint64_t hash = Companion::Instance->GetPathHash(path);
         SPDLOG_INFO("Found path of 0x{:X} {}", addr, path);
         return hash;
     } else {
@@ -152,7 +152,7 @@ std::optional<std::shared_ptr<IParsedData>> AudioTableFactory::parse(std::vector
 
                 Companion::Instance->AddAsset(font);
                 std::string path = font["vpath"].as<std::string>();
-                crc = CRC64(path.c_str());
+                crc = Companion::Instance->GetPathHash(path);
                 break;
             }
             case AudioTableType::SEQ_TABLE: {
@@ -164,7 +164,7 @@ std::optional<std::shared_ptr<IParsedData>> AudioTableFactory::parse(std::vector
                     seq["size"] = size;
                     Companion::Instance->AddAsset(seq);
                     auto path = seq["vpath"].as<std::string>();
-                    crc = CRC64(path.c_str());
+                    crc = Companion::Instance->GetPathHash(path);
                     break;
                 }
             }
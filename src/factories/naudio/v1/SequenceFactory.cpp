@@ -1,6 +1,7 @@
 #include "SequenceFactory.h"
 #include "Companion.h"
 #include "utils/Decompressor.h"
+#include "utils/BinaryEmbed.h"
 #include "AudioContext.h"
 
 ExportResult NSequenceHeaderExporter::Export(std::ostream &write, std::shared_ptr<IParsedData> raw, std::string& entryName, YAML::Node &node, std::string* replacement) {
@@ -26,16 +27,20 @@ ExportResult NSequenceCodeExporter::Export(std::ostream &write, std::shared_ptr<
         return std::nullopt;
     }
 
-    write << GetSafeNode<std::string>(node, "ctype", "u8") << " " << symbol << "[] = {\n" << tab_t;
+    const auto ctype = GetSafeNode<std::string>(node, "ctype", "u8");
 
-    for (int i = 0; i < data.size(); i++) {
-        if ((i % 15 == 0) && i != 0) {
-            write << "\n" << tab_t;
-        }
+    if(!BinaryEmbed::WriteDefinition(write, ctype, symbol, *replacement, data)) {
+        write << ctype << " " << symbol << "[] = {\n" << tab_t;
+
+        for (int i = 0; i < data.size(); i++) {
+            if ((i % 15 == 0) && i != 0) {
+                write << "\n" << tab_t;
+            }
 
-        write << "0x" << std::hex << std::setw(2) << std::setfill('0') << (int) data[i] << ", ";
+            write << "0x" << std::hex << std::setw(2) << std::setfill('0') << (int) data[i] << ", ";
+        }
+        write << "\n};\n";
     }
-    write << "\n};\n";
 
     if (Companion::Instance->IsDebug()) {
         write << "// size: 0x" << std::hex << std::uppercase << data.size() << "\n";
@@ -90,7 +90,7 @@ ExportResult SF64::MessageLookupBinaryExporter::Export(std::ostream &write, std:
         if(dec.has_value()){
             std::string path = std::get<0>(dec.value());
             SPDLOG_INFO("Message ID: {} Ptr: {:X} Path: {}", m.id, m.ptr, path);
-            writer.Write(CRC64(path.c_str()));
+            writer.Write(Companion::Instance->GetPathHash(path));
         } else {
             writer.Write((uint64_t) 0);
             SPDLOG_WARN("Failed to find message ID: {} Ptr: {:X}", m.id, m.ptr);
@@ -116,7 +116,7 @@ ExportResult SF64::SkeletonBinaryExporter::Export(std::ostream &write, std::shar
             auto dec = Companion::Instance->GetNodeByAddr(limb.mDList);
             if (dec.has_value()){
                 std::string path = std::get<0>(dec.value());
-                limbWriter.Write(CRC64(path.c_str()));
+                limbWriter.Write(Companion::Instance->GetPathHash(path));
                 SPDLOG_INFO("Found display list: 0x{:X} at {} with size {}", limb.mDList, path, path.size());
             } else {
                 SPDLOG_WARN("Could not find dlist at 0x{:X}", limb.mDList);
@@ -157,7 +157,7 @@ ExportResult SM64::BehaviorScriptBinaryExporter::Export(std::ostream &write, std
                     if (ptr == 0) {
                         writer.Write(ptr);
                     } else if (dec.has_value()) {
-                        uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+                        uint64_t hash = Companion::Instance->GetHashByAddr(ptr).value();
                         SPDLOG_INFO("Found Asset: 0x{:X} Hash: 0x{:X} Path: {}", ptr, hash, std::get<0>(dec.value()));
                         writer.Write(hash);
                     } else {
@@ -67,7 +67,7 @@ ExportResult SM64::MovtexQuadBinaryExporter::Export(std::ostream &write, std::sh
         } else {
             auto dec = Companion::Instance->GetNodeByAddr(quad.second);
             if (dec.has_value()) {
-                uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+                uint64_t hash = Companion::Instance->GetHashByAddr(quad.second).value();
                 SPDLOG_INFO("Found movtex: 0x{:X} Hash: 0x{:X} Path: {}", quad.second, hash, std::get<0>(dec.value()));
                 writer.Write(hash);
             } else {
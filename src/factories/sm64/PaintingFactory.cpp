@@ -160,7 +160,7 @@ ExportResult SM64::PaintingBinaryExporter::Export(std::ostream &write, std::shar
     {
         auto dec = Companion::Instance->GetNodeByAddr(ptr);
         if (dec.has_value()) {
-            uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+            uint64_t hash = Companion::Instance->GetHashByAddr(ptr).value();
             SPDLOG_INFO("Found DisplayList: 0x{:X} Hash: 0x{:X} Path: {}", ptr, hash, std::get<0>(dec.value()));
             writer.Write(hash);
         } else {
@@ -173,7 +173,7 @@ ExportResult SM64::PaintingBinaryExporter::Export(std::ostream &write, std::shar
     {
         auto dec = Companion::Instance->GetNodeByAddr(ptr);
         if (dec.has_value()) {
-            uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+            uint64_t hash = Companion::Instance->GetHashByAddr(ptr).value();
             SPDLOG_INFO("Found Texture Maps: 0x{:X} Hash: 0x{:X} Path: {}", ptr, hash, std::get<0>(dec.value()));
             writer.Write(hash);
         } else {
@@ -186,7 +186,7 @@ ExportResult SM64::PaintingBinaryExporter::Export(std::ostream &write, std::shar
     {
         auto dec = Companion::Instance->GetNodeByAddr(ptr);
         if (dec.has_value()) {
-            uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+            uint64_t hash = Companion::Instance->GetHashByAddr(ptr).value();
             SPDLOG_INFO("Found Texture Arrays: 0x{:X} Hash: 0x{:X} Path: {}", ptr, hash, std::get<0>(dec.value()));
             writer.Write(hash);
         } else {
@@ -202,7 +202,7 @@ ExportResult SM64::PaintingBinaryExporter::Export(std::ostream &write, std::shar
     {
         auto dec = Companion::Instance->GetNodeByAddr(ptr);
         if (dec.has_value()) {
-            uint64_t hash = CRC64(std::get<0>(dec.value()).c_str());
+            uint64_t hash = Companion::Instance->GetHashByAddr(ptr).value();
             SPDLOG_INFO("Found DisplayList: 0x{:X} Hash: 0x{:X} Path: {}", ptr, hash, std::get<0>(dec.value()));
             writer.Write(hash);
         } else {
@@ -22,9 +22,29 @@ int main(int argc, char *argv[]) {
     bool debug = false;
     std::string srcdir;
     std::string destdir;
+    std::string depfile;
+    std::string depManifest;
+    FilterConfig filters;
+    uint64_t cacheLimit = 1024;
 
     app.require_subcommand();
 
+    const auto addExportOptions = [&](CLI::App* cmd) {
+        cmd->add_option("--depfile", depfile, "Write a Make/Ninja depfile listing the inputs of every generated file");
+        cmd->add_option("--deps-json", depManifest, "Write a JSON manifest listing the inputs of every generated file");
+        cmd->add_option("--only", filters.paths, "Only process assets whose path matches one of these globs, e.g. 'levels/bob/**'")->delimiter(',');
+        cmd->add_option("--symbol", filters.symbols, "Only process assets whose symbol matches one of these globs, e.g. 'gBobTex*'")->delimiter(',');
+        cmd->add_option("--type", filters.types, "Only process assets of these types, e.g. GFX,TEXTURE")->delimiter(',');
+        cmd->add_option("--cache-limit", cacheLimit, "Megabytes of decompressed, compressed and converted data kept in .torch_cache across runs, 0 disables it")->capture_default_str();
+    };
+
+    const auto applyExportOptions = [&](Companion* instance) {
+        instance->GetConfig().depfilePath = depfile;
+        instance->GetConfig().depManifestPath = depManifest;
+        instance->GetConfig().filters = filters;
+        instance->GetConfig().cacheLimit = cacheLimit * 1024 * 1024;
+    };
+
     /* Generate an OTR */
     const auto otr = app.add_subcommand("otr", "OTR - Generates an otr\n");
 
@@ -32,9 +52,11 @@ int main(int argc, char *argv[]) {
     otr->add_flag("-v,--verbose", debug, "Verbose Debug Mode");
     otr->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing")->check(CLI::ExistingDirectory);
     otr->add_option("-d,--destdir", destdir, "Set destination directory for export");
+    addExportOptions(otr);
 
     otr->parse_complete_callback([&] {
         const auto instance = Companion::Instance = new Companion(filename, ArchiveType::OTR, debug, srcdir, destdir);
+        applyExportOptions(instance);
         instance->Init(ExportType::Binary);
     });
 
@@ -45,9 +67,11 @@ int main(int argc, char *argv[]) {
     o2r->add_flag("-v,--verbose", debug, "Verbose Debug Mode");
     o2r->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing")->check(CLI::ExistingDirectory);
     o2r->add_option("-d,--destdir", destdir, "Set destination directory for export");
+    addExportOptions(o2r);
 
     o2r->parse_complete_callback([&] {
         const auto instance = Companion::Instance = new Companion(filename, ArchiveType::O2R, debug, srcdir, destdir);
+        applyExportOptions(instance);
         instance->Init(ExportType::Binary);
     });
 
@@ -58,9 +82,11 @@ int main(int argc, char *argv[]) {
     code->add_flag("-v,--verbose", debug, "Verbose Debug Mode; adds offsets to C code");
     code->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing")->check(CLI::ExistingDirectory);
     code->add_option("-d,--destdir", destdir, "Set destination directory to place C code to");
+    addExportOptions(code);
 
     code->parse_complete_callback([&]() {
         const auto instance = Companion::Instance = new Companion(filename, ArchiveType::None, debug, srcdir, destdir);
+        applyExportOptions(instance);
         instance->Init(ExportType::Code);
     });
 
@@ -70,9 +96,11 @@ int main(int argc, char *argv[]) {
     binary->add_option("<baserom.z64>", filename, "")->required()->check(CLI::ExistingFile);
     binary->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing")->check(CLI::ExistingDirectory);
     binary->add_option("-d,--destdir", destdir, "Set destination directory to place binary to");
+    addExportOptions(binary);
 
     binary->parse_complete_callback([&] {
         const auto instance = Companion::Instance = new Companion(filename, ArchiveType::None, debug, srcdir, destdir);
+        applyExportOptions(instance);
         instance->Init(ExportType::Binary);
     });
 
@@ -83,6 +111,7 @@ int main(int argc, char *argv[]) {
     header->add_flag("-o,--otr", otrModeSelected, "OTR/O2R Mode");
     header->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing")->check(CLI::ExistingDirectory);
     header->add_option("-d,--destdir", destdir, "Set destination directory to place headers to");
+    addExportOptions(header);
 
     header->parse_complete_callback([&] {
         if (otrModeSelected) {
@@ -92,6 +121,7 @@ int main(int argc, char *argv[]) {
         }
 
         const auto instance = Companion::Instance = new Companion(filename, otrMode, debug, srcdir, destdir);
+        applyExportOptions(instance);
         instance->Init(ExportType::Header);
     });
 
@@ -129,6 +159,7 @@ int main(int argc, char *argv[]) {
     modding_import->add_flag("-v,--verbose", debug, "Verbose Debug Mode");
     modding_import->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing, including modified files")->check(CLI::ExistingDirectory);
     modding_import->add_option("-d,--destdir", destdir, "Set destination directory to place for generating C code");
+    addExportOptions(modding_import);
 
     modding_import->parse_complete_callback([&] {
         ArchiveType otrMode;
@@ -142,6 +173,7 @@ int main(int argc, char *argv[]) {
         }
 
         const auto instance = Companion::Instance = new Companion(filename, otrMode, debug, true, srcdir, destdir);
+        applyExportOptions(instance);
         if (mode == "code") {
             instance->Init(ExportType::Code);
         } else if (mode == "otr" || mode == "o2r") {
@@ -157,9 +189,11 @@ int main(int argc, char *argv[]) {
     modding_export->add_option("<baserom.z64>", filename, "")->required()->check(CLI::ExistingFile);
     modding_export->add_option("-s,--srcdir", srcdir, "Set source directory to locate config.yml and asset metadata for processing, including modified files")->check(CLI::ExistingDirectory);
     modding_export->add_option("-d,--destdir", destdir, "Set destination directory to place for generating modified files");
+    addExportOptions(modding_export);
 
     modding_export->parse_complete_callback([&] {
         const auto instance = Companion::Instance = new Companion(filename, ArchiveType::None, debug, srcdir, destdir);
+        applyExportOptions(instance);
         if (xmlMode) {
             instance->Init(ExportType::XML);
         } else {
@@ -167,6 +201,22 @@ int main(int argc, char *argv[]) {
         }
     });
 
+    /* Inspect or clear the cache */
+    const auto cache = app.add_subcommand("cache", "Cache - Inspects or clears the cache kept in the destination directory\n");
+    const auto cache_info = cache->add_subcommand("info", "Info - Lists the entries and size of every cache\n");
+    const auto cache_clear = cache->add_subcommand("clear", "Clear - Deletes every cache\n");
+    cache->require_subcommand();
+
+    cache_info->add_option("-d,--destdir", destdir, "Set destination directory the cache was created in");
+    cache_info->parse_complete_callback([&] {
+        Companion::PrintCacheInfo(destdir);
+    });
+
+    cache_clear->add_option("-d,--destdir", destdir, "Set destination directory the cache was created in");
+    cache_clear->parse_complete_callback([&] {
+        Companion::ClearCacheDirectory(destdir);
+    });
+
     try {
         app.parse(argc, argv);
     } catch (const CLI::ParseError &e) {
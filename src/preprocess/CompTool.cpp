@@ -1,44 +1,113 @@
 #include "CompTool.h"
-#include "utils/Decompressor.h"
-#include "lib/binarytools/BinaryWriter.h"
 #include "lib/binarytools/BinaryReader.h"
-#include <fstream>
+#include "utils/ParallelFor.h"
 #include <cstring>
+#include <algorithm>
+#include <stdexcept>
 
-uint32_t CompTool::FindFileTable(std::vector<uint8_t>& rom) {
-    uint8_t query_one[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x50, 0x00, 0x00, 0x00, 0x00 };
-    uint8_t query_two[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00 };
+extern "C" {
+#include <libmio0/mio0.h>
+}
+
+#define ENTRY_SIZE 0x10
+
+static uint32_t ReadU32(const uint8_t* data) {
+    return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static void WriteU32(uint8_t* data, const uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+uint32_t CompTool::FindFileTable(const std::vector<uint8_t>& rom) {
+    // The table starts with the boot segment: virtual and physical start 0, physical end 0x1050 or 0x1060, uncompressed
+    static constexpr uint8_t zeros[10] = {};
 
-    for(size_t i = 0; i < rom.size() - sizeof(query_one); i++) {
-        if(memcmp(rom.data() + i, query_one, sizeof(query_one)) == 0){
-            return i;
+    if(rom.size() < ENTRY_SIZE) {
+        throw std::runtime_error("Failed to find file table");
+    }
+
+    // memchr skips straight to the next 0x10 byte, the only one that can be the high byte of the physical end
+    const uint8_t* last = rom.data() + rom.size() - 6;
+    for(auto cur = rom.data() + 10; cur <= last; cur++) {
+        cur = static_cast<const uint8_t*>(memchr(cur, 0x10, last - cur + 1));
+        if(cur == nullptr) {
+            break;
         }
 
-        if(memcmp(rom.data() + i, query_two, sizeof(query_two)) == 0){
-            return i;
+        if((cur[1] == 0x50 || cur[1] == 0x60) && memcmp(cur - 10, zeros, 10) == 0 && memcmp(cur + 2, zeros, 4) == 0) {
+            return cur - 10 - rom.data();
         }
     }
 
     throw std::runtime_error("Failed to find file table");
 }
 
-#define ROL(i, b) ((i << (b)) | (i >> (32 - (b))))
+std::vector<CompFile> CompTool::ReadFileTable(const std::vector<uint8_t>& rom, const uint32_t table) {
+    LUS::BinaryReader reader((char*) rom.data(), rom.size());
+    reader.SetEndianness(Torch::Endianness::Big);
+
+    std::vector<CompFile> files;
+    for(uint32_t entry = table; entry + ENTRY_SIZE <= rom.size(); entry += ENTRY_SIZE) {
+        reader.Seek(entry, LUS::SeekOffsetType::Start);
+
+        auto v_begin = reader.ReadUInt32();
+        auto p_begin = reader.ReadUInt32();
+        auto p_end = reader.ReadUInt32();
+        auto comp_flag = reader.ReadUInt32();
+
+        if(v_begin == 0 && p_end == 0){
+            return files;
+        }
+
+        if(p_end < p_begin || p_end > rom.size()) {
+            throw std::runtime_error("Invalid file table entry. There may be a problem with your ROM.");
+        }
+
+        CompFile file = { entry, v_begin, p_begin, p_end - p_begin, 0, (CompType) comp_flag };
+
+        switch (file.type) {
+            case CompType::UNCOMPRESSED:
+                file.v_size = file.p_size;
+                break;
+            case CompType::COMPRESSED: {
+                mio0_header_t head;
+                if(file.p_size < MIO0_HEADER_LENGTH || !mio0_decode_header(rom.data() + p_begin, &head)){
+                    throw std::runtime_error("Failed to decode MIO0 header");
+                }
+                file.v_size = head.dest_size;
+                break;
+            }
+            default:
+                throw std::runtime_error("Invalid compression flag. There may be a problem with your ROM.");
+        }
 
-std::pair<uint32_t, uint32_t> CompTool::CalculateCRCs(LUS::BinaryWriter& decompFile)
+        files.push_back(file);
+    }
+
+    throw std::runtime_error("File table is not terminated. There may be a problem with your ROM.");
+}
+
+#define ROL(i, b) ((i << (b)) | (i >> ((32 - (b)) & 31)))
+
+std::pair<uint32_t, uint32_t> CompTool::CalculateCRCs(const std::vector<uint8_t>& rom)
 {
     uint32_t start = 0x1000;
     uint32_t end = 0x101000;
-    LUS::BinaryReader readFile(decompFile.GetStream());
     uint32_t t1, t2, t3, t4, t5, t6;
 
+    if(rom.size() < end) {
+        throw std::runtime_error("Decompressed ROM is too small to calculate its CRCs");
+    }
+
     // Todo: Implement other bootcodes
     t1 = t2 = t3 = t4 = t5 = t6 = sCrcSeed;
 
-    readFile.SetEndianness(Torch::Endianness::Big);
-    readFile.Seek(start, LUS::SeekOffsetType::Start);
-
     for (size_t i = start; i < end; i += sizeof(uint32_t)) {
-        uint32_t d = readFile.ReadUInt32();
+        uint32_t d = ReadU32(rom.data() + i);
         uint32_t r = ROL(d, d & 0x1F);
 
         if ((t6 + d) < t6) {
@@ -56,68 +125,63 @@ std::pair<uint32_t, uint32_t> CompTool::CalculateCRCs(LUS::BinaryWriter& decompF
 }
 
 std::vector<uint8_t> CompTool::Decompress(std::vector<uint8_t> rom){
-    LUS::BinaryReader basefile((char*) rom.data(), rom.size());
-    basefile.SetEndianness(Torch::Endianness::Big);
-
-    LUS::BinaryWriter decompfile;
-    decompfile.SetEndianness(Torch::Endianness::Big);
-    decompfile.Write((uint8_t)0x80);
+    const auto files = CompTool::ReadFileTable(rom, CompTool::FindFileTable(rom));
 
-    uint32_t table = CompTool::FindFileTable(rom);
-    uint32_t count = 0;
-    while (true){
-        auto entry = table + 0x10 * count;
-        basefile.Seek(entry, LUS::SeekOffsetType::Start);
+    // Every file already knows where it goes, so the output is sized up front and filled in place
+    size_t size = 1;
+    for(auto& file : files) {
+        size = std::max<size_t>({ size, (size_t) file.v_begin + file.v_size, (size_t) file.entry + ENTRY_SIZE });
+    }
 
-        auto v_begin = basefile.ReadInt32();
-        auto p_begin = basefile.ReadInt32();
-        auto p_end = basefile.ReadInt32();
-        auto comp_flag = basefile.ReadInt32();
+    std::vector<uint8_t> result(size);
+    result[0] = 0x80;
 
-        auto p_size = p_end - p_begin;
-        auto v_size = (int32_t) 0;
-        DataChunk* decoded = nullptr;
+    std::vector<int> decoded(files.size());
 
-        if(v_begin == 0 && p_end == 0){
-            break;
+    const auto decode = [&](const size_t i) {
+        auto& file = files[i];
+        if(file.type == CompType::COMPRESSED) {
+            decoded[i] = mio0_decode(rom.data() + file.p_begin, file.p_size, result.data() + file.v_begin, nullptr);
+        } else {
+            memcpy(result.data() + file.v_begin, rom.data() + file.p_begin, file.v_size);
+            decoded[i] = file.v_size;
         }
+    };
 
-        basefile.Seek(p_begin, LUS::SeekOffsetType::Start);
-
-        auto bytes = new uint8_t[p_size];
-        basefile.Read((char*) bytes, p_size);
-
-        switch ((CompType) comp_flag) {
-            case CompType::UNCOMPRESSED:
-                v_size = p_size;
-                break;
-            case CompType::COMPRESSED:
-                decoded = Decompressor::Decode(std::vector(bytes, bytes + p_size), 0, CompressionType::MIO0, p_size, true);
-                bytes = decoded->data;
-                v_size = decoded->size;
-                break;
-            default:
-                throw std::runtime_error("Invalid compression flag. There may be a problem with your ROM.");
+    // Files that overlap are written one after another in table order, like the ROM was built
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for(auto& file : files) {
+        ranges.emplace_back(file.v_begin, file.v_begin + file.v_size);
+    }
+    std::sort(ranges.begin(), ranges.end());
+    const bool overlaps = std::adjacent_find(ranges.begin(), ranges.end(), [](auto& a, auto& b) {
+        return b.first < a.second;
+    }) != ranges.end();
+
+    if(overlaps) {
+        for(size_t i = 0; i < files.size(); i++) {
+            decode(i);
         }
+    } else {
+        Torch::ParallelFor(files.size(), decode);
+    }
 
-        decompfile.Seek(v_begin, LUS::SeekOffsetType::Start);
-        decompfile.Write((char*) bytes, v_size);
-        auto v_end = v_begin + v_size;
+    // The table is patched once every file is in place, so it always describes the decompressed files
+    for(size_t i = 0; i < files.size(); i++) {
+        auto& file = files[i];
+        if(decoded[i] != (int) file.v_size) {
+            throw std::runtime_error("Failed to decode MIO0");
+        }
 
-        decompfile.Seek(entry + 4, LUS::SeekOffsetType::Start);
-        decompfile.Write(v_begin);
-        decompfile.Write(v_end);
-        decompfile.Write((uint32_t) CompType::UNCOMPRESSED);
-        count++;
+        WriteU32(result.data() + file.entry + 4, file.v_begin);
+        WriteU32(result.data() + file.entry + 8, file.v_begin + file.v_size);
+        WriteU32(result.data() + file.entry + 12, (uint32_t) CompType::UNCOMPRESSED);
     }
 
-    auto crcs = CompTool::CalculateCRCs(decompfile);
-
-    decompfile.Seek(0x10, LUS::SeekOffsetType::Start);
+    auto crcs = CompTool::CalculateCRCs(result);
 
-    decompfile.Write(crcs.first); // CRC1
-    decompfile.Write(crcs.second); // CRC2
+    WriteU32(result.data() + 0x10, crcs.first); // CRC1
+    WriteU32(result.data() + 0x14, crcs.second); // CRC2
 
-    auto result = decompfile.ToVector();
-    return { (uint8_t*) result.data(), (uint8_t*) result.data() + result.size() };
-}
\ No newline at end of file
+    return result;
+}
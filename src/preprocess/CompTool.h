@@ -1,6 +1,5 @@
 #pragma once
 
-#include "lib/binarytools/BinaryWriter.h"
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -11,11 +10,21 @@ enum class CompType {
     UNKNOWN
 };
 
+struct CompFile {
+    uint32_t entry;
+    uint32_t v_begin;
+    uint32_t p_begin;
+    uint32_t p_size;
+    uint32_t v_size;
+    CompType type;
+};
+
 class CompTool {
 public:
     static std::vector<uint8_t> Decompress(std::vector<uint8_t> rom);
 private:
-    static uint32_t FindFileTable(std::vector<uint8_t>& rom);
-    static std::pair<uint32_t, uint32_t> CalculateCRCs(LUS::BinaryWriter& decompFile);
+    static uint32_t FindFileTable(const std::vector<uint8_t>& rom);
+    static std::vector<CompFile> ReadFileTable(const std::vector<uint8_t>& rom, uint32_t table);
+    static std::pair<uint32_t, uint32_t> CalculateCRCs(const std::vector<uint8_t>& rom);
     static inline const uint32_t sCrcSeed = 0xF8CA4DDC;
 };
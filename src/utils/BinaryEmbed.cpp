@@ -0,0 +1,76 @@
+#include "BinaryEmbed.h"
+
+#include "Companion.h"
+#include "FileWriter.h"
+#include "factories/BaseFactory.h"
+#include <stdexcept>
+
+static RawDataMode GetMode() {
+    return Companion::Instance->GetConfig().rawData;
+}
+
+// Writes the data next to the generated code and returns the path the compiler should look it up by
+static std::string QueueBinary(const std::string& replacement, const uint8_t* data, size_t size) {
+    const auto instance = Companion::Instance;
+    FileWriter::Queue(instance->GetOutputPath() + "/" + replacement + ".bin", std::string(reinterpret_cast<const char*>(data), size));
+    return instance->GetDestRelativeOutputPath() + "/" + replacement + ".bin";
+}
+
+bool BinaryEmbed::WriteDefinition(std::ostream& write, const std::string& ctype, const std::string& symbol, const std::string& replacement, const std::vector<uint8_t>& data, size_t elementSize) {
+    return WriteDefinition(write, ctype, symbol, replacement, data.data(), data.size(), elementSize);
+}
+
+bool BinaryEmbed::WriteDefinition(std::ostream& write, const std::string& ctype, const std::string& symbol, const std::string& replacement, const uint8_t* data, size_t size, size_t elementSize) {
+    // The file holds the big endian ROM bytes, only a byte array reads the same on every target
+    if (elementSize != 1) {
+        return false;
+    }
+
+    switch (GetMode()) {
+        case RawDataMode::Incbin: {
+            const auto path = QueueBinary(replacement, data, size);
+            const auto alignment = Companion::Instance->GetCurrentAlignment();
+            write << "__asm__(\n";
+            write << tab_t << "\".section .data\\n\"\n";
+            write << tab_t << "\".balign " << std::dec << alignment << "\\n\"\n";
+            write << tab_t << "\".global " << symbol << "\\n\"\n";
+            write << tab_t << "\"" << symbol << ":\\n\"\n";
+            write << tab_t << "\".incbin \\\"" << path << "\\\"\\n\"\n";
+            write << tab_t << "\".previous\\n\"\n";
+            write << ");\n";
+            write << "extern " << ctype << " " << symbol << "[];\n";
+            return true;
+        }
+        case RawDataMode::Embed: {
+            write << ctype << " " << symbol << "[] = {\n";
+            WriteElements(write, replacement, data, size, elementSize, tab_t);
+            write << "};\n";
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool BinaryEmbed::WriteElements(std::ostream& write, const std::string& replacement, const uint8_t* data, size_t size, size_t elementSize, const std::string& indent) {
+    if (GetMode() != RawDataMode::Embed || elementSize != 1) {
+        return false;
+    }
+
+    write << indent << "#embed \"" << QueueBinary(replacement, data, size) << "\"\n";
+    return true;
+}
+
+RawDataMode BinaryEmbed::ParseMode(const std::string& mode) {
+    if (mode == "HEX") {
+        return RawDataMode::Hex;
+    }
+    if (mode == "INCBIN") {
+        return RawDataMode::Incbin;
+    }
+    if (mode == "EMBED") {
+        return RawDataMode::Embed;
+    }
+
+    throw std::runtime_error("Invalid raw_data mode " + mode + ", please use HEX, INCBIN or EMBED");
+}
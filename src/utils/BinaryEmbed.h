@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+enum class RawDataMode {
+    Hex,
+    Incbin,
+    Embed
+};
+
+class BinaryEmbed {
+  public:
+    // Writes the bytes to <replacement>.bin and emits `ctype symbol[]` pulling them in, returns false if the caller has to emit hex.
+    // elementSize is the byte width of every array element. Both modes only take bytes, wider elements are written as hex
+    // so their values don't depend on the endianness of the target. The symbol gets the alignment of the asset being exported.
+    static bool WriteDefinition(std::ostream& write, const std::string& ctype, const std::string& symbol, const std::string& replacement, const std::vector<uint8_t>& data, size_t elementSize = 1);
+    static bool WriteDefinition(std::ostream& write, const std::string& ctype, const std::string& symbol, const std::string& replacement, const uint8_t* data, size_t size, size_t elementSize = 1);
+
+    // Same as above but for the body of an initializer that is already open, like a table entry. Only #embed can do this.
+    static bool WriteElements(std::ostream& write, const std::string& replacement, const uint8_t* data, size_t size, size_t elementSize, const std::string& indent);
+
+    static RawDataMode ParseMode(const std::string& mode);
+};
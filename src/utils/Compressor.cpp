@@ -0,0 +1,145 @@
+#include "Compressor.h"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "spdlog/spdlog.h"
+#include "Companion.h"
+#include "ParallelFor.h"
+#include "TorchUtils.h"
+
+extern "C" {
+#include <libmio0/mio0.h>
+#include <libyay0/yay0.h>
+#include <libyay0/yay1.h>
+#include <libyaz0/yaz0.h>
+}
+
+namespace fs = std::filesystem;
+
+// Blocks are parsed on their own, their matches still reach back into the previous block but stop at their end
+#define BLOCK_SIZE 0x10000
+
+static lz_effort GetEffort(const CompressionEffort effort) {
+    switch (effort) {
+        case CompressionEffort::Fast: return LZ_EFFORT_FAST;
+        case CompressionEffort::Best: return LZ_EFFORT_BEST;
+        default: return LZ_EFFORT_ORIGINAL;
+    }
+}
+
+static std::vector<lz_token> Parse(const uint8_t* data, const size_t size, const uint32_t maxLength, const uint32_t shortLength, const lz_effort effort) {
+    // There is at most one token per byte, so every block gets the slots of its own bytes
+    std::vector<lz_token> tokens(std::max<size_t>(size, 1));
+    const size_t blocks = effort == LZ_EFFORT_ORIGINAL ? 1 : std::max<size_t>((size + BLOCK_SIZE - 1) / BLOCK_SIZE, 1);
+    const size_t blockSize = blocks == 1 ? size : BLOCK_SIZE;
+    std::vector<int> counts(blocks);
+
+    Torch::ParallelFor(blocks, [&](const size_t block) {
+        const size_t begin = block * blockSize;
+        const size_t end = std::min(begin + blockSize, size);
+        counts[block] = lz_parse(data, begin, end, maxLength, shortLength, effort, tokens.data() + begin);
+    });
+
+    size_t written = 0;
+    for(size_t block = 0; block < blocks; block++) {
+        if(counts[block] < 0) {
+            throw std::runtime_error("Failed to compress data");
+        }
+
+        const auto first = tokens.begin() + block * blockSize;
+        if(written != block * blockSize) {
+            std::copy(first, first + counts[block], tokens.begin() + written);
+        }
+        written += counts[block];
+    }
+
+    tokens.resize(written);
+    return tokens;
+}
+
+std::vector<uint8_t> Compressor::Encode(const uint8_t* data, const size_t size, const CompressionType type, const CompressionEffort effort) {
+    // Header, a control bit per byte padded to a whole word and every byte stored as is
+    std::vector<uint8_t> output(16 + (size + 7) / 8 + 3 + size);
+    const auto lzEffort = GetEffort(effort);
+    int32_t written;
+
+    switch (type) {
+        case CompressionType::MIO0: {
+            const auto tokens = Parse(data, size, MIO0_MAX_LENGTH, MIO0_MAX_LENGTH, lzEffort);
+            written = mio0_encode_tokens(data, size, tokens.data(), tokens.size(), output.data());
+            break;
+        }
+        case CompressionType::YAY0: {
+            const auto tokens = Parse(data, size, YAY0_MAX_LENGTH, YAY0_SHORT_LENGTH, lzEffort);
+            written = yay0_encode_tokens(data, size, tokens.data(), tokens.size(), output.data());
+            break;
+        }
+        case CompressionType::YAY1: {
+            const auto tokens = Parse(data, size, YAY1_MAX_LENGTH, YAY1_SHORT_LENGTH, lzEffort);
+            written = yay1_encode_tokens(data, size, tokens.data(), tokens.size(), output.data());
+            break;
+        }
+        case CompressionType::YAZ0: {
+            const auto tokens = Parse(data, size, YAZ0_MAX_LENGTH, YAZ0_SHORT_LENGTH, lzEffort);
+            written = yaz0_encode_tokens(data, size, tokens.data(), tokens.size(), output.data());
+            break;
+        }
+        default:
+            throw std::runtime_error("Unsupported compression type");
+    }
+
+    output.resize(written);
+    return output;
+}
+
+// The entry header holds the uncompressed size, checked on top of the content hash in the name
+static std::optional<std::vector<uint8_t>> LoadCached(const fs::path& path, const size_t size) {
+    std::ifstream input(path, std::ios::binary);
+    if(!input.is_open()) {
+        return std::nullopt;
+    }
+
+    const std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    const auto entry = Torch::readCacheEntry(file.data(), file.size(), COMPRESSION_CACHE_MAGIC, sizeof(uint32_t));
+    if(!entry.has_value()) {
+        return std::nullopt;
+    }
+
+    uint32_t cachedSize;
+    std::memcpy(&cachedSize, entry->header, sizeof(cachedSize));
+    if(cachedSize != size) {
+        return std::nullopt;
+    }
+
+    return std::vector<uint8_t>(entry->data, entry->data + entry->size);
+}
+
+static void StoreCached(const fs::path& path, const size_t size, const std::vector<uint8_t>& compressed) {
+    const uint32_t size32 = size;
+    if(!Torch::writeCacheEntry(path, COMPRESSION_CACHE_MAGIC, &size32, sizeof(size32), compressed.data(), compressed.size())) {
+        SPDLOG_WARN("Failed to write compression cache entry {}", path.string());
+    }
+}
+
+std::vector<uint8_t> Compressor::EncodeCached(const std::vector<uint8_t>& data, const CompressionType type, const CompressionEffort effort) {
+    // A limit of 0 disables the cache, the entries of earlier runs are left alone
+    if(Companion::Instance->GetConfig().cacheLimit == 0) {
+        return Encode(data.data(), data.size(), type, effort);
+    }
+
+    const auto hash = Companion::CalculateHash(data);
+    const auto name = hash + "-" + std::to_string(static_cast<int>(type)) + "-" + std::to_string(static_cast<int>(effort)) + ".bin";
+    const auto path = Companion::Instance->GetCacheDirectory() / "compression" / name;
+
+    if(auto cached = LoadCached(path, data.size())) {
+        SPDLOG_TRACE("Using cached compression of {}", hash);
+        Torch::touchCacheEntry(path);
+        return std::move(cached.value());
+    }
+
+    auto compressed = Encode(data.data(), data.size(), type, effort);
+    StoreCached(path, data.size(), compressed);
+    return compressed;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Decompressor.h"
+
+enum class CompressionEffort {
+    // Byte for byte what the original tools produce, for games whose code depends on the exact compressed size
+    Original,
+    Fast,
+    // Smallest output the format allows
+    Best
+};
+
+class Compressor {
+  public:
+    // Fast and Best search inputs larger than a block on several threads, Original always runs on a single one
+    static std::vector<uint8_t> Encode(const uint8_t* data, size_t size, CompressionType type, CompressionEffort effort);
+    // Same as Encode, results are kept in .torch_cache/compression keyed by the content hash, codec and effort unless
+    // the cache limit is 0
+    static std::vector<uint8_t> EncodeCached(const std::vector<uint8_t>& data, CompressionType type, CompressionEffort effort);
+};
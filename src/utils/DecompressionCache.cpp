@@ -0,0 +1,147 @@
+#include "DecompressionCache.h"
+
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
+#include "spdlog/spdlog.h"
+#include "Companion.h"
+#include "TorchUtils.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+struct Mapping {
+    void* base;
+    size_t length;
+    DataChunk* chunk;
+};
+
+static std::mutex gMappingMutex;
+static std::unordered_map<uint8_t*, Mapping> gMappings;
+
+static fs::path GetDirectory() {
+    return Companion::Instance->GetCacheDirectory() / "decompression";
+}
+
+static void* MapFile(const fs::path& path, size_t& length) {
+#ifdef _WIN32
+    const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if(GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if(mapping == nullptr) {
+        return nullptr;
+    }
+
+    void* base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    length = size.QuadPart;
+    return base;
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    void* base = nullptr;
+    if(fstat(fd, &info) == 0 && info.st_size > 0) {
+        base = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if(base == MAP_FAILED) {
+            base = nullptr;
+        }
+    }
+    close(fd);
+    length = info.st_size;
+    return base;
+#endif
+}
+
+static void UnmapFile(void* base, const size_t length) {
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, length);
+#endif
+}
+
+std::string DecompressionCache::Key(const std::string& romHash, const std::string& codec, const uint32_t offset, const uint32_t size) {
+    return fmt::format("{}-{}-{:X}-{:X}", romHash, codec, offset, size);
+}
+
+std::optional<std::string> DecompressionCache::KeyFor(const std::vector<uint8_t>& buffer, const std::string& codec, const uint32_t offset, const uint32_t size) {
+    const auto instance = Companion::Instance;
+    if(instance == nullptr || instance->GetCartridge() == nullptr || &buffer != &instance->GetRomData()) {
+        return std::nullopt;
+    }
+
+    return Key(instance->GetCartridge()->GetHash(), codec, offset, size);
+}
+
+DataChunk* DecompressionCache::Load(const std::string& key) {
+    if(Companion::Instance->GetConfig().cacheLimit == 0) {
+        return nullptr;
+    }
+
+    const auto path = GetDirectory() / (key + ".bin");
+
+    size_t length = 0;
+    const auto base = static_cast<uint8_t*>(MapFile(path, length));
+    if(base == nullptr) {
+        return nullptr;
+    }
+
+    const auto entry = Torch::readCacheEntry(base, length, DECOMPRESSION_CACHE_MAGIC, 0);
+    if(!entry.has_value()) {
+        SPDLOG_WARN("Ignoring damaged decompression cache entry {}", key);
+        UnmapFile(base, length);
+        return nullptr;
+    }
+
+    Torch::touchCacheEntry(path);
+
+    const auto data = const_cast<uint8_t*>(entry->data);
+    const auto chunk = new DataChunk{ data, entry->size };
+    std::lock_guard lock(gMappingMutex);
+    gMappings[data] = { base, length, chunk };
+    return chunk;
+}
+
+void DecompressionCache::Store(const std::string& key, const uint8_t* data, const size_t size) {
+    if(Companion::Instance->GetConfig().cacheLimit == 0) {
+        return;
+    }
+
+    const auto path = GetDirectory() / (key + ".bin");
+    if(!Torch::writeCacheEntry(path, DECOMPRESSION_CACHE_MAGIC, nullptr, 0, data, size)) {
+        SPDLOG_WARN("Failed to write decompression cache entry {}", key);
+    }
+}
+
+bool DecompressionCache::Release(uint8_t* data) {
+    std::lock_guard lock(gMappingMutex);
+    const auto it = gMappings.find(data);
+    if(it == gMappings.end()) {
+        return false;
+    }
+
+    UnmapFile(it->second.base, it->second.length);
+    delete it->second.chunk;
+    gMappings.erase(it);
+    return true;
+}
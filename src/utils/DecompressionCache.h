@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include "Decompressor.h"
+
+class DecompressionCache {
+  public:
+    // Name of the entry holding what codec decompressed from the ROM at offset, size is 0 when the codec finds it
+    static std::string Key(const std::string& romHash, const std::string& codec, uint32_t offset, uint32_t size = 0);
+    // Same as Key when buffer is the loaded ROM, nullopt for any other data since it has no stable hash
+    static std::optional<std::string> KeyFor(const std::vector<uint8_t>& buffer, const std::string& codec, uint32_t offset, uint32_t size = 0);
+    // Maps the entry into memory, nullptr when it is missing or fails its integrity check. The mapping is copy on write
+    // and stays valid until Release
+    static DataChunk* Load(const std::string& key);
+    static void Store(const std::string& key, const uint8_t* data, size_t size);
+    // Unmaps data returned by Load, returns false when data was not mapped by the cache
+    static bool Release(uint8_t* data);
+};
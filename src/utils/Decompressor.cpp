@@ -1,6 +1,11 @@
 #include "Decompressor.h"
+#include "DecompressionCache.h"
+#include "ParallelFor.h"
 
+#include <memory>
+#include <algorithm>
 #include <stdexcept>
+#include <unordered_set>
 #include "spdlog/spdlog.h"
 #include <Companion.h>
 
@@ -8,54 +13,80 @@ extern "C" {
 #include <libmio0/mio0.h>
 #include <libyay0/yay0.h>
 #include <libyay0/yay1.h>
+#include <libyaz0/yaz0.h>
 #include <libmio0/tkmk00.h>
 }
 
 #include <bk_zip/bk_unzip.h>
 
-std::unordered_map<uint32_t, DataChunk*> gCachedChunks;
+// Magic and big endian uncompressed size in front of every bkzip stream
+#define BKZIP_HEADER_SIZE 6
+// Largest expansion deflate can encode, a 258 byte match costs at least two bits
+#define MAX_DEFLATE_RATIO 1032
 
-DataChunk* Decompressor::Decode(const std::vector<uint8_t>& buffer, const uint32_t offset, const CompressionType type, const uint32_t in_size, bool ignoreCache) {
+std::unordered_map<uint32_t, DataChunk*> gCachedChunks;
+// Buffers holding many prefetched chunks at once, the chunks in them are never freed on their own
+std::vector<std::unique_ptr<uint8_t[]>> gArenas;
+std::unordered_set<uint8_t*> gArenaChunks;
 
-    if(!ignoreCache && gCachedChunks.contains(offset)){
-        return gCachedChunks[offset];
+static const char* GetCodecName(const CompressionType type) {
+    switch (type) {
+        case CompressionType::MIO0: return "mio0";
+        case CompressionType::YAY0: return "yay0";
+        case CompressionType::YAY1: return "yay1";
+        case CompressionType::YAZ0: return "yaz0";
+        case CompressionType::BKZIP: return "bkzip";
+        default: return "none";
     }
+}
 
+static DataChunk* Decompress(const std::vector<uint8_t>& buffer, const uint32_t offset, const CompressionType type, const uint32_t in_size) {
     const unsigned char* in_buf = buffer.data() + offset;
+    const uint32_t available = offset < buffer.size() ? buffer.size() - offset : 0;
 
     switch (type) {
         case CompressionType::MIO0: {
             mio0_header_t head;
-            if(!mio0_decode_header(in_buf, &head)){
+            if(available < MIO0_HEADER_LENGTH || !mio0_decode_header(in_buf, &head)){
                 throw std::runtime_error("Failed to decode MIO0 header");
             }
 
             const auto decompressed = new uint8_t[head.dest_size];
-            mio0_decode(in_buf, decompressed, nullptr);
-            gCachedChunks[offset] = new DataChunk{ decompressed, head.dest_size };
-            return gCachedChunks[offset];
+            if(mio0_decode(in_buf, available, decompressed, nullptr) < 0) {
+                delete[] decompressed;
+                throw std::runtime_error("Failed to decode MIO0");
+            }
+            return new DataChunk{ decompressed, head.dest_size };
         }
         case CompressionType::YAY0: {
             uint32_t size = 0;
-            uint8_t* decompressed = yay0_decode(in_buf, &size);
+            uint8_t* decompressed = yay0_decode(in_buf, available, &size);
 
             if(!decompressed){
                 throw std::runtime_error("Failed to decode YAY0");
             }
 
-            gCachedChunks[offset] = new DataChunk{ decompressed, size };
-            return gCachedChunks[offset];
+            return new DataChunk{ decompressed, size };
         }
         case CompressionType::YAY1: {
             uint32_t size = 0;
-            uint8_t* decompressed = yay1_decode(in_buf, &size);
+            uint8_t* decompressed = yay1_decode(in_buf, available, &size);
 
             if(!decompressed){
                 throw std::runtime_error("Failed to decode YAY1");
             }
 
-            gCachedChunks[offset] = new DataChunk{ decompressed, size };
-            return gCachedChunks[offset];
+            return new DataChunk{ decompressed, size };
+        }
+        case CompressionType::YAZ0: {
+            uint32_t size = 0;
+            uint8_t* decompressed = yaz0_decode(in_buf, available, &size);
+
+            if(!decompressed){
+                throw std::runtime_error("Failed to decode YAZ0");
+            }
+
+            return new DataChunk{ decompressed, size };
         }
         case CompressionType::BKZIP: {
             uint32_t size = in_size;
@@ -65,25 +96,133 @@ DataChunk* Decompressor::Decode(const std::vector<uint8_t>& buffer, const uint32
                 throw std::runtime_error("Failed to decode BKZIP");
             }
 
-            gCachedChunks[offset] = new DataChunk{ decompressed, size };
-            return gCachedChunks[offset];
+            return new DataChunk{ decompressed, size };
         }
         default:
             throw std::runtime_error("Unknown compression type");
     }
 }
 
+DataChunk* Decompressor::Decode(const std::vector<uint8_t>& buffer, const uint32_t offset, const CompressionType type, const uint32_t in_size, bool ignoreCache) {
+
+    if(!ignoreCache && gCachedChunks.contains(offset)){
+        return gCachedChunks[offset];
+    }
+
+    const auto key = ignoreCache ? std::nullopt : DecompressionCache::KeyFor(buffer, GetCodecName(type), offset, in_size);
+    DataChunk* chunk = key.has_value() ? DecompressionCache::Load(key.value()) : nullptr;
+
+    if(chunk == nullptr) {
+        chunk = Decompress(buffer, offset, type, in_size);
+        if(key.has_value()) {
+            DecompressionCache::Store(key.value(), chunk->data, chunk->size);
+        }
+    }
+
+    gCachedChunks[offset] = chunk;
+    return gCachedChunks[offset];
+}
+
+void Decompressor::PrefetchBKZIP(const std::vector<uint8_t>& buffer, const std::vector<std::pair<uint32_t, uint32_t>>& entries) {
+    struct Job {
+        uint32_t offset;
+        uint32_t in_size;
+        uint32_t out_offset;
+        uint32_t out_size;
+        std::optional<std::string> key;
+        bool decoded;
+    };
+
+    std::vector<Job> jobs;
+    std::unordered_set<uint32_t> queued;
+    size_t total = 0;
+    for(const auto& [offset, in_size] : entries) {
+        if(gCachedChunks.contains(offset) || offset > buffer.size() || in_size > buffer.size() - offset || !queued.insert(offset).second) {
+            continue;
+        }
+
+        const auto key = DecompressionCache::KeyFor(buffer, GetCodecName(CompressionType::BKZIP), offset, in_size);
+        if(key.has_value()) {
+            if(const auto chunk = DecompressionCache::Load(key.value())) {
+                gCachedChunks[offset] = chunk;
+                continue;
+            }
+        }
+
+        // Broken entries are left to Decode, which reports them once something actually uses them
+        uint32_t out_size;
+        try {
+            out_size = BK64::bk_unzip_size(buffer.data() + offset, in_size);
+        } catch (const std::runtime_error&) {
+            continue;
+        }
+
+        // Deflate never expands past MAX_DEFLATE_RATIO, a larger size comes from a corrupt header and would size the arena
+        if(out_size > (uint64_t) (in_size - BKZIP_HEADER_SIZE) * MAX_DEFLATE_RATIO || total + out_size > UINT32_MAX) {
+            continue;
+        }
+
+        jobs.push_back({ offset, in_size, static_cast<uint32_t>(total), out_size, key, false });
+        total += out_size;
+    }
+
+    if(jobs.empty()) {
+        return;
+    }
+
+    // A single allocation for the whole table, every entry inflates straight into its own slice of it
+    std::unique_ptr<uint8_t[]> arena(new uint8_t[std::max<size_t>(total, 1)]);
+
+    Torch::ParallelFor(jobs.size(), [&](const size_t index) {
+        auto& job = jobs[index];
+        try {
+            BK64::bk_unzip_into(buffer.data() + job.offset, job.in_size, arena.get() + job.out_offset);
+        } catch (const std::runtime_error&) {
+            return;
+        }
+
+        job.decoded = true;
+        if(job.key.has_value()) {
+            DecompressionCache::Store(job.key.value(), arena.get() + job.out_offset, job.out_size);
+        }
+    });
+
+    for(const auto& job : jobs) {
+        if(!job.decoded) {
+            continue;
+        }
+
+        const auto data = arena.get() + job.out_offset;
+        gCachedChunks[job.offset] = new DataChunk{ data, job.out_size };
+        gArenaChunks.insert(data);
+    }
+
+    SPDLOG_DEBUG("Prefetched {} bkzip entries ({} bytes)", jobs.size(), total);
+    gArenas.push_back(std::move(arena));
+}
+
 DataChunk* Decompressor::DecodeTKMK00(const std::vector<uint8_t>& buffer, const uint32_t offset, const uint32_t size, const uint32_t alpha) {
     if(gCachedChunks.contains(offset)){
         return gCachedChunks[offset];
     }
 
+    const auto key = DecompressionCache::KeyFor(buffer, fmt::format("tkmk00-{:X}", alpha), offset, size);
+    if(key.has_value()) {
+        if(const auto chunk = DecompressionCache::Load(key.value())) {
+            gCachedChunks[offset] = chunk;
+            return chunk;
+        }
+    }
+
     const uint8_t* in_buf = buffer.data() + offset;
 
     const auto decompressed = new uint8_t[size];
     const auto rgba = new uint8_t[size];
     tkmk00_decode(in_buf, decompressed, rgba, alpha);
     gCachedChunks[offset] = new DataChunk{ rgba, size };
+    if(key.has_value()) {
+        DecompressionCache::Store(key.value(), rgba, size);
+    }
     return gCachedChunks[offset];
 }
 
@@ -144,6 +283,7 @@ DecompressedData Decompressor::AutoDecode(YAML::Node& node, std::vector<uint8_t>
     switch(type) {
         case CompressionType::YAY0:
         case CompressionType::YAY1:
+        case CompressionType::YAZ0:
         case CompressionType::MIO0: {
             offset = ASSET_PTR(offset);
 
@@ -154,8 +294,6 @@ DecompressedData Decompressor::AutoDecode(YAML::Node& node, std::vector<uint8_t>
                 .segment = { decoded->data + offset, size }
             };
         }
-        case CompressionType::YAZ0:
-            throw std::runtime_error("Found compressed yaz0 segment.\nDecompression of yaz0 has not been implemented yet.");
         case CompressionType::None: // The data does not have compression
         {
             fileOffset = TranslateAddr(offset, false);
@@ -247,7 +385,13 @@ bool Decompressor::IsSegmented(uint32_t addr) {
 
 void Decompressor::ClearCache() {
     for(auto& [key, value] : gCachedChunks){
-        delete value->data;
+        if(gArenaChunks.contains(value->data)) {
+            delete value;
+        } else if(!DecompressionCache::Release(value->data)) {
+            delete value->data;
+        }
     }
     gCachedChunks.clear();
+    gArenaChunks.clear();
+    gArenas.clear();
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "FileWriter.h"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <memory>
+#include <exception>
+#include <unordered_set>
+#include <condition_variable>
+#include "spdlog/spdlog.h"
+#include "ParallelFor.h"
+
+namespace fs = std::filesystem;
+
+// Upper bound of pending buffers per writer, keeps memory flat when extraction outruns the disk
+#define MAX_QUEUED_WRITES 256
+
+struct WriteJob {
+    fs::path path;
+    std::string data;
+};
+
+struct WriterQueue {
+    std::deque<WriteJob> jobs;
+    std::mutex mutex;
+    std::condition_variable pushed;
+    std::condition_variable drained;
+    bool busy = false;
+    bool stop = false;
+    std::thread thread;
+};
+
+static std::atomic<size_t> sWrittenFiles = 0;
+static std::atomic<size_t> sSkippedFiles = 0;
+static std::vector<std::string> sOutputs;
+static std::mutex sOutputsMutex;
+
+static std::vector<std::unique_ptr<WriterQueue>> sWriters;
+static std::unordered_set<std::string> sCreatedDirectories;
+static std::mutex sDirectoriesMutex;
+static std::exception_ptr sWriterError;
+static std::mutex sErrorMutex;
+
+static void TrackOutput(const fs::path& path) {
+    std::lock_guard<std::mutex> lock(sOutputsMutex);
+    sOutputs.push_back(path.generic_string());
+}
+
+static void EnsureDirectory(const fs::path& directory) {
+    if(directory.empty()) {
+        return;
+    }
+
+    const auto key = directory.generic_string();
+    {
+        std::lock_guard<std::mutex> lock(sDirectoriesMutex);
+        if(sCreatedDirectories.contains(key)) {
+            return;
+        }
+    }
+
+    std::error_code ec;
+    create_directories(directory, ec);
+    if(ec && !is_directory(directory)) {
+        throw std::runtime_error("Failed to create directory " + key + ": " + ec.message());
+    }
+
+    std::lock_guard<std::mutex> lock(sDirectoriesMutex);
+    sCreatedDirectories.insert(key);
+}
+
+static bool WriteNow(const fs::path& path, const char* data, const size_t size) {
+    if(FileWriter::IsUnchanged(path, data, size)) {
+        ++sSkippedFiles;
+        SPDLOG_TRACE("Skipping {} as it has not changed", path.string());
+        return false;
+    }
+
+    EnsureDirectory(path.parent_path());
+
+    std::ofstream file(path, std::ios::binary);
+    if(!file.is_open()) {
+        throw std::runtime_error("Failed to open " + path.string() + " for writing");
+    }
+    file.write(data, size);
+    file.close();
+
+    ++sWrittenFiles;
+    return true;
+}
+
+static void WriterLoop(WriterQueue* queue) {
+    std::deque<WriteJob> batch;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->busy = false;
+            queue->drained.notify_all();
+            queue->pushed.wait(lock, [queue] { return queue->stop || !queue->jobs.empty(); });
+
+            if(queue->jobs.empty()) {
+                return;
+            }
+
+            // Take everything that piled up so the producers are released in one go
+            batch.swap(queue->jobs);
+            queue->busy = true;
+            queue->drained.notify_all();
+        }
+
+        for(auto& job : batch) {
+            try {
+                WriteNow(job.path, job.data.data(), job.data.size());
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(sErrorMutex);
+                if(!sWriterError) {
+                    sWriterError = std::current_exception();
+                }
+            }
+        }
+        batch.clear();
+    }
+}
+
+bool FileWriter::IsUnchanged(const fs::path& path, const char* data, const size_t size) {
+    std::error_code ec;
+    const auto current = fs::file_size(path, ec);
+
+    // Cheap check first, most regenerated files that changed also changed in size
+    if(ec || current != size) {
+        return false;
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    if(!input.is_open()) {
+        return false;
+    }
+
+    char chunk[0x4000];
+    size_t offset = 0;
+
+    while(offset < size) {
+        const auto count = std::min(sizeof(chunk), size - offset);
+        if(!input.read(chunk, count) || std::memcmp(chunk, data + offset, count) != 0) {
+            return false;
+        }
+        offset += count;
+    }
+
+    return true;
+}
+
+bool FileWriter::Write(const fs::path& path, const char* data, const size_t size) {
+    TrackOutput(path);
+    return WriteNow(path, data, size);
+}
+
+bool FileWriter::Write(const fs::path& path, const std::string& data) {
+    return Write(path, data.data(), data.size());
+}
+
+void FileWriter::Queue(const fs::path& path, std::string data, const bool track) {
+    if(track) {
+        TrackOutput(path);
+    }
+
+    if(sWriters.empty()) {
+        WriteNow(path, data.data(), data.size());
+        return;
+    }
+
+    // Pin every path to one writer so repeated writes to it keep their order
+    const auto index = std::hash<std::string>{}(path.generic_string()) % sWriters.size();
+    auto queue = sWriters[index].get();
+
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->drained.wait(lock, [queue] { return queue->jobs.size() < MAX_QUEUED_WRITES; });
+    queue->jobs.push_back({ path, std::move(data) });
+    queue->pushed.notify_one();
+}
+
+void FileWriter::Queue(const fs::path& path, const std::vector<char>& data) {
+    Queue(path, std::string(data.begin(), data.end()));
+}
+
+void FileWriter::Expect(const fs::path& path) {
+    TrackOutput(path);
+}
+
+void FileWriter::StartWorkers(size_t count) {
+#ifndef __EMSCRIPTEN__
+    if(!sWriters.empty()) {
+        return;
+    }
+
+    if(count == 0) {
+        count = Torch::GetWorkerCount(8);
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        auto queue = std::make_unique<WriterQueue>();
+        queue->thread = std::thread(WriterLoop, queue.get());
+        sWriters.push_back(std::move(queue));
+    }
+#endif
+}
+
+void FileWriter::Flush() {
+    for(auto& queue : sWriters) {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        queue->drained.wait(lock, [&queue] { return queue->jobs.empty() && !queue->busy; });
+    }
+
+    std::lock_guard<std::mutex> lock(sErrorMutex);
+    if(sWriterError) {
+        auto error = sWriterError;
+        sWriterError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void FileWriter::StopWorkers() {
+    for(auto& queue : sWriters) {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->stop = true;
+        }
+        queue->pushed.notify_all();
+        queue->thread.join();
+    }
+    sWriters.clear();
+
+    std::lock_guard<std::mutex> lock(sDirectoriesMutex);
+    sCreatedDirectories.clear();
+}
+
+std::vector<std::string> FileWriter::ConsumeOutputs() {
+    std::lock_guard<std::mutex> lock(sOutputsMutex);
+    std::vector<std::string> outputs;
+    outputs.swap(sOutputs);
+    return outputs;
+}
+
+FileWriterStats FileWriter::GetStats() {
+    return { sWrittenFiles.load(), sSkippedFiles.load() };
+}
+
+void FileWriter::ResetStats() {
+    sWrittenFiles = 0;
+    sSkippedFiles = 0;
+    {
+        std::lock_guard<std::mutex> lock(sDirectoriesMutex);
+        sCreatedDirectories.clear();
+    }
+    std::lock_guard<std::mutex> lock(sOutputsMutex);
+    sOutputs.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+struct FileWriterStats {
+    size_t written;
+    size_t skipped;
+};
+
+class FileWriter {
+  public:
+    // Writes data to path unless the file already holds the exact same bytes, returns true if the file was touched
+    static bool Write(const std::filesystem::path& path, const std::string& data);
+    static bool Write(const std::filesystem::path& path, const char* data, size_t size);
+    static bool IsUnchanged(const std::filesystem::path& path, const char* data, size_t size);
+
+    // Hands the buffer to the writer threads and returns immediately, falls back to Write when none are running.
+    // Writes to the same path always land in the order they were queued.
+    static void Queue(const std::filesystem::path& path, std::string data, bool track = true);
+    static void Queue(const std::filesystem::path& path, const std::vector<char>& data);
+
+    // Records path as an output right away for data that is only queued later, which then passes track = false
+    static void Expect(const std::filesystem::path& path);
+
+    static void StartWorkers(size_t count = 0);
+    // Blocks until every queued write hit the disk, rethrows the first error a writer thread ran into
+    static void Flush();
+    static void StopWorkers();
+
+    // Returns every path passed to Write since the last call, written or not, so callers can map outputs to their inputs
+    static std::vector<std::string> ConsumeOutputs();
+
+    static FileWriterStats GetStats();
+    static void ResetStats();
+};
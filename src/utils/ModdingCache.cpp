@@ -0,0 +1,731 @@
+#include "ModdingCache.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include "spdlog/spdlog.h"
+#include "Companion.h"
+#include "Decompressor.h"
+#include "PaletteQuantizer.h"
+#include "ParallelFor.h"
+#include "TorchUtils.h"
+#include "factories/TextureFactory.h"
+#include "factories/CompressedTextureFactory.h"
+
+extern "C" {
+#include "n64graphics/n64graphics.h"
+#include "n64graphics/stb_image.h"
+}
+
+namespace fs = std::filesystem;
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct PrefetchEntry {
+    bool done = false;
+    std::vector<uint8_t> data;
+};
+
+static fs::path sDirectory;
+static std::mutex sMutex;
+static std::condition_variable sDone;
+static std::unordered_map<std::string, std::shared_ptr<PrefetchEntry>> sFiles;
+// PNGs decoded ahead of time by content hash, taken out again when imported
+static std::unordered_map<std::string, DecodedImage> sDecoded;
+// Content hashes with at least one converted texture in the cache directory, those are not worth decoding up front
+static std::unordered_set<std::string> sCachedHashes;
+static std::vector<std::thread> sWorkers;
+
+// CI4 textures only reach one 16 color bank of their TLUT, the palette field of their tile picks which
+#define CI4_BANK_COLORS 16
+
+struct PaletteGroup {
+    uint32_t colors;
+    // CI8 members index the whole palette, CI4 members the entries of their bank
+    PaletteQuantizer quantizer;
+    std::unordered_map<uint32_t, PaletteQuantizer> banks;
+    std::vector<uint16_t> original;
+    std::vector<uint16_t> palette;
+    std::unordered_map<uint32_t, ImportedTexture> textures;
+    // Offsets of the textures the palette was quantized from
+    std::unordered_set<uint32_t> members;
+};
+
+// CI textures and TLUTs of the yaml file being processed, so a group doesn't need a walk over every asset
+struct PaletteIndex {
+    std::string file;
+    std::unordered_map<uint32_t, std::vector<std::tuple<std::string, YAML::Node>>> textures;
+    std::unordered_map<uint32_t, YAML::Node> tluts;
+    std::unordered_map<std::string, uint32_t> symbols;
+};
+
+static PaletteIndex sPaletteIndex;
+// Keyed by file and TLUT offset, holds nullptr when none of the textures using the TLUT is modded
+static std::unordered_map<std::string, std::shared_ptr<PaletteGroup>> sPaletteGroups;
+
+static std::vector<uint8_t> ReadFile(const fs::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    if(!input.is_open()) {
+        return {};
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator(input), {});
+}
+
+static std::string GetCacheKey(const std::string& hash, const TextureFormat& format) {
+    return hash + "-" + std::to_string(static_cast<int>(format.type)) + "-" + std::to_string(format.depth);
+}
+
+static std::optional<ImportedTexture> LoadCached(const fs::path& path) {
+    const auto file = ReadFile(path);
+    const auto entry = Torch::readCacheEntry(file.data(), file.size(), MODDING_CACHE_MAGIC, 2 * sizeof(uint32_t));
+    if(!entry.has_value()) {
+        return std::nullopt;
+    }
+
+    ImportedTexture texture;
+    std::memcpy(&texture.width, entry->header, sizeof(uint32_t));
+    std::memcpy(&texture.height, entry->header + sizeof(uint32_t), sizeof(uint32_t));
+    texture.data.assign(entry->data, entry->data + entry->size);
+    return texture;
+}
+
+static void StoreCached(const fs::path& path, const ImportedTexture& texture) {
+    const uint32_t header[] = { texture.width, texture.height };
+    if(!Torch::writeCacheEntry(path, MODDING_CACHE_MAGIC, header, sizeof(header), texture.data.data(), texture.data.size())) {
+        SPDLOG_WARN("Failed to write modding cache entry {}", path.string());
+    }
+}
+
+static std::optional<DecodedImage> Decode(const std::vector<uint8_t>& png) {
+    DecodedImage image;
+    const auto pixels = stbi_load_from_memory(png.data(), png.size(), &image.width, &image.height, &image.channels, STBI_default);
+    if(pixels == nullptr || image.width <= 0 || image.height <= 0) {
+        stbi_image_free(pixels);
+        return std::nullopt;
+    }
+
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * image.channels);
+    stbi_image_free(pixels);
+    return image;
+}
+
+// Uses the prefetched decode of the PNG when there is one
+static std::optional<DecodedImage> TakeDecoded(const std::string& hash, const std::vector<uint8_t>& png) {
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        const auto it = sDecoded.find(hash);
+        if(it != sDecoded.end()) {
+            auto image = std::move(it->second);
+            sDecoded.erase(it);
+            return image;
+        }
+    }
+
+    return Decode(png);
+}
+
+static void PrefetchFile(const fs::path& path, const std::shared_ptr<PrefetchEntry>& entry) {
+    auto data = ReadFile(path);
+    std::optional<DecodedImage> image;
+    std::string hash;
+
+    if(!data.empty()) {
+        hash = Companion::CalculateHash(data);
+
+        bool cached;
+        {
+            std::lock_guard<std::mutex> lock(sMutex);
+            cached = sCachedHashes.contains(hash) || sDecoded.contains(hash);
+        }
+
+        if(!cached) {
+            image = Decode(data);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(sMutex);
+    if(image.has_value()) {
+        sDecoded.try_emplace(hash, std::move(image.value()));
+    }
+    entry->data = std::move(data);
+    entry->done = true;
+    sDone.notify_all();
+}
+
+void ModdingCache::Prefetch(const std::vector<fs::path>& paths, const fs::path& directory) {
+    Clear();
+    // A limit of 0 disables the cache, conversions are neither looked up nor stored
+    if(Companion::Instance->GetConfig().cacheLimit == 0) {
+        sDirectory.clear();
+    } else {
+        sDirectory = directory;
+    }
+
+    std::error_code ec;
+    for(auto it = fs::directory_iterator(sDirectory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        const auto name = it->path().filename().string();
+        sCachedHashes.insert(name.substr(0, name.find('-')));
+    }
+
+    auto jobs = std::make_shared<std::vector<std::pair<fs::path, std::shared_ptr<PrefetchEntry>>>>();
+    for(const auto& path : paths) {
+        auto entry = std::make_shared<PrefetchEntry>();
+        if(sFiles.try_emplace(path.generic_string(), entry).second) {
+            jobs->emplace_back(path, entry);
+        }
+    }
+
+#ifdef __EMSCRIPTEN__
+    // Without threads the files are simply read once they are needed
+    sFiles.clear();
+#else
+    if(jobs->empty()) {
+        return;
+    }
+
+    auto next = std::make_shared<std::atomic<size_t>>(0);
+    const auto count = std::min<size_t>(jobs->size(), Torch::GetWorkerCount());
+
+    for(size_t i = 0; i < count; i++) {
+        sWorkers.emplace_back([jobs, next] {
+            for(size_t job = (*next)++; job < jobs->size(); job = (*next)++) {
+                PrefetchFile(jobs->at(job).first, jobs->at(job).second);
+            }
+        });
+    }
+#endif
+}
+
+std::vector<uint8_t> ModdingCache::Read(const fs::path& path) {
+    std::shared_ptr<PrefetchEntry> entry;
+    {
+        std::unique_lock<std::mutex> lock(sMutex);
+        const auto it = sFiles.find(path.generic_string());
+        if(it != sFiles.end()) {
+            entry = it->second;
+            sFiles.erase(it);
+            sDone.wait(lock, [&entry] { return entry->done; });
+        }
+    }
+
+    if(entry == nullptr || entry->data.empty()) {
+        return ReadFile(path);
+    }
+    return std::move(entry->data);
+}
+
+ImportedTexture ModdingCache::ImportTexture(const std::vector<uint8_t>& png, const TextureFormat& format) {
+    const auto hash = Companion::CalculateHash(png);
+    const auto cachePath = sDirectory.empty() ? fs::path() : sDirectory / (GetCacheKey(hash, format) + ".bin");
+
+    if(!cachePath.empty()) {
+        if(auto cached = LoadCached(cachePath)) {
+            SPDLOG_TRACE("Using cached conversion of {}", hash);
+            Torch::touchCacheEntry(cachePath);
+            return std::move(cached.value());
+        }
+    }
+
+    const auto image = TakeDecoded(hash, png);
+    if(!image.has_value()) {
+        throw std::runtime_error("Failed to convert PNG to texture");
+    }
+
+    const auto width = image->width;
+    const auto height = image->height;
+    ImportedTexture texture { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    texture.data.resize(static_cast<size_t>(width) * height * format.depth / 8);
+
+    int written;
+    switch (format.type) {
+        case TextureType::TLUT:
+        case TextureType::RGBA16bpp:
+        case TextureType::RGBA32bpp: {
+            std::vector<rgba> imgr(width * height);
+            if(pixels2rgba_into(imgr.data(), image->pixels.data(), width, height, image->channels)) {
+                throw std::runtime_error("Failed to convert PNG to texture");
+            }
+            written = rgba2raw(texture.data.data(), imgr.data(), width, height, format.depth);
+            break;
+        }
+        case TextureType::GrayscaleAlpha16bpp:
+        case TextureType::GrayscaleAlpha8bpp:
+        case TextureType::GrayscaleAlpha4bpp:
+        case TextureType::GrayscaleAlpha1bpp: {
+            std::vector<ia> imgia(width * height);
+            if(pixels2ia_into(imgia.data(), image->pixels.data(), width, height, image->channels)) {
+                throw std::runtime_error("Failed to convert PNG to texture");
+            }
+            written = ia2raw(texture.data.data(), imgia.data(), width, height, format.depth);
+            break;
+        }
+        case TextureType::Grayscale8bpp:
+        case TextureType::Grayscale4bpp: {
+            std::vector<ia> imgi(width * height);
+            if(pixels2ia_into(imgi.data(), image->pixels.data(), width, height, image->channels)) {
+                throw std::runtime_error("Failed to convert PNG to texture");
+            }
+            written = i2raw(texture.data.data(), imgi.data(), width, height, format.depth);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unsupported texture format for modding");
+    }
+
+    if(written <= 0) {
+        throw std::runtime_error("Failed to convert PNG to texture");
+    }
+
+    if(!cachePath.empty()) {
+        StoreCached(cachePath, texture);
+    }
+    return texture;
+}
+
+static std::string GetFormat(YAML::Node& node) {
+    auto format = GetSafeNode<std::string>(node, "format");
+    std::transform(format.begin(), format.end(), format.begin(), ::toupper);
+    return format;
+}
+
+static bool IsPaletteFormat(const std::string& format) {
+    return format == "CI4" || format == "CI8";
+}
+
+// TLUT asset holding an address, CI4 textures point their tlut at the bank they use inside it
+static uint32_t ContainingTlut(const uint32_t addr) {
+    if(sPaletteIndex.tluts.contains(addr)) {
+        return addr;
+    }
+
+    for(auto& [offset, node] : sPaletteIndex.tluts) {
+        const auto colors = GetSafeNode<uint32_t>(node, "colors", 256);
+        if(addr > offset && addr < offset + colors * 2 && (addr - offset) % (CI4_BANK_COLORS * 2) == 0) {
+            return offset;
+        }
+    }
+
+    return addr;
+}
+
+static void BuildPaletteIndex(const bool includeAutogen = false) {
+    sPaletteIndex = { Companion::Instance->GetCurrentFile() };
+
+    std::vector<std::tuple<std::string, YAML::Node>> textures;
+    for(const auto type : { "TEXTURE", "COMPRESSED_TEXTURE" }) {
+        const auto nodes = Companion::Instance->GetNodesByType(type, includeAutogen);
+        if(nodes.has_value()) {
+            textures.insert(textures.end(), nodes->begin(), nodes->end());
+        }
+    }
+
+    for(auto& [name, node] : textures) {
+        if(GetFormat(node) == "TLUT" && node["offset"]) {
+            const auto offset = GetSafeNode<uint32_t>(node, "offset");
+            sPaletteIndex.tluts[offset] = node;
+            if(node["symbol"]) {
+                sPaletteIndex.symbols[GetSafeNode<std::string>(node, "symbol")] = offset;
+            }
+        }
+    }
+
+    for(auto& entry : textures) {
+        auto& node = std::get<1>(entry);
+        if(!IsPaletteFormat(GetFormat(node)) || !node["offset"]) {
+            continue;
+        }
+
+        if(node["tlut"]) {
+            sPaletteIndex.textures[ContainingTlut(GetSafeNode<uint32_t>(node, "tlut"))].push_back(entry);
+        } else if(node["tlut_symbol"]) {
+            const auto tlut = sPaletteIndex.symbols.find(GetSafeNode<std::string>(node, "tlut_symbol"));
+            if(tlut != sPaletteIndex.symbols.end()) {
+                sPaletteIndex.textures[tlut->second].push_back(entry);
+            }
+        }
+    }
+}
+
+static std::optional<uint32_t> FindTlut(YAML::Node& node, const std::string& format) {
+    if(format == "TLUT") {
+        return GetSafeNode<uint32_t>(node, "offset");
+    }
+
+    if(node["tlut"]) {
+        return ContainingTlut(GetSafeNode<uint32_t>(node, "tlut"));
+    }
+
+    if(node["tlut_symbol"]) {
+        const auto it = sPaletteIndex.symbols.find(GetSafeNode<std::string>(node, "tlut_symbol"));
+        if(it != sPaletteIndex.symbols.end()) {
+            return it->second;
+        }
+    }
+
+    return std::nullopt;
+}
+
+static uint32_t FindBank(YAML::Node& node, const uint32_t tlut) {
+    if(!node["tlut"]) {
+        return 0;
+    }
+    return (GetSafeNode<uint32_t>(node, "tlut") - tlut) / (CI4_BANK_COLORS * 2);
+}
+
+static std::vector<uint8_t> ReadOriginal(YAML::Node& node, const size_t size) {
+    auto& rom = Companion::Instance->GetRomData();
+    auto type = GetSafeNode<std::string>(node, "type", "TEXTURE");
+    std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+
+    if(type == "COMPRESSED_TEXTURE") {
+        const auto offset = Decompressor::TranslateAddr(GetSafeNode<uint32_t>(node, "offset"), false);
+        const auto chunk = Decompressor::Decode(rom, offset, Decompressor::GetCompressionType(rom, offset));
+        return std::vector(chunk->data, chunk->data + std::min(chunk->size, size));
+    }
+
+    auto [_, segment] = Decompressor::AutoDecode(node, rom, size);
+    return std::vector(segment.data, segment.data + segment.size);
+}
+
+static std::vector<uint16_t> ReadTlut(const uint32_t offset, const uint32_t colors) {
+    std::vector<uint8_t> raw;
+    const auto tlut = sPaletteIndex.tluts.find(offset);
+    if(tlut != sPaletteIndex.tluts.end()) {
+        raw = ReadOriginal(tlut->second, colors * 2);
+    } else {
+        auto [_, segment] = Decompressor::AutoDecode(offset, colors * 2, Companion::Instance->GetRomData());
+        raw = std::vector(segment.data, segment.data + segment.size);
+    }
+
+    std::vector<uint16_t> result(raw.size() / 2);
+    for(size_t i = 0; i < result.size(); i++) {
+        result[i] = (raw[i * 2] << 8) | raw[i * 2 + 1];
+    }
+    return result;
+}
+
+// RGBA16 colors of a texture using the TLUT, taken from its modded PNG or from the ROM data and the original TLUT
+static std::vector<uint16_t> ReadColors(const std::string& name, YAML::Node& node, const std::vector<uint16_t>& original, const uint32_t bank,
+                                        uint32_t& width, uint32_t& height) {
+    const auto depth = GetFormat(node) == "CI4" ? 4 : 8;
+
+    if(const auto path = Companion::Instance->GetModdedAssetPath(name)) {
+        const auto png = ReadFile(path.value());
+        const auto image = png.empty() ? std::nullopt : TakeDecoded(Companion::CalculateHash(png), png);
+        if(!image.has_value()) {
+            throw std::runtime_error("Failed to convert PNG to texture");
+        }
+
+        width = image->width;
+        height = image->height;
+        std::vector<rgba> imgr(width * height);
+        std::vector<uint8_t> raw(width * height * 2);
+        if(pixels2rgba_into(imgr.data(), image->pixels.data(), width, height, image->channels) || rgba2raw(raw.data(), imgr.data(), width, height, 16) <= 0) {
+            throw std::runtime_error("Failed to convert PNG to texture");
+        }
+
+        std::vector<uint16_t> colors(width * height);
+        for(size_t i = 0; i < colors.size(); i++) {
+            colors[i] = (raw[i * 2] << 8) | raw[i * 2 + 1];
+        }
+        return colors;
+    }
+
+    width = GetSafeNode<uint32_t>(node, "width");
+    height = GetSafeNode<uint32_t>(node, "height");
+    const auto type = depth == 4 ? TextureType::Palette4bpp : TextureType::Palette8bpp;
+    const auto raw = ReadOriginal(node, GetSafeNode<uint32_t>(node, "size", TextureUtils::CalculateTextureSize(type, width, height)));
+
+    std::vector<uint16_t> colors(width * height);
+    for(size_t i = 0; i < colors.size() && i * depth / 8 < raw.size(); i++) {
+        const size_t index = depth == 8 ? raw[i] : bank * CI4_BANK_COLORS + (i % 2 ? raw[i / 2] & 0xF : raw[i / 2] >> 4);
+        colors[i] = index < original.size() ? original[index] : 0;
+    }
+    return colors;
+}
+
+static ImportedTexture WriteIndices(PaletteQuantizer& quantizer, const std::vector<uint16_t>& colors, const uint32_t width, const uint32_t height, const int depth) {
+    ImportedTexture texture { width, height, std::vector<uint8_t>(colors.size() * depth / 8) };
+    bool clamped = false;
+
+    for(size_t i = 0; i < colors.size(); i++) {
+        auto index = quantizer.GetIndex(colors[i]);
+        if(index >= (1 << depth)) {
+            index = 0;
+            clamped = true;
+        }
+
+        if(depth == 8) {
+            texture.data[i] = index;
+        } else {
+            texture.data[i / 2] |= i % 2 ? index : index << 4;
+        }
+    }
+
+    if(clamped) {
+        SPDLOG_WARN("Texture uses palette entries past the reach of CI4, they were replaced by the first one");
+    }
+    return texture;
+}
+
+// Quantizer of a bank that no member was quantized into, it maps onto the entries the bank already has
+static PaletteQuantizer& GetBankQuantizer(PaletteGroup& group, const uint32_t bank) {
+    auto it = group.banks.find(bank);
+    if(it == group.banks.end()) {
+        const auto first = std::min<size_t>(bank * CI4_BANK_COLORS, group.palette.size());
+        const auto last = std::min<size_t>(first + CI4_BANK_COLORS, group.palette.size());
+        it = group.banks.emplace(bank, PaletteQuantizer()).first;
+        it->second.Assign(std::vector(group.palette.begin() + first, group.palette.begin() + last));
+    }
+    return it->second;
+}
+
+static std::shared_ptr<PaletteGroup> BuildPaletteGroup(const uint32_t tlut, YAML::Node& node) {
+    auto& members = sPaletteIndex.textures[tlut];
+    const auto modded = std::any_of(members.begin(), members.end(), [](const auto& member) {
+        return Companion::Instance->GetModdedAssetPath(std::get<0>(member)).has_value();
+    });
+
+    if(!modded) {
+        return nullptr;
+    }
+
+    // The TLUT asset decides how many colors there are, CI textures that create their own one carry the count
+    uint32_t colors = 256;
+    const auto tlutNode = sPaletteIndex.tluts.find(tlut);
+    if(tlutNode != sPaletteIndex.tluts.end()) {
+        colors = GetSafeNode<uint32_t>(tlutNode->second, "colors", colors);
+    } else if(node["colors"]) {
+        colors = GetSafeNode<uint32_t>(node, "colors");
+    }
+
+    for(auto& [name, member] : members) {
+        if(tlutNode == sPaletteIndex.tluts.end() && member["colors"]) {
+            colors = GetSafeNode<uint32_t>(member, "colors");
+        }
+    }
+
+    auto group = std::make_shared<PaletteGroup>();
+    group->colors = colors;
+    group->original = ReadTlut(tlut, colors);
+
+    struct Source {
+        uint32_t offset;
+        int depth;
+        uint32_t bank;
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint16_t> colors;
+    };
+    std::vector<Source> sources;
+    bool banked = false;
+
+    for(auto& [name, member] : members) {
+        const auto depth = GetFormat(member) == "CI4" ? 4 : 8;
+        Source source { GetSafeNode<uint32_t>(member, "offset"), depth, depth == 4 ? FindBank(member, tlut) : 0 };
+        source.colors = ReadColors(name, member, group->original, source.bank, source.width, source.height);
+        auto& quantizer = depth == 4 ? group->banks[source.bank] : group->quantizer;
+        quantizer.Add(source.colors.data(), source.colors.size());
+        group->members.insert(source.offset);
+        banked |= depth == 4;
+        sources.push_back(std::move(source));
+    }
+
+    if(!banked) {
+        group->palette = group->quantizer.Quantize(colors, group->original);
+    } else {
+        // Each bank is quantized on its own, CI8 members then take the nearest entries of the whole palette
+        group->palette = group->original;
+        group->palette.resize(colors);
+        for(auto& [bank, quantizer] : group->banks) {
+            const auto first = std::min<size_t>(bank * CI4_BANK_COLORS, group->palette.size());
+            const auto last = std::min<size_t>(first + CI4_BANK_COLORS, group->palette.size());
+            const auto quantized = quantizer.Quantize(last - first, std::vector(group->palette.begin() + first, group->palette.begin() + last));
+            std::copy(quantized.begin(), quantized.end(), group->palette.begin() + first);
+        }
+        group->quantizer.Assign(group->palette);
+    }
+
+    for(auto& source : sources) {
+        auto& quantizer = source.depth == 4 ? group->banks.at(source.bank) : group->quantizer;
+        group->textures[source.offset] = WriteIndices(quantizer, source.colors, source.width, source.height, source.depth);
+    }
+
+    SPDLOG_INFO("Quantized {} textures sharing the TLUT at 0x{:X} to {} colors", sources.size(), tlut, group->palette.size());
+    return group;
+}
+
+std::optional<ImportedTexture> ModdingCache::ImportPalette(YAML::Node& node) {
+    if(!Companion::Instance->GetConfig().modding) {
+        return std::nullopt;
+    }
+
+    const auto format = GetFormat(node);
+    if(format != "TLUT" && !IsPaletteFormat(format)) {
+        return std::nullopt;
+    }
+
+    if(sPaletteIndex.file != Companion::Instance->GetCurrentFile()) {
+        BuildPaletteIndex();
+    }
+
+    const auto tlut = FindTlut(node, format);
+    if(!tlut.has_value()) {
+        return std::nullopt;
+    }
+
+    const auto key = sPaletteIndex.file + ":" + std::to_string(tlut.value());
+    auto it = sPaletteGroups.find(key);
+    if(it == sPaletteGroups.end()) {
+        // Textures found by the display lists aren't part of the index yet
+        auto& members = sPaletteIndex.textures[tlut.value()];
+        const auto offset = node["offset"] ? GetSafeNode<uint32_t>(node, "offset") : 0;
+        const auto known = std::any_of(members.begin(), members.end(), [offset](auto& member) {
+            return GetSafeNode<uint32_t>(std::get<1>(member), "offset") == offset;
+        });
+        if(format != "TLUT" && !known) {
+            members.emplace_back(GetSafeNode<std::string>(node, "vpath", ""), node);
+        }
+
+        // Only built groups are kept, a modded member may still turn up once more of the file is processed
+        auto built = BuildPaletteGroup(tlut.value(), node);
+        if(built == nullptr) {
+            return std::nullopt;
+        }
+        it = sPaletteGroups.emplace(key, std::move(built)).first;
+    }
+
+    const auto& group = it->second;
+
+    if(format == "TLUT") {
+        ImportedTexture texture { group->colors, 1, std::vector<uint8_t>(group->colors * 2) };
+        for(size_t i = 0; i < group->palette.size() && i < group->colors; i++) {
+            texture.data[i * 2] = group->palette[i] >> 8;
+            texture.data[i * 2 + 1] = group->palette[i] & 0xFF;
+        }
+        return texture;
+    }
+
+    // Textures found after the palette was built are mapped onto it
+    const auto offset = GetSafeNode<uint32_t>(node, "offset");
+    if(!group->textures.contains(offset)) {
+        uint32_t width;
+        uint32_t height;
+        const auto name = GetSafeNode<std::string>(node, "vpath", "");
+        const auto bank = format == "CI4" ? FindBank(node, tlut.value()) : 0;
+        const auto colors = ReadColors(name, node, group->original, bank, width, height);
+        auto& quantizer = format == "CI4" ? GetBankQuantizer(*group, bank) : group->quantizer;
+        group->textures[offset] = WriteIndices(quantizer, colors, width, height, format == "CI4" ? 4 : 8);
+    }
+
+    return group->textures.at(offset);
+}
+
+// Replaces the contents of a parsed texture, compressed ones are only compressed once they are exported
+static void ReplaceParsed(ParseResultData& result, ImportedTexture& texture) {
+    std::vector<uint8_t>* buffer;
+    uint32_t* width;
+    uint32_t* height;
+
+    if(result.type == "TEXTURE") {
+        const auto data = std::static_pointer_cast<TextureData>(result.data.value());
+        buffer = &data->mBuffer;
+        width = &data->mWidth;
+        height = &data->mHeight;
+    } else {
+        const auto data = std::static_pointer_cast<CompressedTextureData>(result.data.value());
+        buffer = &data->mBuffer;
+        width = &data->mWidth;
+        height = &data->mHeight;
+    }
+
+    *buffer = std::move(texture.data);
+    *width = texture.width;
+    *height = texture.height;
+}
+
+void ModdingCache::ResolvePalettes(std::vector<ParseResultData>& results) {
+    if(!Companion::Instance->GetConfig().modding) {
+        return;
+    }
+
+    BuildPaletteIndex(true);
+
+    std::unordered_set<uint32_t> rebuilt;
+    for(auto& [tlut, members] : sPaletteIndex.textures) {
+        if(members.empty()) {
+            continue;
+        }
+
+        const auto key = sPaletteIndex.file + ":" + std::to_string(tlut);
+        const auto it = sPaletteGroups.find(key);
+        if(it != sPaletteGroups.end()) {
+            const auto& quantized = it->second->members;
+            const auto complete = std::all_of(members.begin(), members.end(), [&quantized](auto& member) {
+                return quantized.contains(GetSafeNode<uint32_t>(std::get<1>(member), "offset"));
+            });
+            if(complete) {
+                continue;
+            }
+        }
+
+        auto group = BuildPaletteGroup(tlut, std::get<1>(members.front()));
+        if(group == nullptr) {
+            continue;
+        }
+        sPaletteGroups[key] = std::move(group);
+        rebuilt.insert(tlut);
+    }
+
+    if(rebuilt.empty()) {
+        return;
+    }
+
+    for(auto& result : results) {
+        if(!result.data.has_value() || (result.type != "TEXTURE" && result.type != "COMPRESSED_TEXTURE")) {
+            continue;
+        }
+
+        const auto format = GetFormat(result.node);
+        if(format != "TLUT" && !IsPaletteFormat(format)) {
+            continue;
+        }
+
+        const auto tlut = FindTlut(result.node, format);
+        if(!tlut.has_value() || !rebuilt.contains(tlut.value())) {
+            continue;
+        }
+
+        if(auto texture = ImportPalette(result.node)) {
+            ReplaceParsed(result, texture.value());
+        }
+    }
+}
+
+void ModdingCache::Clear() {
+    for(auto& worker : sWorkers) {
+        worker.join();
+    }
+    sWorkers.clear();
+
+    std::lock_guard<std::mutex> lock(sMutex);
+    sFiles.clear();
+    sDecoded.clear();
+    sCachedHashes.clear();
+    sDirectory.clear();
+    sPaletteGroups.clear();
+    sPaletteIndex = {};
+}
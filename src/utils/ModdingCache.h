@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <yaml-cpp/yaml.h>
+#include "TextureUtils.h"
+
+struct ParseResultData;
+
+struct ImportedTexture {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> data;
+};
+
+class ModdingCache {
+  public:
+    // Reads and decodes the given PNGs on worker threads, converted textures are cached in directory across runs
+    // unless the cache limit is 0
+    static void Prefetch(const std::vector<std::filesystem::path>& paths, const std::filesystem::path& directory);
+    // Contents of a modded file, waits for its prefetch when there is one running
+    static std::vector<uint8_t> Read(const std::filesystem::path& path);
+    // Converts a modded PNG to the texture format, the PNG is only decoded when it changed since it was last imported
+    static ImportedTexture ImportTexture(const std::vector<uint8_t>& png, const TextureFormat& format);
+    // Takes a CI4/CI8 texture or TLUT node. When one of the textures sharing the TLUT is modded all of them are quantized
+    // to a single palette, returns the new indices or TLUT colors, nullopt when there's nothing to import
+    static std::optional<ImportedTexture> ImportPalette(YAML::Node& node);
+    // Rebuilds the palette groups of the current file that gained members while it was parsed, autogenerated ones
+    // included, and rewrites the parsed TLUTs and CI textures of those groups. Runs before anything is exported
+    static void ResolvePalettes(std::vector<ParseResultData>& results);
+    // Joins the prefetch threads and drops everything held in memory
+    static void Clear();
+};
@@ -0,0 +1,620 @@
+#include "PNGEncoder.h"
+#include "FileWriter.h"
+#include "ParallelFor.h"
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
+
+// The implementation is compiled along with the zip wrapper, only the declarations are needed here
+#define MINIZ_HEADER_FILE_ONLY
+#include <miniz/zip_file.hpp>
+
+extern "C" {
+#include "n64graphics/n64graphics.h"
+}
+
+namespace fs = std::filesystem;
+
+// Upper bound of images waiting for an encoder, keeps memory flat when the export outruns the encoders
+#define MAX_QUEUED_IMAGES 256
+
+enum PNGFilter : uint8_t {
+    FILTER_NONE,
+    FILTER_SUB,
+    FILTER_UP,
+    FILTER_AVERAGE,
+    FILTER_PAETH,
+    FILTER_COUNT
+};
+
+struct EncodeJob {
+    fs::path path;
+    PNGImage image;
+    PNGCompression level;
+};
+
+static std::deque<EncodeJob> sJobs;
+static std::mutex sJobsMutex;
+static std::condition_variable sPushed;
+static std::condition_variable sDrained;
+static size_t sBusy = 0;
+static bool sStop = false;
+static std::vector<std::thread> sEncoders;
+static std::exception_ptr sEncoderError;
+
+static size_t GetChannels(const PNGColor color) {
+    switch (color) {
+        case PNGColor::RGBA:
+            return 4;
+        case PNGColor::RGB:
+            return 3;
+        case PNGColor::GrayAlpha:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/*
+ * Slicing-by-8 CRC32 tables, the nibble based mz_crc32 ends up dominating the time spent on stored images.
+ * CRC32_Slices[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct CRC32SliceTables {
+    uint32_t t[8][256];
+};
+
+static constexpr CRC32SliceTables MakeCRC32Tables() {
+    CRC32SliceTables tables = {};
+    for(uint32_t b = 0; b < 256; b++) {
+        uint32_t crc = b;
+        for(int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+        }
+        tables.t[0][b] = crc;
+    }
+    for(int k = 1; k < 8; k++) {
+        for(int b = 0; b < 256; b++) {
+            const uint32_t prev = tables.t[k - 1][b];
+            tables.t[k][b] = tables.t[0][prev & 0xFF] ^ (prev >> 8);
+        }
+    }
+    return tables;
+}
+
+static constexpr CRC32SliceTables CRC32_Slices = MakeCRC32Tables();
+
+static uint32_t CRC32(const uint8_t* data, size_t size) {
+    const auto& t = CRC32_Slices.t;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while(size >= 8) {
+        const uint32_t lo = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24));
+        const uint32_t hi = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while(size--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void WriteU32(std::string& out, const uint32_t value) {
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+static size_t BeginChunk(std::string& out, const char* type) {
+    const auto start = out.size();
+    WriteU32(out, 0);
+    out.append(type, 4);
+    return start;
+}
+
+static void EndChunk(std::string& out, const size_t start) {
+    const auto length = out.size() - start - 8;
+    for(size_t i = 0; i < 4; i++) {
+        out[start + i] = static_cast<char>(length >> (24 - i * 8));
+    }
+
+    // The CRC covers the chunk type and its data
+    WriteU32(out, CRC32(reinterpret_cast<const uint8_t*>(out.data()) + start + 4, length + 4));
+}
+
+// Written without early returns so it compiles to conditional moves
+static uint8_t Paeth(const int a, const int b, const int c) {
+    const int pa = std::abs(b - c);
+    const int pb = std::abs(a - c);
+    const int pc = std::abs(a + b - 2 * c);
+    const int bc = pb <= pc ? b : c;
+    return (pa <= pb && pa <= pc) ? a : bc;
+}
+
+// Filters a row and returns the sum of absolute differences of the result, prev is a zero row for the first one
+static uint64_t FilterRow(uint8_t* out, const uint8_t* row, const uint8_t* prev, const size_t size, const size_t bpp, const PNGFilter filter) {
+    switch (filter) {
+        case FILTER_SUB:
+            std::copy_n(row, bpp, out);
+            for(size_t i = bpp; i < size; i++) {
+                out[i] = row[i] - row[i - bpp];
+            }
+            break;
+        case FILTER_UP:
+            for(size_t i = 0; i < size; i++) {
+                out[i] = row[i] - prev[i];
+            }
+            break;
+        case FILTER_AVERAGE:
+            for(size_t i = 0; i < bpp; i++) {
+                out[i] = row[i] - (prev[i] >> 1);
+            }
+            for(size_t i = bpp; i < size; i++) {
+                out[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+            }
+            break;
+        case FILTER_PAETH:
+            for(size_t i = 0; i < bpp; i++) {
+                out[i] = row[i] - prev[i];
+            }
+            for(size_t i = bpp; i < size; i++) {
+                out[i] = row[i] - Paeth(row[i - bpp], prev[i], prev[i - bpp]);
+            }
+            break;
+        default:
+            std::copy_n(row, size, out);
+            break;
+    }
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < size; i++) {
+        sum += std::abs(static_cast<int8_t>(out[i]));
+    }
+    return sum;
+}
+
+// Turns the image into the filtered scanlines that go through deflate, picking the filter up to lastFilter with the
+// smallest sum of absolute differences for every row. FILTER_NONE leaves the image unfiltered.
+static std::vector<uint8_t> FilterImage(const PNGImage& image, const PNGFilter lastFilter) {
+    const bool adaptive = lastFilter != FILTER_NONE;
+    const auto channels = GetChannels(image.color);
+    const auto bpp = std::max<size_t>(1, channels * image.depth / 8);
+    const auto stride = (image.width * channels * image.depth + 7) / 8;
+    std::vector<uint8_t> packed;
+    const uint8_t* rows = image.pixels.data();
+
+    if(image.depth < 8) {
+        const auto perByte = 8 / image.depth;
+        packed.assign(stride * image.height, 0);
+
+        for(uint32_t y = 0; y < image.height; y++) {
+            for(uint32_t x = 0; x < image.width; x++) {
+                const auto shift = 8 - image.depth * (x % perByte + 1);
+                packed[y * stride + x / perByte] |= (image.pixels[y * image.width + x] & ((1 << image.depth) - 1)) << shift;
+            }
+        }
+        rows = packed.data();
+    }
+
+    std::vector<uint8_t> result((stride + 1) * image.height);
+    std::vector<uint8_t> scratch(adaptive ? stride : 0);
+    const std::vector<uint8_t> zero(adaptive ? stride : 0);
+
+    for(uint32_t y = 0; y < image.height; y++) {
+        const uint8_t* row = rows + y * stride;
+        const uint8_t* prev = y ? row - stride : zero.data();
+        uint8_t* out = result.data() + y * (stride + 1);
+
+        out[0] = FILTER_NONE;
+
+        if(!adaptive) {
+            std::copy_n(row, stride, out + 1);
+            continue;
+        }
+
+        // The unfiltered row goes straight to the output, the others only replace it when they do better
+        auto best = FilterRow(out + 1, row, prev, stride, bpp, FILTER_NONE);
+        for(uint8_t filter = FILTER_SUB; filter <= lastFilter; filter++) {
+            const auto sum = FilterRow(scratch.data(), row, prev, stride, bpp, static_cast<PNGFilter>(filter));
+
+            if(sum < best) {
+                best = sum;
+                out[0] = filter;
+                std::copy(scratch.begin(), scratch.end(), out + 1);
+            }
+        }
+    }
+
+    return result;
+}
+
+static mz_bool AppendOutput(const void* buffer, const int size, void* user) {
+    static_cast<std::string*>(user)->append(static_cast<const char*>(buffer), size);
+    return MZ_TRUE;
+}
+
+// miniz still runs its match finder at level 0, writing the stored blocks directly is an order of magnitude faster
+static void Store(std::string& out, const std::vector<uint8_t>& data) {
+    // zlib header for a 32K window and no preset dictionary
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    size_t offset = 0;
+    do {
+        const auto size = std::min<size_t>(data.size() - offset, 0xFFFF);
+        const bool last = offset + size == data.size();
+
+        out.push_back(static_cast<char>(last));
+        out.push_back(static_cast<char>(size));
+        out.push_back(static_cast<char>(size >> 8));
+        out.push_back(static_cast<char>(~size));
+        out.push_back(static_cast<char>(~size >> 8));
+        out.append(reinterpret_cast<const char*>(data.data()) + offset, size);
+        offset += size;
+    } while(offset < data.size());
+
+    WriteU32(out, static_cast<uint32_t>(mz_adler32(MZ_ADLER32_INIT, data.data(), data.size())));
+}
+
+struct BitWriter {
+    std::string& out;
+    uint64_t bits = 0;
+    int count = 0;
+
+    void Put(const uint32_t value, const int size) {
+        bits |= static_cast<uint64_t>(value) << count;
+        count += size;
+        // Codes are at most 13 bits, so spilling whole words keeps the buffer from overflowing
+        if(count >= 32) {
+            const char word[] = { static_cast<char>(bits), static_cast<char>(bits >> 8), static_cast<char>(bits >> 16), static_cast<char>(bits >> 24) };
+            out.append(word, 4);
+            bits >>= 32;
+            count -= 32;
+        }
+    }
+
+    void Flush() {
+        for(; count > 0; count -= 8) {
+            out.push_back(static_cast<char>(bits));
+            bits >>= 8;
+        }
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Code and bit count of every literal/length symbol of the fixed Huffman table, reversed since deflate writes them MSB first
+struct FixedHuffmanTable {
+    uint16_t code[288];
+    uint8_t size[288];
+    // Symbol, extra bit count and extra bits of every match length from 3 to 258
+    uint16_t lengthSymbol[259];
+    uint8_t lengthExtraSize[259];
+    uint8_t lengthExtra[259];
+};
+
+static constexpr FixedHuffmanTable MakeFixedHuffmanTable() {
+    constexpr uint16_t lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr uint8_t lengthBits[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    FixedHuffmanTable table = {};
+
+    for(int symbol = 0; symbol < 288; symbol++) {
+        uint32_t code;
+        uint8_t size;
+        if(symbol < 144) {
+            code = 0x30 + symbol;
+            size = 8;
+        } else if(symbol < 256) {
+            code = 0x190 + symbol - 144;
+            size = 9;
+        } else if(symbol < 280) {
+            code = symbol - 256;
+            size = 7;
+        } else {
+            code = 0xC0 + symbol - 280;
+            size = 8;
+        }
+
+        uint16_t reversed = 0;
+        for(int bit = 0; bit < size; bit++) {
+            reversed |= ((code >> bit) & 1) << (size - 1 - bit);
+        }
+        table.code[symbol] = reversed;
+        table.size[symbol] = size;
+    }
+
+    for(int i = 0; i < 29; i++) {
+        const int end = i == 28 ? 259 : lengthBase[i + 1];
+        for(int length = lengthBase[i]; length < end; length++) {
+            table.lengthSymbol[length] = 257 + i;
+            table.lengthExtraSize[length] = lengthBits[i];
+            table.lengthExtra[length] = length - lengthBase[i];
+        }
+    }
+    return table;
+}
+
+static constexpr FixedHuffmanTable FIXED_HUFFMAN = MakeFixedHuffmanTable();
+
+// Run length only deflate with the fixed Huffman table. Filtered rows of flat textures turn into long runs, so this
+// gets a good part of the way to a real compressor while running about as fast as storing the data.
+static void RunLength(std::string& out, const std::vector<uint8_t>& data) {
+    const auto& table = FIXED_HUFFMAN;
+    BitWriter writer { out };
+
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    // Final block with fixed codes
+    writer.Put(0b011, 3);
+
+    size_t i = 0;
+    while(i < data.size()) {
+        size_t run = 0;
+        if(i > 0) {
+            const auto limit = std::min<size_t>(258, data.size() - i);
+            while(run < limit && data[i + run] == data[i - 1]) {
+                run++;
+            }
+        }
+
+        if(run >= 3) {
+            const auto symbol = table.lengthSymbol[run];
+            writer.Put(table.code[symbol], table.size[symbol]);
+            writer.Put(table.lengthExtra[run], table.lengthExtraSize[run]);
+            // Distance code 0 is a distance of one byte, five zero bits in the fixed table
+            writer.Put(0, 5);
+            i += run;
+        } else {
+            writer.Put(table.code[data[i]], table.size[data[i]]);
+            i++;
+        }
+    }
+
+    writer.Put(table.code[256], table.size[256]);
+    writer.Flush();
+
+    WriteU32(out, static_cast<uint32_t>(mz_adler32(MZ_ADLER32_INIT, data.data(), data.size())));
+}
+
+static void Deflate(std::string& out, const std::vector<uint8_t>& data, const PNGCompression level) {
+    if(level == PNGCompression::Store) {
+        Store(out, data);
+        return;
+    }
+
+    if(level == PNGCompression::RLE) {
+        RunLength(out, data);
+        return;
+    }
+
+    // Around 300KB of state, allocated once per thread instead of once per image
+    thread_local auto compressor = std::make_unique<tdefl_compressor>();
+    mz_uint flags;
+
+    switch (level) {
+        case PNGCompression::Fast:
+            flags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+            break;
+        case PNGCompression::Best:
+            flags = tdefl_create_comp_flags_from_zip_params(MZ_UBER_COMPRESSION, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+            break;
+        default:
+            flags = tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+            break;
+    }
+
+    if(tdefl_init(compressor.get(), AppendOutput, &out, flags) != TDEFL_STATUS_OKAY ||
+       tdefl_compress_buffer(compressor.get(), data.data(), data.size(), TDEFL_FINISH) != TDEFL_STATUS_DONE) {
+        throw std::runtime_error("Failed to compress PNG image data");
+    }
+}
+
+PNGImage PNGEncoder::CreateImage(const PNGColor color, const uint32_t width, const uint32_t height) {
+    PNGImage image;
+    image.width = width;
+    image.height = height;
+    image.color = color;
+    image.pixels.resize(static_cast<size_t>(width) * height * GetChannels(color));
+    return image;
+}
+
+PNGImage PNGEncoder::CreatePaletteImage(const uint8_t* raw, const uint32_t width, const uint32_t height, const int depth, const std::vector<uint8_t>& tlut, const int tlutDepth) {
+    if(tlutDepth != 16 && tlutDepth != 32) {
+        throw std::runtime_error("Unsupported TLUT depth " + std::to_string(tlutDepth));
+    }
+
+    auto image = CreateImage(PNGColor::Palette, width, height);
+    image.depth = depth == 4 ? 4 : 8;
+
+    if(raw2ci_torch_into(reinterpret_cast<ci*>(image.pixels.data()), raw, width, height, image.depth)) {
+        throw std::runtime_error("Failed to convert texture to PNG");
+    }
+
+    const size_t maxColors = 1 << image.depth;
+    const auto colors = std::min(maxColors, tlut.size() * 8 / tlutDepth);
+    std::vector<rgba> entries(colors);
+    if(colors && raw2rgba_into(entries.data(), tlut.data(), colors, 1, tlutDepth)) {
+        throw std::runtime_error("Failed to convert texture to PNG");
+    }
+
+    // Every index must have an entry, pad the palette up to the highest one in use
+    const auto highest = image.pixels.empty() ? 0 : *std::max_element(image.pixels.begin(), image.pixels.end());
+    entries.resize(std::max<size_t>(colors, highest + 1), { 0, 0, 0, 0 });
+
+    image.palette.resize(entries.size() * 4);
+    std::copy_n(reinterpret_cast<const uint8_t*>(entries.data()), image.palette.size(), image.palette.data());
+    return image;
+}
+
+std::string PNGEncoder::Encode(const PNGImage& image, const PNGCompression level) {
+    const auto isPalette = image.color == PNGColor::Palette;
+    const auto colors = image.palette.size() / 4;
+
+    if(!image.width || !image.height || image.pixels.size() != static_cast<size_t>(image.width) * image.height * GetChannels(image.color)) {
+        throw std::runtime_error("Invalid PNG image size");
+    }
+
+    if(isPalette && (colors == 0 || colors > (1u << image.depth) || (image.depth != 4 && image.depth != 8))) {
+        throw std::runtime_error("Invalid PNG palette");
+    }
+
+    std::string out;
+    out.reserve(64 + image.palette.size() + image.pixels.size() + image.height);
+    out.append("\x89PNG\r\n\x1a\n", 8);
+
+    auto chunk = BeginChunk(out, "IHDR");
+    WriteU32(out, image.width);
+    WriteU32(out, image.height);
+    out.push_back(static_cast<char>(isPalette ? image.depth : 8));
+    out.push_back(static_cast<char>(image.color));
+    // Deflate compression, adaptive filtering, no interlacing
+    out.append(3, '\0');
+    EndChunk(out, chunk);
+
+    if(isPalette) {
+        chunk = BeginChunk(out, "PLTE");
+        for(size_t i = 0; i < colors; i++) {
+            out.append(reinterpret_cast<const char*>(&image.palette[i * 4]), 3);
+        }
+        EndChunk(out, chunk);
+
+        // Alpha of the trailing opaque entries can be left out
+        size_t alphas = colors;
+        while(alphas && image.palette[(alphas - 1) * 4 + 3] == 0xFF) {
+            alphas--;
+        }
+
+        if(alphas) {
+            chunk = BeginChunk(out, "tRNS");
+            for(size_t i = 0; i < alphas; i++) {
+                out.push_back(static_cast<char>(image.palette[i * 4 + 3]));
+            }
+            EndChunk(out, chunk);
+        }
+    }
+
+    // There is nothing to predict between palette indices and nothing to gain from filtering stored data. The fast
+    // levels stick to the cheap Sub and Up filters, which is where most of the gain is on N64 textures anyway.
+    auto lastFilter = FILTER_PAETH;
+    if(isPalette || level == PNGCompression::Store) {
+        lastFilter = FILTER_NONE;
+    } else if(level == PNGCompression::RLE || level == PNGCompression::Fast) {
+        lastFilter = FILTER_UP;
+    }
+
+    chunk = BeginChunk(out, "IDAT");
+    Deflate(out, FilterImage(image, lastFilter), level);
+
+    // Flat and dithered textures sometimes compress better unfiltered, with images this small trying both is cheap
+    if(lastFilter != FILTER_NONE && level == PNGCompression::Best) {
+        std::string plain;
+        Deflate(plain, FilterImage(image, FILTER_NONE), level);
+        if(plain.size() < out.size() - chunk - 8) {
+            out.resize(chunk + 8);
+            out += plain;
+        }
+    }
+    EndChunk(out, chunk);
+
+    chunk = BeginChunk(out, "IEND");
+    EndChunk(out, chunk);
+
+    return out;
+}
+
+static void EncoderLoop() {
+    while(true) {
+        std::unique_lock<std::mutex> lock(sJobsMutex);
+        sPushed.wait(lock, [] { return sStop || !sJobs.empty(); });
+
+        if(sJobs.empty()) {
+            return;
+        }
+
+        auto job = std::move(sJobs.front());
+        sJobs.pop_front();
+        sBusy++;
+        sDrained.notify_all();
+        lock.unlock();
+
+        try {
+            FileWriter::Queue(job.path, PNGEncoder::Encode(job.image, job.level), false);
+        } catch (...) {
+            std::lock_guard<std::mutex> errorLock(sJobsMutex);
+            if(!sEncoderError) {
+                sEncoderError = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        sBusy--;
+        sDrained.notify_all();
+    }
+}
+
+void PNGEncoder::Queue(const fs::path& path, PNGImage image, const PNGCompression level) {
+    if(sEncoders.empty()) {
+        FileWriter::Queue(path, Encode(image, level));
+        return;
+    }
+
+    // Tracked now so the output is attributed to the file being processed, not to whatever runs when it is written
+    FileWriter::Expect(path);
+
+    std::unique_lock<std::mutex> lock(sJobsMutex);
+    sDrained.wait(lock, [] { return sJobs.size() < MAX_QUEUED_IMAGES; });
+    sJobs.push_back({ path, std::move(image), level });
+    sPushed.notify_one();
+}
+
+void PNGEncoder::StartWorkers(size_t count) {
+#ifndef __EMSCRIPTEN__
+    if(!sEncoders.empty()) {
+        return;
+    }
+
+    if(count == 0) {
+        count = Torch::GetWorkerCount();
+    }
+
+    sStop = false;
+    for(size_t i = 0; i < count; i++) {
+        sEncoders.emplace_back(EncoderLoop);
+    }
+#endif
+}
+
+void PNGEncoder::Flush() {
+    std::unique_lock<std::mutex> lock(sJobsMutex);
+    sDrained.wait(lock, [] { return sJobs.empty() && sBusy == 0; });
+
+    if(sEncoderError) {
+        auto error = sEncoderError;
+        sEncoderError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void PNGEncoder::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(sJobsMutex);
+        sStop = true;
+    }
+    sPushed.notify_all();
+
+    for(auto& encoder : sEncoders) {
+        encoder.join();
+    }
+    sEncoders.clear();
+}
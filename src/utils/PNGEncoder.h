@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+enum class PNGCompression {
+    // Stored deflate blocks, for quick iteration on mods
+    Store,
+    // Run length matches only, close to Store in speed but still shrinks flat areas
+    RLE,
+    Fast,
+    Default,
+    // Maximum effort, also tries unfiltered rows and keeps the smaller result
+    Best
+};
+
+// Matches the PNG color type values
+enum class PNGColor : uint8_t {
+    Gray = 0,
+    RGB = 2,
+    Palette = 3,
+    GrayAlpha = 4,
+    RGBA = 6
+};
+
+struct PNGImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    PNGColor color = PNGColor::RGBA;
+    // Bits per palette index, 4 or 8, other color types are always 8 bits per sample
+    uint8_t depth = 8;
+    // One byte per sample and no filter bytes, palette images hold one index per pixel
+    std::vector<uint8_t> pixels;
+    // RGBA entries of palette images
+    std::vector<uint8_t> palette;
+};
+
+class PNGEncoder {
+  public:
+    // Allocates the pixels of an 8 bits per sample image, so rgba/ia buffers can be converted straight into it
+    static PNGImage CreateImage(PNGColor color, uint32_t width, uint32_t height);
+    // Indexed image from N64 CI4/CI8 data and its RGBA16/RGBA32 TLUT, colors missing from the TLUT become transparent black
+    static PNGImage CreatePaletteImage(const uint8_t* raw, uint32_t width, uint32_t height, int depth, const std::vector<uint8_t>& tlut, int tlutDepth);
+
+    static std::string Encode(const PNGImage& image, PNGCompression level);
+
+    // Encodes the image on the encoder threads and hands the result to FileWriter::Queue, encodes in place when none are running
+    static void Queue(const std::filesystem::path& path, PNGImage image, PNGCompression level);
+
+    static void StartWorkers(size_t count = 0);
+    // Blocks until every queued image was encoded, rethrows the first error an encoder thread ran into
+    static void Flush();
+    static void StopWorkers();
+};
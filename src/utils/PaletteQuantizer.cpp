@@ -0,0 +1,297 @@
+#include "PaletteQuantizer.h"
+
+#include <limits>
+#include <algorithm>
+
+#define COLOR_COUNT 0x10000
+#define UNMAPPED 0xFFFF
+// Stops early once no color moves to another entry
+#define KMEANS_PASSES 6
+
+#define CHANNEL_R(c) (((c) >> 11) & 0x1F)
+#define CHANNEL_G(c) (((c) >> 6) & 0x1F)
+#define CHANNEL_B(c) (((c) >> 1) & 0x1F)
+#define IS_OPAQUE(c) ((c) & 1)
+
+struct HistogramColor {
+    uint16_t value;
+    uint32_t count;
+};
+
+struct Box {
+    size_t begin;
+    size_t end;
+    uint64_t score;
+    int channel;
+};
+
+struct Centroid {
+    double r = 0;
+    double g = 0;
+    double b = 0;
+    double weight = 0;
+};
+
+static int GetChannel(const uint16_t color, const int channel) {
+    switch (channel) {
+        case 0: return CHANNEL_R(color);
+        case 1: return CHANNEL_G(color);
+        default: return CHANNEL_B(color);
+    }
+}
+
+// Green weighs the most and blue the least, close enough to perceived difference for 5 bit channels
+static uint32_t Distance(const int r, const int g, const int b, const uint16_t color) {
+    const int dr = r - CHANNEL_R(color);
+    const int dg = g - CHANNEL_G(color);
+    const int db = b - CHANNEL_B(color);
+    return 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+}
+
+static size_t Nearest(const std::vector<uint16_t>& palette, const uint16_t color, const size_t begin) {
+    size_t best = begin;
+    uint32_t bestDistance = std::numeric_limits<uint32_t>::max();
+    const int r = CHANNEL_R(color);
+    const int g = CHANNEL_G(color);
+    const int b = CHANNEL_B(color);
+
+    for(size_t i = begin; i < palette.size() && bestDistance; i++) {
+        const auto distance = Distance(r, g, b, palette[i]);
+        if(distance < bestDistance) {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+
+    return best;
+}
+
+static uint16_t Pack(const double r, const double g, const double b, const bool opaque) {
+    const auto channel = [](const double value) {
+        return static_cast<uint16_t>(std::clamp(static_cast<int>(value + 0.5), 0, 0x1F));
+    };
+    return (channel(r) << 11) | (channel(g) << 6) | (channel(b) << 1) | (opaque ? 1 : 0);
+}
+
+static void MeasureBox(const std::vector<HistogramColor>& colors, Box& box) {
+    int min[3] = { 0x1F, 0x1F, 0x1F };
+    int max[3] = { 0, 0, 0 };
+    uint64_t count = 0;
+
+    for(size_t i = box.begin; i < box.end; i++) {
+        for(int c = 0; c < 3; c++) {
+            const int value = GetChannel(colors[i].value, c);
+            min[c] = std::min(min[c], value);
+            max[c] = std::max(max[c], value);
+        }
+        count += colors[i].count;
+    }
+
+    box.channel = 0;
+    for(int c = 1; c < 3; c++) {
+        if(max[c] - min[c] > max[box.channel] - min[box.channel]) {
+            box.channel = c;
+        }
+    }
+
+    const auto range = static_cast<uint64_t>(max[box.channel] - min[box.channel]);
+    // Boxes holding a single color can't be split any further
+    box.score = box.end - box.begin > 1 ? range * range * count : 0;
+}
+
+static std::vector<Centroid> MedianCut(std::vector<HistogramColor>& colors, const size_t count) {
+    std::vector<Box> boxes = { { 0, colors.size() } };
+    MeasureBox(colors, boxes[0]);
+
+    while(boxes.size() < count) {
+        const auto box = std::max_element(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
+            return a.score < b.score;
+        });
+
+        if(box->score == 0) {
+            break;
+        }
+
+        const auto channel = box->channel;
+        std::sort(colors.begin() + box->begin, colors.begin() + box->end, [channel](const HistogramColor& a, const HistogramColor& b) {
+            return GetChannel(a.value, channel) < GetChannel(b.value, channel);
+        });
+
+        uint64_t total = 0;
+        for(size_t i = box->begin; i < box->end; i++) {
+            total += colors[i].count;
+        }
+
+        // Split at the weighted median, leaving at least one color on each side
+        size_t split = box->begin + 1;
+        for(uint64_t sum = colors[box->begin].count; split < box->end - 1 && sum * 2 < total; split++) {
+            sum += colors[split].count;
+        }
+
+        Box upper = { split, box->end };
+        box->end = split;
+        MeasureBox(colors, *box);
+        MeasureBox(colors, upper);
+        boxes.push_back(upper);
+    }
+
+    std::vector<Centroid> centroids(boxes.size());
+    for(size_t i = 0; i < boxes.size(); i++) {
+        for(size_t j = boxes[i].begin; j < boxes[i].end; j++) {
+            const double weight = colors[j].count;
+            centroids[i].r += CHANNEL_R(colors[j].value) * weight;
+            centroids[i].g += CHANNEL_G(colors[j].value) * weight;
+            centroids[i].b += CHANNEL_B(colors[j].value) * weight;
+            centroids[i].weight += weight;
+        }
+    }
+
+    return centroids;
+}
+
+PaletteQuantizer::PaletteQuantizer() : mHistogram(COLOR_COUNT), mIndices(COLOR_COUNT, UNMAPPED) {}
+
+void PaletteQuantizer::Add(const uint16_t* colors, const size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        this->mHistogram[colors[i]]++;
+    }
+}
+
+std::vector<uint16_t> PaletteQuantizer::Quantize(const size_t maxColors, const std::vector<uint16_t>& current) {
+    std::vector<HistogramColor> opaque;
+    Centroid transparent;
+    bool hasTransparent = false;
+
+    for(uint32_t color = 0; color < COLOR_COUNT; color++) {
+        if(this->mHistogram[color] == 0) {
+            continue;
+        }
+
+        if(IS_OPAQUE(color)) {
+            opaque.push_back({ static_cast<uint16_t>(color), this->mHistogram[color] });
+        } else {
+            const double weight = this->mHistogram[color];
+            transparent.r += CHANNEL_R(color) * weight;
+            transparent.g += CHANNEL_G(color) * weight;
+            transparent.b += CHANNEL_B(color) * weight;
+            transparent.weight += weight;
+            hasTransparent = true;
+        }
+    }
+
+    std::fill(this->mIndices.begin(), this->mIndices.end(), UNMAPPED);
+    this->mPalette.clear();
+
+    // Colors that all exist in the current palette keep it, so textures that weren't touched stay identical
+    if(!current.empty() && current.size() <= maxColors) {
+        for(size_t i = current.size(); i-- > 0;) {
+            this->mIndices[current[i]] = i;
+        }
+
+        bool covered = true;
+        for(uint32_t color = 0; color < COLOR_COUNT && covered; color++) {
+            covered = this->mHistogram[color] == 0 || this->mIndices[color] != UNMAPPED;
+        }
+
+        if(covered) {
+            this->mPalette = current;
+            return this->mPalette;
+        }
+
+        std::fill(this->mIndices.begin(), this->mIndices.end(), UNMAPPED);
+    }
+
+    // Transparent texels take the first entry, keeping their average color for bilinear filtering at the edges
+    if(hasTransparent) {
+        const auto weight = transparent.weight;
+        this->mPalette.push_back(Pack(transparent.r / weight, transparent.g / weight, transparent.b / weight, false));
+        for(uint32_t color = 0; color < COLOR_COUNT; color += 2) {
+            if(this->mHistogram[color]) {
+                this->mIndices[color] = 0;
+            }
+        }
+    }
+
+    const size_t first = this->mPalette.size();
+    const size_t count = maxColors > first ? maxColors - first : 0;
+
+    if(opaque.size() <= count) {
+        for(const auto& color : opaque) {
+            this->mIndices[color.value] = this->mPalette.size();
+            this->mPalette.push_back(color.value);
+        }
+        return this->mPalette;
+    }
+
+    // Transparent texels already take the whole budget, GetIndex sends the opaque ones to that entry too
+    if(count == 0) {
+        return this->mPalette;
+    }
+
+    auto centroids = MedianCut(opaque, count);
+    std::vector<size_t> assigned(opaque.size(), std::numeric_limits<size_t>::max());
+
+    for(size_t pass = 0; pass < KMEANS_PASSES; pass++) {
+        this->mPalette.resize(first);
+        for(const auto& centroid : centroids) {
+            const auto weight = std::max(centroid.weight, 1.0);
+            this->mPalette.push_back(Pack(centroid.r / weight, centroid.g / weight, centroid.b / weight, true));
+        }
+
+        bool changed = false;
+        std::vector<Centroid> next(centroids.size());
+        for(size_t i = 0; i < opaque.size(); i++) {
+            const auto index = Nearest(this->mPalette, opaque[i].value, first) - first;
+            const double weight = opaque[i].count;
+            changed |= assigned[i] != index;
+            assigned[i] = index;
+            next[index].r += CHANNEL_R(opaque[i].value) * weight;
+            next[index].g += CHANNEL_G(opaque[i].value) * weight;
+            next[index].b += CHANNEL_B(opaque[i].value) * weight;
+            next[index].weight += weight;
+        }
+
+        if(!changed) {
+            break;
+        }
+
+        // Entries nobody picked keep their previous color
+        for(size_t i = 0; i < next.size(); i++) {
+            if(next[i].weight > 0) {
+                centroids[i] = next[i];
+            }
+        }
+    }
+
+    for(size_t i = 0; i < opaque.size(); i++) {
+        this->mIndices[opaque[i].value] = first + assigned[i];
+    }
+
+    return this->mPalette;
+}
+
+void PaletteQuantizer::Assign(const std::vector<uint16_t>& palette) {
+    std::fill(this->mIndices.begin(), this->mIndices.end(), UNMAPPED);
+    this->mPalette = palette;
+    for(size_t i = palette.size(); i-- > 0;) {
+        this->mIndices[palette[i]] = i;
+    }
+}
+
+uint8_t PaletteQuantizer::GetIndex(const uint16_t color) {
+    if(this->mIndices[color] == UNMAPPED && !this->mPalette.empty()) {
+        const bool transparent = !IS_OPAQUE(color);
+        size_t index = UNMAPPED;
+
+        for(size_t i = 0; i < this->mPalette.size() && transparent; i++) {
+            if(!IS_OPAQUE(this->mPalette[i])) {
+                index = i;
+                break;
+            }
+        }
+
+        this->mIndices[color] = index != UNMAPPED ? index : Nearest(this->mPalette, color, 0);
+    }
+
+    return this->mIndices[color] == UNMAPPED ? 0 : this->mIndices[color];
+}
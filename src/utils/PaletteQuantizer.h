@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Builds CI4/CI8 palettes out of RGBA16 (RGBA5551) colors, every image added shares the resulting palette
+class PaletteQuantizer {
+  public:
+    PaletteQuantizer();
+
+    void Add(const uint16_t* colors, size_t count);
+
+    // Median cut followed by a few k-means passes, transparent colors share a single entry. The current palette is kept
+    // as is when it already holds every color that was added, and no quantizing is done when they fit in maxColors
+    std::vector<uint16_t> Quantize(size_t maxColors, const std::vector<uint16_t>& current = {});
+
+    // Uses a palette built elsewhere instead of quantizing, colors then map to their exact or nearest entry
+    void Assign(const std::vector<uint16_t>& palette);
+
+    // Palette entry for a color, the nearest one for colors added after Quantize
+    uint8_t GetIndex(uint16_t color);
+
+  private:
+    std::vector<uint32_t> mHistogram;
+    std::vector<uint16_t> mIndices;
+    std::vector<uint16_t> mPalette;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <exception>
+
+namespace Torch {
+
+// Workers a pool runs on this machine, one per core and at most limit
+inline size_t GetWorkerCount(const unsigned limit = 16) {
+    return std::clamp(std::thread::hardware_concurrency(), 1u, limit);
+}
+
+// Runs fn(i) for every i in [0, count), handing indices out to up to GetWorkerCount() threads.
+// The threads are always joined before it returns, the first exception thrown by fn stops the
+// remaining jobs and is rethrown here.
+template<typename Fn>
+void ParallelFor(const size_t count, Fn&& fn) {
+#ifdef __EMSCRIPTEN__
+    const size_t workers = 1;
+#else
+    const size_t workers = std::min<size_t>(count, GetWorkerCount());
+#endif
+
+    if(workers <= 1) {
+        for(size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    const auto worker = [&] {
+        try {
+            for(size_t i; (i = next++) < count;) {
+                fn(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    struct JoinGuard {
+        std::vector<std::thread> threads;
+        ~JoinGuard() {
+            for(auto& thread : threads) {
+                thread.join();
+            }
+        }
+    };
+
+    {
+        JoinGuard guard;
+        guard.threads.reserve(workers);
+        try {
+            for(size_t i = 0; i < workers; i++) {
+                guard.threads.emplace_back(worker);
+            }
+        } catch (...) {
+            // The workers that did start stop at their next job and are joined by the guard
+            next = count;
+            throw;
+        }
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+#include "TextureIndex.h"
+
+#include <tuple>
+#include <algorithm>
+#include "lib/binarytools/BinaryWriter.h"
+#include "strhash64/StrHash64.h"
+
+#define INDEX_MAGIC "TXIX"
+#define INDEX_VERSION 1
+
+static uint32_t ReadBE32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+uint32_t TextureIndex::RiceCRC32(const uint8_t* data, const size_t size, const uint32_t width, uint32_t height, const uint32_t depth) {
+    const size_t line = width * depth / 8;
+    uint32_t crc = 0;
+
+    if(line == 0) {
+        return crc;
+    }
+
+    // Truncated data only hashes the rows that are complete
+    height = std::min<size_t>(height, size / line);
+
+    for(int64_t y = height - 1; y >= 0; y--, data += line) {
+        uint32_t word = 0;
+        for(int64_t x = static_cast<int64_t>(line) - 4; x >= 0; x -= 4) {
+            word = ReadBE32(data + x) ^ static_cast<uint32_t>(x);
+            crc = (crc << 4) + ((crc >> 28) & 15);
+            crc += word;
+        }
+        crc += word ^ static_cast<uint32_t>(y);
+    }
+
+    return crc;
+}
+
+TextureIndexEntry TextureIndex::CreateEntry(const std::string& path, const uint64_t pathHash, const uint32_t offset, const TextureFormat format,
+                                            const uint32_t width, const uint32_t height, const std::vector<uint8_t>& data, const std::vector<uint8_t>* tlut) {
+    TextureIndexEntry entry = { path, pathHash, offset, format, width, height };
+    entry.hash = CRC64N(reinterpret_cast<const char*>(data.data()), data.size());
+
+    if(format.type == TextureType::TLUT) {
+        // Hashed the same way as a palette, one row of RGBA16 colors
+        entry.crc = RiceCRC32(data.data(), data.size(), width, 1, 16);
+        return entry;
+    }
+
+    entry.crc = RiceCRC32(data.data(), data.size(), width, height, format.depth);
+
+    const bool isPalette = format.type == TextureType::Palette4bpp || format.type == TextureType::Palette8bpp;
+    if(!isPalette || tlut == nullptr || data.empty()) {
+        entry.paletteCrc = 0;
+        return entry;
+    }
+
+    uint8_t maxIndex = 0;
+    if(format.type == TextureType::Palette8bpp) {
+        maxIndex = *std::max_element(data.begin(), data.end());
+    } else {
+        for(const auto value : data) {
+            maxIndex = std::max<uint8_t>(maxIndex, std::max(value >> 4, value & 0xF));
+        }
+    }
+
+    entry.paletteCrc = RiceCRC32(tlut->data(), tlut->size(), maxIndex + 1, 1, 16);
+    return entry;
+}
+
+std::vector<char> TextureIndex::ToBinary(std::vector<TextureIndexEntry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const TextureIndexEntry& a, const TextureIndexEntry& b) {
+        return std::tie(a.crc, a.paletteCrc, a.path) < std::tie(b.crc, b.paletteCrc, b.path);
+    });
+
+    auto writer = LUS::BinaryWriter();
+    char magic[] = INDEX_MAGIC;
+    std::string strings;
+
+    writer.Write(magic, 4);
+    writer.Write(static_cast<uint32_t>(INDEX_VERSION));
+    writer.Write(static_cast<uint32_t>(entries.size()));
+
+    for(const auto& entry : entries) {
+        writer.Write(entry.pathHash);
+        writer.Write(entry.hash);
+        writer.Write(entry.crc);
+        writer.Write(entry.paletteCrc);
+        writer.Write(entry.offset);
+        writer.Write(static_cast<uint32_t>(strings.size()));
+        writer.Write(static_cast<uint16_t>(entry.width));
+        writer.Write(static_cast<uint16_t>(entry.height));
+        writer.Write(static_cast<uint8_t>(entry.format.type));
+        writer.Write(static_cast<uint8_t>(entry.format.depth));
+        writer.Write(static_cast<uint16_t>(0));
+
+        strings += entry.path;
+        strings += '\0';
+    }
+
+    writer.Write(strings.data(), strings.size());
+    return writer.ToVector();
+}
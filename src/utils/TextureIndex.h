@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "TextureUtils.h"
+
+struct TextureIndexEntry {
+    std::string path;
+    uint64_t pathHash;
+    uint32_t offset;
+    TextureFormat format;
+    uint32_t width;
+    uint32_t height;
+    // Rice CRC of the texture, the checksum HD texture packs are named after
+    uint32_t crc;
+    // Rice CRC of the TLUT entries a CI texture indexes, zero for every other format
+    uint32_t paletteCrc;
+    // CRC64 of the whole texture data, collides far less often than the Rice CRC
+    uint64_t hash;
+};
+
+class TextureIndex {
+  public:
+    // Checksum of width x height texels as computed by Rice Video and GLideN64 for their hires textures
+    static uint32_t RiceCRC32(const uint8_t* data, size_t size, uint32_t width, uint32_t height, uint32_t depth);
+
+    // The tlut is only looked at for CI textures, and only up to the highest index they use
+    static TextureIndexEntry CreateEntry(const std::string& path, uint64_t pathHash, uint32_t offset, TextureFormat format,
+                                         uint32_t width, uint32_t height, const std::vector<uint8_t>& data, const std::vector<uint8_t>* tlut);
+
+    // Fixed size records sorted by CRC, palette CRC and path followed by the path strings, so loaders can binary search
+    // the file in place or read it straight into a hash map
+    static std::vector<char> ToBinary(std::vector<TextureIndexEntry> entries);
+};
@@ -1,5 +1,6 @@
 #include "TextureUtils.h"
 #include <vector>
+#include <algorithm>
 #include <binarytools/endianness.h>
 
 size_t TextureUtils::CalculateTextureSize(TextureType type, uint32_t width, uint32_t height) {
@@ -54,4 +55,94 @@ std::vector<uint8_t> TextureUtils::alloc_ia8_text_from_i1(uint16_t *in, int16_t
     delete[] out;
 
     return result;
-}
\ No newline at end of file
+}
+
+#define SCALE_5_8(VAL_) (((VAL_) * 0xFF) / 0x1F)
+#define SCALE_4_8(VAL_) ((VAL_) * 0x11)
+#define SCALE_3_8(VAL_) ((VAL_) * 0x24)
+
+static void WriteRGBA16(uint8_t* out, uint16_t color) {
+    out[0] = SCALE_5_8((color >> 11) & 0x1F);
+    out[1] = SCALE_5_8((color >> 6) & 0x1F);
+    out[2] = SCALE_5_8((color >> 1) & 0x1F);
+    out[3] = (color & 1) ? 0xFF : 0x00;
+}
+
+static void WriteIA(uint8_t* out, uint8_t intensity, uint8_t alpha) {
+    out[0] = intensity;
+    out[1] = intensity;
+    out[2] = intensity;
+    out[3] = alpha;
+}
+
+std::vector<uint8_t> TextureUtils::DecodeToRGBA32(TextureType type, uint32_t width, uint32_t height, const std::vector<uint8_t>& buffer,
+                                                  const std::vector<uint8_t>* tlut, TextureType tlutType) {
+    const size_t pixels = width * height;
+    const uint8_t* in = buffer.data();
+    const bool isPalette = type == TextureType::Palette4bpp || type == TextureType::Palette8bpp;
+    // Bytes taken by two pixels, IA1 is stored expanded to one byte per pixel by the factory
+    const size_t pairSize = type == TextureType::GrayscaleAlpha1bpp ? 2 : CalculateTextureSize(type, 2, 1);
+
+    if(type == TextureType::Error || type == TextureType::TLUT || (isPalette && tlut == nullptr)) {
+        return {};
+    }
+
+    if(isPalette && tlutType != TextureType::RGBA16bpp && tlutType != TextureType::GrayscaleAlpha16bpp) {
+        return {};
+    }
+
+    if(buffer.size() < (pairSize * pixels + 1) / 2) {
+        return {};
+    }
+
+    std::vector<uint8_t> result(pixels * 4);
+    uint8_t* out = result.data();
+
+    for(size_t i = 0; i < pixels; i++, out += 4) {
+        const uint8_t nibble = (i % 2) ? (in[i / 2] & 0xF) : (in[i / 2] >> 4);
+
+        switch (type) {
+            case TextureType::RGBA32bpp:
+                std::copy_n(in + i * 4, 4, out);
+                break;
+            case TextureType::RGBA16bpp:
+                WriteRGBA16(out, (in[i * 2] << 8) | in[i * 2 + 1]);
+                break;
+            case TextureType::GrayscaleAlpha16bpp:
+                WriteIA(out, in[i * 2], in[i * 2 + 1]);
+                break;
+            case TextureType::GrayscaleAlpha8bpp:
+                WriteIA(out, SCALE_4_8(in[i] >> 4), SCALE_4_8(in[i] & 0xF));
+                break;
+            case TextureType::GrayscaleAlpha4bpp:
+                WriteIA(out, SCALE_3_8(nibble >> 1), (nibble & 1) ? 0xFF : 0x00);
+                break;
+            case TextureType::GrayscaleAlpha1bpp:
+                WriteIA(out, in[i], in[i]);
+                break;
+            case TextureType::Grayscale8bpp:
+                WriteIA(out, in[i], in[i]);
+                break;
+            case TextureType::Grayscale4bpp:
+                WriteIA(out, SCALE_4_8(nibble), SCALE_4_8(nibble));
+                break;
+            case TextureType::Palette8bpp:
+            case TextureType::Palette4bpp: {
+                const size_t index = type == TextureType::Palette8bpp ? in[i] : nibble;
+                if(index * 2 + 1 >= tlut->size()) {
+                    return {};
+                }
+                if(tlutType == TextureType::GrayscaleAlpha16bpp) {
+                    WriteIA(out, (*tlut)[index * 2], (*tlut)[index * 2 + 1]);
+                } else {
+                    WriteRGBA16(out, ((*tlut)[index * 2] << 8) | (*tlut)[index * 2 + 1]);
+                }
+                break;
+            }
+            default:
+                return {};
+        }
+    }
+
+    return result;
+}
@@ -28,4 +28,8 @@ class TextureUtils {
   public:
     static size_t CalculateTextureSize(TextureType type, uint32_t width, uint32_t height);
     static std::vector<uint8_t> alloc_ia8_text_from_i1(uint16_t *in, int16_t width, int16_t height);
+    // Decodes a native texture to RGBA8 the same way the port does on load, CI formats are looked up in a tlut of tlutType,
+    // RGBA16bpp or GrayscaleAlpha16bpp. Returns an empty buffer for formats that can't be decoded on their own
+    static std::vector<uint8_t> DecodeToRGBA32(TextureType type, uint32_t width, uint32_t height, const std::vector<uint8_t>& buffer,
+                                               const std::vector<uint8_t>* tlut = nullptr, TextureType tlutType = TextureType::RGBA16bpp);
 }; 
@@ -1,9 +1,19 @@
 #include "TorchUtils.h"
 
 #include <stack>
+#include <atomic>
+#include <cstring>
 #include <Companion.h>
 #include <factories/BaseFactory.h>
 #include "spdlog/spdlog.h"
+#include <strhash64/StrHash64.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -35,4 +45,146 @@ std::vector<fs::directory_entry> Torch::getRecursiveEntries(const fs::path baseD
 
     std::vector<fs::directory_entry> sortedEntries(result.begin(), result.end());
     return sortedEntries;
-}
\ No newline at end of file
+}
+
+static bool globMatchAt(const std::string& pattern, size_t p, const std::string& text, size_t t) {
+    while (p < pattern.size()) {
+        if (pattern[p] == '*') {
+            const bool deep = p + 1 < pattern.size() && pattern[p + 1] == '*';
+            const size_t next = p + (deep ? 2 : 1);
+
+            // 'dir/**/name' should also match 'dir/name'
+            if (deep && next < pattern.size() && pattern[next] == '/' && globMatchAt(pattern, next + 1, text, t)) {
+                return true;
+            }
+
+            for (size_t i = t; i <= text.size(); i++) {
+                if (globMatchAt(pattern, next, text, i)) {
+                    return true;
+                }
+                if (!deep && i < text.size() && text[i] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        if (t >= text.size()) {
+            return false;
+        }
+
+        if (pattern[p] == '?' ? text[t] == '/' : pattern[p] != text[t]) {
+            return false;
+        }
+
+        p++;
+        t++;
+    }
+
+    return t == text.size();
+}
+
+bool Torch::globMatch(const std::string& pattern, const std::string& text) {
+    return globMatchAt(pattern, 0, text, 0);
+}
+
+fs::path Torch::tempPathFor(const fs::path& path) {
+    static std::atomic<uint32_t> counter = 0;
+    const auto pid = static_cast<uint32_t>(getpid());
+
+    auto temp = path;
+    temp += "." + std::to_string(pid) + "-" + std::to_string(counter++) + ".tmp";
+    return temp;
+}
+
+bool Torch::writeCacheEntry(const fs::path& path, const char* magic, const void* header, const size_t headerSize, const uint8_t* data, const size_t size) {
+    std::error_code ec;
+    create_directories(path.parent_path(), ec);
+
+    char prefix[CACHE_ENTRY_HEADER_SIZE];
+    const uint32_t size32 = size;
+    const uint64_t crc = CRC64N(reinterpret_cast<const char*>(data), size);
+    std::memcpy(prefix, magic, 4);
+    std::memcpy(prefix + 4, &size32, sizeof(size32));
+    std::memcpy(prefix + 8, &crc, sizeof(crc));
+
+    const auto temp = tempPathFor(path);
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if(!file.is_open()) {
+            return false;
+        }
+        file.write(prefix, CACHE_ENTRY_HEADER_SIZE);
+        file.write(static_cast<const char*>(header), headerSize);
+        file.write(reinterpret_cast<const char*>(data), size);
+    }
+
+    fs::rename(temp, path, ec);
+    if(ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Torch::CacheEntry> Torch::readCacheEntry(const uint8_t* entry, const size_t length, const char* magic, const size_t headerSize) {
+    if(length < CACHE_ENTRY_HEADER_SIZE + headerSize || std::memcmp(entry, magic, 4) != 0) {
+        return std::nullopt;
+    }
+
+    uint32_t size;
+    uint64_t crc;
+    std::memcpy(&size, entry + 4, sizeof(size));
+    std::memcpy(&crc, entry + 8, sizeof(crc));
+
+    const auto data = entry + CACHE_ENTRY_HEADER_SIZE + headerSize;
+    if(length - CACHE_ENTRY_HEADER_SIZE - headerSize != size || CRC64N(reinterpret_cast<const char*>(data), size) != crc) {
+        return std::nullopt;
+    }
+
+    return CacheEntry { entry + CACHE_ENTRY_HEADER_SIZE, data, size };
+}
+
+void Torch::touchCacheEntry(const fs::path& path) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+void Torch::evictCache(const fs::path& directory, const uintmax_t limit) {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type time;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    for(auto it = fs::recursive_directory_iterator(directory, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if(!it->is_regular_file(ec)) {
+            continue;
+        }
+        Entry entry = { it->path(), it->file_size(ec), it->last_write_time(ec) };
+        total += entry.size;
+        entries.push_back(entry);
+    }
+
+    if(total <= limit) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.time < b.time;
+    });
+
+    for(auto& entry : entries) {
+        if(total <= limit) {
+            break;
+        }
+        if(fs::remove(entry.path, ec)) {
+            total -= entry.size;
+        }
+    }
+
+    SPDLOG_INFO("Cache trimmed to {} bytes", total);
+}
@@ -6,9 +6,19 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdint>
+#include <optional>
 #include <algorithm>
 #include <filesystem>
 
+// Versions of the entries under .torch_cache, bumped whenever that cache's layout or contents change so stale entries
+// are never picked up
+#define DECOMPRESSION_CACHE_MAGIC "TDC1"
+#define COMPRESSION_CACHE_MAGIC "TCC2"
+#define MODDING_CACHE_MAGIC "TMC2"
+
+// Magic, data size and the CRC64 of the data, followed by the header of the cache the entry belongs to
+#define CACHE_ENTRY_HEADER_SIZE 16
+
 namespace Torch {
 template< typename T >
 std::string to_hex(T number, const bool append0x = true) {
@@ -26,5 +36,24 @@ std::string to_hex(T number, const bool append0x = true) {
 
 uint32_t translate(uint32_t offset);
 std::vector<std::filesystem::directory_entry> getRecursiveEntries(const std::filesystem::path baseDir);
+// Matches '*' within a path segment, '**' across segments and '?' as any single character
+bool globMatch(const std::string& pattern, const std::string& text);
+// Sibling of path that no other thread or process writes to, for files that are renamed into place
+std::filesystem::path tempPathFor(const std::filesystem::path& path);
+
+struct CacheEntry {
+    const uint8_t* header;
+    const uint8_t* data;
+    size_t size;
+};
+
+// Writes a cache entry through a temp file renamed over path, so an interrupted run never leaves a truncated one behind
+bool writeCacheEntry(const std::filesystem::path& path, const char* magic, const void* header, size_t headerSize, const uint8_t* data, size_t size);
+// Checks the magic, size and CRC64 of an entry read or mapped from disk, nullopt when it is stale or damaged
+std::optional<CacheEntry> readCacheEntry(const uint8_t* entry, size_t length, const char* magic, size_t headerSize);
+// Marks an entry as used, called on every hit so eviction drops the ones that stopped being used first
+void touchCacheEntry(const std::filesystem::path& path);
+// Deletes the least recently used entries of every cache under directory until together they fit in limit bytes
+void evictCache(const std::filesystem::path& directory, uintmax_t limit);
 
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Checks the n64graphics raw <-> intermediate conversions against the ones from before the SSE2 kernels, bit
+// for bit, on random images of odd and even sizes. Built once with the kernels and once with N64GRAPHICS_NO_SIMD.
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+extern "C" {
+#include "n64graphics.h"
+}
+#include "reference/conversions.h"
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        std::printf(__VA_ARGS__); \
+        std::printf("\n"); \
+        sFailures++; \
+    } \
+} while(0)
+
+using Bytes = std::vector<uint8_t>;
+
+static std::mt19937 sRng(0x4E363447);
+
+static Bytes Random(const size_t size) {
+    Bytes data(size);
+    for(auto& byte : data) {
+        byte = sRng();
+    }
+    return data;
+}
+
+static size_t RawSize(const int count, const int depth) {
+    return ((size_t) count * depth + 7) / 8;
+}
+
+static bool Same(const void* a, const void* b, const size_t size) {
+    return std::memcmp(a, b, size) == 0;
+}
+
+template<typename T, typename Alloc, typename RefAlloc, typename Into>
+static void CheckToImage(const char* name, const int width, const int height, const int depth, Alloc alloc, RefAlloc ref, Into into) {
+    const int count = width * height;
+    const auto raw = Random(RawSize(count, depth));
+
+    // The previous decoders could read up to a pixel per byte past the data, so theirs gets a padded copy
+    auto padded = raw;
+    padded.resize(count * 4 + 16);
+
+    T* expected = ref(padded.data(), width, height, depth);
+    T* actual = alloc(raw.data(), width, height, depth);
+    std::vector<T> written(count);
+    const int result = into(written.data(), raw.data(), width, height, depth);
+
+    CHECK(Same(expected, actual, count * sizeof(T)), "%s%d %dx%d differs", name, depth, width, height);
+    CHECK(result == 0 && Same(expected, written.data(), count * sizeof(T)), "%s%d %dx%d (into) differs", name, depth, width, height);
+
+    std::free(expected);
+    std::free(actual);
+}
+
+template<typename T, typename Fill, typename Convert, typename RefConvert>
+static void CheckToRaw(const char* name, const int width, const int height, const int depth, Fill fill, Convert convert, RefConvert ref) {
+    const int count = width * height;
+    std::vector<T> img(count + 1);
+    for(auto& pixel : img) {
+        fill(pixel);
+    }
+
+    // IA4, IA1 and I4 keep the bits of a partially written last byte, so both start from the same contents
+    const auto initial = Random(RawSize(count, depth));
+    auto expected = initial;
+    auto actual = initial;
+
+    const int expectedSize = ref(expected.data(), img.data(), width, height, depth);
+    const int actualSize = convert(actual.data(), img.data(), width, height, depth);
+
+    CHECK(expectedSize == actualSize && expected == actual, "%s%d %dx%d differs", name, depth, width, height);
+}
+
+static void CheckCI4OddWidth(const int width, const int height) {
+    const int count = width * height;
+    std::vector<ci> img(count + 1);
+    for(auto& pixel : img) {
+        pixel.index = sRng() & 0xF;
+    }
+
+    // The previous code read img[count] for the low nibble of the last byte, it is 0 now whatever follows the image
+    img[count].index = 0xF;
+    Bytes previous(RawSize(count, 4)), current(RawSize(count, 4));
+    ref_ci2raw_torch(previous.data(), img.data(), width, height, 4);
+    ci2raw_torch(current.data(), img.data(), width, height, 4);
+
+    CHECK((previous.back() & 0xF) == 0xF && (current.back() & 0xF) == 0, "CI4 %dx%d last nibble is %X", width, height, current.back() & 0xF);
+    previous.back() &= 0xF0;
+    CHECK(previous == current, "CI4 %dx%d differs before the last nibble", width, height);
+}
+
+int main() {
+    const int widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65 };
+    const int heights[] = { 1, 2, 3, 7, 32 };
+
+    const auto rgba = [](::rgba& pixel) { pixel = { (uint8_t) sRng(), (uint8_t) sRng(), (uint8_t) sRng(), (uint8_t) (sRng() % 3 ? sRng() : 0) }; };
+    const auto ia = [](::ia& pixel) { pixel = { (uint8_t) sRng(), (uint8_t) (sRng() % 3 ? sRng() : 0) }; };
+    const auto ci4 = [](::ci& pixel) { pixel.index = sRng() & 0xF; };
+    const auto ci8 = [](::ci& pixel) { pixel.index = sRng(); };
+
+    for(const auto width : widths) {
+        for(const auto height : heights) {
+            for(const auto depth : { 16, 32 }) {
+                CheckToImage<::rgba>("RGBA", width, height, depth, raw2rgba, ref_raw2rgba, raw2rgba_into);
+                CheckToRaw<::rgba>("RGBA", width, height, depth, rgba, rgba2raw, ref_rgba2raw);
+            }
+            for(const auto depth : { 1, 4, 8, 16 }) {
+                CheckToImage<::ia>("IA", width, height, depth, raw2ia, ref_raw2ia, raw2ia_into);
+                CheckToRaw<::ia>("IA", width, height, depth, ia, ia2raw, ref_ia2raw);
+            }
+            for(const auto depth : { 4, 8 }) {
+                CheckToImage<::ia>("I", width, height, depth, raw2i, ref_raw2i, raw2i_into);
+                CheckToRaw<::ia>("I", width, height, depth, ia, i2raw, ref_i2raw);
+                CheckToImage<::ci>("CI", width, height, depth, raw2ci_torch, ref_raw2ci_torch, raw2ci_torch_into);
+            }
+
+            CheckToRaw<::ci>("CI", width, height, 8, ci8, ci2raw_torch, ref_ci2raw_torch);
+            if(width % 2 == 0) {
+                CheckToRaw<::ci>("CI", width, height, 4, ci4, ci2raw_torch, ref_ci2raw_torch);
+            } else {
+                CheckCI4OddWidth(width, height);
+            }
+
+            for(const auto depth : { 4, 8 }) {
+                const int count = width * height;
+                const auto rawci = Random(RawSize(count, depth));
+                const auto palette = Random(512);
+
+                auto padded = rawci;
+                padded.resize(count + 16);
+
+                uint8_t* expected = ref_ci2raw(padded.data(), palette.data(), width, height, depth);
+                uint8_t* actual = ci2raw(rawci.data(), palette.data(), width, height, depth);
+                Bytes written(count * 2);
+                ci2raw_into(written.data(), rawci.data(), palette.data(), width, height, depth);
+
+                CHECK(Same(expected, actual, count * 2) && Same(expected, written.data(), count * 2), "CI%d palette lookup %dx%d differs", depth, width, height);
+                std::free(expected);
+                std::free(actual);
+            }
+        }
+    }
+
+    if(sFailures) {
+        std::printf("%d checks failed\n", sFailures);
+        return 1;
+    }
+
+    std::printf("All conversion checks passed\n");
+    return 0;
+}
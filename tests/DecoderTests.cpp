@@ -0,0 +1,262 @@
+// Checks the bounded MIO0, Yay0, Yay1 and Yaz0 decoders against the previous ones and against truncated
+// and corrupted streams, and the original effort MIO0 encoder against the previous one. Build with
+// ENABLE_ASAN to have out of bounds reads reported as well.
+#include <memory>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+extern "C" {
+#include <libmio0/mio0.h>
+#include <libyay0/yay0.h>
+#include <libyay0/yay1.h>
+#include <libyaz0/yaz0.h>
+}
+#include "reference/decoders.h"
+#include "reference/encoders.h"
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        std::printf(__VA_ARGS__); \
+        std::printf("\n"); \
+        sFailures++; \
+    } \
+} while(0)
+
+using Bytes = std::vector<uint8_t>;
+
+struct Codec {
+    const char* name;
+    std::function<int32_t(const Bytes&, lz_effort, uint8_t*)> encode;
+    // Returns false when the decoder rejects the stream
+    std::function<bool(const uint8_t*, uint32_t, Bytes&)> decode;
+    // Decoder from before the rewrite, nullptr when the format did not have one
+    std::function<Bytes(const uint8_t*)> reference;
+};
+
+static bool FromMalloc(uint8_t* data, const uint32_t size, Bytes& out) {
+    if(data == nullptr) {
+        return false;
+    }
+    out.assign(data, data + size);
+    std::free(data);
+    return true;
+}
+
+static const Codec sCodecs[] = {
+    {
+        "MIO0",
+        [](const Bytes& in, lz_effort effort, uint8_t* out) { return (int32_t) mio0_encode_effort(in.data(), in.size(), out, effort); },
+        [](const uint8_t* in, uint32_t size, Bytes& out) {
+            mio0_header_t head;
+            if(size < MIO0_HEADER_LENGTH || !mio0_decode_header(in, &head)) {
+                return false;
+            }
+            out.resize(head.dest_size);
+            const int written = mio0_decode(in, size, out.data(), nullptr);
+            return written >= 0 && (uint32_t) written == head.dest_size;
+        },
+        [](const uint8_t* in) {
+            mio0_header_t head;
+            mio0_decode_header(in, &head);
+            Bytes out(head.dest_size);
+            ref_mio0_decode(in, out.data(), nullptr);
+            return out;
+        },
+    },
+    {
+        "Yay0",
+        [](const Bytes& in, lz_effort effort, uint8_t* out) { return yay0_encode_effort(in.data(), in.size(), out, effort); },
+        [](const uint8_t* in, uint32_t size, Bytes& out) {
+            uint32_t decoded = 0;
+            uint8_t* data = yay0_decode(in, size, &decoded);
+            return FromMalloc(data, decoded, out);
+        },
+        [](const uint8_t* in) {
+            uint32_t decoded = 0;
+            Bytes out;
+            uint8_t* data = ref_yay0_decode(in, &decoded);
+            FromMalloc(data, decoded, out);
+            return out;
+        },
+    },
+    {
+        "Yay1",
+        [](const Bytes& in, lz_effort effort, uint8_t* out) { return yay1_encode_effort(in.data(), in.size(), out, effort); },
+        [](const uint8_t* in, uint32_t size, Bytes& out) {
+            uint32_t decoded = 0;
+            uint8_t* data = yay1_decode(in, size, &decoded);
+            return FromMalloc(data, decoded, out);
+        },
+        [](const uint8_t* in) {
+            uint32_t decoded = 0;
+            Bytes out;
+            uint8_t* data = ref_yay1_decode(in, &decoded);
+            FromMalloc(data, decoded, out);
+            return out;
+        },
+    },
+    {
+        "Yaz0",
+        [](const Bytes& in, lz_effort effort, uint8_t* out) { return yaz0_encode_effort(in.data(), in.size(), out, effort); },
+        [](const uint8_t* in, uint32_t size, Bytes& out) {
+            uint32_t decoded = 0;
+            uint8_t* data = yaz0_decode(in, size, &decoded);
+            return FromMalloc(data, decoded, out);
+        },
+        nullptr,
+    },
+};
+
+static std::vector<Bytes> GenerateSamples(std::mt19937& rng) {
+    std::vector<Bytes> samples;
+    const size_t sizes[] = { 0, 1, 2, 3, 17, 18, 19, 273, 4095, 4096, 4097, 20000 };
+
+    for(const auto size : sizes) {
+        // Noise, long runs, short repeating patterns and a small alphabet, so literals, short and long matches all show up
+        Bytes noise(size), runs(size), pattern(size), alphabet(size);
+        for(size_t i = 0; i < size; i++) {
+            noise[i] = rng();
+            runs[i] = (i / 300) & 0xFF;
+            pattern[i] = "torch decodes"[i % 13];
+            alphabet[i] = rng() % 4;
+        }
+        samples.push_back(std::move(noise));
+        samples.push_back(std::move(runs));
+        samples.push_back(std::move(pattern));
+        samples.push_back(std::move(alphabet));
+    }
+
+    // Texture-like data, rows that mostly repeat the one above them
+    Bytes image(64 * 64 * 2);
+    for(size_t i = 0; i < image.size(); i++) {
+        image[i] = i < 128 || rng() % 8 == 0 ? rng() : image[i - 128];
+    }
+    samples.push_back(std::move(image));
+    return samples;
+}
+
+// Copies data into an allocation of exactly size bytes, so the sanitizer sees any read past the end
+static std::unique_ptr<uint8_t[]> Exact(const uint8_t* data, const size_t size) {
+    std::unique_ptr<uint8_t[]> copy(new uint8_t[std::max<size_t>(size, 1)]);
+    std::memcpy(copy.get(), data, size);
+    return copy;
+}
+
+static void TestCodec(const Codec& codec, const std::vector<Bytes>& samples, std::mt19937& rng) {
+    const lz_effort efforts[] = { LZ_EFFORT_ORIGINAL, LZ_EFFORT_FAST, LZ_EFFORT_BEST };
+
+    for(size_t s = 0; s < samples.size(); s++) {
+        const auto& sample = samples[s];
+
+        for(const auto effort : efforts) {
+            Bytes encoded(16 + (sample.size() + 7) / 8 + 3 + sample.size() + 16);
+            const int32_t size = codec.encode(sample, effort, encoded.data());
+            CHECK(size > 0, "%s sample %zu: encode failed", codec.name, s);
+            if(size <= 0) {
+                continue;
+            }
+            encoded.resize(size);
+
+            Bytes decoded;
+            const auto stream = Exact(encoded.data(), encoded.size());
+            CHECK(codec.decode(stream.get(), size, decoded) && decoded == sample, "%s sample %zu effort %d: round trip differs", codec.name, s, effort);
+
+            if(codec.reference) {
+                CHECK(codec.reference(encoded.data()) == decoded, "%s sample %zu effort %d: differs from the previous decoder", codec.name, s, effort);
+            }
+
+            // Every cut of a short stream, a few random ones of a long one. A cut stream either fails or was cut
+            // in trailing padding and still decodes to the same data.
+            std::vector<uint32_t> cuts;
+            for(uint32_t cut = 0; cut < (uint32_t) size && cut < 96; cut++) {
+                cuts.push_back(cut);
+            }
+            for(int i = 0; i < 32 && size > 96; i++) {
+                cuts.push_back(96 + rng() % (size - 96));
+            }
+
+            for(const auto cut : cuts) {
+                Bytes truncated;
+                const auto prefix = Exact(encoded.data(), cut);
+                if(codec.decode(prefix.get(), cut, truncated)) {
+                    CHECK(truncated == sample, "%s sample %zu: stream cut at %u decoded to different data", codec.name, s, cut);
+                }
+            }
+
+            // Flipped bytes past the declared size, which would only make the decoders allocate more, must never
+            // crash or read out of bounds
+            for(int i = 0; i < 64 && size > 8; i++) {
+                auto corrupt = encoded;
+                const auto count = 1 + rng() % 4;
+                for(uint32_t j = 0; j < count; j++) {
+                    corrupt[8 + rng() % (size - 8)] ^= 1 << (rng() % 8);
+                }
+
+                Bytes garbage;
+                const auto copy = Exact(corrupt.data(), corrupt.size());
+                codec.decode(copy.get(), size, garbage);
+            }
+        }
+    }
+}
+
+// SM64 builds rely on LZ_EFFORT_ORIGINAL to give the same MIO0 blocks as before, so it has to match the old encoder byte for byte
+static void TestOriginalMio0(const std::vector<Bytes>& samples) {
+    for(size_t s = 0; s < samples.size(); s++) {
+        const auto& sample = samples[s];
+        // The old encoder reads its first byte unconditionally
+        if(sample.empty()) {
+            continue;
+        }
+
+        const size_t capacity = 16 + (sample.size() + 7) / 8 + 3 + sample.size() + 16;
+        Bytes padded(sample);
+        padded.push_back(0);
+        Bytes expected(capacity);
+        Bytes actual(capacity);
+        expected.resize(ref_mio0_encode(padded.data(), sample.size(), expected.data()));
+        actual.resize(mio0_encode_effort(sample.data(), sample.size(), actual.data(), LZ_EFFORT_ORIGINAL));
+        CHECK(actual == expected, "MIO0 sample %zu: original effort differs from the previous encoder", s);
+    }
+}
+
+int main() {
+    std::mt19937 rng(0x70524348);
+    const auto samples = GenerateSamples(rng);
+
+    for(const auto& codec : sCodecs) {
+        TestCodec(codec, samples, rng);
+    }
+    TestOriginalMio0(samples);
+
+    // Yay0 blocks can sit behind a PERS-SZP header, whose size has to stay within the stream as well
+    const Bytes sample(500, 0x42);
+    Bytes yay0(16 + 500 / 8 + 3 + 500 + 16);
+    yay0.resize(yay0_encode(sample.data(), sample.size(), yay0.data()));
+
+    Bytes pers = { 'P', 'E', 'R', 'S', '-', 'S', 'Z', 'P', 0, 0, 0, 16, 0, 0, 0, 0 };
+    pers.insert(pers.end(), yay0.begin(), yay0.end());
+    Bytes decoded;
+    CHECK(sCodecs[1].decode(pers.data(), pers.size(), decoded) && decoded == sample, "PERS-SZP Yay0 did not decode");
+
+    pers[11] = 0xFF;
+    const auto broken = Exact(pers.data(), pers.size());
+    CHECK(!sCodecs[1].decode(broken.get(), pers.size(), decoded), "PERS-SZP header past the stream was accepted");
+
+    if(sFailures) {
+        std::printf("%d checks failed\n", sFailures);
+        return 1;
+    }
+
+    std::printf("All decoder checks passed\n");
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Checks the slicing-by-8 CRC64 against the previous byte at a time one, on random buffers of every
+// length and alignment around the 8 byte steps and on asset paths like the ones the exporters hash.
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include <strhash64/StrHash64.h>
+#include "reference/crc64.h"
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        std::printf(__VA_ARGS__); \
+        std::printf("\n"); \
+        sFailures++; \
+    } \
+} while(0)
+
+static void TestBuffers(std::mt19937& rng) {
+    std::vector<uint8_t> data(4096 + 8);
+    for(auto& byte : data) {
+        byte = rng();
+    }
+
+    for(uint32_t len = 0; len <= 300; len++) {
+        for(uint32_t align = 0; align < 8; align++) {
+            const uint8_t* buf = data.data() + align;
+            CHECK(crc64(buf, len) == ref_update_crc64(buf, len, INITIAL_CRC64), "crc64 differs at length %u, alignment %u", len, align);
+        }
+    }
+
+    CHECK(crc64(data.data(), 4096) == ref_update_crc64(data.data(), 4096, INITIAL_CRC64), "crc64 differs on 4096 bytes");
+
+    // Chained updates have to carry the running value the same way
+    for(int i = 0; i < 64; i++) {
+        const uint32_t len = rng() % 64;
+        const uint64_t seed = ((uint64_t) rng() << 32) | rng();
+        CHECK(update_crc64(data.data(), len, seed) == ref_update_crc64(data.data(), len, seed), "update_crc64 differs with seed 0x%llx", (unsigned long long) seed);
+    }
+}
+
+static void TestStrings(std::mt19937& rng) {
+    std::vector<std::string> paths = {
+        "",
+        "a",
+        "objects/mario/mario_seg4_dl_0403D9C8",
+        "levels/castle_inside/areas/1/geo",
+        "assets/yaml/us/textures/common/gTextureDigit0",
+        "__OTR__objects/gameplay_keep/gEffBubble1Tex",
+    };
+
+    for(int i = 0; i < 256; i++) {
+        std::string path;
+        const auto len = rng() % 160;
+        for(uint32_t j = 0; j < len; j++) {
+            // Anything but the terminator, including bytes with the top bit set
+            path += (char) (1 + rng() % 255);
+        }
+        paths.push_back(path);
+    }
+
+    for(const auto& path : paths) {
+        const auto expected = ref_CRC64(path.c_str());
+        CHECK(CRC64(path.c_str()) == expected, "CRC64 differs for \"%s\"", path.c_str());
+        CHECK(CRC64N(path.c_str(), path.size()) == expected, "CRC64N differs for \"%s\"", path.c_str());
+    }
+}
+
+int main() {
+    std::mt19937 rng(0x43524336);
+
+    TestBuffers(rng);
+    TestStrings(rng);
+
+    if(sFailures) {
+        std::printf("%d checks failed\n", sFailures);
+        return 1;
+    }
+
+    std::printf("All hash checks passed\n");
+    return 0;
+}
@@ -0,0 +1,336 @@
+// Checks the bkzip inflate decoder against miniz's tinfl on stored, fixed and dynamic Huffman blocks and bkzip wrapped
+// assets, and against the zlib inflate it replaced on truncated, corrupted and hand-built invalid streams. Build with
+// ENABLE_ASAN to have out of bounds reads reported as well.
+#include <memory>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include <miniz/zip_file.hpp>
+#include <bk_zip/bk_inflate.h>
+#include <bk_zip/bk_unzip.h>
+#include "reference/inflate.h"
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        std::printf(__VA_ARGS__); \
+        std::printf("\n"); \
+        sFailures++; \
+    } \
+} while(0)
+
+using Bytes = std::vector<uint8_t>;
+
+struct Mode {
+    const char* name;
+    int flags;
+};
+
+// Probe counts as in miniz's levels 1, 6 and 10, plus the two block types it only writes when forced to
+static const Mode sModes[] = {
+    { "stored", TDEFL_FORCE_ALL_RAW_BLOCKS },
+    { "fixed", (int) TDEFL_DEFAULT_MAX_PROBES | TDEFL_FORCE_ALL_STATIC_BLOCKS },
+    { "dynamic", TDEFL_DEFAULT_MAX_PROBES },
+    { "greedy", 1 | TDEFL_GREEDY_PARSING_FLAG },
+    { "huffman only", TDEFL_HUFFMAN_ONLY },
+    { "best", TDEFL_MAX_PROBES_MASK },
+};
+
+static std::vector<Bytes> GenerateSamples(std::mt19937& rng) {
+    std::vector<Bytes> samples;
+    const size_t sizes[] = { 0, 1, 2, 3, 258, 259, 4095, 32768, 32769, 70000 };
+
+    for(const auto size : sizes) {
+        // Noise, long runs, short repeating patterns and a small alphabet, so literals, short and long matches all show up
+        Bytes noise(size), runs(size), pattern(size), alphabet(size);
+        for(size_t i = 0; i < size; i++) {
+            noise[i] = rng();
+            runs[i] = (i / 300) & 0xFF;
+            pattern[i] = "torch inflates"[i % 14];
+            alphabet[i] = rng() % 4;
+        }
+        samples.push_back(std::move(noise));
+        samples.push_back(std::move(runs));
+        samples.push_back(std::move(pattern));
+        samples.push_back(std::move(alphabet));
+    }
+
+    // Texture-like data, rows that mostly repeat the one above them
+    Bytes image(64 * 64 * 2);
+    for(size_t i = 0; i < image.size(); i++) {
+        image[i] = i < 128 || rng() % 8 == 0 ? rng() : image[i - 128];
+    }
+    samples.push_back(std::move(image));
+
+    // Model-like data, big endian vertices on a small grid with repeated texture coordinates and colors
+    Bytes vertices(4000 * 16);
+    for(size_t i = 0; i < vertices.size(); i += 16) {
+        const int16_t fields[8] = {
+            (int16_t) (rng() % 64 * 16), (int16_t) (rng() % 8 * 64), (int16_t) (rng() % 64 * 16), 0,
+            (int16_t) (rng() % 4 << 10), (int16_t) (rng() % 4 << 10), (int16_t) 0xFFFF, (int16_t) (rng() % 2 ? 0xFFFF : 0x80FF)
+        };
+        for(size_t j = 0; j < 8; j++) {
+            vertices[i + j * 2] = fields[j] >> 8;
+            vertices[i + j * 2 + 1] = fields[j];
+        }
+    }
+    samples.push_back(std::move(vertices));
+    return samples;
+}
+
+// Copies data into an allocation of exactly size bytes, so the sanitizer sees any read past the end
+static std::unique_ptr<uint8_t[]> Exact(const uint8_t* data, const size_t size) {
+    std::unique_ptr<uint8_t[]> copy(new uint8_t[std::max<size_t>(size, 1)]);
+    std::memcpy(copy.get(), data, size);
+    return copy;
+}
+
+static Bytes Deflate(const Bytes& sample, const int flags) {
+    // Stored blocks add five bytes for every 64KB or less, the others never grow by more than that either
+    Bytes out(sample.size() + sample.size() / 16 + 64);
+    out.resize(tdefl_compress_mem_to_mem(out.data(), out.size(), sample.data(), sample.size(), flags));
+    return out;
+}
+
+// Decodes into an allocation of exactly size bytes as well, returns false when the stream is rejected
+static bool Inflate(const uint8_t* in, const uint32_t size, const uint32_t out_size, Bytes& out) {
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[std::max<uint32_t>(out_size, 1)]);
+    const int64_t written = BK64::bk_inflate(in, size, buffer.get(), out_size);
+    if(written < 0) {
+        return false;
+    }
+    out.assign(buffer.get(), buffer.get() + written);
+    return true;
+}
+
+static bool Tinfl(const uint8_t* in, const uint32_t size, const uint32_t out_size, Bytes& out) {
+    out.resize(out_size);
+    const size_t written = tinfl_decompress_mem_to_mem(out.data(), out.size(), in, size, 0);
+    if(written == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED) {
+        return false;
+    }
+    out.resize(written);
+    return true;
+}
+
+// zlib only passes streams that fill the whole output, tinfl can't stand in for it on broken streams since it reads
+// zeros past the end of the input and takes the unused distance codes
+static bool Zlib(const uint8_t* in, const uint32_t size, const uint32_t out_size, Bytes& out) {
+    out.resize(std::max<uint32_t>(out_size, 1));
+    const bool valid = ref_bk_inflate(in, size, out.data(), out_size);
+    out.resize(out_size);
+    return valid;
+}
+
+// The same checks bk_unzip makes on top of bk_inflate
+static bool Complete(const uint8_t* in, const uint32_t size, const uint32_t out_size, Bytes& out) {
+    return Inflate(in, size, out_size, out) && out.size() == out_size;
+}
+
+static void TestMode(const Mode& mode, const std::vector<Bytes>& samples, std::mt19937& rng) {
+    for(size_t s = 0; s < samples.size(); s++) {
+        const auto& sample = samples[s];
+        const auto encoded = Deflate(sample, mode.flags);
+        CHECK(!encoded.empty(), "%s sample %zu: deflate failed", mode.name, s);
+        if(encoded.empty()) {
+            continue;
+        }
+
+        const uint32_t size = encoded.size();
+        const auto stream = Exact(encoded.data(), size);
+        Bytes decoded;
+        Bytes expected;
+        CHECK(Inflate(stream.get(), size, sample.size(), decoded) && decoded == sample, "%s sample %zu: round trip differs", mode.name, s);
+        CHECK(Tinfl(encoded.data(), size, sample.size(), expected) && decoded == expected, "%s sample %zu: differs from tinfl", mode.name, s);
+
+        // An output buffer one byte short has to be rejected instead of written past
+        if(!sample.empty()) {
+            CHECK(!Inflate(stream.get(), size, sample.size() - 1, decoded), "%s sample %zu: overflowing output was accepted", mode.name, s);
+        }
+
+        // Every cut of a short stream, a few random ones of a long one. A cut stream either fails or was only cut
+        // after the last byte of output, which zlib accepts as well
+        std::vector<uint32_t> cuts;
+        for(uint32_t cut = 0; cut < size && cut < 96; cut++) {
+            cuts.push_back(cut);
+        }
+        for(int i = 0; i < 32 && size > 96; i++) {
+            cuts.push_back(96 + rng() % (size - 96));
+        }
+
+        for(const auto cut : cuts) {
+            Bytes truncated;
+            const auto prefix = Exact(encoded.data(), cut);
+            if(Inflate(prefix.get(), cut, sample.size(), truncated)) {
+                CHECK(truncated == sample, "%s sample %zu: stream cut at %u decoded to different data", mode.name, s, cut);
+            }
+            CHECK(Complete(prefix.get(), cut, sample.size(), truncated) == Zlib(prefix.get(), cut, sample.size(), truncated),
+                  "%s sample %zu: stream cut at %u is not taken like zlib does", mode.name, s, cut);
+        }
+
+        // Flipped bits must never crash or read out of bounds, and what is accepted has to be accepted by zlib too. It
+        // is stricter than zlib only on streams that decode past the output, which zlib cuts short once it has read
+        // all of the input
+        for(int i = 0; i < 64 && size > 1; i++) {
+            auto corrupt = encoded;
+            const auto count = 1 + rng() % 4;
+            for(uint32_t j = 0; j < count; j++) {
+                corrupt[rng() % size] ^= 1 << (rng() % 8);
+            }
+
+            Bytes garbage;
+            Bytes reference;
+            const auto copy = Exact(corrupt.data(), size);
+            const bool valid = Complete(copy.get(), size, sample.size(), garbage);
+            const bool expected = Zlib(corrupt.data(), size, sample.size(), reference);
+            CHECK(!valid || (expected && garbage == reference), "%s sample %zu: corrupt stream %d was accepted, zlib rejects it", mode.name, s, i);
+        }
+    }
+}
+
+// Assets are stored as 0x11 0x72, the big endian decompressed size, then the raw deflate stream
+static void TestBkzip(const std::vector<Bytes>& samples) {
+    for(size_t s = 0; s < samples.size(); s++) {
+        const auto& sample = samples[s];
+        const auto encoded = Deflate(sample, TDEFL_MAX_PROBES_MASK);
+        const uint32_t length = sample.size();
+
+        Bytes asset = { 0x11, 0x72, (uint8_t) (length >> 24), (uint8_t) (length >> 16), (uint8_t) (length >> 8), (uint8_t) length };
+        asset.insert(asset.end(), encoded.begin(), encoded.end());
+
+        uint32_t size = asset.size();
+        const auto copy = Exact(asset.data(), size);
+        uint8_t* out = nullptr;
+        try {
+            out = BK64::bk_unzip(copy.get(), &size);
+        } catch(const std::runtime_error&) {
+        }
+        CHECK(out != nullptr && size == length && std::memcmp(out, sample.data(), length) == 0, "bkzip sample %zu: differs", s);
+        std::free(out);
+
+        // A header claiming more than the stream holds fails instead of handing back a partly filled buffer
+        asset[5]++;
+        size = asset.size();
+        const auto longer = Exact(asset.data(), size);
+        bool threw = false;
+        try {
+            std::free(BK64::bk_unzip(longer.get(), &size));
+        } catch(const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw, "bkzip sample %zu: size past the stream was accepted", s);
+    }
+}
+
+// Writes deflate bits, least significant first, and Huffman codes, most significant first
+struct BitWriter {
+    Bytes out;
+    uint32_t used = 0;
+
+    BitWriter& Put(const uint32_t value, const uint32_t n) {
+        for(uint32_t i = 0; i < n; i++, used++) {
+            if(used % 8 == 0) {
+                out.push_back(0);
+            }
+            out.back() |= ((value >> i) & 1) << (used % 8);
+        }
+        return *this;
+    }
+
+    BitWriter& Code(const uint32_t code, const uint32_t n) {
+        for(uint32_t i = n; i > 0; i--) {
+            Put(code >> (i - 1), 1);
+        }
+        return *this;
+    }
+};
+
+// Streams tdefl never writes, each has to be rejected
+static void TestInvalid() {
+    std::vector<std::pair<const char*, Bytes>> streams;
+
+    // Final block with the reserved type 3
+    streams.emplace_back("reserved block type", BitWriter().Put(1, 1).Put(3, 2).out);
+
+    // Stored block whose length and complement disagree, then one that is longer than the input
+    streams.emplace_back("stored complement", Bytes { 0x01, 0x04, 0x00, 0xFA, 0xFF, 'b', 'k', '6', '4' });
+    streams.emplace_back("stored length", Bytes { 0x01, 0x05, 0x00, 0xFA, 0xFF, 'b', 'k', '6', '4' });
+
+    // Fixed block with a literal, then a length 3 match at distance 2, which is before the start of the output
+    streams.emplace_back("distance past start", BitWriter().Put(1, 1).Put(1, 2).Code(0x30 + 'a', 8).Code(1, 7).Code(1, 5).Code(0, 7).out);
+
+    // Fixed block with a literal, then a match using distance code 30, which only exists to complete the code
+    streams.emplace_back("distance code 30", BitWriter().Put(1, 1).Put(1, 2).Code(0x30 + 'a', 8).Code(1, 7).Code(30, 5).Code(0, 7).out);
+
+    // Fixed block that ends without an end of block code
+    streams.emplace_back("missing end", BitWriter().Put(1, 1).Put(1, 2).Code(0x30 + 'a', 8).out);
+
+    // Dynamic block whose code length code gives three symbols a one bit code
+    streams.emplace_back("over-subscribed", BitWriter().Put(1, 1).Put(2, 2).Put(0, 5).Put(0, 5).Put(0, 4).Put(1, 3).Put(1, 3).Put(1, 3).Put(0, 3).out);
+
+    // Dynamic block that starts by repeating the previous length, of which there is none
+    streams.emplace_back("repeat first", BitWriter().Put(1, 1).Put(2, 2).Put(0, 5).Put(0, 5).Put(0, 4).Put(1, 3).Put(0, 3).Put(0, 3).Put(1, 3).Code(1, 1).Put(0, 2).out);
+
+    // Dynamic block writing 'a' with one bit codes for 'a' and the end of block, the distance lengths are given as
+    // code length symbols
+    const auto dynamic = [](const uint32_t first, const uint32_t second) {
+        BitWriter writer;
+        writer.Put(1, 1).Put(2, 2).Put(0, 5).Put(1, 5).Put(14, 4);
+        // Two bit codes for the code lengths 0, 1, 2 and 18, in the order the lengths are sent
+        const uint32_t lengths[18] = { 0, 0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2 };
+        for(const auto length : lengths) {
+            writer.Put(length, 3);
+        }
+        // 97 zeros, 1 for 'a', 158 zeros, 1 for the end of block, then the two distance lengths
+        writer.Code(3, 2).Put(86, 7).Code(1, 2).Code(3, 2).Put(127, 7).Code(3, 2).Put(9, 7).Code(1, 2);
+        writer.Code(first, 2).Code(second, 2);
+        return writer.Code(0, 1).Code(1, 1).out;
+    };
+    streams.emplace_back("incomplete distances", dynamic(2, 0));
+
+    for(const auto& [name, stream] : streams) {
+        Bytes out;
+        const auto copy = Exact(stream.data(), stream.size());
+        CHECK(!Inflate(copy.get(), stream.size(), 64, out), "%s: invalid stream was accepted", name);
+        CHECK(!Zlib(stream.data(), stream.size(), 64, out), "%s: zlib accepted it, the stream is not built right", name);
+    }
+
+    // The same literal and match at distance 1 is valid, so the streams above fail for the reason given
+    const auto valid = BitWriter().Put(1, 1).Put(1, 2).Code(0x30 + 'a', 8).Code(1, 7).Code(0, 5).Code(0, 7).out;
+    Bytes out;
+    CHECK(Complete(valid.data(), valid.size(), 4, out) && out == Bytes(4, 'a'), "valid fixed block did not decode");
+    CHECK(Zlib(valid.data(), valid.size(), 4, out) && out == Bytes(4, 'a'), "valid fixed block did not decode with zlib");
+
+    // Complete distance codes, and a lone one bit code which zlib takes as well
+    for(const auto& stream : { dynamic(1, 1), dynamic(1, 0) }) {
+        CHECK(Complete(stream.data(), stream.size(), 1, out) && out == Bytes(1, 'a'), "valid dynamic block did not decode");
+        CHECK(Zlib(stream.data(), stream.size(), 1, out) && out == Bytes(1, 'a'), "valid dynamic block did not decode with zlib");
+    }
+}
+
+int main() {
+    std::mt19937 rng(0x70524348);
+    const auto samples = GenerateSamples(rng);
+
+    for(const auto& mode : sModes) {
+        TestMode(mode, samples, rng);
+    }
+    TestBkzip(samples);
+    TestInvalid();
+
+    if(sFailures) {
+        std::printf("%d checks failed\n", sFailures);
+        return 1;
+    }
+
+    std::printf("All inflate checks passed\n");
+    return 0;
+}
@@ -0,0 +1,339 @@
+// The raw <-> intermediate conversions as they were before the SSE2 kernels, kept verbatim so the current ones
+// can be checked against them bit for bit.
+#include "n64graphics.h"
+#include "conversions.h"
+#include "libmio0/utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// SCALE_M_N: upscale/downscale M-bit integer to N-bit
+#define SCALE_5_8(VAL_) (((VAL_) * 0xFF) / 0x1F)
+#define SCALE_8_5(VAL_) ((((VAL_) + 4) * 0x1F) / 0xFF)
+#define SCALE_4_8(VAL_) ((VAL_) * 0x11)
+#define SCALE_8_4(VAL_) ((VAL_) / 0x11)
+#define SCALE_3_8(VAL_) ((VAL_) * 0x24)
+#define SCALE_8_3(VAL_) ((VAL_) / 0x24)
+
+rgba* ref_raw2rgba(const uint8_t* raw, int width, int height, int depth) {
+    rgba* img;
+    int img_size;
+
+    img_size = width * height * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %d bytes\n", img_size);
+        return NULL;
+    }
+
+    if (depth == 16) {
+        for (int i = 0; i < width * height; i++) {
+            img[i].red = SCALE_5_8((raw[i * 2] & 0xF8) >> 3);
+            img[i].green = SCALE_5_8(((raw[i * 2] & 0x07) << 2) | ((raw[i * 2 + 1] & 0xC0) >> 6));
+            img[i].blue = SCALE_5_8((raw[i * 2 + 1] & 0x3E) >> 1);
+            img[i].alpha = (raw[i * 2 + 1] & 0x01) ? 0xFF : 0x00;
+        }
+    } else if (depth == 32) {
+        for (int i = 0; i < width * height; i++) {
+            img[i].red = raw[i * 4];
+            img[i].green = raw[i * 4 + 1];
+            img[i].blue = raw[i * 4 + 2];
+            img[i].alpha = raw[i * 4 + 3];
+        }
+    }
+
+    return img;
+}
+
+ia* ref_raw2ia(const uint8_t* raw, int width, int height, int depth) {
+    ia* img;
+    int img_size;
+
+    img_size = width * height * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %u bytes\n", img_size);
+        return NULL;
+    }
+
+    switch (depth) {
+        case 16:
+            for (int i = 0; i < width * height; i++) {
+                img[i].intensity = raw[i * 2];
+                img[i].alpha = raw[i * 2 + 1];
+            }
+            break;
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                img[i].intensity = SCALE_4_8((raw[i] & 0xF0) >> 4);
+                img[i].alpha = SCALE_4_8(raw[i] & 0x0F);
+            }
+            break;
+        case 4:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t bits;
+                bits = raw[i / 2];
+                if (i % 2) {
+                    bits &= 0xF;
+                } else {
+                    bits >>= 4;
+                }
+                img[i].intensity = SCALE_3_8((bits >> 1) & 0x07);
+                img[i].alpha = (bits & 0x01) ? 0xFF : 0x00;
+            }
+            break;
+        case 1:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t bits;
+                uint8_t mask;
+                bits = raw[i / 8];
+                mask = 1 << (7 - (i % 8)); // MSb->LSb
+                bits = (bits & mask) ? 0xFF : 0x00;
+                img[i].intensity = bits;
+                img[i].alpha = bits;
+            }
+            break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+            break;
+    }
+
+    return img;
+}
+
+ci *ref_raw2ci_torch(const uint8_t* raw, int width, int height, int depth) {
+    ci *img = NULL;
+    int img_size;
+
+    img_size = width * height * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %u bytes\n", img_size);
+        return NULL;
+    }
+
+    switch (depth) {
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                img[i].index = raw[i];
+            }
+        break;
+        case 4:
+            for (int i = 0; i < width * height; i++) {
+                int pos = i / 2;
+                img[i].index = i % 2 ? raw[pos] & 0xF : raw[pos] >> 4;
+            }
+        break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+        break;
+    }
+
+    return img;
+}
+
+ia* ref_raw2i(const uint8_t* raw, int width, int height, int depth) {
+    ia* img = NULL;
+    int img_size;
+
+    img_size = width * height * sizeof(*img);
+    img = malloc(img_size);
+    if (!img) {
+        ERROR("Error allocating %u bytes\n", img_size);
+        return NULL;
+    }
+
+    switch (depth) {
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                img[i].intensity = raw[i];
+                img[i].alpha = 0xFF;
+            }
+            break;
+        case 4:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t bits;
+                bits = raw[i / 2];
+                if (i % 2) {
+                    bits &= 0xF;
+                } else {
+                    bits >>= 4;
+                }
+                img[i].intensity = SCALE_4_8(bits);
+                img[i].alpha = 0xFF;
+            }
+            break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+            break;
+    }
+
+    return img;
+}
+
+uint8_t* ref_ci2raw(const uint8_t* rawci, const uint8_t* palette, int width, int height, int ci_depth) {
+    uint8_t* raw;
+    int raw_size;
+
+    // first convert to raw RGBA
+    raw_size = sizeof(uint16_t) * width * height;
+    raw = malloc(raw_size);
+    if (!raw) {
+        ERROR("Error allocating %u bytes\n", raw_size);
+        return NULL;
+    }
+
+    for (int i = 0; i < width * height; i++) {
+        int pal_idx = rawci[i];
+        if (ci_depth == 4) {
+            int byte_idx = i / 2;
+            int nibble = 1 - (i % 2);
+            int shift = 4 * nibble;
+            pal_idx = (rawci[byte_idx] >> shift) & 0xF;
+        }
+        raw[2 * i] = palette[2 * pal_idx];
+        raw[2 * i + 1] = palette[2 * pal_idx + 1];
+    }
+
+    return raw;
+}
+
+int ref_rgba2raw(uint8_t* raw, const rgba* img, int width, int height, int depth) {
+    int size = width * height * depth / 8;
+    INFO("Converting RGBA%d %dx%d to raw\n", depth, width, height);
+
+    if (depth == 16) {
+        for (int i = 0; i < width * height; i++) {
+            uint8_t r, g, b, a;
+            r = SCALE_8_5(img[i].red);
+            g = SCALE_8_5(img[i].green);
+            b = SCALE_8_5(img[i].blue);
+            a = img[i].alpha ? 0x1 : 0x0;
+            raw[i * 2] = (r << 3) | (g >> 2);
+            raw[i * 2 + 1] = ((g & 0x3) << 6) | (b << 1) | a;
+        }
+    } else if (depth == 32) {
+        for (int i = 0; i < width * height; i++) {
+            raw[i * 4] = img[i].red;
+            raw[i * 4 + 1] = img[i].green;
+            raw[i * 4 + 2] = img[i].blue;
+            raw[i * 4 + 3] = img[i].alpha;
+        }
+    } else {
+        ERROR("Error invalid depth %d\n", depth);
+        size = -1;
+    }
+
+    return size;
+}
+
+int ref_ia2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
+    int size = width * height * depth / 8;
+    INFO("Converting IA%d %dx%d to raw\n", depth, width, height);
+
+    switch (depth) {
+        case 16:
+            for (int i = 0; i < width * height; i++) {
+                raw[i * 2] = img[i].intensity;
+                raw[i * 2 + 1] = img[i].alpha;
+            }
+            break;
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t val = SCALE_8_4(img[i].intensity);
+                uint8_t alpha = SCALE_8_4(img[i].alpha);
+                raw[i] = (val << 4) | alpha;
+            }
+            break;
+        case 4:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t val = SCALE_8_3(img[i].intensity);
+                uint8_t alpha = img[i].alpha ? 0x01 : 0x00;
+                uint8_t old = raw[i / 2];
+                if (i % 2) {
+                    raw[i / 2] = (old & 0xF0) | (val << 1) | alpha;
+                } else {
+                    raw[i / 2] = (old & 0x0F) | (((val << 1) | alpha) << 4);
+                }
+            }
+            break;
+        case 1:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t val = img[i].intensity;
+                uint8_t old = raw[i / 8];
+                uint8_t bit = 1 << (7 - (i % 8));
+                if (val) {
+                    raw[i / 8] = old | bit;
+                } else {
+                    raw[i / 8] = old & (~bit);
+                }
+            }
+            break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+            size = -1;
+            break;
+    }
+
+    return size;
+}
+
+int ref_i2raw(uint8_t* raw, const ia* img, int width, int height, int depth) {
+    int size = width * height * depth / 8;
+    INFO("Converting I%d %dx%d to raw\n", depth, width, height);
+
+    switch (depth) {
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                raw[i] = img[i].intensity;
+            }
+            break;
+        case 4:
+            for (int i = 0; i < width * height; i++) {
+                uint8_t val = SCALE_8_4(img[i].intensity);
+                uint8_t old = raw[i / 2];
+                if (i % 2) {
+                    raw[i / 2] = (old & 0xF0) | val;
+                } else {
+                    raw[i / 2] = (old & 0x0F) | (val << 4);
+                }
+            }
+            break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+            size = -1;
+            break;
+    }
+
+    return size;
+}
+
+int ref_ci2raw_torch(uint8_t *raw, const ci *img, int width, int height, int depth) {
+    int size = width * height * depth / 8;
+    INFO("Converting I%d %dx%d to raw\n", depth, width, height);
+
+    switch (depth) {
+        case 8:
+            for (int i = 0; i < width * height; i++) {
+                raw[i] = img[i].index;
+            }
+        break;
+        case 4:
+            for(int y = 0; y < height; y++) {
+                for(int x = 0; x < width; x += 2) {
+                    const size_t pos = (y * width + x) / 2;
+
+                    const uint8_t cR1 = img[y * width + x].index;
+                    const uint8_t cR2 = img[y * width + x + 1].index;
+
+                    raw[pos] = cR1 << 4 | cR2;
+                }
+            }
+        break;
+        default:
+            ERROR("Error invalid depth %d\n", depth);
+        size = -1;
+        break;
+    }
+
+    return size;
+}
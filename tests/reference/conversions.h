@@ -0,0 +1,21 @@
+#pragma once
+
+#include "n64graphics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+rgba* ref_raw2rgba(const uint8_t* raw, int width, int height, int depth);
+ia* ref_raw2ia(const uint8_t* raw, int width, int height, int depth);
+ci *ref_raw2ci_torch(const uint8_t* raw, int width, int height, int depth);
+ia* ref_raw2i(const uint8_t* raw, int width, int height, int depth);
+uint8_t* ref_ci2raw(const uint8_t* rawci, const uint8_t* palette, int width, int height, int ci_depth);
+int ref_rgba2raw(uint8_t* raw, const rgba* img, int width, int height, int depth);
+int ref_ia2raw(uint8_t* raw, const ia* img, int width, int height, int depth);
+int ref_i2raw(uint8_t* raw, const ia* img, int width, int height, int depth);
+int ref_ci2raw_torch(uint8_t *raw, const ci *img, int width, int height, int depth);
+
+#ifdef __cplusplus
+}
+#endif
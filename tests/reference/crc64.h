@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t ref_update_crc64(const void* buf, uint32_t len, uint64_t crc);
+uint64_t ref_CRC64(const char* t);
+
+#ifdef __cplusplus
+}
+#endif
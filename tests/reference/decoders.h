@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ref_mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end);
+uint8_t* ref_yay0_decode(const uint8_t* in_buf, uint32_t* out_size);
+uint8_t* ref_yay1_decode(const uint8_t* in_buf, uint32_t* out_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ref_mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out);
+
+#ifdef __cplusplus
+}
+#endif
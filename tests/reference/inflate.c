@@ -0,0 +1,24 @@
+// The zlib inflate bkzip assets went through before bk_inflate, with the same checks bk_unzip made on the result.
+// Kept apart from the tests since miniz declares the zlib names as well.
+#include "inflate.h"
+#include <zlib.h>
+
+// Returns 1 when the stream decoded to exactly out_size bytes
+int ref_bk_inflate(const uint8_t* in, uint32_t size, uint8_t* out, uint32_t out_size)
+{
+    z_stream stream = { 0 };
+    int result;
+
+    stream.next_in = (Bytef*) in;
+    stream.avail_in = size;
+    stream.next_out = out;
+    stream.avail_out = out_size;
+
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        return 0;
+    }
+    result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    return (result == Z_STREAM_END || (result == Z_BUF_ERROR && stream.avail_in == 0)) && stream.total_out == out_size;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ref_bk_inflate(const uint8_t* in, uint32_t size, uint8_t* out, uint32_t out_size);
+
+#ifdef __cplusplus
+}
+#endif